@@ -0,0 +1,183 @@
+#ifndef __SBL_ASYNC_DEVICE_H__
+#define __SBL_ASYNC_DEVICE_H__
+/******************************************************************************
+*  Filename:       sbl_async_device.h
+*
+*  Description:    Serial Bootloader asynchronous device interface header file.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+#include "sbllibUART.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <deque>
+#include <string>
+
+class SblOperation;
+class SblAsyncDevice;
+
+//
+// Called when an operation completes: on the executor thread, or on the
+// caller of cancel() or stop() if the operation had not started
+//
+typedef void (*tSblCompleteFPTR)(SblOperation *pOp, void *pvUser);
+
+//
+// Operations that can be queued on an SblAsyncDevice
+//
+typedef enum
+{
+    SBL_OP_CONNECT,
+    SBL_OP_PING,
+    SBL_OP_ERASE,
+    SBL_OP_WRITE,
+    SBL_OP_READ,
+    SBL_OP_CRC32,
+    SBL_OP_RESET
+} tSblOpType;
+
+//
+// A queued device operation; the future returned by SblAsyncDevice. Wait on
+// it, poll it, or pass a completion callback when queueing it. Buffers given
+// to the operation must stay valid until it has completed.
+//
+// Operations are reference counted: the executor holds one reference until
+// the operation completes and the caller holds one until release().
+//
+class SblOperation
+{
+public:
+    bool isDone();
+    bool wait(int timeoutMs = -1);
+    bool cancel();
+    void release();
+
+    tSblOpType getType() { return m_type; }
+    uint32_t getStatus();
+    uint32_t getResult();
+    std::string getError();
+
+private:
+    friend class SblAsyncDevice;
+
+    SblOperation(tSblOpType type, uint32_t ui32TimeoutMs, tSblCompleteFPTR pfnComplete, void *pvUser);
+    ~SblOperation();
+
+    void complete(uint32_t ui32Status, const std::string &csError);
+
+    tSblOpType  m_type;
+    uint32_t    m_ui32Address;
+    uint32_t    m_ui32ByteCount;
+    const char *m_pcWriteData;
+    char       *m_pcReadData;
+    std::string m_csPortNum;
+    uint32_t    m_ui32BaudRate;
+    int         m_pigpiodID;
+
+    uint32_t    m_ui32TimeoutMs;    // 0 if none
+    uint64_t    m_ui64DeadlineMs;   // Counted from when the operation was queued
+    tSblCompleteFPTR m_pfnComplete;
+    void       *m_pvUser;
+    SblAsyncDevice *m_pOwner;       // Set while queued or running
+
+    /// Protects the members below
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_cond;
+    int         m_refCount;
+    bool        m_bDone;
+    bool        m_bCancel;
+    uint32_t    m_ui32Status;
+    uint32_t    m_ui32Result;       // CRC32 for SBL_OP_CRC32
+    std::string m_csError;
+};
+
+//
+// Runs the operations of one SblDevice on a library owned executor thread,
+// one at a time and in the order they were queued, so the caller can prepare
+// the next image, parse files or compute CRCs while the device is busy, and
+// can queue the next operation before the current one is done so the port
+// never goes idle.
+//
+// Every operation can have a deadline, counted from when it was queued. An
+// operation still queued when its deadline passes fails with
+// SBL_TIMEOUT_ERROR without being started; a running one fails at its next
+// wait for the device. cancel() works the same way and fails the operation
+// with SBL_CANCELLED.
+//
+class SblAsyncDevice
+{
+public:
+    SblAsyncDevice(SblDevice *pDevice);
+    ~SblAsyncDevice();
+
+    int start();
+    void stop();
+    SblDevice *getDevice() { return m_pDevice; }
+    uint32_t getPending();
+
+    SblOperation *connect(std::string csPortNum, int pigpiodID, uint32_t ui32BaudRate, uint32_t ui32TimeoutMs = 0, 
+                          tSblCompleteFPTR pfnComplete = NULL, void *pvUser = NULL);
+    SblOperation *ping(uint32_t ui32TimeoutMs = 0, tSblCompleteFPTR pfnComplete = NULL, void *pvUser = NULL);
+    SblOperation *eraseFlashRange(uint32_t ui32StartAddress, uint32_t ui32ByteCount, uint32_t ui32TimeoutMs = 0, 
+                                  tSblCompleteFPTR pfnComplete = NULL, void *pvUser = NULL);
+    SblOperation *writeFlashRange(uint32_t ui32StartAddress, uint32_t ui32ByteCount, const char *pcData, 
+                                  uint32_t ui32TimeoutMs = 0, tSblCompleteFPTR pfnComplete = NULL, void *pvUser = NULL);
+    SblOperation *readMemoryRange(uint32_t ui32StartAddress, uint32_t ui32ByteCount, char *pcData, 
+                                  uint32_t ui32TimeoutMs = 0, tSblCompleteFPTR pfnComplete = NULL, void *pvUser = NULL);
+    SblOperation *calculateCrc32(uint32_t ui32StartAddress, uint32_t ui32ByteCount, uint32_t ui32TimeoutMs = 0, 
+                                 tSblCompleteFPTR pfnComplete = NULL, void *pvUser = NULL);
+    SblOperation *reset(uint32_t ui32TimeoutMs = 0, tSblCompleteFPTR pfnComplete = NULL, void *pvUser = NULL);
+
+private:
+    friend class SblOperation;
+
+    static void *executorThread(void *pArg);
+    SblOperation *submit(SblOperation *pOp);
+    uint32_t execute(SblOperation *pOp, std::string &csError);
+    bool cancel(SblOperation *pOp);
+
+    SblDevice *m_pDevice;
+
+    /// Executor thread, and whether it should stop
+    pthread_t m_thread;
+    bool m_bStarted;
+    bool m_bStop;
+
+    /// Protects the members below. m_cond is signalled when an operation is
+    /// queued or stop() is called.
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_cond;
+    std::deque<SblOperation *> m_queue;
+    SblOperation *m_pRunning;
+};
+
+#endif // __SBL_ASYNC_DEVICE_H__
@@ -0,0 +1,144 @@
+#ifndef __SBL_CHIP_TRAITS_H__
+#define __SBL_CHIP_TRAITS_H__
+/******************************************************************************
+*  Filename:       sbl_chip_traitsUART.h
+*
+*  Description:    Serial Bootloader per chip constants.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+#include <stdint.h>
+
+
+//-----------------------------------------------------------------------------
+/** \brief Constants of the CC26xx/CC13xx bootloader. Adding a part that
+ *      speaks the same protocol but has a different memory layout means
+ *      adding a traits struct and instantiating SblDeviceCC26xx with it.
+ */
+//-----------------------------------------------------------------------------
+struct SblTraitsCC2650
+{
+    enum {
+        CHIP_TYPE                = 0x2650,
+        PAGE_ERASE_SIZE          = 4096,
+        FLASH_START_ADDRESS      = 0x00000000,
+        RAM_START_ADDRESS        = 0x20000000,
+        ACCESS_WIDTH_32B         = 1,
+        ACCESS_WIDTH_8B          = 0,
+        PAGE_ERASE_TIME_MS       = 20,
+        SECTOR_ERASE_BATCH       = 4,       // 7 B commands queued in the 32 B UART RX FIFO
+        MAX_BYTES_PER_TRANSFER   = 252,
+        MAX_MEMWRITE_BYTES       = 247,
+        MAX_MEMWRITE_WORDS       = 61,
+        MAX_MEMREAD_BYTES        = 253,
+        MAX_MEMREAD_WORDS        = 63,
+        FLASH_SIZE_CFG           = 0x4003002C,
+        RAM_SIZE_CFG             = 0x40082250,
+        BL_CONFIG_PAGE_OFFSET    = 0xFDB,
+        BL_CONFIG_ENABLED_BM     = 0xC5,
+        BL_WORK_MEMORY_START     = 0x20000000,
+        BL_WORK_MEMORY_END       = 0x2000016F,
+        BL_STACK_MEMORY_START    = 0x20000FC0,
+        BL_STACK_MEMORY_END      = 0x20000FFF,
+    };
+};
+
+
+//-----------------------------------------------------------------------------
+/** \brief Constants of the CC2538 bootloader.
+ */
+//-----------------------------------------------------------------------------
+struct SblTraitsCC2538
+{
+    enum {
+        CHIP_TYPE                = 0x2538,
+        PAGE_ERASE_SIZE          = 2048,
+        FLASH_START_ADDRESS      = 0x00200000,
+        RAM_START_ADDRESS        = 0x20000000,
+        ACCESS_WIDTH_4B          = 4,
+        ACCESS_WIDTH_1B          = 1,
+        PAGE_ERASE_TIME_MS       = 20,
+        MAX_BYTES_PER_TRANSFER   = 252,
+        MAX_MEMREAD_BYTES        = 1,       // One access per read command
+        MAX_MEMREAD_WORDS        = 1,
+        DIECFG0                  = 0x400D3014,
+        BL_CONFIG_PAGE_OFFSET    = 2007,
+        BL_CONFIG_ENABLED_BM     = 0x10,
+    };
+};
+
+
+//-----------------------------------------------------------------------------
+/** \brief Memory layout helpers for the chip described by \e TTraits. All
+ *      constants are known at compile time, so the page divisions reduce to
+ *      shifts.
+ */
+//-----------------------------------------------------------------------------
+template <class TTraits>
+struct SblChip : public TTraits
+{
+    /// Flash page within which \e ui32Address is located
+    static uint32_t addressToPage(uint32_t ui32Address)
+    {
+        return ((ui32Address - TTraits::FLASH_START_ADDRESS) / TTraits::PAGE_ERASE_SIZE);
+    }
+
+    /// Start address of flash page \e ui32Page
+    static uint32_t pageToAddress(uint32_t ui32Page)
+    {
+        return (TTraits::FLASH_START_ADDRESS + (ui32Page * TTraits::PAGE_ERASE_SIZE));
+    }
+
+    /// Number of pages touched by \e ui32ByteCount bytes from \e ui32StartAddress
+    static uint32_t pageCount(uint32_t ui32StartAddress, uint32_t ui32ByteCount)
+    {
+        if(ui32ByteCount == 0) return 0;
+        return (addressToPage(ui32StartAddress + ui32ByteCount - 1) - addressToPage(ui32StartAddress) + 1);
+    }
+
+    /// Is [\e ui32StartAddress, \e ui32StartAddress + \e ui32ByteCount) in RAM?
+    static bool addressInRam(uint32_t ui32StartAddress, uint32_t ui32ByteCount, uint32_t ui32RamSize)
+    {
+        return (ui32StartAddress >= (uint32_t)TTraits::RAM_START_ADDRESS &&
+                (ui32StartAddress + ui32ByteCount) <= ((uint32_t)TTraits::RAM_START_ADDRESS + ui32RamSize));
+    }
+
+    /// Is [\e ui32StartAddress, \e ui32StartAddress + \e ui32ByteCount) in flash?
+    static bool addressInFlash(uint32_t ui32StartAddress, uint32_t ui32ByteCount, uint32_t ui32FlashSize)
+    {
+        return (ui32StartAddress >= (uint32_t)TTraits::FLASH_START_ADDRESS &&
+                (ui32StartAddress + ui32ByteCount) <= ((uint32_t)TTraits::FLASH_START_ADDRESS + ui32FlashSize));
+    }
+};
+
+
+#endif // __SBL_CHIP_TRAITS_H__
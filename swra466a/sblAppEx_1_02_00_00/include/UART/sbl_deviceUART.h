@@ -39,6 +39,7 @@
 *
 ******************************************************************************/
 #include <vector>
+#include <pthread.h>
 
 //
 // Typedefs for callback functions to report status and progress to application
@@ -46,10 +47,61 @@
 typedef void (*tStatusFPTR)(char *pcText, bool bError);
 typedef void (*tProgressFPTR)(uint32_t ui32Value);
 
-#define GTmin(x,y) x < y ? x : y
-#define GTmax(x, y) x > y ? x : y
+//
+// What connect() learned about the device on a port. Kept in the probe
+// cache so that a later connect() on the same port can skip the size queries.
+//
+typedef struct
+{
+    uint32_t    ui32DeviceId;
+    uint32_t    ui32FlashSize;
+    uint32_t    ui32RamSize;
+    uint32_t    ui32BaudRate;
+    bool        bSynced;        // Device was left in bootloader mode, auto baud done
+} tSblProbeInfo;
+
+//
+// Progress of a resumable flash download, see
+// SblDevice::writeFlashRangeResumable()
+//
+typedef struct
+{
+    uint32_t    ui32ImageCrc;
+    uint32_t    ui32ByteCount;
+    uint32_t    ui32DeviceId;
+    uint32_t    ui32StartAddress;
+    uint32_t    ui32PageSize;
+    uint32_t    ui32PagesDone;  // Leading pages written and confirmed by CRC
+} tSblCheckpoint;
+
+//
+// Part of a flash download, see writeFlashRange(). Long transfers are split
+// so that the page holding the bootloader configuration goes last.
+//
+typedef struct
+{
+    uint32_t startAddr;
+    uint32_t byteCount;
+    uint32_t startOffset;
+    bool     bExpectAck;
+} tSblTransfer;
+
+//
+// A port with a live bootloader, as found by SblDevice::discover()
+//
+typedef struct
+{
+    std::string csPortNum;
+    std::string csDescription;
+    uint32_t    ui32ChipType;   // 0x2538 or 0x2650 (CC26xx/CC13xx)
+    uint32_t    ui32DeviceId;
+    uint32_t    ui32FlashSize;
+} tSblPortInfo;
 
-class UART_ComPort;
+#define GTmin(x,y) ((x) < (y) ? (x) : (y))
+#define GTmax(x, y) ((x) > (y) ? (x) : (y))
+
+class SblTransport;
 class ComPortElement;
 
 
@@ -57,13 +109,17 @@ class SblDevice
 {
 public:
     // Destructor
-    ~SblDevice();
+    virtual ~SblDevice();
 
     // Static functions
     static SblDevice *Create(uint32_t ui32ChipType);
+    static uint32_t CreateAndConnect(SblDevice *&pDevice, std::string csPortNum, int pigpiodID, uint32_t ui32BaudRate, 
+                                     bool bEnableXosc = false, bool bFlowControl = false);
 
-    virtual uint32_t enumerate(ComPortElement*& pComPortElements, int &numElements);
-    virtual uint32_t connect(std::string csPortNum, int pigpiodID, uint32_t ui32BaudRate, bool bEnableXosc = false);
+    virtual uint32_t enumerate(ComPortElement*& pComPortElements, int &numElements, uint32_t ui32TransportMask = SBL_TRANSPORT_ALL);
+    virtual uint32_t discover(std::vector<tSblPortInfo> &pvPorts, uint32_t ui32BaudRate, 
+                              uint32_t ui32TimeoutMs = SBL_DISCOVER_TIMEOUT);
+    virtual uint32_t connect(std::string csPortNum, int pigpiodID, uint32_t ui32BaudRate, bool bEnableXosc = false, bool bFlowControl = false);
     virtual uint32_t ping() = 0;
     virtual uint32_t readStatus(uint32_t *pui32Status) = 0;
     virtual uint32_t readDeviceId(uint32_t *pui32DeviceId) = 0;
@@ -79,6 +135,11 @@ public:
     virtual uint32_t writeMemory8(uint32_t ui32StartAddress, uint32_t ui32UnitCount, const char *pcData) = 0;
     virtual uint32_t calculateCrc32(uint32_t ui32StartAddress, uint32_t ui32ByteCount, uint32_t *pui32Crc) = 0;
     virtual uint32_t setBootloaderMode(int pigpiodID) = 0;
+    virtual uint32_t getPageSize() = 0;
+    virtual uint32_t getMaxReadBytes() = 0;
+    uint32_t readMemoryRange(uint32_t ui32StartAddress, uint32_t ui32ByteCount, char *pcData);
+    uint32_t writeFlashRangeResumable(uint32_t ui32StartAddress, uint32_t ui32ByteCount, const char *pcData, 
+                                      std::string csCheckpointFile);
 
     // CC2650 specific
     virtual uint32_t eraseFlashBank(){ return SBL_UNSUPPORTED_FUNCTION; };
@@ -95,24 +156,54 @@ public:
     uint32_t getFlashSize() { return m_flashSize; }    
     uint32_t getRamSize() { return m_ramSize; }
     uint32_t getBaudRate() { return m_baudRate;}
+    bool getFlowControl() { return m_bFlowControl; }
     uint32_t getLastStatus() {return m_lastSblStatus;}
     uint32_t getLastDeviceStatus() { return m_lastDeviceStatus;}
     static std::string &getLastError(void) { return sm_csLastError;}
+    std::string getDeviceError() { return m_csLastError; }
     static uint32_t getProgress() { return sm_progress; }
+    static uint32_t getChipType(uint32_t ui32DeviceId);
+    static uint32_t calcCrc32(const char *pcData, uint32_t ui32ByteCount, uint32_t ui32Crc = 0);
+    static uint32_t calcBlankCrc32(uint32_t ui32ByteCount);
     static uint32_t setProgress(uint32_t ui32Progress);
     static void setCallBackStatusFunction(tStatusFPTR pSf) {sm_pStatusFunction = pSf; }
     static void setCallBackProgressFunction(tProgressFPTR pPf) {sm_pProgressFunction = pPf; }
+    static void setProbeCacheFile(std::string csFile) { sm_csProbeCacheFile = csFile; }
+    void setRetryPolicy(uint32_t ui32ChunkRetries, uint32_t ui32TotalRetries, uint32_t ui32BackoffMs);
+    void setOperationDeadline(uint32_t ui32TimeoutMs);
+    void setBlankCheck(bool bEnable) { m_bBlankCheck = bEnable; }
+    void setPageVerify(bool bEnable) { m_bPageVerify = bEnable; }
+    void setPageCrcs(uint32_t ui32Address, uint32_t ui32ByteCount, const char *pcData, const std::vector<uint32_t> &pvPageCrcs);
+    uint32_t getBlankPageCount() { return m_ui32BlankPages; }
+    void cancel() { m_bCancel = true; }
+    void clearCancel() { m_bCancel = false; }
+    bool isCancelled() { return m_bCancel; }
 
 protected:
     // Constructor
     SblDevice();
 
+    enum {
+        CMD_RET_SUCCESS      = 0x40,    // Device status after a good command, on all chips
+    };
+
+    uint32_t connectPort(std::string csPortNum, int pigpiodID, uint32_t ui32BaudRate, bool bEnableXosc, bool bFlowControl);
+    uint32_t readDeviceInfo();
     virtual uint32_t initCommunication(bool bSetXosc) = 0;
     virtual uint32_t sendCmd(uint32_t ui32Cmd, const char *pcSendData = NULL, uint32_t ui32SendLen = 0) = 0;
     virtual uint32_t sendAutoBaud(bool &bBaudSetOk);
     virtual uint32_t getCmdResponse(bool &bAck, uint32_t ui32MaxRetries = SBL_DEFAULT_RETRY_COUNT, bool bQuiet = false);
-    virtual uint32_t sendCmdResponse(bool bAck);
+    virtual uint32_t sendCmdResponse(bool bAck, const char *pcNextPkt = NULL, uint32_t ui32NextLen = 0);
     virtual uint32_t getResponseData(char *pcData, uint32_t &ui32MaxLen, uint32_t ui32MaxRetries = SBL_DEFAULT_RETRY_COUNT);
+    uint32_t getCmdResponseData(bool &bAck, char *pcData, uint32_t &ui32MaxLen, uint32_t ui32MaxRetries = SBL_DEFAULT_RETRY_COUNT);
+
+    virtual uint32_t cmdDownload(uint32_t ui32Address, uint32_t ui32Size) = 0;
+    virtual std::string getCmdStatusString(uint32_t ui32Status) = 0;
+    uint32_t restartDownload(uint32_t ui32Address, uint32_t ui32ByteCount);
+    uint32_t resync(bool &bPadAccepted);
+    uint32_t recoverTransfer(uint32_t ui32Address, uint32_t ui32BytesLeft, uint32_t ui32ChunkBytes, 
+                             uint32_t ui32TransferNumber, uint32_t &ui32ChunkRetries, uint32_t &ui32TotalRetries, 
+                             bool &bVerifyChunk);
 
     virtual uint8_t generateCheckSum(uint32_t ui32Cmd, const char *pcData, uint32_t ui32DataLen);
     virtual uint32_t addressToPage(uint32_t ui32Address) = 0;
@@ -126,11 +217,42 @@ protected:
     static uint32_t charArrayToUL(const char *pcSrc);
     static void ulToCharArray(const uint32_t ui32Src, char *pcDst);
     static void byteSwap(char *pcArray);
+    static uint64_t getTimeMs();
+    void setDeadline(uint32_t ui32TimeoutMs);
+    bool deadlineExpired();
+    bool operationAborted();
+    uint32_t findDirtyPages(uint32_t ui32Address, uint32_t ui32PageCount, std::vector<bool> &pvDirty);
+    static uint32_t nextDirtyRun(const std::vector<bool> &pvDirty, uint32_t &ui32Index, uint32_t ui32MaxCount);
+    uint32_t checkBlank(uint32_t ui32Address, uint32_t ui32ByteCount, bool &bBlank);
+    uint32_t verifyPages(uint32_t &ui32VerifyAddress, uint32_t ui32WrittenEnd, uint32_t ui32TransferEnd, 
+                         uint32_t ui32DataAddress, const char *pcData, bool &bVerified);
+    uint32_t verifyPage(uint32_t ui32Address, uint32_t ui32ByteCount, const char *pcData);
+    uint32_t verifyChunk(uint32_t ui32Address, uint32_t ui32ByteCount, const char *pcData);
+    uint32_t hostCrc32(uint32_t ui32Address, uint32_t ui32ByteCount, const char *pcData);
+    uint32_t writePagesResumable(uint32_t ui32StartAddress, uint32_t ui32ByteCount, 
+                                 const char *pcData, std::string csCheckpointFile);
+    void releasePageCrcs(uint32_t ui32Address, uint32_t ui32ByteCount, const char *pcData);
 
-    UART_ComPort     *m_pCom;
+    SblTransport     *m_pCom;
     std::string m_csComPort;
     bool        m_bCommInitialized;
     uint32_t    m_baudRate;
+    bool        m_bFlowControl;     // RTS/CTS set on the line (status is still read per frame)
+    bool        m_bTryPing;         // initCommunication() should ping instead of auto baud
+    uint64_t    m_ui64DeadlineMs;   // Response wait deadline (getTimeMs()), 0 if none
+    uint64_t    m_ui64OpDeadlineMs; // Deadline for the whole operation, 0 if none
+    volatile bool m_bCancel;        // cancel() called, fail the operation in progress
+    bool        m_bQuiet;           // Do not report status to the status callback
+    uint32_t    m_ui32ChunkRetries; // Retransmissions allowed per flash chunk
+    uint32_t    m_ui32TotalRetries; // Retransmissions allowed per writeFlashRange()
+    uint32_t    m_ui32BackoffMs;    // Delay before the first retransmission, doubled for each retry
+    bool        m_bBlankCheck;      // eraseFlashRange() skips pages that are already blank
+    uint32_t    m_ui32BlankPages;   // Pages the last eraseFlashRange() found blank
+    bool        m_bPageVerify;      // writeFlashRange() checks each page by CRC as it is written
+    uint32_t    m_ui32PageCrcAddress;   // Image the page CRCs below belong to, see setPageCrcs()
+    uint32_t    m_ui32PageCrcBytes;
+    const char *m_pcPageCrcData;
+    std::vector<uint32_t> m_pvPageCrcs; // Host CRC of each page of the image
 
     uint32_t    m_deviceId;
     uint32_t    m_flashSize;
@@ -139,12 +261,25 @@ protected:
     // Status and progress variables
     int32_t                 m_lastDeviceStatus;
     int32_t                 m_lastSblStatus;
+    std::string             m_csLastError;      // Last setState() text of this device
     static uint32_t         sm_progress;
     static std::string      sm_csLastError;
     static tProgressFPTR    sm_pProgressFunction;
     static tStatusFPTR      sm_pStatusFunction;
 
 private:
+    static void *discoverPort(void *pArg);
+    void takeOverPort(SblDevice &other);
+
+    static bool loadCheckpoint(const std::string &csFile, tSblCheckpoint &ckpt);
+    static void storeCheckpoint(const std::string &csFile, const tSblCheckpoint &ckpt);
+    static bool loadProbeCache(const std::string &csPort, tSblProbeInfo &info);
+    static void storeProbeCache(const std::string &csPort, const tSblProbeInfo &info);
+    static std::string defaultProbeCacheFile();
+    static int lockProbeCache(int operation);
+
+    static std::string      sm_csProbeCacheFile;
+    static pthread_mutex_t  sm_mutex;   // Guards static state shared between devices
 };
 
 
@@ -38,30 +38,22 @@
 *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *
 ******************************************************************************/
-#include "sbl_device.h"
+#include "sbl_deviceUART.h"
+#include "sbl_chip_traitsUART.h"
 
 //
 // For more information about the CC2538 serial bootloader interface,
 // please refer to the CC2538 ROM User's guide (http://www.ti.com/lit/swru333)
 //
 
-#define SBL_CC2538_PAGE_ERASE_SIZE          2048
-#define SBL_CC2538_FLASH_START_ADDRESS      0x00200000
-#define SBL_CC2538_RAM_START_ADDRESS        0x20000000
-#define SBL_CC2538_ACCESS_WIDTH_4B          4
-#define SBL_CC2538_ACCESS_WIDTH_1B          1
-#define SBL_CC2538_PAGE_ERASE_TIME_MS       20
-#define SBL_CC2538_MAX_BYTES_PER_TRANSFER   252
-#define SBL_CC2538_DIECFG0                  0x400D3014
-#define SBL_CC2538_BL_CONFIG_PAGE_OFFSET    2007
-#define SBL_CC2538_BL_CONFIG_ENABLED_BM     0x10
-
 class SblDeviceCC2538 : public SblDevice
 {
 public:
     SblDeviceCC2538();  // Constructor
     ~SblDeviceCC2538(); // Destructor
 
+    typedef SblChip<SblTraitsCC2538> Chip;
+
     enum {
         CMD_PING             = 0x20,
         CMD_DOWNLOAD         = 0x21,
@@ -107,9 +99,11 @@ protected:
     uint32_t calculateCrc32(uint32_t ui32StartAddress, uint32_t ui32ByteCount, uint32_t *pui32Crc);
 
     uint32_t sendCmd(uint32_t ui32Cmd, const char *pcSendData = NULL, uint32_t ui32SendLen = 0);
-    uint32_t addressToPage(uint32_t ui32Address);
-    bool     addressInRam(uint32_t ui32StartAddress, uint32_t ui32ByteCount = 1);
-    bool     addressInFlash(uint32_t ui32StartAddress, uint32_t ui32ByteCount = 1);
+    uint32_t addressToPage(uint32_t ui32Address) { return Chip::addressToPage(ui32Address); }
+    uint32_t getPageSize() { return Chip::PAGE_ERASE_SIZE; }
+    uint32_t getMaxReadBytes() { return Chip::MAX_MEMREAD_WORDS * 4; }
+    bool     addressInRam(uint32_t ui32StartAddress, uint32_t ui32ByteCount = 1) { return Chip::addressInRam(ui32StartAddress, ui32ByteCount, getRamSize()); }
+    bool     addressInFlash(uint32_t ui32StartAddress, uint32_t ui32ByteCount = 1) { return Chip::addressInFlash(ui32StartAddress, ui32ByteCount, getFlashSize()); }
 
     uint32_t setBootloaderMode(int pigpiodID);
 
@@ -118,6 +112,8 @@ protected:
     
 private:
     uint32_t initCommunication(bool bSetXosc);
+    uint32_t writeTransfers(uint32_t ui32StartAddress, uint32_t ui32ByteCount, const char *pcData);
+    uint32_t cmdErase(uint32_t ui32StartAddress, uint32_t ui32ByteCount);
     uint32_t cmdDownload(uint32_t ui32Address, uint32_t ui32Size);
     uint32_t cmdSendData(const char *pcData, uint32_t ui32ByteCount);
 
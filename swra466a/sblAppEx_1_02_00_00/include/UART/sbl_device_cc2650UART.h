@@ -38,35 +38,24 @@
 *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *
 ******************************************************************************/
-#include "sbl_device.h"
+#include "sbl_deviceUART.h"
+#include "sbl_chip_traitsUART.h"
 #include <vector>
 
 
-#define SBL_CC2650_PAGE_ERASE_SIZE          4096
-#define SBL_CC2650_FLASH_START_ADDRESS      0x00000000
-#define SBL_CC2650_RAM_START_ADDRESS        0x20000000
-#define SBL_CC2650_ACCESS_WIDTH_32B         1
-#define SBL_CC2650_ACCESS_WIDTH_8B          0
-#define SBL_CC2650_PAGE_ERASE_TIME_MS       20
-#define SBL_CC2650_MAX_BYTES_PER_TRANSFER   252
-#define SBL_CC2650_MAX_MEMWRITE_BYTES		247
-#define SBL_CC2650_MAX_MEMWRITE_WORDS		61
-#define SBL_CC2650_MAX_MEMREAD_BYTES		253
-#define SBL_CC2650_MAX_MEMREAD_WORDS		63
-#define SBL_CC2650_FLASH_SIZE_CFG           0x4003002C
-#define SBL_CC2650_RAM_SIZE_CFG             0x40082250
-#define SBL_CC2650_BL_CONFIG_PAGE_OFFSET    0xFDB
-#define SBL_CC2650_BL_CONFIG_ENABLED_BM     0xC5
-#define SBL_CC2650_BL_WORK_MEMORY_START		0x20000000
-#define SBL_CC2650_BL_WORK_MEMORY_END		0x2000016F
-#define SBL_CC2650_BL_STACK_MEMORY_START	0x20000FC0
-#define SBL_CC2650_BL_STACK_MEMORY_END		0x20000FFF
-
-class SblDeviceCC2650 : public SblDevice
+//-----------------------------------------------------------------------------
+/** \brief Serial bootloader driver for the CC26xx/CC13xx family. Chip
+ *      specific constants come from \e TTraits (see sbl_chip_traitsUART.h).
+ */
+//-----------------------------------------------------------------------------
+template <class TTraits>
+class SblDeviceCC26xx : public SblDevice
 {
 public:
-    SblDeviceCC2650();  // Constructor
-    ~SblDeviceCC2650(); // Destructor
+    SblDeviceCC26xx();  // Constructor
+    ~SblDeviceCC26xx(); // Destructor
+
+    typedef SblChip<TTraits> Chip;
 
     enum {
         CMD_PING             = 0x20,
@@ -122,9 +111,11 @@ protected:
     uint32_t calculateCrc32(uint32_t ui32StartAddress, uint32_t ui32ByteCount, uint32_t *pui32Crc);
 
     uint32_t sendCmd(uint32_t ui32Cmd, const char *pcSendData = NULL, uint32_t ui32SendLen = 0);
-    uint32_t addressToPage(uint32_t ui32Address);
-    bool     addressInRam(uint32_t ui32StartAddress, uint32_t ui32ByteCount = 1);
-    bool     addressInFlash(uint32_t ui32StartAddress, uint32_t ui32ByteCount = 1);
+    uint32_t addressToPage(uint32_t ui32Address) { return Chip::addressToPage(ui32Address); }
+    uint32_t getPageSize() { return Chip::PAGE_ERASE_SIZE; }
+    uint32_t getMaxReadBytes() { return Chip::MAX_MEMREAD_WORDS * 4; }
+    bool     addressInRam(uint32_t ui32StartAddress, uint32_t ui32ByteCount = 1) { return Chip::addressInRam(ui32StartAddress, ui32ByteCount, getRamSize()); }
+    bool     addressInFlash(uint32_t ui32StartAddress, uint32_t ui32ByteCount = 1) { return Chip::addressInFlash(ui32StartAddress, ui32ByteCount, getFlashSize()); }
 
     // CC2650 specific
     uint32_t eraseFlashBank();
@@ -135,8 +126,12 @@ protected:
     
 private:
     uint32_t initCommunication(bool bSetXosc);
+    uint32_t writeTransfers(uint32_t ui32StartAddress, uint32_t ui32ByteCount, const char *pcData);
     uint32_t cmdDownload(uint32_t ui32Address, uint32_t ui32Size);
     uint32_t cmdSendData(const char *pcData, uint32_t ui32ByteCount);
+    void     buildCmdPacket(uint32_t ui32Cmd, const char *pcSendData, uint32_t ui32SendLen, std::vector<char> &pvPkt);
+    uint32_t sectorEraseBatch(uint32_t ui32FirstPage, uint32_t ui32PageCount);
+    uint32_t readMemoryChunks(uint32_t ui32StartAddress, uint32_t ui32UnitCount, uint32_t ui32AccessWidth, char *pcData);
 
     std::string getCmdString(uint32_t ui32Cmd);
     std::string getCmdStatusString(uint32_t ui32Status);
@@ -149,6 +144,8 @@ private:
     uint32_t m_deviceRev;
 };
 
+typedef SblDeviceCC26xx<SblTraitsCC2650> SblDeviceCC2650;
+
 
 
 #endif // __SBL_DEVICE_CC2650_H__
\ No newline at end of file
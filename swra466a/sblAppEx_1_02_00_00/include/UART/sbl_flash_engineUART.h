@@ -0,0 +1,241 @@
+#ifndef __SBL_FLASH_ENGINE_H__
+#define __SBL_FLASH_ENGINE_H__
+/******************************************************************************
+*  Filename:       sbl_flash_engine.h
+*
+*  Description:    Serial Bootloader event driven flash engine header file.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+#include "sbllibUART.h"
+#include "sbl_port_lockUART.h"
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#define SBL_ENGINE_CMD_TIMEOUT      1000    // in ms
+#define SBL_ENGINE_AUTOBAUD_TRIES   3
+
+//
+// Steps of a flash job. Each one is a command exchange with the device.
+//
+typedef enum
+{
+    SBL_JOB_AUTOBAUD,
+    SBL_JOB_CHIP_ID,
+    SBL_JOB_FLASH_SIZE,
+    SBL_JOB_ERASE,
+    SBL_JOB_ERASE_STATUS,
+    SBL_JOB_ERASE_CHECK,
+    SBL_JOB_DOWNLOAD,
+    SBL_JOB_DOWNLOAD_STATUS,
+    SBL_JOB_SEND_DATA,
+    SBL_JOB_SEND_DATA_STATUS,
+    SBL_JOB_CRC,
+    SBL_JOB_CCFG,
+    SBL_JOB_RESET,
+    SBL_JOB_DONE,
+    SBL_JOB_FAILED
+} tSblJobState;
+
+//
+// Operations a workflow is made of
+//
+typedef enum
+{
+    SBL_STEP_ERASE,
+    SBL_STEP_WRITE,
+    SBL_STEP_VERIFY,
+    SBL_STEP_SET_CCFG,
+    SBL_STEP_RESET
+} tSblStepType;
+
+typedef struct
+{
+    tSblStepType type;
+    uint32_t    ui32Offset;         // From the start of flash
+    uint32_t    ui32ByteCount;
+    uint32_t    ui32DataIndex;      // Into the workflow data (write, verify)
+    uint32_t    ui32Field;          // CCFG field ID (set CCFG)
+    uint32_t    ui32Value;
+} tSblStep;
+
+//
+// A bootloader workflow written as one sequence, e.g.
+//
+//     SblWorkflow flow;
+//     flow.program(0, pcImage, ui32Size).setCCFG(ui32FieldId, ui32Value).reset();
+//
+// and run by SblFlashEngine on any number of devices. Connecting and
+// identifying the device always comes first. Addresses are offsets from
+// the start of flash of the chip found, so one workflow serves CC2538 and
+// CC26xx. The data is copied in; jobs refer to the workflow, which must
+// outlive them.
+//
+class SblWorkflow
+{
+public:
+    SblWorkflow &erase(uint32_t ui32Offset, uint32_t ui32ByteCount);
+    SblWorkflow &write(uint32_t ui32Offset, const char *pcData, uint32_t ui32ByteCount);
+    SblWorkflow &verify(uint32_t ui32Offset, const char *pcData, uint32_t ui32ByteCount);
+    SblWorkflow &program(uint32_t ui32Offset, const char *pcData, uint32_t ui32ByteCount);
+    SblWorkflow &setCCFG(uint32_t ui32Field, uint32_t ui32Value);
+    SblWorkflow &reset();
+
+    const std::vector<tSblStep> &getSteps() const { return m_steps; }
+    const char *getData(const tSblStep &step) const { return &m_pvData[step.ui32DataIndex]; }
+    uint32_t getWriteBytes() const;
+
+private:
+    uint32_t addData(const char *pcData, uint32_t ui32ByteCount);
+
+    std::vector<tSblStep> m_steps;
+    std::vector<char> m_pvData;
+};
+
+//
+// Flashes many devices from one thread. Every job (a workflow run on one
+// device) is a state machine advanced by the bytes that arrive on its port;
+// one epoll loop waits on all ports at once, so an idle job costs nothing
+// and no thread blocks in a read. Run one engine per thread to spread
+// thousands of jobs over a few cores.
+//
+// A write step whose data disables the bootloader (bootloader config byte
+// in the last flash page) is sent as in the drivers' writeFlashRange(): the
+// words from that byte on go in a download of their own, and their status
+// is not read.
+//
+// Jobs run on serial ports only (the engine opens the tty itself, non
+// blocking) and expect the device to be in bootloader mode and not yet
+// auto bauded, as after a reset with the backdoor pin held.
+//
+// A finished job keeps its port until the last bytes (the ACK of the final
+// response, the reset command) have left the UART, and counts as running
+// until then.
+//
+// All calls except wake() must come from the thread calling step().
+//
+class SblFlashEngine
+{
+public:
+    SblFlashEngine();
+    ~SblFlashEngine();
+
+    int addJob(const std::string &csPortNum, uint32_t ui32BaudRate, const SblWorkflow &workflow);
+    int addJob(const std::string &csPortNum, uint32_t ui32BaudRate, const char *pcData, uint32_t ui32ByteCount);
+    void removeJob(int job);
+
+    uint32_t step(int timeoutMs);
+    uint32_t run();
+    void wake();
+
+    tSblJobState getState(int job);
+    bool isActive(int job);
+    uint32_t getStatus(int job);
+    std::string getError(int job);
+    uint32_t getProgress(int job);
+    uint32_t getChipType(int job);
+
+private:
+    typedef struct
+    {
+        std::string csPortNum;
+        int         fd;
+        SblPortLock *pLock;
+        uint32_t    ui32BaudRate;
+        bool        bRunning;           // Counted in m_activeJobs until the port is released
+        bool        bDraining;          // Done, port closes once the bytes queued are sent
+        uint64_t    ui64DrainEndMs;
+        tSblJobState state;
+        const SblWorkflow *pWorkflow;
+        SblWorkflow *pOwnWorkflow;      // Built by addJob() from an image
+        uint32_t    ui32Step;           // Index of the workflow step running
+        uint32_t    ui32WriteBytes;     // Bytes written by all write steps
+        uint32_t    ui32WriteDone;
+
+        uint32_t    ui32ChipType;
+        uint32_t    ui32DeviceRev;      // 1 for CC26xx early samples, see convertCmd()
+        uint32_t    ui32FlashBase;
+        uint32_t    ui32FlashSize;
+        uint32_t    ui32Page;           // Next page to erase (CC26xx)
+        uint32_t    ui32PageEnd;
+        uint32_t    ui32BatchPage;      // First page of the erase batch in flight
+        uint32_t    ui32RetryEnd;       // Erasing page by page up to here, 0 if not
+        uint32_t    ui32Offset;         // Bytes sent in this write step
+        uint32_t    ui32WriteEnd;       // End of the download in flight, from the step start
+        uint32_t    ui32Chunk;          // Bytes in the SEND_DATA in flight
+        bool        bNoStatus;          // Download in flight disables the bootloader
+        bool        bBlDisabled;        // Such a download was sent
+        uint32_t    ui32Tries;
+
+        std::vector<char> pvTx;         // Bytes not yet written
+        std::vector<unsigned char> pvRx;
+        uint32_t    ui32PendingAcks;    // ACKs still expected
+        bool        bExpectData;        // Data packet expected after them
+        uint64_t    ui64DeadlineMs;
+        bool        bWantWrite;         // EPOLLOUT registered
+
+        uint32_t    ui32Status;
+        std::string csError;
+        uint32_t    ui32Progress;
+    } tJob;
+
+    tJob *findJob(int job);
+    void sendCmd(tJob *pJob, uint32_t ui32Cmd, const char *pcData, uint32_t ui32Len, 
+                 bool bExpectData, uint32_t ui32TimeoutMs);
+    void sendAutoBaud(tJob *pJob);
+    void flushTx(tJob *pJob);
+    void onReadable(tJob *pJob);
+    void onResponse(tJob *pJob, const unsigned char *pData, uint32_t ui32Len);
+    void onTimeout(tJob *pJob);
+    void portLost(tJob *pJob, const char *pcReason);
+    void startStep(tJob *pJob);
+    void nextErase(tJob *pJob);
+    bool retryErase(tJob *pJob);
+    void startDownload(tJob *pJob);
+    void nextSendData(tJob *pJob);
+    void sendDataDone(tJob *pJob);
+    void fail(tJob *pJob, uint32_t ui32Status, const char *pcFormat, ...);
+    void finishJob(tJob *pJob);
+    void checkDrained(tJob *pJob);
+    void closeJob(tJob *pJob);
+    void updateEvents(tJob *pJob);
+
+    int m_epoll;
+    int m_wakeFd;
+    int m_nextId;
+    uint32_t m_activeJobs;
+    std::map<int, tJob *> m_jobs;
+};
+
+#endif // __SBL_FLASH_ENGINE_H__
@@ -0,0 +1,131 @@
+#ifndef __SBL_HID_PORT_H__
+#define __SBL_HID_PORT_H__
+/******************************************************************************
+*  Filename:       sbl_hid_port.h
+*
+*  Description:    Serial Bootloader buffered CP2110 HID port header file.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+#include "HID_ComPort.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//
+// CP2110 reports carry at most 63 UART bytes each, and the interrupt
+// endpoints are polled once per millisecond. Every HID_ComPort call
+// therefore costs at least one USB frame, no matter how few bytes it moves.
+//
+// SblHidPort wraps HID_ComPort so the bootloader protocol pays that cost as
+// rarely as possible:
+//  - Writes are collected and sent as one transfer of full reports when the
+//    host next waits for input (or the batch is full). A 2 byte ACK is thus
+//    sent in the same reports as the following command.
+//  - A reader thread keeps an interrupt IN read pending at all times and
+//    moves incoming data to a ring buffer, which readBytes() serves from.
+//
+// The CP2110 is accessed through the virtual port*() functions only, so a
+// test can put a fake device behind SblHidPort. A subclass overriding them
+// must call close() in its own destructor.
+//
+class SblHidPort
+{
+public:
+    enum {
+        HID_REPORT_DATA_SIZE = 63,                          ///< UART bytes per HID report
+        HID_TX_BATCH_SIZE    = 16 * HID_REPORT_DATA_SIZE,   ///< Max bytes held back before sending
+        HID_RX_RING_SIZE     = 16384,                       ///< RX ring buffer size
+        HID_RX_POLL_MS       = 20,                          ///< Read timeout of the reader thread
+    };
+
+    SblHidPort();
+    virtual ~SblHidPort();
+
+    int enumerate(ComPortElement*& pComPortList, int& numElements) 
+    { 
+        return m_port.enumerate(pComPortList, numElements); 
+    }
+    int open(std::string csPortNumber, int baudRate, int rdTimeoutMs, int wrTimeoutMs, int flags);
+    int close();
+    int readBytes(void *pData, int length);
+    int writeBytes(void *pData, int length);
+    int flushBuffers();
+    int flushTx();
+    int setBootloaderMode() { return m_port.setBootloaderMode(); }
+    bool isInitiated() { return portIsOpen(); }
+    int getBaudRate() { return m_port.getBaudRate(); }
+
+protected:
+    virtual int portOpen(const std::string &csPortNumber, int baudRate, int rdTimeoutMs, 
+                         int wrTimeoutMs, int flags) 
+    { 
+        return m_port.open(csPortNumber, baudRate, rdTimeoutMs, wrTimeoutMs, flags); 
+    }
+    virtual int portClose() { return m_port.close(); }
+    virtual int portRead(void *pData, int length) { return m_port.readBytes(pData, length); }
+    virtual int portWrite(void *pData, int length) { return m_port.writeBytes(pData, length); }
+    virtual int portFlush() { return m_port.flushBuffers(); }
+    virtual bool portIsOpen() { return m_port.isInitiated(); }
+
+private:
+    static void *rxThread(void *pArg);
+
+    /// The CP2110 port
+    HID_ComPort m_port;
+
+    /// Reader thread, and whether it has been started and should stop
+    pthread_t m_rxThread;
+    bool m_bRxStarted;
+    volatile bool m_bRxStop;
+
+    /// Protects the RX ring. m_rxCond is signalled when data is added.
+    pthread_mutex_t m_rxMutex;
+    pthread_cond_t m_rxCond;
+
+    /// RX ring buffer, index of the oldest byte and number of bytes held
+    std::vector<char> m_pvRxRing;
+    uint32_t m_ui32RxHead;
+    uint32_t m_ui32RxCount;
+
+    /// Set if the reader thread got an error from the port
+    bool m_bRxError;
+
+    /// Bytes written but not yet sent
+    std::vector<char> m_pvTx;
+
+    /// How long readBytes() waits for data
+    int m_rdTimeoutMs;
+};
+
+#endif // __SBL_HID_PORT_H__
@@ -0,0 +1,115 @@
+#ifndef __SBL_IMAGE_PREP_H__
+#define __SBL_IMAGE_PREP_H__
+/******************************************************************************
+*  Filename:       sbl_image_prep.h
+*
+*  Description:    Serial Bootloader host side image preparation header file.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+#include <pthread.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class SblManifest;
+
+//
+// Prepares an image on a worker thread while the caller connects to and
+// erases the device, so the host side work is done by the time the data is
+// needed for the write. The stages run in order:
+//
+//     load     Map the file (or read it if it cannot be mapped)
+//     CRC      CRC32 of the whole image, for the check after the write
+//     page map CRC32 of the image bytes in each flash page, once the page
+//              size is known (from start() or setPageSize()), for the page
+//              checks after the write (see SblDevice::setPageCrcs())
+//
+// For a manifest the worker runs SblManifest::load() instead, which reads
+// and pads all images it lists.
+//
+// The size of an image is known when start() returns, so the erase can be
+// started right away. Everything else must only be used after wait().
+//
+class SblImagePrep
+{
+public:
+    SblImagePrep();
+    ~SblImagePrep();
+
+    uint32_t start(const std::string &csFile, uint32_t ui32PageSize = 0);
+    uint32_t start(SblManifest *pManifest, const std::string &csFile);
+    void setPageSize(uint32_t ui32PageSize);
+    uint32_t wait();
+
+    uint32_t getByteCount() { return m_ui32ByteCount; }
+    const char *getData() { return m_pcData; }
+    uint32_t getCrc() { return m_ui32Crc; }
+    uint32_t getPageSize() { return m_ui32PageSize; }
+    const std::vector<uint32_t> &getPageCrcs() { return m_pvPageCrcs; }
+    uint32_t getPrepTimeMs() { return m_ui32PrepMs; }
+    uint32_t getWaitTimeMs() { return m_ui32WaitMs; }
+    const std::string &getError() { return m_csError; }
+
+private:
+    static void *workerThread(void *pArg);
+    uint32_t prepare();
+    uint32_t loadImage();
+    void release();
+
+    SblManifest *m_pManifest;       // Manifest to load, NULL for an image
+    std::string m_csFile;
+    int         m_fd;
+    void       *m_pvMap;            // Mapped file, NULL if read into m_pvData
+    std::vector<char> m_pvData;
+    const char *m_pcData;
+    uint32_t    m_ui32ByteCount;
+    uint32_t    m_ui32Crc;
+    std::vector<uint32_t> m_pvPageCrcs;
+    uint32_t    m_ui32PrepMs;       // Time the worker spent
+    uint32_t    m_ui32WaitMs;       // Time wait() blocked the caller
+    uint32_t    m_ui32Status;
+    std::string m_csError;
+
+    /// Worker thread
+    pthread_t   m_thread;
+    bool        m_bStarted;
+
+    /// Protects the members below. m_cond is signalled when the page size
+    /// is set or wait() is called.
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_cond;
+    uint32_t    m_ui32PageSize;     // 0 if not known yet
+    bool        m_bWaiting;         // wait() called, do not wait for the page size
+};
+
+#endif // __SBL_IMAGE_PREP_H__
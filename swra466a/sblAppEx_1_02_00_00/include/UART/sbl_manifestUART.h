@@ -0,0 +1,167 @@
+#ifndef __SBL_MANIFEST_H__
+#define __SBL_MANIFEST_H__
+/******************************************************************************
+*  Filename:       sbl_manifest.h
+*
+*  Description:    Serial Bootloader job manifest header file.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+class SblDevice;
+
+//
+// How a region is checked after all regions are written
+//
+typedef enum
+{
+    SBL_VERIFY_CRC,         // Device CRC32 against the file (default)
+    SBL_VERIFY_READBACK,    // Read the region back and compare
+    SBL_VERIFY_NONE
+} tSblVerify;
+
+//
+// An image file to program into flash
+//
+typedef struct
+{
+    std::string csFile;
+    uint32_t    ui32Address;
+    bool        bFlashStart;        // No address given, use the start of flash
+    std::vector<char> pvData;       // Padded with 0xFF to a multiple of 4
+    tSblVerify  verify;
+} tSblRegion;
+
+//
+// Words to write to RAM with writeMemory32()
+//
+typedef struct
+{
+    uint32_t    ui32Address;
+    std::vector<uint32_t> pvWords;
+    tSblVerify  verify;             // CRC is done as read back for RAM
+} tSblRamPatch;
+
+//
+// A CCFG field to set with setCCFG() (CC26xx)
+//
+typedef struct
+{
+    uint32_t    ui32Field;
+    uint32_t    ui32Value;
+} tSblCcfgField;
+
+//
+// Bytes patched into an image in memory before it is written, e.g. a
+// serial number or MAC address. \e csData is a template: ${NAME} is
+// replaced by variable NAME when the manifest is run.
+//
+typedef struct
+{
+    uint32_t    ui32Address;
+    std::string csData;
+    uint32_t    ui32LineNo;
+} tSblPatch;
+
+//
+// Everything to program into one device in one session. A manifest is a
+// text file with one entry per line ('#' starts a comment):
+//
+//     image <file> [<address>] [verify=crc|readback|none]
+//     ccfg  <field ID> <value>
+//     ram32 <address> <word> [<word> ...] [verify=readback|none]
+//     patch <address> <data>
+//
+// Numbers are decimal or hex with '0x' in front. Image paths are relative
+// to the manifest. An image without address goes to the start of flash.
+// Arguments are split at whitespace. Put double quotes around text that
+// holds spaces or '#', e.g. str:"Unit #1" or "my images/app.bin"; inside
+// quotes \" is a quote and \\ a backslash. A comment must start before an
+// argument; an unquoted '#' inside one, an extra argument or a missing
+// closing quote fails load() with the line number, so no text is dropped.
+//
+// Patch data is 0x<hex bytes>, u16:<number>, u32:<number> (little endian)
+// or str:<text>, after ${NAME} is replaced by the value set with
+// setVariable(). Patches must fall inside an image. They are applied to a
+// copy of the image each run, before the CRC and the transfer, so they cost
+// no device round trips and one loaded manifest serves every unit.
+//
+// run() connects nothing itself; it takes a connected device and does
+// one erase of the pages under all images (adjacent ranges merged), writes
+// and verifies the images, then sets the CCFG fields and applies and
+// verifies the RAM patches. The images are verified before the CCFG fields
+// change the CCFG page, which an image may cover.
+//
+class SblManifest
+{
+public:
+    uint32_t load(const std::string &csFile);
+    uint32_t run(SblDevice *pDevice);
+
+    const std::vector<tSblRegion> &getRegions() { return m_regions; }
+    const std::vector<tSblRamPatch> &getRamPatches() { return m_ramPatches; }
+    const std::vector<tSblCcfgField> &getCcfgFields() { return m_ccfgFields; }
+    const std::vector<tSblPatch> &getPatches() { return m_patches; }
+    uint32_t getEraseRangeCount() { return m_eraseRanges.size(); }
+    void setVariable(const std::string &csName, const std::string &csValue) { m_variables[csName] = csValue; }
+    const std::string &getError() { return m_csError; }
+
+private:
+    typedef struct
+    {
+        uint32_t    ui32Start;
+        uint32_t    ui32End;            // Exclusive
+    } tRange;
+
+    uint32_t planErase(SblDevice *pDevice, uint32_t ui32FlashBase);
+    uint32_t applyPatches();
+    uint32_t patchBytes(const tSblPatch &patch, std::vector<char> &pvBytes);
+    const char *regionData(size_t i) { return (m_pvPatched[i].empty()) ? &m_regions[i].pvData[0] : &m_pvPatched[i][0]; }
+    uint32_t verifyRange(SblDevice *pDevice, uint32_t ui32Address, const char *pcData, uint32_t ui32ByteCount, 
+                         tSblVerify verify);
+    uint32_t error(uint32_t ui32Status, const char *pcFormat, ...);
+
+    std::vector<tSblRegion> m_regions;
+    std::vector<tSblRamPatch> m_ramPatches;
+    std::vector<tSblCcfgField> m_ccfgFields;
+    std::vector<tSblPatch> m_patches;
+    std::map<std::string, std::string> m_variables;
+    std::vector<std::vector<char> > m_pvPatched;   // Patched copy per region, empty if unpatched
+    std::vector<tRange> m_eraseRanges;
+    std::string m_csError;
+};
+
+#endif // __SBL_MANIFEST_H__
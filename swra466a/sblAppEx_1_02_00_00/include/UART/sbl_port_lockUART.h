@@ -1,11 +1,9 @@
-#ifndef __SBLLIB_H__
-#define __SBLLIB_H__
+#ifndef __SBL_PORT_LOCK_H__
+#define __SBL_PORT_LOCK_H__
 /******************************************************************************
-*  Filename:       sbllib.h
-*  Revised:        $Date: 2014-12-18 18:51:59 +0100 (to, 18 des 2014) $
-*  Revision:       $Revision: 33858 $
+*  Filename:       sbl_port_lock.h
 *
-*  Description:    Serial Bootloader Library header file.
+*  Description:    Serial Bootloader port lock header file.
 *
 *  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
 *
@@ -39,28 +37,48 @@
 *
 ******************************************************************************/
 #include <string>
-#include <stdint.h>
 
-#define SBL_MAX_DEVICES             20
-#define SBL_DEFAULT_RETRY_COUNT     1
-#define SBL_DEFAULT_READ_TIMEOUT    100 // in ms
-#define SBL_DEFAULT_WRITE_TIMEOUT   200 // in ms
+#ifndef SBL_LOCK_DIR
+#define SBL_LOCK_DIR                "/var/lock"
+#endif
 
-typedef enum {
-    SBL_SUCCESS = 0,
-    SBL_UNSUPPORTED_FUNCTION = -6,
-    SBL_ENUM_ERROR,
-    SBL_PORT_ERROR,
-    SBL_TIMEOUT_ERROR,
-    SBL_ARGUMENT_ERROR,
-    SBL_ERROR,
-} tSblStatus;
+//
+// Exclusive claim of a port (or other shared resource such as the Pi HAT
+// GPIOs) across processes. The claim is a UUCP style lock file,
+// SBL_LOCK_DIR/LCK..<name> holding the owner's PID, which is also flock()ed
+// so that it is released by the kernel if the owner dies. Lock files left
+// by tools that do not flock() (minicom, screen, ...) are honoured while
+// their PID is alive.
+//
+class SblPortLock
+{
+public:
+    SblPortLock();
+    ~SblPortLock();
 
-#include "sbl_device.h"
-#include "sbl_device_cc2538.h"
-#include "sbl_device_cc2650.h"
-#include "sbl_eb_info.h"
+    int lock(const std::string &csName);
+    void unlock();
 
+    bool isLocked() const { return (m_fd >= 0); }
 
+    /// PID holding the lock after lock() returned SBL_PORT_BUSY_ERROR
+    int getOwner() const { return m_owner; }
 
-#endif // __SBLLIB_H__
+    /// errno of the lock file open() after lock() returned SBL_PORT_ERROR
+    int getError() const { return m_error; }
+
+    /// Path of the lock file last tried
+    const std::string &getPath() const { return m_csPath; }
+
+    static std::string ttyPath(const std::string &csPortNum);
+    static std::string lockName(const std::string &csPortNum);
+    static std::string hidLockName(const std::string &csSerial, const std::string &csIndex);
+
+private:
+    int m_fd;
+    int m_owner;
+    int m_error;
+    std::string m_csPath;
+};
+
+#endif // __SBL_PORT_LOCK_H__
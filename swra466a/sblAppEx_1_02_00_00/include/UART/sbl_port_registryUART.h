@@ -0,0 +1,121 @@
+#ifndef __SBL_PORT_REGISTRY_H__
+#define __SBL_PORT_REGISTRY_H__
+/******************************************************************************
+*  Filename:       sbl_port_registry.h
+*
+*  Description:    Serial Bootloader USB serial port registry header file.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+#include <pthread.h>
+#include <stdint.h>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifndef SBL_SYSFS_ROOT
+#define SBL_SYSFS_ROOT              "/sys"
+#endif
+
+#define SBL_USB_PORT_PREFIX         "usb:"
+
+//
+// A USB serial port and the identity of the device behind it
+//
+typedef struct
+{
+    std::string csPortNum;      // tty name, e.g. "ttyUSB0"
+    std::string csUsbPath;      // Physical USB port, e.g. "1-1.2:1.0"
+    std::string csSerial;       // USB serial number (may be empty)
+    std::string csDescription;  // Manufacturer and product strings
+    uint16_t    ui16Vid;
+    uint16_t    ui16Pid;
+} tSblUsbPort;
+
+//
+// Live list of USB serial ports. The list is read from sysfs once, then kept
+// up to date from kernel uevents (netlink) by a monitor thread, so a board is
+// known the moment its tty appears instead of at the next enumeration.
+//
+// Ports are keyed by tty name and can be looked up by a stable identity:
+// the USB serial number or the physical USB port, which stay the same when
+// the tty number changes.
+//
+// sysfs is read below the root given to the constructor (SBL_SYSFS_ROOT by
+// default), so the registry can be pointed at a copy of the tree.
+//
+class SblPortRegistry
+{
+public:
+    SblPortRegistry(const std::string &csSysfsRoot = SBL_SYSFS_ROOT);
+    ~SblPortRegistry();
+
+    int start();
+    void stop();
+
+    void getPorts(std::vector<tSblUsbPort> &pvPorts);
+    bool find(const std::string &csId, tSblUsbPort &port);
+    bool waitForPort(tSblUsbPort &port, int timeoutMs);
+
+    bool identify(const std::string &csTty, tSblUsbPort &port);
+
+protected:
+    void scan();
+    void handleUevent(const char *pcMsg, int length);
+
+private:
+    static void *monitorThread(void *pArg);
+
+    /// sysfs mount point
+    std::string m_csSysfsRoot;
+
+    /// Netlink socket, or -1
+    int m_sock;
+
+    /// Monitor thread, and whether it should stop
+    pthread_t m_thread;
+    bool m_bStarted;
+    volatile bool m_bStop;
+
+    /// Protects the members below. m_cond is signalled when a port is added.
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_cond;
+
+    /// Known ports by tty name
+    std::map<std::string, tSblUsbPort> m_ports;
+
+    /// Ports added since start(), not yet returned by waitForPort()
+    std::deque<tSblUsbPort> m_added;
+};
+
+#endif // __SBL_PORT_REGISTRY_H__
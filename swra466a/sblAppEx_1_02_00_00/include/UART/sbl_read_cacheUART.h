@@ -0,0 +1,104 @@
+#ifndef __SBL_READ_CACHE_H__
+#define __SBL_READ_CACHE_H__
+/******************************************************************************
+*  Filename:       sbl_read_cache.h
+*
+*  Description:    Serial Bootloader batched memory read header file.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+class SblDevice;
+
+//
+// One read of a batch given to SblReadCache::read()
+//
+typedef struct
+{
+    uint32_t    ui32Address;
+    uint32_t    ui32ByteCount;
+    char       *pcData;             // Where the bytes are stored
+} tSblReadRequest;
+
+//
+// Reads many small fields (IEEE address, calibration words, version
+// structs, ...) with as few memory read commands as possible.
+//
+// Memory is read in aligned blocks that are kept for the rest of the
+// session, so fields that share a block, or were read before, cost no
+// further commands. The blocks missing for a batch are read in runs of
+// adjacent blocks, each with one SblDevice::readMemoryRange(), which packs
+// 32 bit accesses into full size commands.
+//
+// Peripheral registers (0x40000000 - 0x4FFFFFFF) and the Cortex-M private
+// peripheral bus (0xE0000000 - 0xE00FFFFF: SysTick, NVIC, SCB, debug) can
+// change or have side effects when read, so they are never cached or read
+// ahead: overlapping and adjacent requests are merged, nothing more.
+//
+// The cache does not see writes to the device. Call invalidate() after
+// erasing or writing memory that may be cached.
+//
+class SblReadCache
+{
+public:
+    SblReadCache(SblDevice *pDevice);
+
+    uint32_t read(std::vector<tSblReadRequest> &pvRequests);
+    uint32_t read(uint32_t ui32Address, uint32_t ui32ByteCount, char *pcData);
+    void invalidate() { m_blocks.clear(); }
+
+    uint32_t getDeviceReads() { return m_ui32DeviceReads; }
+    uint32_t getCacheHits() { return m_ui32CacheHits; }
+
+private:
+    typedef struct
+    {
+        uint32_t    ui32Start;
+        uint32_t    ui32End;            // Exclusive
+    } tRange;
+
+    static bool isRegister(const tSblReadRequest &request);
+    uint32_t blockSize();
+    uint32_t readBlocks(uint32_t ui32Start, uint32_t ui32End);
+    uint32_t readRegisters(std::vector<tSblReadRequest> &pvRequests);
+    void copyFromBlocks(const tSblReadRequest &request);
+
+    SblDevice  *m_pDevice;
+    std::map<uint32_t, std::vector<char> > m_blocks;   // Cached blocks by address
+    uint32_t    m_ui32DeviceReads;  // readMemoryRange() calls made
+    uint32_t    m_ui32CacheHits;    // Requests served without reading
+};
+
+#endif // __SBL_READ_CACHE_H__
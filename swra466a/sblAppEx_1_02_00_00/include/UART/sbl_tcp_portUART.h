@@ -0,0 +1,116 @@
+#ifndef __SBL_TCP_PORT_H__
+#define __SBL_TCP_PORT_H__
+/******************************************************************************
+*  Filename:       sbl_tcp_port.h
+*
+*  Description:    Serial Bootloader TCP / RFC 2217 remote serial port header file.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+#include "ComPort.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define SBL_TCP_PORT_PREFIX         "tcp://"
+#define SBL_RFC2217_PORT_PREFIX     "rfc2217://"
+
+//
+// Serial port on another machine, reached over TCP. Two kinds of server
+// are supported:
+//  - tcp://<host>:<port>      Raw TCP. The server's line settings are used.
+//  - rfc2217://<host>:<port>  Telnet COM-PORT-OPTION (RFC 2217), as spoken by
+//                             ser2net. Baud rate and framing are set on open.
+//
+// Nagle is turned off and writes are instead queued until the host next
+// waits for input, so each command (and the ACK before it) leaves in one
+// segment and costs one round trip.
+//
+class SblTcpPort
+{
+public:
+    enum {
+        TCP_TX_BATCH_SIZE      = 4096,  ///< Max bytes held back before sending
+        TCP_CONNECT_TIMEOUT_MS = 3000,  ///< Connect timeout
+    };
+
+    SblTcpPort();
+    ~SblTcpPort();
+
+    static bool isTcpPort(const std::string &csPortNumber);
+
+    int open(std::string csPortNumber, int baudRate, int rdTimeoutMs, int wrTimeoutMs, int flags);
+    int attach(int sock, bool bRfc2217, int baudRate, int rdTimeoutMs, int wrTimeoutMs);
+    int close();
+    int readBytes(void *pData, int length);
+    int writeBytes(void *pData, int length);
+    int flushBuffers();
+    int flushTx();
+    /// The remote fixture owns the reset lines. Returns 0 (success) like
+    /// UART_ComPort::setBootloaderMode().
+    int setBootloaderMode() { return 0; }
+    bool isInitiated() { return (m_sock >= 0); }
+    int getBaudRate() { return m_baudRate; }
+
+private:
+    enum tTelnetState {
+        TELNET_STATE_DATA,
+        TELNET_STATE_IAC,
+        TELNET_STATE_OPTION,
+        TELNET_STATE_SB,
+        TELNET_STATE_SB_IAC,
+    };
+
+    int connectTo(const std::string &csHost, const std::string &csService);
+    int sendComPortOption(uint8_t ui8Cmd, const uint8_t *pui8Value, uint32_t ui32Len);
+    int parseTelnet(char *pcData, int length);
+    int waitSocket(short events, int timeoutMs);
+
+    /// Socket, or -1 if not connected
+    int m_sock;
+
+    /// Whether the server speaks RFC 2217
+    bool m_bRfc2217;
+
+    /// Receive side telnet parser state, and the WILL/WONT/DO/DONT being parsed
+    tTelnetState m_telnetState;
+    uint8_t m_ui8TelnetVerb;
+
+    /// Bytes queued for sending, already telnet escaped
+    std::vector<char> m_pvTx;
+
+    int m_baudRate;
+    int m_rdTimeoutMs;
+    int m_wrTimeoutMs;
+};
+
+#endif // __SBL_TCP_PORT_H__
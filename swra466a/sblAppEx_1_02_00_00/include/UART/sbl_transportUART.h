@@ -0,0 +1,220 @@
+#ifndef __SBL_TRANSPORT_H__
+#define __SBL_TRANSPORT_H__
+/******************************************************************************
+*  Filename:       sbl_transport.h
+*
+*  Description:    Serial Bootloader transport (UART or USB HID) header file.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+#include "sbllibUART.h"
+#include "UART_ComPort.h"
+#include "sbl_hid_portUART.h"
+#include "sbl_tcp_portUART.h"
+#include "sbl_port_lockUART.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define SBL_HID_PORT_PREFIX     "hid:"
+#define SBL_MAX_HID_PORTS       16      // HID bridges looked at to find one by index
+
+// Lock name of the Pi HAT boot (12) and reset (16) GPIOs
+#define SBL_GPIO_LOCK_NAME      "gpio12_16"
+
+//
+// Transport policies. Each one adapts the calls where the port classes
+// differ; readBytes(), writeBytes() and friends have the same signature on
+// both and are called directly.
+//
+
+/// Serial port (tty), optionally with RTS/CTS and Pi HAT GPIO reset
+struct SblUartTransport
+{
+    typedef UART_ComPort Port;
+
+    static int open(Port *pPort, const std::string &csPort, int baudRate, 
+                    int rdTimeoutMs, int wrTimeoutMs, int flags)
+    {
+        return pPort->open(csPort, baudRate, rdTimeoutMs, wrTimeoutMs, flags);
+    }
+    static int setBootloaderMode(Port *pPort, int pigpiodID)
+    {
+        return pPort->setBootloaderMode(pigpiodID);
+    }
+};
+
+/// CP2110 USB HID bridge, through the report batching SblHidPort. No flow
+/// control, and no GPIO reset line.
+struct SblHidTransport
+{
+    typedef SblHidPort Port;
+
+    static int open(Port *pPort, const std::string &csPort, int baudRate, 
+                    int rdTimeoutMs, int wrTimeoutMs, int /*flags*/)
+    {
+        return pPort->open(csPort, baudRate, rdTimeoutMs, wrTimeoutMs, 0);
+    }
+    static int setBootloaderMode(Port *pPort, int /*pigpiodID*/)
+    {
+        return pPort->setBootloaderMode();
+    }
+};
+
+/// Serial port on another machine (raw TCP or RFC 2217). Line settings are
+/// sent on open; bootloader mode is up to the remote fixture.
+struct SblTcpTransport
+{
+    typedef SblTcpPort Port;
+
+    static int open(Port *pPort, const std::string &csPort, int baudRate, 
+                    int rdTimeoutMs, int wrTimeoutMs, int flags)
+    {
+        return pPort->open(csPort, baudRate, rdTimeoutMs, wrTimeoutMs, flags);
+    }
+    static int setBootloaderMode(Port *pPort, int /*pigpiodID*/)
+    {
+        return pPort->setBootloaderMode();
+    }
+};
+
+
+//
+// The port an SblDevice talks through. The transport is picked at runtime
+// from the port name (HID ports are named "hid:<n>", remote ports
+// "tcp://<host>:<port>" or "rfc2217://<host>:<port>"), but the set of
+// transports is closed, so each call is a branch on m_type followed by a
+// direct, inlinable call instead of a virtual call.
+//
+// Local ports are claimed for the process while open (lock file, and
+// TIOCEXCL on ttys), and the Pi HAT GPIOs from the first
+// setBootloaderMode() on a Pi UART until close(). A port another process holds fails
+// to open, and getBusyOwner() tells by whom. A port whose lock file cannot
+// be created fails too, and getLockError() tells why.
+//
+class SblTransport
+{
+public:
+    enum tType {
+        TRANSPORT_UART = SBL_TRANSPORT_UART,
+        TRANSPORT_HID  = SBL_TRANSPORT_HID,
+        TRANSPORT_TCP  = SBL_TRANSPORT_TCP,
+    };
+
+    SblTransport();
+    ~SblTransport();
+
+    int enumerate(ComPortElement*& pComPortList, int& numElements, uint32_t ui32TransportMask = SBL_TRANSPORT_ALL);
+    int open(std::string csPortNumber, int baudRate, int rdTimeoutMs, int wrTimeoutMs, int flags);
+    int close();
+    int setBootloaderMode(int pigpiodID);
+    int setFlowControl(bool bEnable);
+
+    static tType portType(const std::string &csPortNumber);
+
+    tType getType() { return m_type; }
+
+    /// After open() or setBootloaderMode() failed on a claimed resource, the
+    /// PID holding it (-1 if unknown). 0 if nothing was busy.
+    int getBusyOwner() { return m_busyOwner; }
+
+    /// After open() or setBootloaderMode() failed to create a lock file, what
+    /// went wrong. Empty otherwise.
+    std::string getLockError() { return m_csLockError; }
+
+    int readBytes(void *pData, int length)
+    {
+        switch(m_type)
+        {
+        case TRANSPORT_HID: return m_hid.readBytes(pData, length);
+        case TRANSPORT_TCP: return m_tcp.readBytes(pData, length);
+        default:            return m_uart.readBytes(pData, length);
+        }
+    }
+    int writeBytes(void *pData, int length)
+    {
+        switch(m_type)
+        {
+        case TRANSPORT_HID: return m_hid.writeBytes(pData, length);
+        case TRANSPORT_TCP: return m_tcp.writeBytes(pData, length);
+        default:            return m_uart.writeBytes(pData, length);
+        }
+    }
+    int flushBuffers()
+    {
+        switch(m_type)
+        {
+        case TRANSPORT_HID: return m_hid.flushBuffers();
+        case TRANSPORT_TCP: return m_tcp.flushBuffers();
+        default:            return m_uart.flushBuffers();
+        }
+    }
+    bool isInitiated()
+    {
+        switch(m_type)
+        {
+        case TRANSPORT_HID: return m_hid.isInitiated();
+        case TRANSPORT_TCP: return m_tcp.isInitiated();
+        default:            return m_uart.isInitiated();
+        }
+    }
+    int getBaudRate()
+    {
+        switch(m_type)
+        {
+        case TRANSPORT_HID: return m_hid.getBaudRate();
+        case TRANSPORT_TCP: return m_tcp.getBaudRate();
+        default:            return m_uart.getBaudRate();
+        }
+    }
+
+private:
+    tType m_type;
+    UART_ComPort m_uart;
+    SblHidPort m_hid;
+    SblTcpPort m_tcp;
+    std::vector<ComPortElement> m_pvList;
+
+    int claimTty(const std::string &csPortNumber);
+    int takeLock(SblPortLock &lock, const std::string &csName);
+    std::string hidSerial(const std::string &csIndex);
+    static bool isPiUart(const std::string &csTty);
+
+    SblPortLock m_portLock;
+    SblPortLock m_gpioLock;
+    std::string m_csTty;        // Resolved tty name of the open serial port
+    int m_exclFd;               // Our fd on the tty, holding TIOCEXCL
+    int m_busyOwner;
+    std::string m_csLockError;
+};
+
+#endif // __SBL_TRANSPORT_H__
@@ -1,9 +1,9 @@
+#ifndef __SBL_TTY_H__
+#define __SBL_TTY_H__
 /******************************************************************************
-*  Filename:       sbllib.cpp
-*  Revised:        $Date: 2014-12-18 18:51:59 +0100 (to, 18 des 2014) $
-*  Revision:       $Revision: 33858 $
+*  Filename:       sbl_tty.h
 *
-*  Description:    Serial Bootloader Library main file.
+*  Description:    Serial Bootloader tty line control header file.
 *
 *  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
 *
@@ -37,3 +37,17 @@
 *
 ******************************************************************************/
 
+//
+// Line settings of the local tty are owned by UART_ComPort. The functions in
+// this class work on another descriptor of the same tty, the one
+// SblTransport holds TIOCEXCL with. termios settings belong to the tty and
+// not to the descriptor, so changes made here apply to the port UART_ComPort
+// has open.
+//
+class SblTty
+{
+public:
+    static int setFlowControl(int fd, bool bEnable);
+};
+
+#endif // __SBL_TTY_H__
@@ -45,9 +45,22 @@
 #define SBL_DEFAULT_RETRY_COUNT     1
 #define SBL_DEFAULT_READ_TIMEOUT    100 // in ms
 #define SBL_DEFAULT_WRITE_TIMEOUT   200 // in ms
+#define SBL_PROBE_TIMEOUT           50  // in ms
+#define SBL_DEFAULT_CHUNK_RETRIES   3
+#define SBL_DEFAULT_TOTAL_RETRIES   16
+#define SBL_DEFAULT_BACKOFF         10  // in ms
+#define SBL_MAX_BACKOFF             1000 // in ms
+#define SBL_DISCOVER_TIMEOUT        500 // in ms
+#define SBL_PROBE_CACHE_FILE        "sbl_probe_cache"    // in $XDG_CACHE_HOME or ~/.cache
+#define SBL_TRANSPORT_UART          0x01
+#define SBL_TRANSPORT_HID           0x02
+#define SBL_TRANSPORT_TCP           0x04
+#define SBL_TRANSPORT_ALL           (SBL_TRANSPORT_UART | SBL_TRANSPORT_HID | SBL_TRANSPORT_TCP)
 
 typedef enum {
     SBL_SUCCESS = 0,
+    SBL_CANCELLED = -8,
+    SBL_PORT_BUSY_ERROR,
     SBL_UNSUPPORTED_FUNCTION = -6,
     SBL_ENUM_ERROR,
     SBL_PORT_ERROR,
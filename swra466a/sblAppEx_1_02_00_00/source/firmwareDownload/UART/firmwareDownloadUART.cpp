@@ -1,5 +1,9 @@
 #include "sbllibUART.h"
 #include "ComPortElement.h"
+#include "sbl_port_registryUART.h"
+#include "sbl_manifestUART.h"
+#include "sbl_image_prepUART.h"
+#include "sbl_read_cacheUART.h"
 
 #include <vector>
 #include <iostream>
@@ -18,6 +22,7 @@
 #include <sys/time.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 
@@ -30,31 +35,6 @@ double diff_ms(timeval t1, timeval t2)
 }
 
 
-// Calculate crc32 checksum the way CC2538 and CC2650 does it.
-int calcCrcLikeChip(const unsigned char *pData, unsigned long ulByteCount)
-{
-    unsigned long d, ind;
-    unsigned long acc = 0xFFFFFFFF;
-    const unsigned long ulCrcRand32Lut[] =
-    {
-        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 
-        0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C, 
-        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 
-        0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
-    };
-
-    while (ulByteCount--)
-    {
-        d = *pData++;
-        ind = (acc & 0x0F) ^ (d & 0x0F);
-        acc = (acc >> 4) ^ ulCrcRand32Lut[ind];
-        ind = (acc & 0x0F) ^ (d >> 4);
-        acc = (acc >> 4) ^ ulCrcRand32Lut[ind];
-    }
-
-    return (acc ^ 0xFFFFFFFF);
-}
-
 /// Application status function (used as SBL status callback)
 void appStatus(char *pcText, bool bError)
 {
@@ -92,6 +72,23 @@ static void printTimeDelta(void)
     printf("(%.2fms)\n", diff_ms(tAfter, tBefore));
 }
 
+// Waits for the file to be read and CRC'ed. Prints how long that took
+// and how much of it was not hidden behind connecting and erasing.
+static bool waitForImage(SblImagePrep &imagePrep, bool bSilent)
+{
+    if (imagePrep.wait() != SBL_SUCCESS)
+    {
+        cout << imagePrep.getError() << endl;
+        return false;
+    }
+    if (!bSilent)
+    {
+        printf("Image ready: %d bytes, CRC 0x%08x (prepared in %dms, waited %dms)\n", imagePrep.getByteCount(), 
+               imagePrep.getCrc(), imagePrep.getPrepTimeMs(), imagePrep.getWaitTimeMs());
+    }
+    return true;
+}
+
 // Checks to see if the given string is hex
 bool isHexString(string s)
 {
@@ -146,10 +143,13 @@ bool prepareGPIOs(int pigpiodID)
 
 
 // Defines
-#define DEVICE_CC2538				0x2538
-#define DEVICE_CC26XX				0x2650
-#define CC2538_FLASH_BASE			0x00200000
-#define CC26XX_FLASH_BASE			0x00000000
+#define DEVICE_CC2538				SblTraitsCC2538::CHIP_TYPE
+#define DEVICE_AUTO					0x0000
+#define DEVICE_CC26XX				SblTraitsCC2650::CHIP_TYPE
+#define CC2538_FLASH_BASE			((uint32_t)SblTraitsCC2538::FLASH_START_ADDRESS)
+#define CC26XX_FLASH_BASE			((uint32_t)SblTraitsCC2650::FLASH_START_ADDRESS)
+#define DEVICE_RAM_BASE				SblTraitsCC2650::RAM_START_ADDRESS
+#define DUMP_BLOCK_SIZE				4096
 
 // Application main function
 int main(int argc, char* argv[])
@@ -158,8 +158,9 @@ int main(int argc, char* argv[])
 	// START: Program Configuration
 	//
 	/* Device type. (Binary-coded decimal of the device
-	     e.g. 0x2538 for CC2538 and 0x2650 for CC2650) */
-	uint32_t deviceType = DEVICE_CC26XX;
+	     e.g. 0x2538 for CC2538 and 0x2650 for CC2650,
+	     DEVICE_AUTO to detect it when connecting) */
+	uint32_t deviceType = DEVICE_AUTO;
 
 	/* UART baud rate. Default: 460800 */
     uint32_t baudRate = 460800;
@@ -177,21 +178,38 @@ int main(int argc, char* argv[])
     uint32_t fileCrc, devCrc;	   // Variables to save CRC checksum
 	uint32_t devFlashBase;	       // Flash start address
     uint32_t readLength = 0;       // How many bytes to read
-	static std::vector<char> pvWrite(1);// Vector to application firmware in.
-	static std::ifstream file;     // File stream
+    SblImagePrep imagePrep;        // Reads and CRCs the file while the device connects
     std::string filePath;          // File path to program
+    std::string portNum;           // Port to connect to
+    std::string checkpointFile;    // Checkpoint file for resumable download
+    std::string dumpFile;          // File to dump memory to ("-" for stdout)
+    std::string manifestFile;      // Manifest listing the regions to program
+    SblManifest manifest;          // Regions loaded from manifestFile
     bool bEnableXosc = false;      // Should SBL try to enable XOSC? (Not possible for CC26xx)
+    bool bFlowControl = false;     // Should SBL try to use RTS/CTS flow control?
+    bool bKeepBootloader = false;  // Leave the device in bootloader mode when done?
+    bool bBlankCheck = false;      // Skip erasing pages that are already blank?
+    bool bPageVerify = false;      // Check each page by CRC right after writing it?
     bool idxSelected = false;      // Was index inputted in command line
     bool filePathInputted = false; // Was a file path specified
     bool readSelected = false;     // Whether we're in read mode
+    bool scatterSelected = false;  // Whether -r lists several <address>:<length> fields
     bool writeSelected = false;    // Whether we're in write mode
     bool findSelected = false;     // Whether we're in find mode
+    bool dumpSelected = false;     // Whether we're in dump mode
+    bool manifestSelected = false; // Whether we're in manifest mode
+    bool crcCheckSelected = false; // Whether to verify the dump against the device CRC
     bool silentModeSelected = false;  // Whether or not to output raw data to stdout
     bool listPorts = false;        // Whether or not to list ports to user
+    bool discoverPorts = false;    // Whether or not to list ports with a live bootloader
+    bool waitForBoard = false;     // Wait for a USB serial board to be plugged in
+    int waitTimeoutMs = -1;        // How long to wait for it (-1: forever)
     std::string addressInput;      // Inputted address to read from
     std::string writeInput;        // Bytes to write to the device
     std::string searchInput;       // Inputted bytes to search for
     int pigpiodID = 0;             // Pigpio ID for accessing GPIO
+    bool bUseGpio = true;          // Whether the Pi HAT GPIOs drive the bootloader pins
+    uint32_t transportMask = SBL_TRANSPORT_ALL; // Transports to enumerate ports on
 
     
     devFlashBase = CC26XX_FLASH_BASE;
@@ -199,25 +217,27 @@ int main(int argc, char* argv[])
     // Intialise GPIO and set values
     
     
+    // The HID build is now a link to this binary. When started under that
+    // name only CP2110 ports are listed and the Pi HAT GPIOs are left alone.
+    if (strstr(argv[0], "HID") != NULL)
+    {
+        transportMask = SBL_TRANSPORT_HID;
+        bUseGpio = false;
+    }
+
     // Prepare GPIOs
-    if (!prepareGPIOs(pigpiodID)) goto error;
+    if (bUseGpio && !prepareGPIOs(pigpiodID)) goto error;
 
     //
     // Enumerate COM ports
     //
-    pDevice = SblDevice::Create(deviceType);
-    pDevice->enumerate(pElements, nElem);
+    pDevice = SblDevice::Create((deviceType == DEVICE_AUTO) ? DEVICE_CC26XX : deviceType);
+    pDevice->enumerate(pElements, nElem, transportMask);
 
-    if(nElem == 0) 
-    { 
-        cout << "No COM ports detected.\n"; 
-        //cout <<  "+-------------------------------------------------------------\n\n";
-        goto exit;
-    }
 
     opterr = 1;
     int c;
-    while ((c = getopt(argc, argv, "p::l::h::r::n::w::f::s::")) != -1)
+    while ((c = getopt(argc, argv, "p::l::h::r::n::w::f::s::c::k::d::j::o::x::a::m::t::b::v::")) != -1)
     {
         switch (c)
         {
@@ -227,7 +247,10 @@ int main(int argc, char* argv[])
    					cout << "Option -p requires an argument!" << endl;
    					goto exit;
    				}
-                devIdx = strtol(optarg, NULL, 0);
+                // Remote and USB ports are given by name, local ones by index
+                if (strstr(optarg, "://") != NULL || 
+                    strncmp(optarg, SBL_USB_PORT_PREFIX, strlen(SBL_USB_PORT_PREFIX)) == 0) portNum.assign(optarg);
+                else devIdx = strtol(optarg, NULL, 0);
                 idxSelected = true;
                 break;
             case 'l':
@@ -241,6 +264,7 @@ int main(int argc, char* argv[])
                 }
                 readSelected = true;
                 addressInput = optarg;
+                scatterSelected = (strchr(optarg, ',') != NULL || strchr(optarg, ':') != NULL);
                 break;
             case 'n':
                 if (!optarg)
@@ -271,8 +295,66 @@ int main(int argc, char* argv[])
             case 's':
                 silentModeSelected = true;
                 break;
+            case 'c':
+                bFlowControl = true;
+                break;
+            case 'k':
+                bKeepBootloader = true;
+                break;
+            case 'b':
+                bBlankCheck = true;
+                break;
+            case 'v':
+                bPageVerify = true;
+                break;
+            case 'd':
+                discoverPorts = true;
+                break;
+            case 'j':
+                if (!optarg)
+                {
+                    cout << "Option -j requires an argument!" << endl;
+                    goto exit;
+                }
+                checkpointFile = optarg;
+                break;
+            case 'o':
+                if (!optarg)
+                {
+                    cout << "Option -o requires an argument!" << endl;
+                    goto exit;
+                }
+                dumpSelected = true;
+                dumpFile = optarg;
+                // Keep stdout clean for the binary data
+                if (dumpFile == "-") silentModeSelected = true;
+                break;
+            case 'x':
+                crcCheckSelected = true;
+                break;
+            case 'a':
+                waitForBoard = true;
+                if (optarg) waitTimeoutMs = strtol(optarg, NULL, 0) * 1000;
+                break;
+            case 'm':
+                if (!optarg)
+                {
+                    cout << "Option -m requires an argument!" << endl;
+                    goto exit;
+                }
+                manifestSelected = true;
+                manifestFile = optarg;
+                break;
+            case 't':
+                if (!optarg || strchr(optarg, '=') == NULL)
+                {
+                    cout << "Option -t requires an argument NAME=value!" << endl;
+                    goto exit;
+                }
+                manifest.setVariable(std::string(optarg, strchr(optarg, '=') - optarg), strchr(optarg, '=') + 1);
+                break;
             case '?':
-                if (optopt == 'p' || optopt == 'r' || optopt == 'n' || optopt == 'w' || optopt == 'f')
+                if (optopt == 'p' || optopt == 'r' || optopt == 'n' || optopt == 'w' || optopt == 'f' || optopt == 'j' || optopt == 'o' || optopt == 'm' || optopt == 't')
                     cout << "Option -" << optopt << " requires an argument" << endl;
                 goto exit;
             default:
@@ -284,12 +366,31 @@ int main(int argc, char* argv[])
    					 << "Options:\n"
    					 << "\t-h\tShow this screen\n"
    					 << "\t-p\tSelect port number [default: 0]\n"
+                     << "\t\t\t(CP2110 USB-HID ports are listed after the serial ports)\n"
+                     << "\t\t\tA remote port is given as tcp://<host>:<port> (raw TCP)\n\t\t\tor rfc2217://<host>:<port> (e.g. ser2net)\n"
+                     << "\t\t\tA USB serial port is given as usb:<serial number> or\n\t\t\tusb:<physical USB port> (e.g. usb:1-1.2)\n"
    					 << "\t-l\tEnumerate connected devices\n"
+                     << "\t-d\tList ports with a device in bootloader mode (probes all ports at once)\n"
                      << "\t-r\tRead from given address\n\t\t\t(Enter address as int or hex with '0x' in front)\n"
+                     << "\t\t\tSeveral fields are read in one batch with <address>:<length>,...\n"
                      << "\t-w\tWrite to given address\n\t\t\t(Enter address as int or hex with '0x' in front)\n"
-                     << "\t-n\tNumber of bytes to read [1 - 4096]\n"
+                     << "\t-n\tNumber of bytes to read [1 - 4096, no limit with -o]\n"
+                     << "\t-o\tDump memory to binary file ('-' for stdout). Starts at the -r address\n\t\t\t[default: flash start] and reads -n bytes [default: to end of flash/RAM]\n"
+                     << "\t-x\tCheck the dump against a CRC calculated by the device\n"
                      << "\t-f\tSearch for string of bytes\n"
-                     << "\t-s\tSilent mode: will only print error messages"
+                     << "\t-s\tSilent mode: will only print error messages\n"
+                     << "\t-c\tUse RTS/CTS hardware flow control if the device supports it\n"
+                     << "\t-j\tCheckpoint file for a resumable download. Re-run with the same\n\t\t\tfile to resume a failed download\n"
+                     << "\t-k\tKeep the device in bootloader mode (no reset) so the next run reconnects faster\n"
+                     << "\t-b\tCheck pages by CRC before erasing and skip the ones already blank\n"
+                     << "\t-v\tCheck each page by CRC right after writing it and rewrite it on a mismatch\n"
+                     << "\t-a\tWait for a USB serial board to be plugged in and use it\n\t\t\t[optional: timeout in seconds]. With -pusb:<id>, wait for that board\n"
+                     << "\t-m\tProgram all regions of a manifest in one session. One line per entry:\n"
+                     << "\t\t\timage <file> [<address>] [verify=crc|readback|none]\n"
+                     << "\t\t\tccfg <field ID> <value>\n"
+                     << "\t\t\tram32 <address> <word> [<word> ...] [verify=readback|none]\n"
+                     << "\t\t\tpatch <address> 0x<hex bytes>|u16:<n>|u32:<n>|str:<text>\n"
+                     << "\t-t\tSet manifest variable NAME=value, used as ${NAME} in patch data"
    					 << endl;
                 goto exit;
         }
@@ -301,8 +402,11 @@ int main(int argc, char* argv[])
         // Print out header
         //
         cout << "+--------------------------------------------------------------------+\n";
-        cout << "| Serial Bootloader Library Firmware Download Application for CC" 
-            << (deviceType >> 12 & 0xf) << (deviceType >> 8 & 0xf) << (deviceType >> 4 & 0xf) << (deviceType & 0xf) << " |\n";
+        if (deviceType == DEVICE_AUTO)
+            cout << "| Serial Bootloader Library Firmware Download Application            |\n";
+        else
+            cout << "| Serial Bootloader Library Firmware Download Application for CC" 
+                << (deviceType >> 12 & 0xf) << (deviceType >> 8 & 0xf) << (deviceType >> 4 & 0xf) << (deviceType & 0xf) << " |\n";
         cout << "+--------------------------------------------------------------------+\n";
     }
     
@@ -319,7 +423,29 @@ int main(int argc, char* argv[])
         cout << "+--------------------------------------------------------------------+\n";
     }
     
-    if (!((readSelected || readLength) && silentModeSelected))
+    if (discoverPorts)
+    {
+        std::vector<tSblPortInfo> pvPorts;
+        if (!silentModeSelected) getTime();
+        if (pDevice->discover(pvPorts, baudRate) != SBL_SUCCESS) goto error;
+        if (!silentModeSelected) printTimeDelta();
+
+        cout << "+--------------------------------------------------------------------+\n";
+        printf("%-069s|\n", "| Bootloaders:");
+        cout << "+--------------------------------------------------------------------+\n";
+        printf("%-066s|\n", "|Idx\t| Chip\t| Flash\t| Port");
+        for (uint32_t i = 0; i < pvPorts.size(); i++)
+        {
+            int32_t idx = 0;
+            while (idx < nElem && pvPorts[i].csPortNum.compare(pElements[idx].portNumber) != 0) idx++;
+            printf("|%2d\t| CC%04x\t| %3dKB\t| %s\n", idx, pvPorts[i].ui32ChipType, 
+                   pvPorts[i].ui32FlashSize / 1024, pvPorts[i].csPortNum.c_str());
+        }
+        cout << "+--------------------------------------------------------------------+\n";
+        goto exit;
+    }
+
+    if (!((readSelected || readLength || dumpSelected) && silentModeSelected))
     {
         //
         // Set callback functions
@@ -341,27 +467,78 @@ int main(int argc, char* argv[])
         }
     }
 
-    if (!idxSelected)
+    //
+    // Resolve USB identities and wait for hotplugged boards. The registry
+    // follows kernel uevents, so a board is used as soon as its tty appears.
+    //
+    if (waitForBoard || portNum.compare(0, strlen(SBL_USB_PORT_PREFIX), SBL_USB_PORT_PREFIX) == 0)
     {
-        if (nElem == 1)
+        SblPortRegistry registry;
+        tSblUsbPort usbPort;
+        std::string usbId = portNum;
+        bool bFound;
+
+        if (registry.start() != SBL_SUCCESS && waitForBoard)
         {
-            devIdx = 0;
+            cout << "Unable to monitor USB ports." << endl;
+            goto error;
         }
-        else
+
+        bFound = !usbId.empty() && registry.find(usbId, usbPort);
+        if (!bFound && waitForBoard && !silentModeSelected)
         {
-            //
-            // Wait for user to select COM port
-            //
-            cout << "Select COM port index: ";
-            cin >> devIdx;
-    
+            cout << "Waiting for " << (usbId.empty() ? std::string("a board") : usbId) << " to be plugged in ..." << endl;
+        }
+        while (!bFound && waitForBoard && registry.waitForPort(usbPort, waitTimeoutMs))
+        {
+            bFound = usbId.empty() || registry.find(usbId, usbPort);
+        }
+        if (!bFound)
+        {
+            cout << (usbId.empty() ? std::string("No board was found.") : usbId + " was not found.") << endl;
+            goto error;
+        }
+
+        portNum = usbPort.csPortNum;
+        if (!silentModeSelected)
+        {
+            printf("Found %s (%04x:%04x %s, USB port %s)\n", portNum.c_str(), usbPort.ui16Vid, usbPort.ui16Pid,
+                   usbPort.csDescription.c_str(), usbPort.csUsbPath.c_str());
         }
     }
 
-    if(devIdx < 0 || devIdx >= nElem)
+    if (portNum.empty())
     {
-        cout << "Port index out of bounds." << endl;
-        goto error;
+        if(nElem == 0) 
+        { 
+            cout << "No COM ports detected.\n"; 
+            //cout <<  "+-------------------------------------------------------------\n\n";
+            goto exit;
+        }
+
+        if (!idxSelected)
+        {
+            if (nElem == 1)
+            {
+                devIdx = 0;
+            }
+            else
+            {
+                //
+                // Wait for user to select COM port
+                //
+                cout << "Select COM port index: ";
+                cin >> devIdx;
+        
+            }
+        }
+
+        if(devIdx < 0 || devIdx >= nElem)
+        {
+            cout << "Port index out of bounds." << endl;
+            goto error;
+        }
+        portNum = pElements[devIdx].portNumber;
     }
 
     //
@@ -373,13 +550,13 @@ int main(int argc, char* argv[])
         goto error;
     }
 
-    if (readSelected && !readLength)
+    if (readSelected && !readLength && !dumpSelected && !scatterSelected)
     {
         cout << "Please enter the number of bytes to read: ";
         cin >> readLength;
     }
 
-    if (readLength && !readSelected)
+    if (readLength && !readSelected && !dumpSelected)
     {
         cout << "Please enter a memory address to read from: ";
         cin >> addressInput;
@@ -391,13 +568,23 @@ int main(int argc, char* argv[])
         cin >> writeInput;
     }
 
-    if (readSelected && (readLength > 4096 || readLength < 1))
+    if (readSelected && !dumpSelected && !scatterSelected && (readLength > 4096 || readLength < 1))
     {
         cout << "Read Length must be between 1 and 4096" << endl;
         goto error;
     }
 
-    if (!readSelected && !writeSelected && !findSelected)
+    if (manifestSelected)
+    {
+        //
+        // Read the manifest and all its images while connecting
+        //
+        if (imagePrep.start(&manifest, manifestFile) != SBL_SUCCESS)
+        {
+            goto error;
+        }
+    }
+    else if (!readSelected && !writeSelected && !findSelected && !dumpSelected)
     {
         if (!filePathInputted)
         {
@@ -409,28 +596,19 @@ int main(int argc, char* argv[])
         }
 
         //
-        // Read file
+        // Read and CRC the file while connecting and erasing. Only the
+        // size is needed before the write.
         //
-        file.open(filePath.c_str(), std::ios::binary);
-        if(file.is_open())
+        if (imagePrep.start(filePath) != SBL_SUCCESS)
         {
-            //
-            // Get file size:
-            //
-            file.seekg(0, std::ios::end);
-            byteCount = (uint32_t)file.tellg();
-            file.seekg(0, std::ios::beg);
-
-            //
-            // Read data
-            //
-            pvWrite.resize(byteCount);
-            file.read((char*) &pvWrite[0], byteCount);
+            cout << imagePrep.getError();
+            goto error;
         }
-        else   
+        byteCount = imagePrep.getByteCount();
+        if (!byteCount && imagePrep.wait() == SBL_SUCCESS)
         {
-            cout << "Unable to open file path: " << filePath.c_str();
-            goto error;
+            // Not a regular file, the size is known once it has been read
+            byteCount = imagePrep.getByteCount();
         }
     }
 
@@ -439,26 +617,237 @@ int main(int argc, char* argv[])
     //
     if (!silentModeSelected)
     {
-        printf("\nConnecting (%s @ %d baud) ...\n", pElements[devIdx].portNumber, baudRate);
+        printf("\nConnecting (%s @ %d baud) ...\n", portNum.c_str(), baudRate);
         getTime();
     }
-    if (pDevice->connect(pElements[devIdx].portNumber, pigpiodID,  baudRate, bEnableXosc) != SBL_SUCCESS) 
+    if (deviceType == DEVICE_AUTO)
+    {
+        //
+        // The enumeration object is replaced by one for the detected device
+        //
+        delete pDevice;
+        if (SblDevice::CreateAndConnect(pDevice, portNum, pigpiodID, baudRate, bEnableXosc, bFlowControl) != SBL_SUCCESS)
+        {
+            goto error;
+        }
+    }
+    else if (pDevice->connect(portNum, pigpiodID,  baudRate, bEnableXosc, bFlowControl) != SBL_SUCCESS) 
     {
         goto error;
     }
-    if (!silentModeSelected) printTimeDelta();
+    devFlashBase = (SblDevice::getChipType(pDevice->getDeviceId()) == DEVICE_CC2538) ? CC2538_FLASH_BASE : CC26XX_FLASH_BASE;
+    if (!silentModeSelected)
+    {
+        printTimeDelta();
+        printf("Device: CC%04x (ID 0x%08x), %dKB flash\n", SblDevice::getChipType(pDevice->getDeviceId()), 
+               pDevice->getDeviceId(), pDevice->getFlashSize() / 1024);
+        if (pDevice->getFlowControl()) cout << "RTS/CTS flow control enabled" << endl;
+    }
+    imagePrep.setPageSize(pDevice->getPageSize());
+    pDevice->setBlankCheck(bBlankCheck);
+    pDevice->setPageVerify(bPageVerify);
 
-    if (readSelected || writeSelected)
+    if (manifestSelected)
+    {
+        if (imagePrep.wait() != SBL_SUCCESS)
+        {
+            cout << imagePrep.getError() << endl;
+            goto error;
+        }
+        if (!silentModeSelected)
+        {
+            printf("Programming manifest %s (%d images, %d CCFG fields, %d RAM patches) ...\n", manifestFile.c_str(), 
+                   (int)manifest.getRegions().size(), (int)manifest.getCcfgFields().size(), (int)manifest.getRamPatches().size());
+            getTime();
+        }
+        if (manifest.run(pDevice) != SBL_SUCCESS)
+        {
+            cout << manifest.getError() << endl;
+            goto error;
+        }
+        if (!silentModeSelected)
+        {
+            printTimeDelta();
+            for (uint32_t i = 0; i < manifest.getRegions().size(); i++)
+            {
+                const tSblRegion &region = manifest.getRegions()[i];
+                printf("0x%08x %7d bytes %s\n", region.ui32Address, (int)region.pvData.size(), region.csFile.c_str());
+            }
+            printf("%d erase range(s), %d patch(es), verify OK\n", manifest.getEraseRangeCount(), 
+                   (int)manifest.getPatches().size());
+        }
+
+        if (bKeepBootloader) goto exit;
+        if (!silentModeSelected) cout << "Resetting device ...\n";
+        if(pDevice->reset() != SBL_SUCCESS) goto error;
+        if (!silentModeSelected) cout << "OK\n";
+        goto exit;
+    }
+    else if (dumpSelected)
+    {
+        uint32_t dumpAddress = (!readSelected) ? devFlashBase : 
+                               (isHexString(addressInput)) ? strtoul(addressInput.c_str(), NULL, 16) : strtoul(addressInput.c_str(), NULL, 0);
+        
+        //
+        // Without a length, read to the end of the flash or RAM region
+        //
+        if (!readLength)
+        {
+            if (dumpAddress >= devFlashBase && dumpAddress < devFlashBase + pDevice->getFlashSize())
+            {
+                readLength = devFlashBase + pDevice->getFlashSize() - dumpAddress;
+            }
+            else if (dumpAddress >= DEVICE_RAM_BASE && dumpAddress < DEVICE_RAM_BASE + pDevice->getRamSize())
+            {
+                readLength = DEVICE_RAM_BASE + pDevice->getRamSize() - dumpAddress;
+            }
+            else
+            {
+                cerr << "Address 0x" << hex << dumpAddress << dec << " is outside flash and RAM, use -n to set the length." << endl;
+                goto error;
+            }
+        }
+
+        FILE *pFile = (dumpFile == "-") ? stdout : fopen(dumpFile.c_str(), "wb");
+        if (!pFile)
+        {
+            cerr << "Unable to open dump file: " << dumpFile << endl;
+            goto error;
+        }
+        static char pcOutBuf[64 * 1024];
+        setvbuf(pFile, pcOutBuf, _IOFBF, sizeof(pcOutBuf));
+
+        if (!silentModeSelected)
+        {
+            printf("Dumping %d bytes from 0x%08x to %s ...\n", readLength, dumpAddress, dumpFile.c_str());
+            getTime();
+        }
+
+        //
+        // Read block by block and stream each block to the output
+        //
+        std::vector<char> pvBlock(DUMP_BLOCK_SIZE);
+        uint32_t dumpCrc = 0;
+        bool bDumpOk = true;
+        for (uint32_t done = 0; done < readLength && bDumpOk; )
+        {
+            uint32_t blockBytes = GTmin(readLength - done, (uint32_t)DUMP_BLOCK_SIZE);
+            if (pDevice->readMemoryRange(dumpAddress + done, blockBytes, &pvBlock[0]) != SBL_SUCCESS)
+            {
+                cerr << "Error reading from device at 0x" << hex << (dumpAddress + done) << dec << "." << endl;
+                bDumpOk = false;
+                break;
+            }
+            if (fwrite(&pvBlock[0], 1, blockBytes, pFile) != blockBytes)
+            {
+                cerr << "Error writing to dump file." << endl;
+                bDumpOk = false;
+                break;
+            }
+            if (crcCheckSelected) dumpCrc = SblDevice::calcCrc32(&pvBlock[0], blockBytes, dumpCrc);
+            done += blockBytes;
+            if (!silentModeSelected) appProgress((uint32_t)(((uint64_t)done * 100) / readLength));
+        }
+        if (fflush(pFile) != 0) bDumpOk = false;
+        if (pFile != stdout) fclose(pFile);
+        if (!bDumpOk) goto error;
+        if (!silentModeSelected) printTimeDelta();
+
+        if (crcCheckSelected)
+        {
+            if (pDevice->calculateCrc32(dumpAddress, readLength, &devCrc) != SBL_SUCCESS)
+            {
+                goto error;
+            }
+            if (dumpCrc != devCrc)
+            {
+                cerr << "CRC Mismatch! (dump 0x" << hex << dumpCrc << ", device 0x" << devCrc << dec << ")" << endl;
+                goto error;
+            }
+            if (!silentModeSelected) printf("CRC OK (0x%08x)\n", devCrc);
+        }
+
+        if (bKeepBootloader) goto exit;
+        if (!silentModeSelected) cout << "\n\nResetting device ..." << endl;
+        if(pDevice->reset() != SBL_SUCCESS)
+            cerr << "Error resetting device.  Please press the reset button on the PI HAT." << endl;
+        else if (!silentModeSelected) cout << "OK" << endl;
+        goto exit;
+    }
+    else if (readSelected || writeSelected)
     {
         uint32_t realAddress = (isHexString(addressInput)) ? strtol(addressInput.c_str(), NULL, 16) : atoi(addressInput.c_str());
 
-        if (readSelected)
+        if (scatterSelected)
+        {
+            //
+            // Read all fields in one batch, e.g. -r0x500012F0:8,0x50001318:4
+            //
+            std::vector<tSblReadRequest> pvRequests;
+            std::vector<std::string> pvFields;
+            size_t start = 0, end;
+            do
+            {
+                end = addressInput.find(',', start);
+                pvFields.push_back(addressInput.substr(start, end - start));
+                start = end + 1;
+            } while (end != std::string::npos);
+
+            std::vector<std::vector<char> > pvBuffers(pvFields.size());
+            for (uint32_t i = 0; i < pvFields.size(); i++)
+            {
+                tSblReadRequest request;
+                size_t colon = pvFields[i].find(':');
+                request.ui32Address = strtoul(pvFields[i].substr(0, colon).c_str(), NULL, 0);
+                request.ui32ByteCount = (colon == std::string::npos) ? (readLength ? readLength : 4) : 
+                                        strtoul(pvFields[i].substr(colon + 1).c_str(), NULL, 0);
+                if (request.ui32ByteCount < 1 || request.ui32ByteCount > 4096)
+                {
+                    cout << "Read Length must be between 1 and 4096" << endl;
+                    goto error;
+                }
+                pvBuffers[i].resize(request.ui32ByteCount);
+                request.pcData = &pvBuffers[i][0];
+                pvRequests.push_back(request);
+            }
+
+            if (!silentModeSelected)
+            {
+                cout << "Reading " << pvRequests.size() << " fields ..." << endl;
+                getTime();
+            }
+            SblReadCache readCache(pDevice);
+            if (readCache.read(pvRequests) != SBL_SUCCESS)
+            {
+                cout << "Error reading from firmware." << endl;
+                goto error;
+            }
+            if (!silentModeSelected)
+            {
+                printTimeDelta();
+                printf("%d device read(s)\n\n%-08s\tData", readCache.getDeviceReads(), "Address");
+            }
+            for (uint32_t i = 0; i < pvRequests.size(); i++)
+            {
+                static const char pcHex[] = "0123456789abcdef";
+                if (!silentModeSelected) printf("\n0x%08x\t", pvRequests[i].ui32Address);
+                else if (i) putchar(' ');
+                for (uint32_t j = 0; j < pvRequests[i].ui32ByteCount; j++)
+                {
+                    putchar(pcHex[(pvRequests[i].pcData[j] >> 4) & 0x0F]);
+                    putchar(pcHex[pvRequests[i].pcData[j] & 0x0F]);
+                }
+            }
+            cout << endl;
+            fflush(stdout);
+        }
+        else if (readSelected)
         {
             if (!silentModeSelected) cout << "Reading data ..." << endl;    
             char* pcData = new char[readLength];
             
             if (!silentModeSelected) getTime();
-            if (pDevice->readMemory8(realAddress, readLength, pcData) != SBL_SUCCESS)
+            if (pDevice->readMemoryRange(realAddress, readLength, pcData) != SBL_SUCCESS)
             {
                 cout << "Error reading from firmware." << endl;
                 goto error;
@@ -466,13 +855,22 @@ int main(int argc, char* argv[])
             if (!silentModeSelected) printTimeDelta();
 
             if (!silentModeSelected) printf("\n\n%-08s\tData", "Address");
-            for (int i = 0; i < readLength; i++)
+            for (uint32_t i = 0; i < readLength; i += 16)
             {
-                if (!(i % 16))
+                //
+                // Format one line at a time instead of one printf per byte
+                //
+                static const char pcHex[] = "0123456789abcdef";
+                char pcLine[33];
+                uint32_t lineBytes = GTmin(readLength - i, (uint32_t)16);
+                for (uint32_t j = 0; j < lineBytes; j++)
                 {
-                    if (!silentModeSelected) printf("\n0x%08x\t", realAddress + i);
+                    pcLine[2 * j] = pcHex[(pcData[i + j] >> 4) & 0x0F];
+                    pcLine[2 * j + 1] = pcHex[pcData[i + j] & 0x0F];
                 }
-                printf("%02x", pcData[i]);
+                pcLine[2 * lineBytes] = '\0';
+                if (!silentModeSelected) printf("\n0x%08x\t", realAddress + i);
+                fputs(pcLine, stdout);
             }
             cout << endl;
             fflush(stdout);
@@ -512,6 +910,7 @@ int main(int argc, char* argv[])
             if (!silentModeSelected) printTimeDelta();
         }
 
+        if (bKeepBootloader) goto exit;
         if (!silentModeSelected) cout << "\n\nResetting device ..." << endl;
         if(pDevice->reset() != SBL_SUCCESS)
             cout << "Error resetting device.  Please press the reset button on the PI HAT." << endl;
@@ -566,6 +965,7 @@ int main(int argc, char* argv[])
             fflush(stdout);
         }
         
+        if (bKeepBootloader) goto exit;
         if (!silentModeSelected) cout << "\n\nResetting device ..." << endl;
         if(pDevice->reset() != SBL_SUCCESS)
             cout << "Error resetting device.  Please press the reset button on the PI HAT." << endl;
@@ -573,38 +973,58 @@ int main(int argc, char* argv[])
         goto exit;
     }
 
-    //
-    // Calculate file CRC checksum
-    //
-    fileCrc = calcCrcLikeChip((unsigned char *)&pvWrite[0], byteCount);
-
-	//
-	// Erasing as much flash needed to program firmware.
-	//
-    getTime();
-    if (!silentModeSelected)
-    {
-        cout << "Erasing flash ...\n";
-    }
-    if (pDevice->eraseFlashRange(devFlashBase, byteCount) != SBL_SUCCESS)
+    if (!checkpointFile.empty())
     {
-        goto error;
-    }
-    if (!silentModeSelected) printTimeDelta();
+        if (!waitForImage(imagePrep, silentModeSelected)) goto error;
+        pDevice->setPageCrcs(devFlashBase, byteCount, imagePrep.getData(), imagePrep.getPageCrcs());
 
-	//
-	// Writing file to device flash memory.
-	//
-    if (!silentModeSelected)
+        //
+        // Erase and write page by page, resuming an earlier attempt if any
+        //
+        if (!silentModeSelected)
+        {
+            cout << "Erasing and writing flash (checkpoint " << checkpointFile << ") ...\n";
+            getTime();
+        }
+        if (pDevice->writeFlashRangeResumable(devFlashBase, byteCount, imagePrep.getData(), checkpointFile) != SBL_SUCCESS)
+        {
+            goto error;
+        }
+        if (!silentModeSelected) printTimeDelta();
+    }
+    else
     {
-        cout << "Writing flash ...\n";
+		//
+		// Erasing as much flash needed to program firmware.
+		//
         getTime();
-    } 
-    if (pDevice->writeFlashRange(devFlashBase, byteCount, &pvWrite[0]) != SBL_SUCCESS)
-    {
-        goto error;
+        if (!silentModeSelected)
+        {
+            cout << "Erasing flash ...\n";
+        }
+        if (pDevice->eraseFlashRange(devFlashBase, byteCount) != SBL_SUCCESS)
+        {
+            goto error;
+        }
+        if (!silentModeSelected) printTimeDelta();
+        if (bBlankCheck && !silentModeSelected) printf("%d page(s) already blank\n", pDevice->getBlankPageCount());
+
+		//
+		// Writing file to device flash memory.
+		//
+        if (!waitForImage(imagePrep, silentModeSelected)) goto error;
+        pDevice->setPageCrcs(devFlashBase, byteCount, imagePrep.getData(), imagePrep.getPageCrcs());
+        if (!silentModeSelected)
+        {
+            cout << "Writing flash ...\n";
+            getTime();
+        } 
+        if (pDevice->writeFlashRange(devFlashBase, byteCount, imagePrep.getData()) != SBL_SUCCESS)
+        {
+            goto error;
+        }
+        if (!silentModeSelected) printTimeDelta();
     }
-    if (!silentModeSelected) printTimeDelta();
 
 	//
 	// Calculate CRC checksum of flashed content.
@@ -625,12 +1045,14 @@ int main(int argc, char* argv[])
 	// Compare CRC checksums
 	//
     if (!silentModeSelected) cout << "Comparing CRC ...\n";
+    fileCrc = imagePrep.getCrc();
     if (fileCrc == devCrc)
     {
         if (!silentModeSelected) printf("OK\n");
     }
     else printf("CRC Mismatch!\n");
 
+    if (bKeepBootloader) goto exit;
     if (!silentModeSelected) cout << "Resetting device ...\n";
     if(pDevice->reset() != SBL_SUCCESS) goto error;
     if (!silentModeSelected) cout << "OK\n";
@@ -646,7 +1068,7 @@ error:
     else cout << SBL_ERROR << endl;
 exit:
     if (!silentModeSelected) printf("%06sTake off the jumpers and then press the reset button\n%06safter you are done using this program.\n", "Note: ", "");
-	pigpio_stop(pigpiodID);
+	if (bUseGpio) pigpio_stop(pigpiodID);
     devStatus = 0;
 	if(pDevice) {
 		devStatus = pDevice->getLastStatus();
@@ -0,0 +1,1062 @@
+#include "sbllibUART.h"
+#include "sbl_transportUART.h"
+#include "sbl_port_registryUART.h"
+#include "sbl_flash_engineUART.h"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <vector>
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <fstream>
+#include <stdlib.h>
+#include <pigpiod_if2.h>
+
+#include <errno.h>
+#include <grp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <pwd.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+
+using namespace std;
+
+//
+// Long running flash service. Ports, the pigpio connection and images stay
+// open between boards; flash jobs are queued from the control socket, from
+// USB hotplug (-u) or from a fixture GPIO (-g), and run by a pool of worker
+// threads, one job per port at a time.
+//
+// Control socket protocol (one command per line, reply ends with "END"):
+//   flash <port> [<image>]   Queue a job. Reply "OK <job id>" or "ERROR ..."
+//   status                   Queue depth, worker use, throughput, port states
+//   shutdown                 Finish running jobs and exit
+//
+// The socket is made in a directory only the daemon user can write to (not
+// /tmp), with mode 0660. Only root, the daemon user and members of the -G
+// group are served; the peer is checked with SO_PEERCRED.
+//
+
+#define DAEMON_SOCKET_PATH          "/run/sbl/daemon.sock"
+#define DAEMON_SOCKET_MODE          0660        // Owner and -G group may connect
+#define DAEMON_SOCKET_DIR_MODE      0750
+#define DAEMON_WORKERS              4
+#define DAEMON_QUEUE_DEPTH          32
+#define DAEMON_MAX_CLIENTS          16          // Control socket connections served at once
+#define DAEMON_MAX_LINE             4096        // Longest control socket command
+#define DAEMON_BAUD_RATE            460800
+#define DEVICE_CC2538               SblTraitsCC2538::CHIP_TYPE
+#define CC2538_FLASH_BASE           ((uint32_t)SblTraitsCC2538::FLASH_START_ADDRESS)
+#define CC26XX_FLASH_BASE           ((uint32_t)SblTraitsCC2650::FLASH_START_ADDRESS)
+
+// Pi HAT pins, see firmwareDownloadUART
+#define PIHAT_GPIO_BOOT             12
+#define PIHAT_GPIO_RESET            16
+
+
+/// State of a port, as shown by "status"
+typedef enum
+{
+    PORT_IDLE,
+    PORT_QUEUED,
+    PORT_FLASHING,
+    PORT_DONE,
+    PORT_FAILED
+} tPortState;
+
+static const char *portStateString(tPortState state)
+{
+    switch(state)
+    {
+    case PORT_QUEUED:   return "queued";
+    case PORT_FLASHING: return "flashing";
+    case PORT_DONE:     return "done";
+    case PORT_FAILED:   return "failed";
+    default:            return "idle";
+    }
+}
+
+/// A queued flash job
+typedef struct
+{
+    uint32_t    ui32Id;
+    std::string csPort;
+    std::string csImage;
+} tFlashJob;
+
+/// Per port bookkeeping. The device object is kept between jobs.
+typedef struct
+{
+    tPortState  state;
+    bool        bBusy;          // A worker is running a job on the port
+    uint32_t    ui32JobId;      // Current or last job
+    uint32_t    ui32Progress;   // Progress of the current job [%]
+    uint32_t    ui32JobsOk;
+    uint32_t    ui32JobsFailed;
+    double      lastSeconds;    // Duration of the last job
+    std::string csLastError;
+    SblDevice  *pDevice;
+} tPortInfo;
+
+/// An image file, kept in memory until it changes on disk
+typedef struct
+{
+    std::vector<char> pvData;
+    time_t      mtime;
+    off_t       size;
+} tImage;
+
+
+//
+// Daemon configuration and state. All members below m_mutex are protected
+// by it.
+//
+static std::string g_defaultImage;
+static std::string g_socketPath = DAEMON_SOCKET_PATH;
+static std::string g_gpioPort;
+static gid_t g_socketGid = (gid_t)-1;
+static uint32_t g_baudRate = DAEMON_BAUD_RATE;
+static uint32_t g_numWorkers = DAEMON_WORKERS;
+static uint32_t g_maxQueue = DAEMON_QUEUE_DEPTH;
+static int g_gpioPin = -1;
+static int g_pigpiodID = -1;
+static bool g_bVerbose = false;
+static volatile bool g_bStop = false;
+
+static pthread_mutex_t g_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cond = PTHREAD_COND_INITIALIZER;
+static std::deque<tFlashJob> g_queue;
+static std::map<std::string, tPortInfo> g_ports;
+static std::map<std::string, tImage> g_images;
+static uint32_t g_nextJobId = 1;
+static uint32_t g_busyWorkers = 0;
+static bool g_bEngine = false;
+static std::vector<SblFlashEngine *> g_engines;
+static uint32_t g_jobsOk = 0;
+static uint32_t g_jobsFailed = 0;
+static double g_totalBytes = 0;
+static double g_totalSeconds = 0;
+
+// The SBL callbacks are global, so the port a worker runs is kept per thread
+static __thread tPortInfo *tl_pPort = NULL;
+static __thread const char *tl_pcPortName = NULL;
+
+
+/// Log a line with a timestamp
+static void logMsg(const char *pcFmt, ...)
+{
+    char pcTime[32];
+    time_t now = time(NULL);
+    va_list args;
+
+    strftime(pcTime, sizeof(pcTime), "%Y-%m-%d %H:%M:%S", localtime(&now));
+    pthread_mutex_lock(&g_mutex);
+    fprintf(stderr, "%s ", pcTime);
+    va_start(args, pcFmt);
+    vfprintf(stderr, pcFmt, args);
+    va_end(args);
+    pthread_mutex_unlock(&g_mutex);
+}
+
+/// Current time in seconds
+static double nowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/// SBL status callback. Errors are logged with the port they happened on.
+static void daemonStatus(char *pcText, bool bError)
+{
+    if(bError || g_bVerbose)
+    {
+        logMsg("[%s] %s", tl_pcPortName ? tl_pcPortName : "-", pcText);
+    }
+    if(bError && tl_pPort)
+    {
+        pthread_mutex_lock(&g_mutex);
+        tl_pPort->csLastError = pcText;
+        size_t end = tl_pPort->csLastError.find_last_not_of("\r\n ");
+        tl_pPort->csLastError.erase(end == std::string::npos ? 0 : end + 1);
+        pthread_mutex_unlock(&g_mutex);
+    }
+}
+
+
+/// SBL progress callback
+static void daemonProgress(uint32_t progress)
+{
+    if(tl_pPort)
+    {
+        tl_pPort->ui32Progress = progress;
+    }
+}
+
+
+/// Get \e port's entry, creating it if needed. Called with g_mutex held.
+static tPortInfo &getPort(const std::string &csPort)
+{
+    std::map<std::string, tPortInfo>::iterator it = g_ports.find(csPort);
+    if(it == g_ports.end())
+    {
+        tPortInfo info;
+        info.state = PORT_IDLE;
+        info.bBusy = false;
+        info.ui32JobId = 0;
+        info.ui32Progress = 0;
+        info.ui32JobsOk = 0;
+        info.ui32JobsFailed = 0;
+        info.lastSeconds = 0;
+        info.pDevice = NULL;
+        it = g_ports.insert(std::make_pair(csPort, info)).first;
+    }
+    return it->second;
+}
+
+
+/// Cut short the step() of every event engine. Called with g_mutex held.
+static void wakeEngines(void)
+{
+    for(size_t i = 0; i < g_engines.size(); i++)
+    {
+        g_engines[i]->wake();
+    }
+}
+
+
+/// Queue a flash job. Returns the job ID, or 0 with \e csError set.
+static uint32_t queueJob(const std::string &csPort, const std::string &csImage, std::string &csError)
+{
+    uint32_t ui32Id = 0;
+    std::string csPath = csImage.empty() ? g_defaultImage : csImage;
+
+    if(csPath.empty())
+    {
+        csError = "no image given and no default image set";
+        return 0;
+    }
+
+    pthread_mutex_lock(&g_mutex);
+    tPortInfo &port = getPort(csPort);
+    if(g_queue.size() >= g_maxQueue)
+    {
+        csError = "queue full";
+    }
+    else
+    {
+        tFlashJob job;
+        job.ui32Id = ui32Id = g_nextJobId++;
+        job.csPort = csPort;
+        job.csImage = csPath;
+        g_queue.push_back(job);
+        if(!port.bBusy) port.state = PORT_QUEUED;
+        pthread_cond_broadcast(&g_cond);
+        wakeEngines();
+    }
+    pthread_mutex_unlock(&g_mutex);
+
+    if(ui32Id)
+    {
+        logMsg("[%s] job %u queued (%s)\n", csPort.c_str(), ui32Id, csPath.c_str());
+    }
+    return ui32Id;
+}
+
+
+/// Get \e csPath from the image cache, reading it if new or changed on disk.
+/// The returned copy stays valid while the cache is updated by others.
+static bool loadImage(const std::string &csPath, std::vector<char> &pvData)
+{
+    struct stat st;
+    bool bOk = true;
+
+    if(stat(csPath.c_str(), &st) != 0 || st.st_size <= 0)
+    {
+        return false;
+    }
+
+    pthread_mutex_lock(&g_mutex);
+    tImage &image = g_images[csPath];
+    if(image.pvData.empty() || image.mtime != st.st_mtime || image.size != st.st_size)
+    {
+        std::ifstream file(csPath.c_str(), std::ios::binary);
+        image.pvData.resize(st.st_size);
+        image.mtime = st.st_mtime;
+        image.size = st.st_size;
+        bOk = file.read(&image.pvData[0], st.st_size).good();
+        if(!bOk) image.pvData.clear();
+    }
+    if(bOk) pvData = image.pvData;
+    pthread_mutex_unlock(&g_mutex);
+
+    return bOk;
+}
+
+
+/// Connect to \e port's device, reusing its device object if possible.
+static uint32_t connectPort(const std::string &csPort, tPortInfo &port)
+{
+    //
+    // A fixture normally sees the same chip for every board, so the driver
+    // from the last job is tried first. It is replaced if that fails.
+    //
+    if(port.pDevice && port.pDevice->connect(csPort, g_pigpiodID, g_baudRate) == SBL_SUCCESS)
+    {
+        return SBL_SUCCESS;
+    }
+    delete port.pDevice;
+    port.pDevice = NULL;
+
+    SblDevice *pDevice = NULL;
+    uint32_t retCode = SblDevice::CreateAndConnect(pDevice, csPort, g_pigpiodID, g_baudRate);
+    if(retCode != SBL_SUCCESS)
+    {
+        delete pDevice;
+        return retCode;
+    }
+    port.pDevice = pDevice;
+    return SBL_SUCCESS;
+}
+
+
+/// Run one flash job: connect, erase, write, verify CRC and reset
+static bool runJob(const tFlashJob &job, tPortInfo &port)
+{
+    std::vector<char> pvImage;
+    uint32_t devCrc, fileCrc, ui32FlashBase;
+
+    if(!loadImage(job.csImage, pvImage))
+    {
+        daemonStatus((char *)("Unable to read image " + job.csImage + "\n").c_str(), true);
+        return false;
+    }
+
+    if(connectPort(job.csPort, port) != SBL_SUCCESS)
+    {
+        return false;
+    }
+    SblDevice *pDevice = port.pDevice;
+    ui32FlashBase = (SblDevice::getChipType(pDevice->getDeviceId()) == DEVICE_CC2538) ? CC2538_FLASH_BASE : CC26XX_FLASH_BASE;
+
+    fileCrc = SblDevice::calcCrc32(&pvImage[0], pvImage.size());
+    if(pDevice->eraseFlashRange(ui32FlashBase, pvImage.size()) != SBL_SUCCESS ||
+       pDevice->writeFlashRange(ui32FlashBase, pvImage.size(), &pvImage[0]) != SBL_SUCCESS ||
+       pDevice->calculateCrc32(ui32FlashBase, pvImage.size(), &devCrc) != SBL_SUCCESS)
+    {
+        return false;
+    }
+    if(devCrc != fileCrc)
+    {
+        daemonStatus((char *)"CRC mismatch\n", true);
+        return false;
+    }
+
+    return (pDevice->reset() == SBL_SUCCESS);
+}
+
+
+/// Take the oldest job whose port is not busy and mark the port busy.
+/// Called with g_mutex held. Returns the port, or NULL if no job can run.
+static tPortInfo *takeJob(tFlashJob &job)
+{
+    std::deque<tFlashJob>::iterator it = g_queue.begin();
+    while(it != g_queue.end() && getPort(it->csPort).bBusy) ++it;
+    if(it == g_queue.end())
+    {
+        return NULL;
+    }
+
+    job = *it;
+    g_queue.erase(it);
+    tPortInfo &port = getPort(job.csPort);
+    port.bBusy = true;
+    port.state = PORT_FLASHING;
+    port.ui32JobId = job.ui32Id;
+    port.ui32Progress = 0;
+    port.csLastError.clear();
+    g_busyWorkers++;
+
+    // std::map references stay valid while other ports are added
+    return &port;
+}
+
+
+/// Book the result of a job taken with takeJob(). Called with g_mutex held.
+static void finishJob(const tFlashJob &job, bool bOk, double seconds)
+{
+    tPortInfo &port = getPort(job.csPort);
+
+    port.bBusy = false;
+    port.lastSeconds = seconds;
+    port.state = bOk ? PORT_DONE : PORT_FAILED;
+    if(bOk)
+    {
+        port.ui32JobsOk++;
+        g_jobsOk++;
+        g_totalBytes += g_images[job.csImage].size;
+        g_totalSeconds += seconds;
+    }
+    else
+    {
+        port.ui32JobsFailed++;
+        g_jobsFailed++;
+    }
+    for(std::deque<tFlashJob>::iterator it = g_queue.begin(); it != g_queue.end(); ++it)
+    {
+        if(it->csPort == job.csPort) port.state = PORT_QUEUED;
+    }
+    g_busyWorkers--;
+    pthread_cond_broadcast(&g_cond);
+}
+
+
+/// Worker thread. Takes the oldest job whose port is not busy.
+static void *workerThread(void *)
+{
+    tFlashJob job;
+    tPortInfo *pPort;
+
+    pthread_mutex_lock(&g_mutex);
+    while(!g_bStop)
+    {
+        if((pPort = takeJob(job)) == NULL)
+        {
+            pthread_cond_wait(&g_cond, &g_mutex);
+            continue;
+        }
+        pthread_mutex_unlock(&g_mutex);
+
+        tPortInfo &port = *pPort;
+        tl_pPort = &port;
+        tl_pcPortName = job.csPort.c_str();
+        logMsg("[%s] job %u started\n", job.csPort.c_str(), job.ui32Id);
+        double start = nowSeconds();
+        bool bOk = runJob(job, port);
+        double seconds = nowSeconds() - start;
+        logMsg("[%s] job %u %s (%.2f s)\n", job.csPort.c_str(), job.ui32Id, bOk ? "done" : "FAILED", seconds);
+        tl_pPort = NULL;
+        tl_pcPortName = NULL;
+
+        pthread_mutex_lock(&g_mutex);
+        finishJob(job, bOk, seconds);
+    }
+    pthread_mutex_unlock(&g_mutex);
+
+    return NULL;
+}
+
+
+/// A job running on the event engine
+typedef struct
+{
+    tFlashJob   job;
+    tPortInfo  *pPort;
+    double      start;
+} tEngineRun;
+
+/// Event engine thread (-e). Runs its share of the jobs from one epoll loop
+/// instead of a worker thread per board. The engine talks to serial ports
+/// directly and expects the boards to be in bootloader mode already.
+static void *engineThread(void *)
+{
+    SblFlashEngine engine;
+    std::map<int, tEngineRun> running;
+    std::vector<tEngineRun> pvStart;
+    std::vector<char> pvImage;
+    tEngineRun run;
+
+    pthread_mutex_lock(&g_mutex);
+    g_engines.push_back(&engine);
+    pthread_mutex_unlock(&g_mutex);
+
+    while(!g_bStop)
+    {
+        //
+        // Take jobs while this engine runs no more than its share. If that
+        // stops it with jobs left, another engine is below its share.
+        //
+        pthread_mutex_lock(&g_mutex);
+        run.pPort = NULL;
+        while((running.size() + pvStart.size()) * g_engines.size() <= g_busyWorkers)
+        {
+            if((run.pPort = takeJob(run.job)) == NULL) break;
+            pvStart.push_back(run);
+        }
+        if(run.pPort != NULL) wakeEngines();
+        pthread_mutex_unlock(&g_mutex);
+
+        for(size_t i = 0; i < pvStart.size(); i++)
+        {
+            run = pvStart[i];
+            run.start = nowSeconds();
+            logMsg("[%s] job %u started\n", run.job.csPort.c_str(), run.job.ui32Id);
+
+            if(SblTransport::portType(run.job.csPort) != SblTransport::TRANSPORT_UART)
+            {
+                logMsg("[%s] The event engine only drives serial ports\n", run.job.csPort.c_str());
+            }
+            else if(!loadImage(run.job.csImage, pvImage))
+            {
+                logMsg("[%s] Unable to read image %s\n", run.job.csPort.c_str(), run.job.csImage.c_str());
+            }
+            else
+            {
+                running[engine.addJob(run.job.csPort, g_baudRate, &pvImage[0], pvImage.size())] = run;
+                continue;
+            }
+            pthread_mutex_lock(&g_mutex);
+            run.pPort->csLastError = "not started";
+            finishJob(run.job, false, 0);
+            pthread_mutex_unlock(&g_mutex);
+        }
+        pvStart.clear();
+
+        engine.step(500);
+
+        std::map<int, tEngineRun>::iterator it = running.begin();
+        while(it != running.end())
+        {
+            tSblJobState state = engine.getState(it->first);
+            tPortInfo &port = *it->second.pPort;
+            port.ui32Progress = engine.getProgress(it->first);
+            if(engine.isActive(it->first))
+            {
+                ++it;
+                continue;
+            }
+
+            double seconds = nowSeconds() - it->second.start;
+            if(state == SBL_JOB_FAILED)
+            {
+                logMsg("[%s] %s\n", it->second.job.csPort.c_str(), engine.getError(it->first).c_str());
+            }
+            logMsg("[%s] job %u %s (%.2f s)\n", it->second.job.csPort.c_str(), it->second.job.ui32Id, 
+                   (state == SBL_JOB_DONE) ? "done" : "FAILED", seconds);
+
+            pthread_mutex_lock(&g_mutex);
+            port.csLastError = engine.getError(it->first);
+            finishJob(it->second.job, state == SBL_JOB_DONE, seconds);
+            pthread_mutex_unlock(&g_mutex);
+
+            engine.removeJob(it->first);
+            running.erase(it++);
+        }
+    }
+
+    pthread_mutex_lock(&g_mutex);
+    g_engines.erase(std::find(g_engines.begin(), g_engines.end(), &engine));
+    pthread_mutex_unlock(&g_mutex);
+
+    return NULL;
+}
+
+
+/// USB hotplug thread. Queues a job with the default image for every new
+/// USB serial port.
+static void *hotplugThread(void *pArg)
+{
+    SblPortRegistry *pRegistry = (SblPortRegistry *)pArg;
+    tSblUsbPort usbPort;
+    std::string csError;
+
+    while(!g_bStop)
+    {
+        if(pRegistry->waitForPort(usbPort, 500))
+        {
+            logMsg("[%s] plugged in (%04x:%04x %s, USB port %s)\n", usbPort.csPortNum.c_str(),
+                   usbPort.ui16Vid, usbPort.ui16Pid, usbPort.csDescription.c_str(), usbPort.csUsbPath.c_str());
+            if(queueJob(usbPort.csPortNum, "", csError) == 0)
+            {
+                logMsg("[%s] not queued: %s\n", usbPort.csPortNum.c_str(), csError.c_str());
+            }
+        }
+    }
+
+    return NULL;
+}
+
+
+/// Fixture ready GPIO callback (pigpiod thread)
+static void gpioReady(int, unsigned, unsigned, uint32_t)
+{
+    std::string csError;
+    if(queueJob(g_gpioPort, "", csError) == 0)
+    {
+        logMsg("[%s] not queued: %s\n", g_gpioPort.c_str(), csError.c_str());
+    }
+}
+
+
+/// Build the reply to "status"
+static std::string statusReport(void)
+{
+    char pcLine[512];
+    std::string csReply;
+
+    pthread_mutex_lock(&g_mutex);
+    snprintf(pcLine, sizeof(pcLine), "queue %u/%u\n", (uint32_t)g_queue.size(), g_maxQueue);
+    csReply = pcLine;
+    if(g_bEngine)
+    {
+        snprintf(pcLine, sizeof(pcLine), "engines %u running %u\n", g_numWorkers, g_busyWorkers);
+    }
+    else snprintf(pcLine, sizeof(pcLine), "workers %u/%u\n", g_busyWorkers, g_numWorkers);
+    csReply += pcLine;
+    snprintf(pcLine, sizeof(pcLine), "jobs ok %u failed %u\nthroughput %.1f KB/s\n", g_jobsOk, g_jobsFailed,
+             (g_totalSeconds > 0) ? g_totalBytes / 1024 / g_totalSeconds : 0.0);
+    csReply += pcLine;
+    for(std::map<std::string, tPortInfo>::iterator it = g_ports.begin(); it != g_ports.end(); ++it)
+    {
+        tPortInfo &port = it->second;
+        snprintf(pcLine, sizeof(pcLine), "port %s %s job %u progress %u%% ok %u failed %u last %.2fs%s%s\n",
+                 it->first.c_str(), portStateString(port.state), port.ui32JobId, port.ui32Progress,
+                 port.ui32JobsOk, port.ui32JobsFailed, port.lastSeconds,
+                 port.csLastError.empty() ? "" : " error ", port.csLastError.c_str());
+        csReply += pcLine;
+    }
+    pthread_mutex_unlock(&g_mutex);
+
+    return csReply;
+}
+
+
+/// Handle one control socket command
+static std::string handleCommand(const std::string &csLine)
+{
+    char pcCmd[32] = "", pcPort[256] = "", pcImage[1024] = "";
+    std::string csError;
+
+    sscanf(csLine.c_str(), "%31s %255s %1023s", pcCmd, pcPort, pcImage);
+
+    if(strcmp(pcCmd, "flash") == 0 && pcPort[0])
+    {
+        uint32_t ui32Id = queueJob(pcPort, pcImage, csError);
+        if(ui32Id == 0) return "ERROR " + csError + "\n";
+        snprintf(pcCmd, sizeof(pcCmd), "OK %u\n", ui32Id);
+        return pcCmd;
+    }
+    if(strcmp(pcCmd, "status") == 0)
+    {
+        return statusReport();
+    }
+    if(strcmp(pcCmd, "shutdown") == 0)
+    {
+        g_bStop = true;
+        return "OK\n";
+    }
+    return "ERROR unknown command\n";
+}
+
+
+/// Check that the process on the other end of \e fd is root, the daemon user
+/// or in the -G group
+static bool peerAllowed(int fd)
+{
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+
+    if(getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0)
+    {
+        return false;
+    }
+    if(cred.uid == 0 || cred.uid == geteuid())
+    {
+        return true;
+    }
+    if(g_socketGid != (gid_t)-1)
+    {
+        if(cred.gid == g_socketGid)
+        {
+            return true;
+        }
+
+        //
+        // Supplementary groups of the peer's user
+        //
+        struct passwd pw, *pPw = NULL;
+        char pcBuf[1024];
+        if(getpwuid_r(cred.uid, &pw, pcBuf, sizeof(pcBuf), &pPw) == 0 && pPw)
+        {
+            std::vector<gid_t> pvGroups(64);
+            int n = pvGroups.size();
+            if(getgrouplist(pPw->pw_name, pPw->pw_gid, &pvGroups[0], &n) < 0)
+            {
+                pvGroups.resize(n);
+                getgrouplist(pPw->pw_name, pPw->pw_gid, &pvGroups[0], &n);
+            }
+            pvGroups.resize(std::min(n, (int)pvGroups.size()));
+            if(std::find(pvGroups.begin(), pvGroups.end(), g_socketGid) != pvGroups.end())
+            {
+                return true;
+            }
+        }
+    }
+    logMsg("Control socket: refused pid %d uid %d\n", (int)cred.pid, (int)cred.uid);
+    return false;
+}
+
+
+/// A control socket client
+typedef struct
+{
+    int         fd;
+    std::string csIn;           // Received, not yet a whole line
+    std::string csOut;          // Replies not yet written
+} tClient;
+
+
+/// Read what \e client sent and queue the replies to its whole lines.
+/// Returns false if the client hung up or misbehaved.
+static bool readClient(tClient &client)
+{
+    char pcBuf[512];
+    int ret = read(client.fd, pcBuf, sizeof(pcBuf));
+
+    if(ret < 0 && (errno == EAGAIN || errno == EINTR)) return true;
+    if(ret <= 0) return false;
+    client.csIn.append(pcBuf, ret);
+
+    size_t eol;
+    while((eol = client.csIn.find('\n')) != std::string::npos)
+    {
+        client.csOut += handleCommand(client.csIn.substr(0, eol)) + "END\n";
+        client.csIn.erase(0, eol + 1);
+    }
+    return client.csIn.size() <= DAEMON_MAX_LINE;
+}
+
+
+/// Write what can be written of the replies to \e client. Returns false if
+/// the client is gone.
+static bool writeClient(tClient &client)
+{
+    int ret = write(client.fd, client.csOut.c_str(), client.csOut.size());
+
+    if(ret < 0) return (errno == EAGAIN || errno == EINTR);
+    client.csOut.erase(0, ret);
+    return true;
+}
+
+
+/// Serve the control socket until shutdown. All clients are served from one
+/// poll() loop, so a client that stays connected (or stops reading its
+/// replies) does not keep the others waiting.
+static void serveControlSocket(int sock)
+{
+    std::vector<tClient> pvClients;
+    std::vector<struct pollfd> pvFds;
+
+    while(!g_bStop)
+    {
+        pvFds.resize(1 + pvClients.size());
+        pvFds[0].fd = sock;
+        pvFds[0].events = (pvClients.size() < DAEMON_MAX_CLIENTS) ? POLLIN : 0;
+        for(size_t i = 0; i < pvClients.size(); i++)
+        {
+            pvFds[i + 1].fd = pvClients[i].fd;
+            pvFds[i + 1].events = pvClients[i].csOut.empty() ? POLLIN : POLLOUT;
+        }
+        if(poll(&pvFds[0], pvFds.size(), 200) <= 0) continue;
+
+        //
+        // Serve the clients polled, dropping the ones that are done. New
+        // clients go to the end and are polled next round.
+        //
+        size_t n = 0;
+        for(size_t i = 0; i < pvClients.size(); i++)
+        {
+            short revents = pvFds[i + 1].revents;
+            bool bKeep = true;
+
+            if(revents & POLLOUT) bKeep = writeClient(pvClients[i]);
+            else if(revents & (POLLIN | POLLHUP | POLLERR))
+            {
+                bKeep = readClient(pvClients[i]) && writeClient(pvClients[i]);
+            }
+
+            if(bKeep) pvClients[n++] = pvClients[i];
+            else close(pvClients[i].fd);
+        }
+        pvClients.resize(n);
+
+        if(pvFds[0].revents & POLLIN)
+        {
+            tClient client;
+            if((client.fd = accept4(sock, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+            {
+                if(peerAllowed(client.fd)) pvClients.push_back(client);
+                else close(client.fd);
+            }
+        }
+    }
+
+    for(size_t i = 0; i < pvClients.size(); i++)
+    {
+        close(pvClients[i].fd);
+    }
+}
+
+
+/// Make the directory of the control socket if needed, and check that no
+/// one but the daemon user (and the -G group) can write to it, so the socket
+/// cannot be replaced under us.
+static bool prepareSocketDir(const std::string &csDir)
+{
+    struct stat st;
+
+    if(mkdir(csDir.c_str(), DAEMON_SOCKET_DIR_MODE) == 0 && g_socketGid != (gid_t)-1 &&
+       chown(csDir.c_str(), (uid_t)-1, g_socketGid) != 0)
+    {
+        logMsg("Unable to set the group of %s: %s\n", csDir.c_str(), strerror(errno));
+        return false;
+    }
+    if(lstat(csDir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode))
+    {
+        logMsg("Socket directory %s is not a directory\n", csDir.c_str());
+        return false;
+    }
+    if(st.st_uid != geteuid() || (st.st_mode & S_IWOTH) ||
+       ((st.st_mode & S_IWGRP) && st.st_gid != g_socketGid))
+    {
+        logMsg("Socket directory %s must be owned by the daemon user and not writable by others\n", csDir.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+/// Open the control socket
+static int openControlSocket(void)
+{
+    struct sockaddr_un addr;
+    struct stat st;
+    size_t slash = g_socketPath.rfind('/');
+    int sock;
+
+    if(g_socketPath.size() >= sizeof(addr.sun_path) ||
+       !prepareSocketDir((slash == std::string::npos) ? "." : (slash == 0) ? "/" : g_socketPath.substr(0, slash)))
+    {
+        return -1;
+    }
+
+    //
+    // Only a stale socket of ours is removed
+    //
+    if(lstat(g_socketPath.c_str(), &st) == 0)
+    {
+        if(!S_ISSOCK(st.st_mode))
+        {
+            logMsg("%s exists and is not a socket\n", g_socketPath.c_str());
+            return -1;
+        }
+        unlink(g_socketPath.c_str());
+    }
+
+    if((sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0)
+    {
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, g_socketPath.c_str());
+
+    //
+    // The umask keeps the socket from being open to others even for the
+    // moment between bind() and chmod()
+    //
+    mode_t oldMask = umask(0777 & ~DAEMON_SOCKET_MODE);
+    int ret = bind(sock, (struct sockaddr *)&addr, sizeof(addr));
+    umask(oldMask);
+    if(ret != 0 || chmod(g_socketPath.c_str(), DAEMON_SOCKET_MODE) != 0 ||
+       (g_socketGid != (gid_t)-1 && chown(g_socketPath.c_str(), (uid_t)-1, g_socketGid) != 0) ||
+       listen(sock, DAEMON_MAX_CLIENTS) != 0)
+    {
+        logMsg("Unable to set up %s: %s\n", g_socketPath.c_str(), strerror(errno));
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+
+/// Connect to pigpiod and set up the Pi HAT pins. Unlike firmwareDownloadUART
+/// the HAT is not reset here; that happens once per board in connect().
+static void prepareGPIOs(void)
+{
+    if((g_pigpiodID = pigpio_start(NULL, NULL)) < 0)
+    {
+        // -1 also keeps the ports from claiming the GPIOs
+        logMsg("pigpiod not available, GPIO bootloader entry disabled\n");
+        g_pigpiodID = -1;
+        return;
+    }
+    set_mode(g_pigpiodID, PIHAT_GPIO_BOOT, PI_OUTPUT);
+    set_mode(g_pigpiodID, PIHAT_GPIO_RESET, PI_OUTPUT);
+
+    if(g_gpioPin >= 0)
+    {
+        set_mode(g_pigpiodID, g_gpioPin, PI_INPUT);
+        set_pull_up_down(g_pigpiodID, g_gpioPin, PI_PUD_UP);
+        if(callback(g_pigpiodID, g_gpioPin, RISING_EDGE, &gpioReady) < 0)
+        {
+            logMsg("Unable to watch GPIO %d\n", g_gpioPin);
+        }
+    }
+}
+
+
+static void onSignal(int)
+{
+    g_bStop = true;
+}
+
+
+static void printUsage(void)
+{
+    cout << "Flash daemon: keeps ports open and flashes boards from a job queue\n"
+         << "Usage:\n"
+         << "\tsudo ./flashDaemonUART [options]\n"
+         << "Options:\n"
+         << "\t-h\tShow this screen\n"
+         << "\t-i\tDefault image (used by hotplug, GPIO and 'flash <port>' jobs)\n"
+         << "\t-s\tControl socket path [default: " DAEMON_SOCKET_PATH "]\n"
+         << "\t-G\tGroup allowed to use the control socket [default: none]\n"
+         << "\t-w\tNumber of workers [default: " << DAEMON_WORKERS << "]\n"
+         << "\t-e\tRun serial jobs on event loops instead of workers, -w gives the number of loops\n"
+         << "\t-q\tMax queued jobs [default: " << DAEMON_QUEUE_DEPTH << "]\n"
+         << "\t-b\tBaud rate [default: " << DAEMON_BAUD_RATE << "]\n"
+         << "\t-u\tFlash every USB serial board that is plugged in\n"
+         << "\t-g\tFlash the -P port when this GPIO goes high (fixture ready)\n"
+         << "\t-P\tPort flashed on a -g signal\n"
+         << "\t-v\tLog all status messages\n"
+         << "Control socket commands: flash <port> [<image>], status, shutdown"
+         << endl;
+}
+
+
+int main(int argc, char* argv[])
+{
+    SblPortRegistry registry;
+    std::vector<pthread_t> pvWorkers;
+    pthread_t hotplug;
+    bool bHotplug = false;
+    int c, sock;
+
+    while ((c = getopt(argc, argv, "i:s:G:w:q:b:g:P:euvh")) != -1)
+    {
+        switch (c)
+        {
+            case 'i': g_defaultImage = optarg; break;
+            case 's': g_socketPath = optarg; break;
+            case 'G':
+            {
+                struct group *pGroup = getgrnam(optarg);
+                if(pGroup == NULL)
+                {
+                    cout << "Unknown group " << optarg << endl;
+                    return 1;
+                }
+                g_socketGid = pGroup->gr_gid;
+                break;
+            }
+            case 'w': g_numWorkers = strtoul(optarg, NULL, 0); break;
+            case 'q': g_maxQueue = strtoul(optarg, NULL, 0); break;
+            case 'b': g_baudRate = strtoul(optarg, NULL, 0); break;
+            case 'g': g_gpioPin = strtol(optarg, NULL, 0); break;
+            case 'P': g_gpioPort = optarg; break;
+            case 'e': g_bEngine = true; break;
+            case 'u': bHotplug = true; break;
+            case 'v': g_bVerbose = true; break;
+            default:
+                printUsage();
+                return 1;
+        }
+    }
+    if(g_numWorkers == 0 || (g_gpioPin >= 0 && g_gpioPort.empty()) ||
+       ((bHotplug || g_gpioPin >= 0) && g_defaultImage.empty()))
+    {
+        printUsage();
+        return 1;
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    SblDevice::setCallBackStatusFunction(&daemonStatus);
+    SblDevice::setCallBackProgressFunction(&daemonProgress);
+
+    if((sock = openControlSocket()) < 0)
+    {
+        logMsg("Unable to open control socket %s\n", g_socketPath.c_str());
+        return 1;
+    }
+
+    prepareGPIOs();
+
+    //
+    // A worker runs one board at a time, an engine any number
+    //
+    pvWorkers.resize(g_numWorkers);
+    for(uint32_t i = 0; i < g_numWorkers; i++)
+    {
+        pthread_create(&pvWorkers[i], NULL, (g_bEngine) ? &engineThread : &workerThread, NULL);
+    }
+
+    if(bHotplug)
+    {
+        if(registry.start() != SBL_SUCCESS)
+        {
+            logMsg("Unable to monitor USB ports, hotplug disabled\n");
+            bHotplug = false;
+        }
+        else pthread_create(&hotplug, NULL, &hotplugThread, &registry);
+    }
+
+    if(g_bEngine)
+    {
+        logMsg("Ready: %u event engines, queue %u, socket %s\n", g_numWorkers, g_maxQueue, g_socketPath.c_str());
+    }
+    else logMsg("Ready: %u workers, queue %u, socket %s\n", g_numWorkers, g_maxQueue, g_socketPath.c_str());
+
+    serveControlSocket(sock);
+
+    logMsg("Shutting down\n");
+    pthread_mutex_lock(&g_mutex);
+    g_queue.clear();
+    pthread_cond_broadcast(&g_cond);
+    wakeEngines();
+    pthread_mutex_unlock(&g_mutex);
+    for(uint32_t i = 0; i < g_numWorkers; i++)
+    {
+        pthread_join(pvWorkers[i], NULL);
+    }
+    if(bHotplug)
+    {
+        pthread_join(hotplug, NULL);
+    }
+
+    for(std::map<std::string, tPortInfo>::iterator it = g_ports.begin(); it != g_ports.end(); ++it)
+    {
+        delete it->second.pDevice;
+    }
+    close(sock);
+    unlink(g_socketPath.c_str());
+    if(g_pigpiodID >= 0) pigpio_stop(g_pigpiodID);
+
+    return 0;
+}
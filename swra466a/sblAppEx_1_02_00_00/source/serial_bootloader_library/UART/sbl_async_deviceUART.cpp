@@ -0,0 +1,721 @@
+/******************************************************************************
+*  Filename:       sbl_async_device.cpp
+*
+*  Description:    Serial Bootloader asynchronous device interface file.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+
+
+#include "sbl_async_deviceUART.h"
+
+#include <time.h>
+
+
+//-----------------------------------------------------------------------------
+/** \brief Milliseconds from a monotonic clock
+ */
+//-----------------------------------------------------------------------------
+static uint64_t
+getTimeMs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Initialize a condition variable that waits on the monotonic clock
+ */
+//-----------------------------------------------------------------------------
+static void
+initMonotonicCond(pthread_cond_t *pCond)
+{
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(pCond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Constructor. The operation starts with two references, one for the
+ *      caller and one for the executor.
+ */
+//-----------------------------------------------------------------------------
+SblOperation::SblOperation(tSblOpType type, uint32_t ui32TimeoutMs, tSblCompleteFPTR pfnComplete, void *pvUser)
+{
+    m_type = type;
+    m_ui32Address = 0;
+    m_ui32ByteCount = 0;
+    m_pcWriteData = NULL;
+    m_pcReadData = NULL;
+    m_ui32BaudRate = 0;
+    m_pigpiodID = -1;
+
+    m_ui32TimeoutMs = ui32TimeoutMs;
+    m_ui64DeadlineMs = (ui32TimeoutMs) ? getTimeMs() + ui32TimeoutMs : 0;
+    m_pfnComplete = pfnComplete;
+    m_pvUser = pvUser;
+    m_pOwner = NULL;
+
+    pthread_mutex_init(&m_mutex, NULL);
+    initMonotonicCond(&m_cond);
+    m_refCount = 2;
+    m_bDone = false;
+    m_bCancel = false;
+    m_ui32Status = SBL_SUCCESS;
+    m_ui32Result = 0;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Destructor
+ */
+//-----------------------------------------------------------------------------
+SblOperation::~SblOperation()
+{
+    pthread_cond_destroy(&m_cond);
+    pthread_mutex_destroy(&m_mutex);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Has the operation completed?
+ *
+ * \return
+ *      Returns true if the operation has completed, successfully or not.
+ */
+//-----------------------------------------------------------------------------
+bool
+SblOperation::isDone()
+{
+    pthread_mutex_lock(&m_mutex);
+    bool bDone = m_bDone;
+    pthread_mutex_unlock(&m_mutex);
+
+    return bDone;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Wait for the operation to complete.
+ *
+ * \param[in] timeoutMs
+ *      How long to wait. A negative value waits forever. This only limits
+ *      the wait; the operation itself keeps running.
+ *
+ * \return
+ *      Returns true if the operation has completed, false on timeout.
+ */
+//-----------------------------------------------------------------------------
+bool
+SblOperation::wait(int timeoutMs)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    if(timeoutMs >= 0)
+    {
+        ts.tv_sec += timeoutMs / 1000;
+        ts.tv_nsec += (timeoutMs % 1000) * 1000000L;
+        if(ts.tv_nsec >= 1000000000L)
+        {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+    }
+
+    pthread_mutex_lock(&m_mutex);
+    while(!m_bDone)
+    {
+        int ret = (timeoutMs < 0) ? pthread_cond_wait(&m_cond, &m_mutex) :
+                                    pthread_cond_timedwait(&m_cond, &m_mutex, &ts);
+        if(ret != 0)
+        {
+            break;
+        }
+    }
+    bool bDone = m_bDone;
+    pthread_mutex_unlock(&m_mutex);
+
+    return bDone;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Cancel the operation. A queued operation completes at once with
+ *      SBL_CANCELLED; a running one completes with SBL_CANCELLED at its next
+ *      wait for the device.
+ *
+ * \return
+ *      Returns true if the operation will complete as cancelled, false if
+ *      it has already completed.
+ */
+//-----------------------------------------------------------------------------
+bool
+SblOperation::cancel()
+{
+    pthread_mutex_lock(&m_mutex);
+    if(m_bDone || m_pOwner == NULL)
+    {
+        pthread_mutex_unlock(&m_mutex);
+        return false;
+    }
+    m_bCancel = true;
+    SblAsyncDevice *pOwner = m_pOwner;
+    pthread_mutex_unlock(&m_mutex);
+
+    return pOwner->cancel(this);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Drop the caller's reference. The operation must not be used after
+ *      this. An operation still running is not cancelled by release().
+ */
+//-----------------------------------------------------------------------------
+void
+SblOperation::release()
+{
+    pthread_mutex_lock(&m_mutex);
+    bool bLast = (--m_refCount == 0);
+    pthread_mutex_unlock(&m_mutex);
+
+    if(bLast)
+    {
+        delete this;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Get the status of a completed operation.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, SBL_CANCELLED, SBL_TIMEOUT_ERROR, ... or
+ *      SBL_ERROR if the operation has not completed.
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblOperation::getStatus()
+{
+    pthread_mutex_lock(&m_mutex);
+    uint32_t ui32Status = (m_bDone) ? m_ui32Status : (uint32_t)SBL_ERROR;
+    pthread_mutex_unlock(&m_mutex);
+
+    return ui32Status;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Get the value produced by a completed operation, the CRC32 for
+ *      calculateCrc32().
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblOperation::getResult()
+{
+    pthread_mutex_lock(&m_mutex);
+    uint32_t ui32Result = m_ui32Result;
+    pthread_mutex_unlock(&m_mutex);
+
+    return ui32Result;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Get the error reported by a failed operation.
+ */
+//-----------------------------------------------------------------------------
+std::string
+SblOperation::getError()
+{
+    pthread_mutex_lock(&m_mutex);
+    std::string csError = m_csError;
+    pthread_mutex_unlock(&m_mutex);
+
+    return csError;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Mark the operation completed, wake waiters, call the completion
+ *      callback and drop the executor's reference.
+ */
+//-----------------------------------------------------------------------------
+void
+SblOperation::complete(uint32_t ui32Status, const std::string &csError)
+{
+    pthread_mutex_lock(&m_mutex);
+    m_ui32Status = ui32Status;
+    m_csError = (ui32Status == SBL_SUCCESS) ? "" : csError;
+    m_bDone = true;
+    m_pOwner = NULL;
+    pthread_cond_broadcast(&m_cond);
+    pthread_mutex_unlock(&m_mutex);
+
+    if(m_pfnComplete)
+    {
+        m_pfnComplete(this, m_pvUser);
+    }
+    release();
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Constructor
+ *
+ * \param[in] pDevice
+ *      The device to run operations on, created with SblDevice::Create().
+ *      It is not deleted by SblAsyncDevice, and must not be used directly
+ *      while operations are queued.
+ */
+//-----------------------------------------------------------------------------
+SblAsyncDevice::SblAsyncDevice(SblDevice *pDevice)
+{
+    m_pDevice = pDevice;
+    m_bStarted = false;
+    m_bStop = false;
+    m_pRunning = NULL;
+
+    pthread_mutex_init(&m_mutex, NULL);
+    pthread_cond_init(&m_cond, NULL);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Destructor. Cancels all operations.
+ */
+//-----------------------------------------------------------------------------
+SblAsyncDevice::~SblAsyncDevice()
+{
+    stop();
+    pthread_cond_destroy(&m_cond);
+    pthread_mutex_destroy(&m_mutex);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Start the executor thread. Called by the first operation queued if
+ *      not called before.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, or SBL_ERROR if the thread cannot be created.
+ */
+//-----------------------------------------------------------------------------
+int
+SblAsyncDevice::start()
+{
+    pthread_mutex_lock(&m_mutex);
+    if(!m_bStarted)
+    {
+        m_bStop = false;
+        m_bStarted = (pthread_create(&m_thread, NULL, &SblAsyncDevice::executorThread, this) == 0);
+    }
+    bool bStarted = m_bStarted;
+    pthread_mutex_unlock(&m_mutex);
+
+    return (bStarted) ? SBL_SUCCESS : SBL_ERROR;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Cancel all queued and running operations and stop the executor
+ *      thread. Returns when the running operation, if any, has completed.
+ */
+//-----------------------------------------------------------------------------
+void
+SblAsyncDevice::stop()
+{
+    std::deque<SblOperation *> queued;
+
+    pthread_mutex_lock(&m_mutex);
+    if(!m_bStarted)
+    {
+        pthread_mutex_unlock(&m_mutex);
+        return;
+    }
+    m_bStop = true;
+    queued.swap(m_queue);
+    if(m_pRunning)
+    {
+        m_pDevice->cancel();
+    }
+    pthread_cond_broadcast(&m_cond);
+    pthread_mutex_unlock(&m_mutex);
+
+    for(size_t i = 0; i < queued.size(); i++)
+    {
+        queued[i]->complete(SBL_CANCELLED, "Operation cancelled.\n");
+    }
+
+    pthread_join(m_thread, NULL);
+    pthread_mutex_lock(&m_mutex);
+    m_bStarted = false;
+    pthread_mutex_unlock(&m_mutex);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Get the number of operations queued or running.
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblAsyncDevice::getPending()
+{
+    pthread_mutex_lock(&m_mutex);
+    uint32_t ui32Pending = m_queue.size() + ((m_pRunning) ? 1 : 0);
+    pthread_mutex_unlock(&m_mutex);
+
+    return ui32Pending;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Queue a connect(). The device must have been created for the
+ *      right chip type.
+ *
+ * \param[in] ui32TimeoutMs
+ *      Deadline for the operation, counted from now. 0 for none.
+ * \param[in] pfnComplete
+ *      Called when the operation completes, or NULL.
+ * \param[in] pvUser
+ *      Passed to \e pfnComplete.
+ *
+ * \return
+ *      Returns the operation. The caller must release() it.
+ */
+//-----------------------------------------------------------------------------
+SblOperation *
+SblAsyncDevice::connect(std::string csPortNum, int pigpiodID, uint32_t ui32BaudRate, uint32_t ui32TimeoutMs, 
+                        tSblCompleteFPTR pfnComplete, void *pvUser)
+{
+    SblOperation *pOp = new SblOperation(SBL_OP_CONNECT, ui32TimeoutMs, pfnComplete, pvUser);
+    pOp->m_csPortNum = csPortNum;
+    pOp->m_pigpiodID = pigpiodID;
+    pOp->m_ui32BaudRate = ui32BaudRate;
+
+    return submit(pOp);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Queue a ping(). See connect() for the common parameters.
+ */
+//-----------------------------------------------------------------------------
+SblOperation *
+SblAsyncDevice::ping(uint32_t ui32TimeoutMs, tSblCompleteFPTR pfnComplete, void *pvUser)
+{
+    return submit(new SblOperation(SBL_OP_PING, ui32TimeoutMs, pfnComplete, pvUser));
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Queue an eraseFlashRange(). See connect() for the common
+ *      parameters.
+ */
+//-----------------------------------------------------------------------------
+SblOperation *
+SblAsyncDevice::eraseFlashRange(uint32_t ui32StartAddress, uint32_t ui32ByteCount, uint32_t ui32TimeoutMs, 
+                                tSblCompleteFPTR pfnComplete, void *pvUser)
+{
+    SblOperation *pOp = new SblOperation(SBL_OP_ERASE, ui32TimeoutMs, pfnComplete, pvUser);
+    pOp->m_ui32Address = ui32StartAddress;
+    pOp->m_ui32ByteCount = ui32ByteCount;
+
+    return submit(pOp);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Queue a writeFlashRange(). \e pcData must stay valid until the
+ *      operation completes. See connect() for the common parameters.
+ */
+//-----------------------------------------------------------------------------
+SblOperation *
+SblAsyncDevice::writeFlashRange(uint32_t ui32StartAddress, uint32_t ui32ByteCount, const char *pcData, 
+                                uint32_t ui32TimeoutMs, tSblCompleteFPTR pfnComplete, void *pvUser)
+{
+    SblOperation *pOp = new SblOperation(SBL_OP_WRITE, ui32TimeoutMs, pfnComplete, pvUser);
+    pOp->m_ui32Address = ui32StartAddress;
+    pOp->m_ui32ByteCount = ui32ByteCount;
+    pOp->m_pcWriteData = pcData;
+
+    return submit(pOp);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Queue a readMemoryRange(). \e pcData must stay valid until the
+ *      operation completes. See connect() for the common parameters.
+ */
+//-----------------------------------------------------------------------------
+SblOperation *
+SblAsyncDevice::readMemoryRange(uint32_t ui32StartAddress, uint32_t ui32ByteCount, char *pcData, 
+                                uint32_t ui32TimeoutMs, tSblCompleteFPTR pfnComplete, void *pvUser)
+{
+    SblOperation *pOp = new SblOperation(SBL_OP_READ, ui32TimeoutMs, pfnComplete, pvUser);
+    pOp->m_ui32Address = ui32StartAddress;
+    pOp->m_ui32ByteCount = ui32ByteCount;
+    pOp->m_pcReadData = pcData;
+
+    return submit(pOp);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Queue a calculateCrc32(). The CRC is returned by
+ *      SblOperation::getResult(). See connect() for the common parameters.
+ */
+//-----------------------------------------------------------------------------
+SblOperation *
+SblAsyncDevice::calculateCrc32(uint32_t ui32StartAddress, uint32_t ui32ByteCount, uint32_t ui32TimeoutMs, 
+                               tSblCompleteFPTR pfnComplete, void *pvUser)
+{
+    SblOperation *pOp = new SblOperation(SBL_OP_CRC32, ui32TimeoutMs, pfnComplete, pvUser);
+    pOp->m_ui32Address = ui32StartAddress;
+    pOp->m_ui32ByteCount = ui32ByteCount;
+
+    return submit(pOp);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Queue a reset(). See connect() for the common parameters.
+ */
+//-----------------------------------------------------------------------------
+SblOperation *
+SblAsyncDevice::reset(uint32_t ui32TimeoutMs, tSblCompleteFPTR pfnComplete, void *pvUser)
+{
+    return submit(new SblOperation(SBL_OP_RESET, ui32TimeoutMs, pfnComplete, pvUser));
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Put an operation on the queue, starting the executor if needed.
+ *      The operation is completed with SBL_ERROR if the executor cannot be
+ *      started.
+ *
+ * \return
+ *      Returns \e pOp.
+ */
+//-----------------------------------------------------------------------------
+SblOperation *
+SblAsyncDevice::submit(SblOperation *pOp)
+{
+    start();
+
+    pthread_mutex_lock(&m_mutex);
+    if(!m_bStarted || m_bStop)
+    {
+        pthread_mutex_unlock(&m_mutex);
+        pOp->complete(SBL_ERROR, "Unable to start the device executor.\n");
+        return pOp;
+    }
+    pOp->m_pOwner = this;
+    m_queue.push_back(pOp);
+    pthread_cond_broadcast(&m_cond);
+    pthread_mutex_unlock(&m_mutex);
+
+    return pOp;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Cancel \e pOp, see SblOperation::cancel().
+ *
+ * \return
+ *      Returns true if the operation will complete as cancelled.
+ */
+//-----------------------------------------------------------------------------
+bool
+SblAsyncDevice::cancel(SblOperation *pOp)
+{
+    pthread_mutex_lock(&m_mutex);
+    for(std::deque<SblOperation *>::iterator it = m_queue.begin(); it != m_queue.end(); ++it)
+    {
+        if(*it == pOp)
+        {
+            m_queue.erase(it);
+            pthread_mutex_unlock(&m_mutex);
+            pOp->complete(SBL_CANCELLED, "Operation cancelled.\n");
+            return true;
+        }
+    }
+
+    //
+    // Running. If it has only just been taken off the queue, execute()
+    // sees the flag set by SblOperation::cancel() instead.
+    //
+    bool bRunning = (m_pRunning == pOp);
+    if(bRunning)
+    {
+        m_pDevice->cancel();
+    }
+    pthread_mutex_unlock(&m_mutex);
+
+    return bRunning;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Run \e pOp on the device.
+ *
+ * \param[out] csError
+ *      Is populated with the error if the operation fails.
+ *
+ * \return
+ *      Returns the status of the operation.
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblAsyncDevice::execute(SblOperation *pOp, std::string &csError)
+{
+    uint32_t retCode = SBL_ERROR;
+    uint32_t ui32Crc = 0;
+
+    //
+    // Clear a cancel meant for the previous operation before looking at
+    // this one's, so a cancel() racing with the start is not lost
+    //
+    m_pDevice->clearCancel();
+    pthread_mutex_lock(&pOp->m_mutex);
+    bool bCancel = pOp->m_bCancel;
+    pthread_mutex_unlock(&pOp->m_mutex);
+    if(bCancel)
+    {
+        csError = "Operation cancelled.\n";
+        return SBL_CANCELLED;
+    }
+
+    uint64_t now = getTimeMs();
+    if(pOp->m_ui64DeadlineMs)
+    {
+        if(now >= pOp->m_ui64DeadlineMs)
+        {
+            csError = "Operation deadline passed before it started.\n";
+            return SBL_TIMEOUT_ERROR;
+        }
+        m_pDevice->setOperationDeadline((uint32_t)(pOp->m_ui64DeadlineMs - now));
+    }
+
+    switch(pOp->m_type)
+    {
+    case SBL_OP_CONNECT:
+        retCode = m_pDevice->connect(pOp->m_csPortNum, pOp->m_pigpiodID, pOp->m_ui32BaudRate);
+        break;
+    case SBL_OP_PING:
+        retCode = m_pDevice->ping();
+        break;
+    case SBL_OP_ERASE:
+        retCode = m_pDevice->eraseFlashRange(pOp->m_ui32Address, pOp->m_ui32ByteCount);
+        break;
+    case SBL_OP_WRITE:
+        retCode = m_pDevice->writeFlashRange(pOp->m_ui32Address, pOp->m_ui32ByteCount, pOp->m_pcWriteData);
+        break;
+    case SBL_OP_READ:
+        retCode = m_pDevice->readMemoryRange(pOp->m_ui32Address, pOp->m_ui32ByteCount, pOp->m_pcReadData);
+        break;
+    case SBL_OP_CRC32:
+        retCode = m_pDevice->calculateCrc32(pOp->m_ui32Address, pOp->m_ui32ByteCount, &ui32Crc);
+        pOp->m_ui32Result = ui32Crc;
+        break;
+    case SBL_OP_RESET:
+        retCode = m_pDevice->reset();
+        break;
+    }
+    m_pDevice->setOperationDeadline(0);
+
+    if(retCode == SBL_SUCCESS)
+    {
+        csError.clear();
+    }
+    else if(m_pDevice->isCancelled())
+    {
+        csError = "Operation cancelled.\n";
+        retCode = SBL_CANCELLED;
+    }
+    else if(pOp->m_ui64DeadlineMs && getTimeMs() >= pOp->m_ui64DeadlineMs)
+    {
+        csError = "Operation deadline passed. " + m_pDevice->getDeviceError();
+        retCode = SBL_TIMEOUT_ERROR;
+    }
+    else
+    {
+        csError = m_pDevice->getDeviceError();
+    }
+
+    return retCode;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Executor thread. Runs queued operations one at a time.
+ */
+//-----------------------------------------------------------------------------
+/*static*/void *
+SblAsyncDevice::executorThread(void *pArg)
+{
+    SblAsyncDevice *pThis = (SblAsyncDevice *)pArg;
+    std::string csError;
+
+    pthread_mutex_lock(&pThis->m_mutex);
+    while(!pThis->m_bStop)
+    {
+        if(pThis->m_queue.empty())
+        {
+            pthread_cond_wait(&pThis->m_cond, &pThis->m_mutex);
+            continue;
+        }
+        SblOperation *pOp = pThis->m_queue.front();
+        pThis->m_queue.pop_front();
+        pThis->m_pRunning = pOp;
+        pthread_mutex_unlock(&pThis->m_mutex);
+
+        uint32_t retCode = pThis->execute(pOp, csError);
+
+        pthread_mutex_lock(&pThis->m_mutex);
+        pThis->m_pRunning = NULL;
+        pthread_mutex_unlock(&pThis->m_mutex);
+
+        pOp->complete(retCode, csError);
+
+        pthread_mutex_lock(&pThis->m_mutex);
+    }
+    pthread_mutex_unlock(&pThis->m_mutex);
+
+    return NULL;
+}
@@ -42,11 +42,19 @@
 #include "sbl_device_cc2538.h"
 #include "sbl_device_cc2650.h"*/
 
-#include "UART_ComPort.h"
-//#include <ComPortElement.h>
+#include "sbl_transportUART.h"
+#include "ComPortElement.h"
 
+#include <fcntl.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
 
 //
 // Static  variables
@@ -55,6 +63,8 @@ std::string     SblDevice::sm_csLastError;
 uint32_t        SblDevice::sm_progress = 0;
 tProgressFPTR   SblDevice::sm_pProgressFunction = NULL;
 tStatusFPTR     SblDevice::sm_pStatusFunction = NULL;
+std::string     SblDevice::sm_csProbeCacheFile = SblDevice::defaultProbeCacheFile();
+pthread_mutex_t SblDevice::sm_mutex = PTHREAD_MUTEX_INITIALIZER;
     
 
 //-----------------------------------------------------------------------------
@@ -63,10 +73,25 @@ tStatusFPTR     SblDevice::sm_pStatusFunction = NULL;
 //-----------------------------------------------------------------------------
 SblDevice::SblDevice()
 {
-    m_pCom = new UART_ComPort();
+    m_pCom = new SblTransport();
     m_lastDeviceStatus = -1;
     m_lastSblStatus = SBL_SUCCESS;
     m_bCommInitialized = false;
+    m_bFlowControl = false;
+    m_bTryPing = false;
+    m_ui64DeadlineMs = 0;
+    m_ui64OpDeadlineMs = 0;
+    m_bCancel = false;
+    m_bQuiet = false;
+    m_ui32ChunkRetries = SBL_DEFAULT_CHUNK_RETRIES;
+    m_ui32TotalRetries = SBL_DEFAULT_TOTAL_RETRIES;
+    m_ui32BackoffMs = SBL_DEFAULT_BACKOFF;
+    m_bBlankCheck = false;
+    m_ui32BlankPages = 0;
+    m_bPageVerify = false;
+    m_ui32PageCrcAddress = 0;
+    m_ui32PageCrcBytes = 0;
+    m_pcPageCrcData = NULL;
     m_deviceId = 0;
     m_ramSize = 0;
     m_flashSize = 0;
@@ -79,6 +104,21 @@ SblDevice::SblDevice()
 //-----------------------------------------------------------------------------
 SblDevice::~SblDevice()
 {
+    //
+    // Remember if the device is left in bootloader mode so the next
+    // connect() can skip auto baud.
+    //
+    if(m_deviceId != 0 && !m_csComPort.empty())
+    {
+        tSblProbeInfo info;
+        info.ui32DeviceId = m_deviceId;
+        info.ui32FlashSize = m_flashSize;
+        info.ui32RamSize = m_ramSize;
+        info.ui32BaudRate = m_baudRate;
+        info.bSynced = isConnected();
+        storeProbeCache(m_csComPort, info);
+    }
+
     if(m_pCom) { delete m_pCom; }
     m_lastDeviceStatus = -1;
     m_bCommInitialized = false;
@@ -104,7 +144,7 @@ SblDevice::Create(uint32_t ui32ChipType)
 
     switch(ui32ChipType)
     {
-    case 0x2538: return (SblDevice *)new SblDeviceCC2538();
+    case SblTraitsCC2538::CHIP_TYPE: return (SblDevice *)new SblDeviceCC2538();
     case 0x1350:
     case 0x1310:
     case 0x2670:    
@@ -126,15 +166,19 @@ SblDevice::Create(uint32_t ui32ChipType)
  * \param[in/out]   numElements
  *      Maximum number of elements to enumerate. Is populated with number
  *      of devices enumerated.
+ * \param[in]       ui32TransportMask (optional)
+ *      Transports to enumerate, SBL_TRANSPORT_UART and/or SBL_TRANSPORT_HID.
+ *      HID ports are named SBL_HID_PORT_PREFIX followed by the port number.
  *
  * \return
  *
  */
 //-----------------------------------------------------------------------------
 uint32_t
-SblDevice::enumerate(ComPortElement*& pComPortElements, int &numElements)
+SblDevice::enumerate(ComPortElement*& pComPortElements, int &numElements, 
+                     uint32_t ui32TransportMask/* = SBL_TRANSPORT_ALL*/)
 {
-    if(m_pCom->enumerate(pComPortElements, numElements) != ComPort::COMPORT_SUCCESS)
+    if(m_pCom->enumerate(pComPortElements, numElements, ui32TransportMask) != ComPort::COMPORT_SUCCESS)
     {
         printf("Failed to enumerate COM devices.\n");
         return SBL_ENUM_ERROR;
@@ -142,6 +186,174 @@ SblDevice::enumerate(ComPortElement*& pComPortElements, int &numElements)
     return SBL_SUCCESS;
 }
 
+//
+// Work item of one discover() thread
+//
+typedef struct
+{
+    std::string csPortNum;
+    uint32_t    ui32BaudRate;
+    uint32_t    ui32TimeoutMs;
+    bool        bFound;
+    uint32_t    ui32DeviceId;
+    uint32_t    ui32FlashSize;
+} tDiscoverJob;
+
+
+//-----------------------------------------------------------------------------
+/** \brief Find the enumerated ports that have a live bootloader.
+ *
+ * All ports are probed at the same time, each from its own thread. A probe
+ * does auto baud (or a ping, if the probe cache says the device was left in
+ * bootloader mode) and reads the device ID and flash size. Devices are not
+ * reset into bootloader mode, so they must already be in it.
+ *
+ * \param[out] pvPorts
+ *      Populated with the ports that answered, in enumeration order.
+ * \param[in] ui32BaudRate
+ *      Baudrate to use for talking to the devices.
+ * \param[in] ui32TimeoutMs (optional)
+ *      How long each port may take to answer.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblDevice::discover(std::vector<tSblPortInfo> &pvPorts, uint32_t ui32BaudRate, 
+                    uint32_t ui32TimeoutMs/* = SBL_DISCOVER_TIMEOUT*/)
+{
+    ComPortElement *pElements;
+    int numElements = SBL_MAX_DEVICES;
+    uint32_t retCode;
+
+    pvPorts.clear();
+    if((retCode = enumerate(pElements, numElements)) != SBL_SUCCESS)
+    {
+        return retCode;
+    }
+
+    //
+    // Start one probe per port, then wait for all of them
+    //
+    std::vector<tDiscoverJob> pvJobs(numElements);
+    std::vector<pthread_t> pvThreads(numElements);
+    std::vector<bool> pvStarted(numElements, false);
+    for(int i = 0; i < numElements; i++)
+    {
+        pvJobs[i].csPortNum = pElements[i].portNumber;
+        pvJobs[i].ui32BaudRate = ui32BaudRate;
+        pvJobs[i].ui32TimeoutMs = ui32TimeoutMs;
+        pvJobs[i].bFound = false;
+        pvStarted[i] = (pthread_create(&pvThreads[i], NULL, &SblDevice::discoverPort, &pvJobs[i]) == 0);
+    }
+
+    for(int i = 0; i < numElements; i++)
+    {
+        if(!pvStarted[i])
+        {
+            continue;
+        }
+        pthread_join(pvThreads[i], NULL);
+
+        if(pvJobs[i].bFound)
+        {
+            tSblPortInfo info;
+            info.csPortNum = pvJobs[i].csPortNum;
+            info.csDescription = pElements[i].description;
+            info.ui32DeviceId = pvJobs[i].ui32DeviceId;
+            info.ui32ChipType = getChipType(pvJobs[i].ui32DeviceId);
+            info.ui32FlashSize = pvJobs[i].ui32FlashSize;
+            pvPorts.push_back(info);
+        }
+    }
+
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Thread function probing a single port for discover().
+ *
+ * \param[in|out] pArg
+ *      Pointer to the tDiscoverJob to run. The result is stored in it.
+ *
+ * \return
+ *      NULL
+ */
+//-----------------------------------------------------------------------------
+/*static*/void *
+SblDevice::discoverPort(void *pArg)
+{
+    tDiscoverJob *pJob = (tDiscoverJob *)pArg;
+    uint32_t ui32DeviceId, ui32FlashSize;
+    tSblProbeInfo probe;
+    uint32_t retCode = SBL_ERROR;
+
+    //
+    // The CC26xx driver is used to get the device ID, the commands
+    // involved are the same for CC2538.
+    //
+    SblDevice *pDevice = Create(SblTraitsCC2650::CHIP_TYPE);
+    pDevice->m_bQuiet = true;
+    pDevice->setDeadline(pJob->ui32TimeoutMs);
+
+    if(pDevice->m_pCom->open(pJob->csPortNum, pJob->ui32BaudRate, SBL_DEFAULT_READ_TIMEOUT, 
+                             SBL_DEFAULT_WRITE_TIMEOUT, 0) != ComPort::COMPORT_SUCCESS)
+    {
+        delete pDevice;
+        return NULL;
+    }
+    pDevice->m_csComPort = pJob->csPortNum;
+    pDevice->m_baudRate = pJob->ui32BaudRate;
+    pDevice->m_pCom->flushBuffers();
+
+    if(loadProbeCache(pJob->csPortNum, probe) && probe.bSynced && 
+       probe.ui32BaudRate == pJob->ui32BaudRate)
+    {
+        pDevice->m_bTryPing = true;
+        retCode = pDevice->initCommunication(false);
+        pDevice->m_bTryPing = false;
+        pDevice->setDeadline(pJob->ui32TimeoutMs);
+    }
+    if(retCode != SBL_SUCCESS)
+    {
+        retCode = pDevice->initCommunication(false);
+    }
+
+    if(retCode == SBL_SUCCESS && 
+       pDevice->readDeviceId(&ui32DeviceId) == SBL_SUCCESS)
+    {
+        //
+        // Flash size is read differently on CC2538
+        //
+        if(getChipType(ui32DeviceId) == SblTraitsCC2538::CHIP_TYPE)
+        {
+            SblDevice *pCC2538 = Create(SblTraitsCC2538::CHIP_TYPE);
+            pCC2538->m_bQuiet = true;
+            pCC2538->m_ui64DeadlineMs = pDevice->m_ui64DeadlineMs;
+            pCC2538->takeOverPort(*pDevice);
+            pCC2538->m_deviceId = ui32DeviceId;
+            delete pDevice;
+            pDevice = pCC2538;
+        }
+
+        if(pDevice->readFlashSize(&ui32FlashSize) == SBL_SUCCESS)
+        {
+            pJob->ui32DeviceId = ui32DeviceId;
+            pJob->ui32FlashSize = ui32FlashSize;
+            pJob->bFound = true;
+        }
+    }
+
+    //
+    // The destructor records the found device in the probe cache
+    //
+    delete pDevice;
+    return NULL;
+}
+
+
 //-----------------------------------------------------------------------------
 /** \brief sConnect to given port number at specified baud rate.
  *
@@ -152,6 +364,18 @@ SblDevice::enumerate(ComPortElement*& pComPortElements, int &numElements)
  * \param[in] bEnableXosc (optional)
  *      If true, try to enable device XOSC. Defaults to false. This option is
  *      not available for all device types.
+ * \param[in] bFlowControl (optional)
+ *      If true, try to enable RTS/CTS hardware flow control after auto baud.
+ *      Flow control is only used if CTS is asserted and the device answers
+ *      a ping with it enabled, otherwise the connection falls back to no
+ *      flow control. It only protects the line; the ROM bootloader does not
+ *      throttle, so every data frame is still acknowledged and its status
+ *      read. Defaults to false.
+ *
+ * If the probe cache says the device on \e csPortNum was left in bootloader
+ * mode at \e ui32BaudRate, the device is pinged first and auto baud is only
+ * done if the ping fails. Flash and RAM size are taken from the cache if the
+ * device ID matches the cached one.
  *
  * \return
  *      Returns SBL_SUCCESS, ...
@@ -159,7 +383,107 @@ SblDevice::enumerate(ComPortElement*& pComPortElements, int &numElements)
 //-----------------------------------------------------------------------------
 uint32_t 
 SblDevice::connect(std::string csPortNum, int pigpiodID, uint32_t ui32BaudRate, 
-                         bool bEnableXosc/* = false*/)
+                         bool bEnableXosc/* = false*/, bool bFlowControl/* = false*/)
+{
+    int retCode;
+
+    if((retCode = connectPort(csPortNum, pigpiodID, ui32BaudRate, bEnableXosc, bFlowControl)) != SBL_SUCCESS)
+    {
+        return retCode;
+    }
+
+    return readDeviceInfo();
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Create a Serial Bootloader Device for whatever device is connected
+ *      to \e csPortNum, and connect to it.
+ *
+ * CMD_GET_CHIP_ID is the same for all device families, so the port is first
+ * connected with the CC26xx driver. If the chip ID shows a CC2538, the
+ * connection is handed over to a CC2538 driver without a new auto baud.
+ * For early CC26xx samples, readDeviceId() sets up the command remapping.
+ *
+ * \param[out] pDevice
+ *      Populated with the created device. Set also if connecting fails, so
+ *      that the status can be read. The caller must delete it.
+ * \param[in] csPortNum
+ *      String containing the COM port to use
+ * \param[in] pigpiodID
+ *      Pigpio ID used to put the device in bootloader mode.
+ * \param[in] ui32BaudRate
+ *      Baudrate to use for talking to the device.
+ * \param[in] bEnableXosc (optional)
+ *      If true, try to enable device XOSC. Defaults to false. This option is
+ *      not available for all device types.
+ * \param[in] bFlowControl (optional)
+ *      If true, try to enable RTS/CTS hardware flow control after auto baud.
+ *      Defaults to false.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+/*static*/uint32_t
+SblDevice::CreateAndConnect(SblDevice *&pDevice, std::string csPortNum, int pigpiodID, 
+                            uint32_t ui32BaudRate, bool bEnableXosc/* = false*/, 
+                            bool bFlowControl/* = false*/)
+{
+    uint32_t retCode;
+
+    pDevice = Create(SblTraitsCC2650::CHIP_TYPE);
+    if((retCode = pDevice->connectPort(csPortNum, pigpiodID, ui32BaudRate, false, bFlowControl)) != SBL_SUCCESS)
+    {
+        return retCode;
+    }
+
+    if(getChipType(pDevice->getDeviceId()) == SblTraitsCC2538::CHIP_TYPE)
+    {
+        SblDevice *pCC2538 = Create(SblTraitsCC2538::CHIP_TYPE);
+        pCC2538->takeOverPort(*pDevice);
+        pCC2538->m_deviceId = pDevice->m_deviceId;
+        delete pDevice;
+        pDevice = pCC2538;
+
+        //
+        // XOSC can only be enabled by the CC2538 driver. The device is already
+        // initialized, so only the XOSC part is done.
+        //
+        if(bEnableXosc && (retCode = pDevice->initCommunication(true)) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+    }
+
+    return pDevice->readDeviceInfo();
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Open the port, bring the device into bootloader mode and read its
+ *      device ID. First step of connect().
+ *
+ * \param[in] csPortNum
+ *      String containing the COM port to use
+ * \param[in] pigpiodID
+ *      Pigpio ID used to put the device in bootloader mode.
+ * \param[in] ui32BaudRate
+ *      Baudrate to use for talking to the device.
+ * \param[in] bEnableXosc (optional)
+ *      If true, try to enable device XOSC. Defaults to false. This option is
+ *      not available for all device types.
+ * \param[in] bFlowControl (optional)
+ *      If true, try to enable RTS/CTS hardware flow control after auto baud.
+ *      Defaults to false.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+uint32_t 
+SblDevice::connectPort(std::string csPortNum, int pigpiodID, uint32_t ui32BaudRate, 
+                       bool bEnableXosc, bool bFlowControl)
 {
     int retCode = SBL_SUCCESS;
 
@@ -173,6 +497,19 @@ SblDevice::connect(std::string csPortNum, int pigpiodID, uint32_t ui32BaudRate,
         return SBL_ARGUMENT_ERROR;
     }
 
+    //
+    // Look up what we know about the device on this port. If this object
+    // still has the port open, it knows better than the cache whether the
+    // device is in bootloader mode.
+    //
+    tSblProbeInfo probe;
+    bool bProbeCached = loadProbeCache(csPortNum, probe);
+    if(bProbeCached && m_pCom != NULL && m_pCom->isInitiated() && 
+       m_csComPort.compare(csPortNum) == 0)
+    {
+        probe.bSynced = m_bCommInitialized;
+    }
+
     // Try to connect to the specified port at the specified baud rate
     if(m_pCom != NULL) 
     {
@@ -193,6 +530,22 @@ SblDevice::connect(std::string csPortNum, int pigpiodID, uint32_t ui32BaudRate,
                                          SBL_DEFAULT_READ_TIMEOUT, 
                                          SBL_DEFAULT_WRITE_TIMEOUT, 0) != ComPort::COMPORT_SUCCESS)
             {
+                if(m_pCom->getBusyOwner() > 0)
+                {
+                    setState(SBL_PORT_BUSY_ERROR, "SBL: %s is in use by process %d.\n", 
+                             csPortNum.c_str(), m_pCom->getBusyOwner());
+                    return SBL_PORT_BUSY_ERROR;
+                }
+                if(m_pCom->getBusyOwner() < 0)
+                {
+                    setState(SBL_PORT_BUSY_ERROR, "SBL: %s is in use by another process.\n", csPortNum.c_str());
+                    return SBL_PORT_BUSY_ERROR;
+                }
+                if(!m_pCom->getLockError().empty())
+                {
+                    setState(SBL_PORT_ERROR, "SBL: %s: %s.\n", csPortNum.c_str(), m_pCom->getLockError().c_str());
+                    return SBL_PORT_ERROR;
+                }
                 setState(SBL_PORT_ERROR, "SBL: Unable to open %s. Error: %d.\n", csPortNum.c_str(), result);
                 return SBL_PORT_ERROR;
             }
@@ -201,19 +554,59 @@ SblDevice::connect(std::string csPortNum, int pigpiodID, uint32_t ui32BaudRate,
         }
     }
 
+    m_bFlowControl = false;
+    m_bCommInitialized = false;
+    retCode = SBL_ERROR;
 
-    //Trigger bootloader mode
-    if ((retCode = setBootloaderMode(pigpiodID)) != SBL_SUCCESS)
+    //
+    // Fast reconnect. The device was left in bootloader mode at this baud
+    // rate, so a ping is enough to check that it is still listening.
+    //
+    if(bProbeCached && probe.bSynced && probe.ui32BaudRate == ui32BaudRate)
     {
-        return retCode;
+        m_pCom->flushBuffers();
+        m_bTryPing = true;
+        retCode = initCommunication(bEnableXosc);
+        m_bTryPing = false;
     }
-    m_pCom->flushBuffers();
 
+    if(retCode != SBL_SUCCESS)
+    {
+        //Trigger bootloader mode
+        if ((retCode = setBootloaderMode(pigpiodID)) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+        m_pCom->flushBuffers();
+
+
+        // Check if device is responding at the given baud rate
+        if((retCode = initCommunication(bEnableXosc)) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+    }
 
-    // Check if device is responding at the given baud rate
-    if((retCode = initCommunication(bEnableXosc)) != SBL_SUCCESS)
+    //
+    // Switch to RTS/CTS flow control. Auto baud is always done without it,
+    // the link is then confirmed with a ping.
+    //
+    if(bFlowControl)
     {
-        return retCode;
+        if(m_pCom->setFlowControl(true) != 0)
+        {
+            setState(SBL_SUCCESS, "Warning: Unable to enable RTS/CTS flow control on %s. Continuing without.\n", m_csComPort.c_str());
+        }
+        else if(ping() != SBL_SUCCESS)
+        {
+            m_pCom->setFlowControl(false);
+            m_pCom->flushBuffers();
+            setState(SBL_SUCCESS, "Warning: No response from device with RTS/CTS flow control. Continuing without.\n");
+        }
+        else
+        {
+            m_bFlowControl = true;
+        }
     }
 
     //
@@ -226,24 +619,63 @@ SblDevice::connect(std::string csPortNum, int pigpiodID, uint32_t ui32BaudRate,
         return retCode;
     }
 
-    //
-    // Read device flash size
-    //   
-    if((retCode = readFlashSize(&tmp)) != SBL_SUCCESS)
-    {
-        setState(retCode, "Failed to read flash size during initial connect.\n");
-        return retCode;
-    }
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Read flash and RAM size of the connected device, or take them from
+ *      the probe cache if the cached device ID matches. Last step of connect().
+ *
+ * \return
+ *      Returns SBL_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblDevice::readDeviceInfo()
+{
+    int retCode = SBL_SUCCESS;
+    uint32_t tmp;
+    tSblProbeInfo probe;
+    bool bProbeCached = loadProbeCache(m_csComPort, probe);
 
     //
-    // Read device ram size
+    // Same chip as last time on this port, reuse the sizes.
     //
-    if((retCode = readRamSize(&tmp)) != SBL_SUCCESS)
+    if(bProbeCached && probe.ui32DeviceId == m_deviceId && 
+       probe.ui32FlashSize != 0 && probe.ui32RamSize != 0)
     {
-        setState(retCode, "Failed to read RAM size during initial connect.\n");
-        return retCode;
+        m_flashSize = probe.ui32FlashSize;
+        m_ramSize = probe.ui32RamSize;
+    }
+    else
+    {
+        //
+        // Read device flash size
+        //   
+        if((retCode = readFlashSize(&tmp)) != SBL_SUCCESS)
+        {
+            setState(retCode, "Failed to read flash size during initial connect.\n");
+            return retCode;
+        }
+
+        //
+        // Read device ram size
+        //
+        if((retCode = readRamSize(&tmp)) != SBL_SUCCESS)
+        {
+            setState(retCode, "Failed to read RAM size during initial connect.\n");
+            return retCode;
+        }
     }
 
+    probe.ui32DeviceId = m_deviceId;
+    probe.ui32FlashSize = m_flashSize;
+    probe.ui32RamSize = m_ramSize;
+    probe.ui32BaudRate = m_baudRate;
+    probe.bSynced = true;
+    storeProbeCache(m_csComPort, probe);
+
     return SBL_SUCCESS;
 }
 
@@ -337,7 +769,7 @@ SblDevice::getCmdResponse(bool &bAck,
         if (ret < 0) continue;
         bytesRecv += ret;
     }
-    while((bytesRecv < 2) && (retry < ui32MaxRetries));
+    while((bytesRecv < 2) && (retry < ui32MaxRetries) && !deadlineExpired());
 
     if(bytesRecv < 2)
     {
@@ -366,16 +798,23 @@ SblDevice::getCmdResponse(bool &bAck,
 
 
 //-----------------------------------------------------------------------------
-/** \brief Send command response (ACK/NAK).
+/** \brief Send command response (ACK/NAK), optionally followed by the next
+ *      command packet in the same write. The device does not look at the
+ *      next command before it has seen the response, so queueing it saves
+ *      one write turnaround.
  *
  * \param[in] bAck
  *      True if response is ACK, false if response is NAK.
+ * \param[in] pcNextPkt (optional)
+ *      Complete command packet to send after the response.
+ * \param[in] ui32NextLen (optional)
+ *      Length of \e pcNextPkt.
  * \return
  *      Returns SBL_SUCCESS, ...
  */
 //-----------------------------------------------------------------------------
 uint32_t
-SblDevice::sendCmdResponse(bool bAck)
+SblDevice::sendCmdResponse(bool bAck, const char *pcNextPkt/* = NULL*/, uint32_t ui32NextLen/* = 0*/)
 {
     int numBytes = 0, retry = 0;
 
@@ -388,17 +827,21 @@ SblDevice::sendCmdResponse(bool bAck)
     //
     // Send response
     //
-    char pData[2];
-    pData[0] = 0x00;
-    pData[1] = (bAck) ? 0xCC : 0x33;
+    std::vector<char> pvData(2 + ui32NextLen);
+    pvData[0] = 0x00;
+    pvData[1] = (bAck) ? 0xCC : 0x33;
+    if(ui32NextLen)
+    {
+        memcpy(&pvData[2], pcNextPkt, ui32NextLen);
+    }
     do
     {
         retry++;
-        int ret = m_pCom->writeBytes(pData+numBytes, sizeof(pData)-numBytes);
+        int ret = m_pCom->writeBytes(&pvData[0]+numBytes, pvData.size()-numBytes);
         if (ret < 0) continue;
         numBytes += ret;
     }
-    while (numBytes < sizeof(pData) && retry < 10000000);
+    while (numBytes < pvData.size() && retry < 10000000);
 
     if (retry >= 10000000)
     {
@@ -450,7 +893,7 @@ SblDevice::getResponseData(char *pcData, uint32_t &ui32MaxLen,
         bytesRecv += ret;
         retry ++;
     }
-    while((bytesRecv < 2) && retry < ui32MaxRetries);
+    while((bytesRecv < 2) && retry < ui32MaxRetries && !deadlineExpired());
 
     //
     // Check that we've received 2 bytes
@@ -484,7 +927,7 @@ SblDevice::getResponseData(char *pcData, uint32_t &ui32MaxLen,
         if (ret < 0) continue;
         bytesRecv += ret;
     }
-    while(bytesRecv < numPayloadBytes && retry < ui32MaxRetries);
+    while(bytesRecv < numPayloadBytes && retry < ui32MaxRetries && !deadlineExpired());
 
     //
     // Have we received what we expected?
@@ -512,56 +955,983 @@ SblDevice::getResponseData(char *pcData, uint32_t &ui32MaxLen,
 
 
 //-----------------------------------------------------------------------------
-/** \brief Are we connected to the device?
+/** \brief Get command response (ACK/NAK) and the response data following it.
+ *      Same as getCmdResponse() followed by getResponseData(), but the
+ *      bytes are parsed as they come in, so the ACK, the data header and
+ *      the payload are usually picked up by a single read.
  *
+ * \param[out] bAck
+ *      True if response is ACK, false if response is NAK. No data is
+ *      received after a NAK.
+ * \param[out] pcData
+ *      Pointer to where received data will be stored.
+ * \param[in|out] ui32MaxLen
+ *      Max number of bytes that can be received. Is populated with the actual
+ *      number of bytes received.
+ * \param[in] ui32MaxRetries (optional)
+ *      How many times ComPort::readBytes() can time out before fail is issued.
  * \return
- *      Returns true if connected to device.
- *      Returns false if not connected to device.
+ *      Returns SBL_SUCCESS, ...
  */
 //-----------------------------------------------------------------------------
-bool
-SblDevice::isConnected()
+uint32_t
+SblDevice::getCmdResponseData(bool &bAck, char *pcData, uint32_t &ui32MaxLen, 
+                              uint32_t ui32MaxRetries/* = SBL_DEFAULT_RETRY_COUNT*/)
 {
-    if(!m_pCom)
-    {
-        return false;
-    }
-    bool comInited  = m_pCom->isInitiated();
-    return (comInited) ? m_bCommInitialized : comInited;
-}
+    uint32_t retry = 0;
+    uint32_t bytesRecv = 0;
+    uint32_t numPayloadBytes = 0;
+    bool bHdrRecv = false;
 
+    //
+    // <2B ACK/NAK> <1B length> <1B checksum> <payload>. The device sends
+    // nothing after the payload until we respond, so it is safe to ask for
+    // the whole frame at once.
+    //
+    uint32_t bytesExpected = 4 + ui32MaxLen;
+    std::vector<unsigned char> pvIn(bytesExpected);
+    bAck = false;
 
-//-----------------------------------------------------------------------------
-/** \brief This function generates the bootloader protocol checksum.
- *
- * \param[in] ui32Cmd
- *      The bootloader command
- * \param[in] pcData
- *      Pointer to the command data.
- * \param[in] ui32DataLen
- *      Data length in bytes.
- *
- * \return
- *      Returns the generated checksum.
- */
-//-----------------------------------------------------------------------------
-uint8_t
-SblDevice::generateCheckSum(uint32_t ui32Cmd, const char *pcData, 
-                            uint32_t ui32DataLen)
-{
-    uint8_t ui8CheckSum = (uint8_t)ui32Cmd;
-    for(uint32_t i = 0; i < ui32DataLen; i++)
+    if(!m_pCom->isInitiated())
     {
-        ui8CheckSum += pcData[i];
+        setState(SBL_PORT_ERROR, "COM port not initiated.\n");
+        return SBL_PORT_ERROR;
     }
-    return ui8CheckSum;
-}
 
+    do
+    {
+        retry++;
+        int ret = m_pCom->readBytes(&pvIn[bytesRecv], bytesExpected - bytesRecv);
+        if (ret < 0) continue;
+        bytesRecv += ret;
 
-//-----------------------------------------------------------------------------
-/** \brief This function sets the the SBL status and the SBL error string.
- *
- * \param[in] ui32Status
+        //
+        // ACK/NAK
+        //
+        if(bytesRecv >= 2 && !bAck)
+        {
+            if(pvIn[0] == 0x00 && pvIn[1] == 0x33)
+            {
+                return setState(SBL_SUCCESS);
+            }
+            if(pvIn[0] != 0x00 || pvIn[1] != 0xCC)
+            {
+                setState(SBL_ERROR, "ACK/NAK not received. Expected 0x00 0xCC or 0x00 0x33, received 0x%02X 0x%02X.\n", pvIn[0], pvIn[1]);
+                return SBL_ERROR;
+            }
+            bAck = true;
+        }
+
+        //
+        // Data header
+        //
+        if(bytesRecv >= 4 && !bHdrRecv)
+        {
+            numPayloadBytes = pvIn[2] - 2;
+            if(pvIn[2] < 2 || numPayloadBytes > ui32MaxLen)
+            {
+                setState(SBL_ERROR, "Error: Device sending more data than expected. \nMax expected was %d, sent was %d.\n", (uint32_t)ui32MaxLen, pvIn[2]);
+                m_pCom->flushBuffers();
+                return SBL_ERROR;
+            }
+            bytesExpected = 4 + numPayloadBytes;
+            bHdrRecv = true;
+        }
+    }
+    while((bytesRecv < bytesExpected) && retry < ui32MaxRetries && !deadlineExpired());
+
+    if(bytesRecv < 2)
+    {
+        setState(SBL_TIMEOUT_ERROR, "Timed out waiting for ACK/NAK. No response from device.\n");
+        return SBL_TIMEOUT_ERROR;
+    }
+    if(bytesRecv < bytesExpected)
+    {
+        ui32MaxLen = (bytesRecv > 4) ? bytesRecv - 4 : 0;
+        setState(SBL_TIMEOUT_ERROR, "Timed out waiting for data from device.\n");
+        return SBL_TIMEOUT_ERROR;
+    }
+
+    //
+    // Verify data checksum
+    //
+    memcpy(pcData, &pvIn[4], numPayloadBytes);
+    uint8_t dataChecksum = generateCheckSum(0, pcData, numPayloadBytes);
+    if(dataChecksum != pvIn[3])
+    {
+        setState(SBL_ERROR, "Checksum verification error. Expected 0x%02X, got 0x%02X.\n", pvIn[3], dataChecksum);
+        return SBL_ERROR;
+    }
+
+    ui32MaxLen = numPayloadBytes;
+    return setState(SBL_SUCCESS);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Set how failed flash chunks are retransmitted by writeFlashRange().
+ *
+ * \param[in] ui32ChunkRetries
+ *      Retransmissions allowed for a single chunk.
+ * \param[in] ui32TotalRetries
+ *      Retransmissions allowed in one writeFlashRange() call.
+ * \param[in] ui32BackoffMs
+ *      Delay before the first retransmission of a chunk. The delay is
+ *      doubled for each further retransmission, up to SBL_MAX_BACKOFF.
+ *
+ * \return
+ *      void
+ */
+//-----------------------------------------------------------------------------
+void
+SblDevice::setRetryPolicy(uint32_t ui32ChunkRetries, uint32_t ui32TotalRetries, 
+                          uint32_t ui32BackoffMs)
+{
+    m_ui32ChunkRetries = ui32ChunkRetries;
+    m_ui32TotalRetries = ui32TotalRetries;
+    m_ui32BackoffMs = ui32BackoffMs;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Get back in step with the bootloader after a failed command.
+ *
+ * Zero bytes are sent to complete any packet the device is still waiting
+ * for (the device ignores zero bytes between packets), then the device is
+ * pinged. If the ping is not answered, auto baud is tried in case the device
+ * has restarted.
+ *
+ * The padding does not always complete a packet harmlessly. Zeros add
+ * nothing to the checksum, so a SEND_DATA cut short passes the checksum
+ * whenever its missing bytes summed to 0 (mod 256), and the device then
+ * programs zeros for them. \e bPadAccepted tells the caller when the
+ * device ACKed something after the padding, so that it can check the flash
+ * it was writing (see recoverTransfer()).
+ *
+ * \param[out] bPadAccepted
+ *      Set to true if the device ACKed a packet after the padding.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblDevice::resync(bool &bPadAccepted)
+{
+    char pcZero[255];
+    int numBytes = 0, retry = 0;
+    bool bAck = false, bQuiet = m_bQuiet;
+    uint32_t retCode;
+
+    memset(pcZero, 0, sizeof(pcZero));
+    m_pCom->flushBuffers();
+    do
+    {
+        retry++;
+        int ret = m_pCom->writeBytes(pcZero + numBytes, sizeof(pcZero) - numBytes);
+        if (ret < 0) continue;
+        numBytes += ret;
+    }
+    while (numBytes < sizeof(pcZero) && retry < 10000000);
+
+    //
+    // Drop the response to the completed packet, if any
+    //
+    m_bQuiet = true;
+    setDeadline(SBL_PROBE_TIMEOUT);
+    bPadAccepted = (getCmdResponse(bAck, 1000000, true) == SBL_SUCCESS && bAck);
+    m_pCom->flushBuffers();
+
+    setDeadline(SBL_PROBE_TIMEOUT);
+    retCode = ping();
+    if(retCode != SBL_SUCCESS)
+    {
+        m_pCom->flushBuffers();
+        setDeadline(SBL_PROBE_TIMEOUT);
+        if((retCode = sendAutoBaud(bAck)) == SBL_SUCCESS && !bAck)
+        {
+            retCode = SBL_ERROR;
+        }
+    }
+    setDeadline(0);
+    m_bQuiet = bQuiet;
+
+    return retCode;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Prepare retransmission of a failed flash chunk. Waits for the
+ *      back-off delay, resyncs with the device and restarts the download at
+ *      the failed chunk. Reports the failure if the retry budget set by
+ *      setRetryPolicy() is spent.
+ *
+ * \param[in] ui32Address
+ *      Flash address of the failed chunk.
+ * \param[in] ui32BytesLeft
+ *      Bytes left in the transfer, from the failed chunk on.
+ * \param[in] ui32ChunkBytes
+ *      Size of the failed chunk.
+ * \param[in] ui32TransferNumber
+ *      Number of the failed chunk in the download, for the error text.
+ * \param[in|out] ui32ChunkRetries
+ *      Retransmissions of the current chunk so far. Incremented.
+ * \param[in|out] ui32TotalRetries
+ *      Retransmissions in the current transfer so far. Incremented.
+ * \param[in|out] bVerifyChunk
+ *      Set to true if the device took the padding of resync() as a packet.
+ *      The failed chunk may then hold zeros that sending it again cannot
+ *      undo (flash bits are only cleared), so the caller must check it with
+ *      verifyChunk() once it has been sent again. Left as it is otherwise.
+ *
+ * \return
+ *      Returns SBL_SUCCESS if the chunk can be sent again.
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblDevice::recoverTransfer(uint32_t ui32Address, uint32_t ui32BytesLeft, uint32_t ui32ChunkBytes, 
+                           uint32_t ui32TransferNumber, uint32_t &ui32ChunkRetries, uint32_t &ui32TotalRetries, 
+                           bool &bVerifyChunk)
+{
+    uint32_t retCode;
+    bool bPadAccepted;
+
+    if(ui32ChunkRetries >= m_ui32ChunkRetries || ui32TotalRetries >= m_ui32TotalRetries || operationAborted())
+    {
+        setState(SBL_ERROR, "Error during flash download. \n- Start address 0x%08X (page %d). \n- Tried to transfer %d bytes. \n- This was transfer %d, retried %d times.\n", 
+                 ui32Address, addressToPage(ui32Address), ui32ChunkBytes, ui32TransferNumber, ui32ChunkRetries);
+        return SBL_ERROR;
+    }
+
+    uint32_t backoffMs = (ui32ChunkRetries < 16) ? (m_ui32BackoffMs << ui32ChunkRetries) : SBL_MAX_BACKOFF;
+    usleep(1000 * (GTmin(backoffMs, SBL_MAX_BACKOFF)));
+    ui32ChunkRetries++;
+    ui32TotalRetries++;
+    setState(SBL_SUCCESS, "Warning: Resending flash data at 0x%08X (retry %d).\n", ui32Address, ui32ChunkRetries);
+
+    if((retCode = resync(bPadAccepted)) != SBL_SUCCESS)
+    {
+        setState(retCode, "Failed to resync with device.\n");
+        return retCode;
+    }
+    if(bPadAccepted)
+    {
+        setState(SBL_SUCCESS, "Warning: Device accepted the resync padding, 0x%08X - 0x%08X will be checked.\n", 
+                 ui32Address, ui32Address + ui32ChunkBytes);
+        bVerifyChunk = true;
+    }
+
+    return restartDownload(ui32Address, ui32BytesLeft);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Restart an interrupted flash download at \e ui32Address, with
+ *      \e ui32ByteCount bytes left. Sends the download command again and
+ *      checks the device status.
+ *
+ * \param[in] ui32Address
+ *      Address of the first byte not yet written.
+ * \param[in] ui32ByteCount
+ *      Number of bytes left in the download.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblDevice::restartDownload(uint32_t ui32Address, uint32_t ui32ByteCount)
+{
+    uint32_t retCode;
+    uint32_t devStatus = 0;
+
+    if((retCode = cmdDownload(ui32Address, ui32ByteCount)) != SBL_SUCCESS)
+    {
+        return retCode;
+    }
+    if((retCode = readStatus(&devStatus)) != SBL_SUCCESS)
+    {
+        return retCode;
+    }
+    if(devStatus != CMD_RET_SUCCESS)
+    {
+        setState(SBL_ERROR, "Failed to restart download. Device returned status %d (%s).\n", devStatus, getCmdStatusString(devStatus).c_str());
+        return SBL_ERROR;
+    }
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Are we connected to the device?
+ *
+ * \return
+ *      Returns true if connected to device.
+ *      Returns false if not connected to device.
+ */
+//-----------------------------------------------------------------------------
+bool
+SblDevice::isConnected()
+{
+    if(!m_pCom)
+    {
+        return false;
+    }
+    bool comInited  = m_pCom->isInitiated();
+    return (comInited) ? m_bCommInitialized : comInited;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Read \e ui32ByteCount bytes of device memory starting at
+ *      \e ui32StartAddress. The word aligned part of the range is read with
+ *      32 bit accesses, which move more data per command, the rest with
+ *      8 bit accesses.
+ *
+ * \param[in] ui32StartAddress
+ *      Start address in device.
+ * \param[in] ui32ByteCount
+ *      Number of bytes to read.
+ * \param[out] pcData
+ *      Pointer to where read data is stored.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblDevice::readMemoryRange(uint32_t ui32StartAddress, uint32_t ui32ByteCount, char *pcData)
+{
+    uint32_t retCode;
+
+    //
+    // Unaligned head
+    //
+    uint32_t headBytes = GTmin((4 - (ui32StartAddress & 0x03)) & 0x03, ui32ByteCount);
+    if(headBytes && (retCode = readMemory8(ui32StartAddress, headBytes, pcData)) != SBL_SUCCESS)
+    {
+        return retCode;
+    }
+
+    //
+    // Aligned words
+    //
+    uint32_t wordCount = (ui32ByteCount - headBytes) / 4;
+    if(wordCount)
+    {
+        std::vector<uint32_t> pvWords(wordCount);
+        if((retCode = readMemory32(ui32StartAddress + headBytes, wordCount, &pvWords[0])) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+        memcpy(pcData + headBytes, &pvWords[0], wordCount * 4);
+    }
+
+    //
+    // Tail
+    //
+    uint32_t doneBytes = headBytes + wordCount * 4;
+    if(doneBytes < ui32ByteCount && 
+       (retCode = readMemory8(ui32StartAddress + doneBytes, ui32ByteCount - doneBytes, pcData + doneBytes)) != SBL_SUCCESS)
+    {
+        return retCode;
+    }
+
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Erase and write \e ui32ByteCount bytes of \e pcData to device
+ *      flash, page by page, so that a failed download can be resumed.
+ *
+ * Each page is confirmed with a device CRC after writing, and the number of
+ * confirmed pages is stored in \e csCheckpointFile. If the file holds a
+ * checkpoint for the same image, device and range, the confirmed pages are
+ * verified by CRC and the download resumes from the first bad page. The
+ * checkpoint file is removed when the download completes. Page CRCs given
+ * to setPageCrcs() for this image are dropped when the download ends.
+ *
+ * \param[in] ui32StartAddress
+ *      Start address in device flash.
+ * \param[in] ui32ByteCount
+ *      Number of bytes to program.
+ * \param[in] pcData
+ *      Pointer to the data to program.
+ * \param[in] csCheckpointFile
+ *      Path of the checkpoint file.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblDevice::writeFlashRangeResumable(uint32_t ui32StartAddress, uint32_t ui32ByteCount, 
+                                    const char *pcData, std::string csCheckpointFile)
+{
+    uint32_t retCode = writePagesResumable(ui32StartAddress, ui32ByteCount, pcData, csCheckpointFile);
+
+    //
+    // The page CRCs of setPageCrcs() are only good for one write of the image
+    //
+    releasePageCrcs(ui32StartAddress, ui32ByteCount, pcData);
+    return retCode;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief The page by page write of writeFlashRangeResumable(), which takes
+ *      the same parameters.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblDevice::writePagesResumable(uint32_t ui32StartAddress, uint32_t ui32ByteCount, 
+                               const char *pcData, std::string csCheckpointFile)
+{
+    uint32_t retCode = SBL_SUCCESS;
+    uint32_t devCrc;
+    tSblCheckpoint ckpt, saved;
+
+    if(!isConnected())
+    {
+        return SBL_PORT_ERROR;
+    }
+    if(ui32ByteCount == 0 || csCheckpointFile.empty())
+    {
+        setState(SBL_ARGUMENT_ERROR, "Flash download: Invalid byte count or checkpoint file.\n");
+        return SBL_ARGUMENT_ERROR;
+    }
+
+    //
+    // The range is handled in chunks that do not cross page boundaries
+    //
+    uint32_t pageSize = getPageSize();
+    uint32_t endAddress = ui32StartAddress + ui32ByteCount;
+    uint32_t firstPage = ui32StartAddress / pageSize;
+    uint32_t numPages = (endAddress - 1) / pageSize - firstPage + 1;
+
+    ckpt.ui32ImageCrc = calcCrc32(pcData, ui32ByteCount);
+    ckpt.ui32ByteCount = ui32ByteCount;
+    ckpt.ui32DeviceId = m_deviceId;
+    ckpt.ui32StartAddress = ui32StartAddress;
+    ckpt.ui32PageSize = pageSize;
+    ckpt.ui32PagesDone = 0;
+    if(loadCheckpoint(csCheckpointFile, saved) && 
+       saved.ui32ImageCrc == ckpt.ui32ImageCrc && saved.ui32ByteCount == ckpt.ui32ByteCount &&
+       saved.ui32DeviceId == ckpt.ui32DeviceId && saved.ui32StartAddress == ckpt.ui32StartAddress &&
+       saved.ui32PageSize == ckpt.ui32PageSize && saved.ui32PagesDone <= numPages)
+    {
+        ckpt.ui32PagesDone = saved.ui32PagesDone;
+    }
+
+    //
+    // Verify the pages confirmed by an earlier attempt. Resume from the
+    // first page that does not match.
+    //
+    uint32_t page = 0;
+    while(page < ckpt.ui32PagesDone)
+    {
+        uint32_t chunkStart = GTmax(ui32StartAddress, (firstPage + page) * pageSize);
+        uint32_t chunkEnd = GTmin(endAddress, (firstPage + page + 1) * pageSize);
+        if((retCode = calculateCrc32(chunkStart, chunkEnd - chunkStart, &devCrc)) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+        if(devCrc != hostCrc32(chunkStart, chunkEnd - chunkStart, pcData + (chunkStart - ui32StartAddress)))
+        {
+            break;
+        }
+        page++;
+    }
+    if(page > 0)
+    {
+        setState(SBL_SUCCESS, "Resuming flash download at page %d of %d.\n", page, numPages);
+    }
+    ckpt.ui32PagesDone = page;
+    storeCheckpoint(csCheckpointFile, ckpt);
+
+    //
+    // Erase what is left
+    //
+    uint32_t resumeAddress = GTmax(ui32StartAddress, (firstPage + page) * pageSize);
+    if(resumeAddress < endAddress && 
+       (retCode = eraseFlashRange(resumeAddress, endAddress - resumeAddress)) != SBL_SUCCESS)
+    {
+        return retCode;
+    }
+
+    //
+    // Write and confirm one page at a time
+    //
+    for(; page < numPages; page++)
+    {
+        uint32_t chunkStart = GTmax(ui32StartAddress, (firstPage + page) * pageSize);
+        uint32_t chunkEnd = GTmin(endAddress, (firstPage + page + 1) * pageSize);
+        const char *pcChunk = pcData + (chunkStart - ui32StartAddress);
+
+        if((retCode = writeFlashRange(chunkStart, chunkEnd - chunkStart, pcChunk)) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+        if(!m_bPageVerify && (retCode = calculateCrc32(chunkStart, chunkEnd - chunkStart, &devCrc)) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+        if(!m_bPageVerify && devCrc != hostCrc32(chunkStart, chunkEnd - chunkStart, pcChunk))
+        {
+            setState(SBL_ERROR, "Flash download: CRC mismatch after writing 0x%08X - 0x%08X.\n", chunkStart, chunkEnd);
+            return SBL_ERROR;
+        }
+
+        ckpt.ui32PagesDone = page + 1;
+        storeCheckpoint(csCheckpointFile, ckpt);
+    }
+
+    remove(csCheckpointFile.c_str());
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Find the flash pages that are not blank (all 0xFF), for
+ *      eraseFlashRange() to skip the blank ones when setBlankCheck() is on.
+ *
+ * The whole range is checked with one device CRC first, which is all it
+ * takes for a new or bank erased part. Only if that does not match the CRC
+ * of blank flash is each page checked on its own. A CRC32 costs one round
+ * trip and no flash wear; a page erase costs tens of milliseconds.
+ *
+ * \param[in] ui32Address
+ *      Address of the first page.
+ * \param[in] ui32PageCount
+ *      Number of pages.
+ * \param[out] pvDirty
+ *      Set to one entry per page, true if the page must be erased.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblDevice::findDirtyPages(uint32_t ui32Address, uint32_t ui32PageCount, std::vector<bool> &pvDirty)
+{
+    uint32_t retCode;
+    uint32_t pageSize = getPageSize();
+    bool bBlank;
+
+    pvDirty.assign(ui32PageCount, true);
+    m_ui32BlankPages = 0;
+    if(ui32PageCount == 0)
+    {
+        return SBL_SUCCESS;
+    }
+
+    if((retCode = checkBlank(ui32Address, ui32PageCount * pageSize, bBlank)) != SBL_SUCCESS)
+    {
+        return retCode;
+    }
+    if(bBlank)
+    {
+        pvDirty.assign(ui32PageCount, false);
+        m_ui32BlankPages = ui32PageCount;
+        return SBL_SUCCESS;
+    }
+    if(ui32PageCount == 1)
+    {
+        return SBL_SUCCESS;
+    }
+
+    for(uint32_t i = 0; i < ui32PageCount; i++)
+    {
+        if((retCode = checkBlank(ui32Address + i * pageSize, pageSize, bBlank)) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+        if(bBlank)
+        {
+            pvDirty[i] = false;
+            m_ui32BlankPages++;
+        }
+    }
+
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Find the next run of pages to erase in \e pvDirty, as given by
+ *      findDirtyPages().
+ *
+ * \param[in] pvDirty
+ *      One entry per page, true if the page must be erased.
+ * \param[in|out] ui32Index
+ *      Page to search from. Set to the first page of the run.
+ * \param[in] ui32MaxCount
+ *      Maximum number of pages in a run.
+ *
+ * \return
+ *      Returns the number of pages in the run, 0 if there are no more pages
+ *      to erase.
+ */
+//-----------------------------------------------------------------------------
+/*static*/uint32_t
+SblDevice::nextDirtyRun(const std::vector<bool> &pvDirty, uint32_t &ui32Index, uint32_t ui32MaxCount)
+{
+    uint32_t runCount = 0;
+
+    while(ui32Index < pvDirty.size() && !pvDirty[ui32Index])
+    {
+        ui32Index++;
+    }
+    while(runCount < ui32MaxCount && ui32Index + runCount < pvDirty.size() && pvDirty[ui32Index + runCount])
+    {
+        runCount++;
+    }
+    return runCount;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Check with one device CRC whether \e ui32ByteCount bytes of flash
+ *      from \e ui32Address are blank (all 0xFF).
+ *
+ * \param[out] bBlank
+ *      Set to true if the range is blank.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblDevice::checkBlank(uint32_t ui32Address, uint32_t ui32ByteCount, bool &bBlank)
+{
+    uint32_t retCode;
+    uint32_t devCrc;
+
+    bBlank = false;
+    if((retCode = calculateCrc32(ui32Address, ui32ByteCount, &devCrc)) != SBL_SUCCESS)
+    {
+        return retCode;
+    }
+    bBlank = (devCrc == calcBlankCrc32(ui32ByteCount));
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Give the host CRC of each page of the image in \e pcData that
+ *      will be written at \e ui32Address, as prepared by
+ *      SblImagePrep::getPageCrcs(). The page checks of setPageVerify() and
+ *      writeFlashRangeResumable() then use them instead of calculating the
+ *      CRCs again. The CRCs are ignored if they were not made for the page
+ *      size of this device.
+ *
+ * The CRCs are only used for ranges of the same \e pcData buffer, and are
+ * dropped when writeFlashRange() or writeFlashRangeResumable() of the whole
+ * image ends. Give them again before writing the image again.
+ *
+ * \param[in] ui32Address
+ *      Device address of the image.
+ * \param[in] ui32ByteCount
+ *      Size of the image.
+ * \param[in] pcData
+ *      The image, as it will be given to the write.
+ * \param[in] pvPageCrcs
+ *      CRC of each getPageSize() bytes of the image, the last one possibly
+ *      shorter. Empty to forget the CRCs.
+ */
+//-----------------------------------------------------------------------------
+void
+SblDevice::setPageCrcs(uint32_t ui32Address, uint32_t ui32ByteCount, const char *pcData, 
+                       const std::vector<uint32_t> &pvPageCrcs)
+{
+    uint32_t pageSize = getPageSize();
+
+    m_pvPageCrcs.clear();
+    m_pcPageCrcData = NULL;
+    if(pageSize && pcData && pvPageCrcs.size() == (ui32ByteCount + pageSize - 1) / pageSize)
+    {
+        m_pvPageCrcs = pvPageCrcs;
+        m_ui32PageCrcAddress = ui32Address;
+        m_ui32PageCrcBytes = ui32ByteCount;
+        m_pcPageCrcData = pcData;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Drop the page CRCs of setPageCrcs() if they were made for the
+ *      image that has just been written, \e ui32ByteCount bytes of
+ *      \e pcData at \e ui32Address. Called when such a write ends, good or
+ *      bad, so that a later write from the same buffer with other contents
+ *      is not checked against them.
+ *
+ * \param[in] ui32Address
+ *      Start address of the write.
+ * \param[in] ui32ByteCount
+ *      Number of bytes written.
+ * \param[in] pcData
+ *      The data written.
+ */
+//-----------------------------------------------------------------------------
+void
+SblDevice::releasePageCrcs(uint32_t ui32Address, uint32_t ui32ByteCount, const char *pcData)
+{
+    if(pcData == m_pcPageCrcData && ui32Address == m_ui32PageCrcAddress && 
+       ui32ByteCount == m_ui32PageCrcBytes)
+    {
+        m_pvPageCrcs.clear();
+        m_pcPageCrcData = NULL;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Verify-as-you-go for writeFlashRange() with setPageVerify() on.
+ *      Checks the pages from \e ui32VerifyAddress on that have been written
+ *      completely, or up to the end of the transfer.
+ *
+ * \param[in|out] ui32VerifyAddress
+ *      First address not yet verified. Advanced past the pages verified.
+ * \param[in] ui32WrittenEnd
+ *      End of the data written so far (exclusive).
+ * \param[in] ui32TransferEnd
+ *      End of the transfer (exclusive). Its last page is verified even
+ *      though it is not written to the end.
+ * \param[in] ui32DataAddress
+ *      Device address of the first byte of \e pcData.
+ * \param[in] pcData
+ *      The data being written.
+ * \param[out] bVerified
+ *      Set to true if a page was verified. The CRC command ends the
+ *      download, which must then be restarted for the bytes left.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblDevice::verifyPages(uint32_t &ui32VerifyAddress, uint32_t ui32WrittenEnd, uint32_t ui32TransferEnd, 
+                       uint32_t ui32DataAddress, const char *pcData, bool &bVerified)
+{
+    uint32_t retCode;
+    uint32_t pageSize = getPageSize();
+
+    bVerified = false;
+    while(ui32VerifyAddress < ui32WrittenEnd)
+    {
+        uint32_t pageEnd = (ui32VerifyAddress / pageSize + 1) * pageSize;
+        if(pageEnd > ui32WrittenEnd && ui32WrittenEnd < ui32TransferEnd)
+        {
+            // Rest of the page not written yet
+            break;
+        }
+        uint32_t verifyEnd = GTmin(pageEnd, ui32WrittenEnd);
+        if((retCode = verifyPage(ui32VerifyAddress, verifyEnd - ui32VerifyAddress, 
+                                 pcData + (ui32VerifyAddress - ui32DataAddress))) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+        ui32VerifyAddress = verifyEnd;
+        bVerified = true;
+    }
+
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Check \e ui32ByteCount bytes written at \e ui32Address, all in
+ *      one page, against a device CRC. On a mismatch the page is erased
+ *      and written again, keeping what else it holds, up to the chunk
+ *      retry count of setRetryPolicy(). The expected CRC is taken from the
+ *      page CRCs of setPageCrcs() if it is one of their pages.
+ *
+ * \param[in] ui32Address
+ *      Start address of the written bytes.
+ * \param[in] ui32ByteCount
+ *      Number of bytes.
+ * \param[in] pcData
+ *      The data that should be there.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblDevice::verifyPage(uint32_t ui32Address, uint32_t ui32ByteCount, const char *pcData)
+{
+    uint32_t retCode;
+    uint32_t devCrc;
+    uint32_t hostCrc = hostCrc32(ui32Address, ui32ByteCount, pcData);
+    uint32_t pageSize = getPageSize();
+    uint32_t pageAddress = ui32Address - (ui32Address % pageSize);
+    uint32_t endAddress = ui32Address + ui32ByteCount;
+
+    for(uint32_t retry = 0; ; retry++)
+    {
+        if((retCode = calculateCrc32(ui32Address, ui32ByteCount, &devCrc)) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+        if(devCrc == hostCrc)
+        {
+            return SBL_SUCCESS;
+        }
+        if(retry == m_ui32ChunkRetries)
+        {
+            setState(SBL_ERROR, "Flash download: CRC mismatch at 0x%08X - 0x%08X after rewriting the page %d times.\n", 
+                     ui32Address, endAddress, retry);
+            return SBL_ERROR;
+        }
+        setState(SBL_SUCCESS, "Warning: CRC mismatch at 0x%08X - 0x%08X, rewriting page %d (retry %d).\n", 
+                 ui32Address, endAddress, addressToPage(ui32Address), retry + 1);
+
+        //
+        // Keep the rest of the page
+        //
+        std::vector<char> pvPage(pageSize);
+        if(ui32Address > pageAddress && 
+           (retCode = readMemoryRange(pageAddress, ui32Address - pageAddress, &pvPage[0])) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+        if(endAddress < pageAddress + pageSize && 
+           (retCode = readMemoryRange(endAddress, pageAddress + pageSize - endAddress, &pvPage[endAddress - pageAddress])) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+        memcpy(&pvPage[ui32Address - pageAddress], pcData, ui32ByteCount);
+
+        //
+        // Rewrite it as a plain erase and write; it is checked by the next
+        // round of the loop
+        //
+        bool bBlankCheck = m_bBlankCheck;
+        bool bPageVerify = m_bPageVerify;
+        m_bBlankCheck = false;
+        m_bPageVerify = false;
+        if((retCode = eraseFlashRange(pageAddress, pageSize)) == SBL_SUCCESS)
+        {
+            retCode = writeFlashRange(pageAddress, pageSize, &pvPage[0]);
+        }
+        m_bBlankCheck = bBlankCheck;
+        m_bPageVerify = bPageVerify;
+        if(retCode != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Check a chunk that was sent again after the device took the
+ *      padding of resync() as a packet (see recoverTransfer()). Each page
+ *      part of the chunk is checked by CRC with verifyPage(), which erases
+ *      and rewrites the page, keeping the rest of it, if the padding left
+ *      zeros there. The CRC command ends the download, which must then be
+ *      restarted after the chunk.
+ *
+ * \param[in] ui32Address
+ *      Start address of the chunk.
+ * \param[in] ui32ByteCount
+ *      Number of bytes.
+ * \param[in] pcData
+ *      The data of the chunk.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblDevice::verifyChunk(uint32_t ui32Address, uint32_t ui32ByteCount, const char *pcData)
+{
+    uint32_t retCode;
+    uint32_t pageSize = getPageSize();
+    uint32_t endAddress = ui32Address + ui32ByteCount;
+
+    for(uint32_t address = ui32Address; address < endAddress; )
+    {
+        uint32_t partEnd = GTmin(endAddress, address - (address % pageSize) + pageSize);
+        if((retCode = verifyPage(address, partEnd - address, pcData + (address - ui32Address))) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+        address = partEnd;
+    }
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Host CRC32 (see calcCrc32()) of \e ui32ByteCount bytes of
+ *      \e pcData, to be written at \e ui32Address. Taken from the page CRCs
+ *      given to setPageCrcs() when the range is one of their pages and
+ *      \e pcData points into their image, else calculated.
+ *
+ * \param[in] ui32Address
+ *      Device address of the range.
+ * \param[in] ui32ByteCount
+ *      Number of bytes.
+ * \param[in] pcData
+ *      The data.
+ *
+ * \return
+ *      Returns the CRC.
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblDevice::hostCrc32(uint32_t ui32Address, uint32_t ui32ByteCount, const char *pcData)
+{
+    uint32_t pageSize = getPageSize();
+    uint32_t offset = ui32Address - m_ui32PageCrcAddress;
+
+    if(!m_pvPageCrcs.empty() && ui32Address >= m_ui32PageCrcAddress && 
+       offset < m_ui32PageCrcBytes && (offset % pageSize) == 0 &&
+       ui32ByteCount == GTmin(pageSize, m_ui32PageCrcBytes - offset) && 
+       pcData == m_pcPageCrcData + offset)
+    {
+        return m_pvPageCrcs.at(offset / pageSize);
+    }
+    return calcCrc32(pcData, ui32ByteCount);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief This function generates the bootloader protocol checksum.
+ *
+ * \param[in] ui32Cmd
+ *      The bootloader command
+ * \param[in] pcData
+ *      Pointer to the command data.
+ * \param[in] ui32DataLen
+ *      Data length in bytes.
+ *
+ * \return
+ *      Returns the generated checksum.
+ */
+//-----------------------------------------------------------------------------
+uint8_t
+SblDevice::generateCheckSum(uint32_t ui32Cmd, const char *pcData, 
+                            uint32_t ui32DataLen)
+{
+    uint8_t ui8CheckSum = (uint8_t)ui32Cmd;
+    for(uint32_t i = 0; i < ui32DataLen; i++)
+    {
+        ui8CheckSum += pcData[i];
+    }
+    return ui8CheckSum;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief This function sets the the SBL status and the SBL error string.
+ *
+ * \param[in] ui32Status
  *      The new SBL status. SBL_SUCCESS, SBL_ERROR, ...
  * \param[in] pcFormat
  *      'printf' like format string.
@@ -589,14 +1959,27 @@ SblDevice::setState(const uint32_t &ui32Status, char *pcFormat, ...)
 
     va_start(args, pcFormat);
     vsprintf(text, pcFormat, args);
-    sm_csLastError = text;
     va_end(args);
 
+    //
+    // sm_csLastError is shared by all devices. Callers running several
+    // devices at once read the text of their own device instead.
+    //
+    m_csLastError = text;
+
+    if(m_bQuiet)
+    {
+        return SBL_SUCCESS;
+    }
+
+    pthread_mutex_lock(&sm_mutex);
+    sm_csLastError = text;
     if(SblDevice::sm_pStatusFunction != NULL)
     {
         bool error = (m_lastSblStatus == SBL_SUCCESS) ? false : true;
         sm_pStatusFunction((char *)sm_csLastError.c_str(), error);    
     }
+    pthread_mutex_unlock(&sm_mutex);
 
     return SBL_SUCCESS;
 } 
@@ -695,3 +2078,476 @@ SblDevice::setProgress(uint32_t ui32Progress)
     return SBL_SUCCESS;
 }
 
+
+
+//-----------------------------------------------------------------------------
+/** \brief Utility function returning a monotonic time stamp in milliseconds.
+ *
+ * \return
+ *      Milliseconds since an unspecified starting point.
+ */
+//-----------------------------------------------------------------------------
+/*static*/uint64_t
+SblDevice::getTimeMs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Limit how long getCmdResponse() and getResponseData() wait for the
+ *      device, regardless of their retry count.
+ *
+ * \param[in] ui32TimeoutMs
+ *      Milliseconds from now. 0 removes the deadline.
+ *
+ * \return
+ *      void
+ */
+//-----------------------------------------------------------------------------
+void
+SblDevice::setDeadline(uint32_t ui32TimeoutMs)
+{
+    m_ui64DeadlineMs = (ui32TimeoutMs) ? getTimeMs() + ui32TimeoutMs : 0;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Has the deadline set by setDeadline() passed?
+ *
+ * \return
+ *      Returns true if a deadline is set and has passed.
+ */
+//-----------------------------------------------------------------------------
+bool
+SblDevice::deadlineExpired()
+{
+    return (m_ui64DeadlineMs != 0 && getTimeMs() >= m_ui64DeadlineMs) || operationAborted();
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Limit how long the next operations may take in total. Once the
+ *      deadline passes every wait for the device fails, so a long
+ *      writeFlashRange() stops at the next chunk instead of running on.
+ *
+ * \param[in] ui32TimeoutMs
+ *      Milliseconds from now. 0 removes the deadline.
+ *
+ * \return
+ *      void
+ */
+//-----------------------------------------------------------------------------
+void
+SblDevice::setOperationDeadline(uint32_t ui32TimeoutMs)
+{
+    m_ui64OpDeadlineMs = (ui32TimeoutMs) ? getTimeMs() + ui32TimeoutMs : 0;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Has the operation been cancelled, or has the deadline set by
+ *      setOperationDeadline() passed?
+ *
+ * \return
+ *      Returns true if the operation in progress should give up.
+ */
+//-----------------------------------------------------------------------------
+bool
+SblDevice::operationAborted()
+{
+    return m_bCancel || (m_ui64OpDeadlineMs != 0 && getTimeMs() >= m_ui64OpDeadlineMs);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Look up port \e csPort in the probe cache file.
+ *
+ * \param[in] csPort
+ *      The port to look up.
+ * \param[out] info
+ *      Populated with the cached device information if found.
+ *
+ * \return
+ *      Returns true if the port was found in the cache.
+ */
+//-----------------------------------------------------------------------------
+/*static*/bool
+SblDevice::loadProbeCache(const std::string &csPort, tSblProbeInfo &info)
+{
+    if(sm_csProbeCacheFile.empty())
+    {
+        return false;
+    }
+
+    pthread_mutex_lock(&sm_mutex);
+    int lockFd = lockProbeCache(LOCK_SH);
+    FILE *pFile = fopen(sm_csProbeCacheFile.c_str(), "r");
+    if(!pFile)
+    {
+        if(lockFd >= 0) close(lockFd);
+        pthread_mutex_unlock(&sm_mutex);
+        return false;
+    }
+
+    //
+    // One line per port: <port> <device id> <flash size> <ram size> <baud> <synced>
+    //
+    char pcPort[256];
+    unsigned int id, flashSize, ramSize, baud, synced;
+    bool bFound = false;
+    while(fscanf(pFile, "%255s %x %u %u %u %u", pcPort, &id, &flashSize, &ramSize, &baud, &synced) == 6)
+    {
+        if(csPort.compare(pcPort) == 0)
+        {
+            info.ui32DeviceId = id;
+            info.ui32FlashSize = flashSize;
+            info.ui32RamSize = ramSize;
+            info.ui32BaudRate = baud;
+            info.bSynced = (synced != 0);
+            bFound = true;
+        }
+    }
+    fclose(pFile);
+    if(lockFd >= 0) close(lockFd);
+    pthread_mutex_unlock(&sm_mutex);
+
+    return bFound;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Store device information for port \e csPort in the probe cache
+ *      file, replacing any previous entry for the port.
+ *
+ * \param[in] csPort
+ *      The port the information belongs to.
+ * \param[in] info
+ *      The device information.
+ *
+ * \return
+ *      void
+ */
+//-----------------------------------------------------------------------------
+/*static*/void
+SblDevice::storeProbeCache(const std::string &csPort, const tSblProbeInfo &info)
+{
+    if(sm_csProbeCacheFile.empty())
+    {
+        return;
+    }
+
+    //
+    // The cache is shared by all processes flashing from this account. The
+    // read-modify-write below holds its lock file, so none of them loses
+    // another's entry.
+    //
+    pthread_mutex_lock(&sm_mutex);
+    int lockFd = lockProbeCache(LOCK_EX);
+    if(lockFd < 0)
+    {
+        pthread_mutex_unlock(&sm_mutex);
+        return;
+    }
+
+    //
+    // Keep the entries of other ports
+    //
+    std::vector<std::string> lines;
+    char pcLine[512];
+    FILE *pFile = fopen(sm_csProbeCacheFile.c_str(), "r");
+    if(pFile)
+    {
+        while(fgets(pcLine, sizeof(pcLine), pFile))
+        {
+            std::string csLine(pcLine);
+            if(csLine.compare(0, csPort.length() + 1, csPort + " ") != 0)
+            {
+                lines.push_back(csLine);
+            }
+        }
+        fclose(pFile);
+    }
+
+    snprintf(pcLine, sizeof(pcLine), "%s %08X %u %u %u %u\n", csPort.c_str(), info.ui32DeviceId,
+             info.ui32FlashSize, info.ui32RamSize, info.ui32BaudRate, (info.bSynced) ? 1 : 0);
+    lines.push_back(pcLine);
+
+    //
+    // Write to a new temporary file (mkstemp() never opens an existing file
+    // or follows a link) and rename it so that readers never see a half
+    // written cache.
+    //
+    std::string csTmp = sm_csProbeCacheFile + ".XXXXXX";
+    std::vector<char> pcTmp(csTmp.begin(), csTmp.end());
+    pcTmp.push_back('\0');
+    int fd = mkstemp(&pcTmp[0]);
+    if(fd >= 0 && !(pFile = fdopen(fd, "w")))
+    {
+        close(fd);
+        unlink(&pcTmp[0]);
+        fd = -1;
+    }
+    if(fd >= 0)
+    {
+        for(uint32_t i = 0; i < lines.size(); i++)
+        {
+            fputs(lines.at(i).c_str(), pFile);
+        }
+        if(fclose(pFile) != 0 || rename(&pcTmp[0], sm_csProbeCacheFile.c_str()) != 0)
+        {
+            unlink(&pcTmp[0]);
+        }
+    }
+    close(lockFd);
+    pthread_mutex_unlock(&sm_mutex);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Get the default probe cache file: SBL_PROBE_CACHE_FILE in
+ *      $XDG_CACHE_HOME, or in ~/.cache. The cache is per user, as it is not
+ *      safe to share one in a world-writable directory such as /tmp.
+ *
+ * \return
+ *      Returns the path, or an empty string (no cache) if neither variable
+ *      is set.
+ */
+//-----------------------------------------------------------------------------
+/*static*/std::string
+SblDevice::defaultProbeCacheFile()
+{
+    const char *pcDir = getenv("XDG_CACHE_HOME");
+    if(pcDir && pcDir[0] == '/')
+    {
+        return std::string(pcDir) + "/" + SBL_PROBE_CACHE_FILE;
+    }
+    pcDir = getenv("HOME");
+    if(pcDir && pcDir[0] == '/')
+    {
+        return std::string(pcDir) + "/.cache/" + SBL_PROBE_CACHE_FILE;
+    }
+    return std::string();
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Lock the probe cache against other processes. The lock is taken
+ *      on <cache>.lock, because storeProbeCache() replaces the cache file
+ *      itself. The cache directory is created if missing.
+ *
+ * \param[in] operation
+ *      LOCK_SH to read, LOCK_EX to update.
+ *
+ * \return
+ *      Returns the lock file descriptor, closed to unlock, or -1.
+ */
+//-----------------------------------------------------------------------------
+/*static*/int
+SblDevice::lockProbeCache(int operation)
+{
+    size_t slash = sm_csProbeCacheFile.rfind('/');
+    if(operation == LOCK_EX && slash != std::string::npos && slash > 0)
+    {
+        mkdir(sm_csProbeCacheFile.substr(0, slash).c_str(), 0700);
+    }
+
+    int fd = open((sm_csProbeCacheFile + ".lock").c_str(), O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if(fd >= 0 && flock(fd, operation) != 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Utility function returning the chip type of a device ID read by
+ *      readDeviceId().
+ *
+ * \param[in] ui32DeviceId
+ *      The device ID.
+ *
+ * \return
+ *      Returns 0x2538 for CC2538 and 0x2650 for CC26xx/CC13xx devices.
+ */
+//-----------------------------------------------------------------------------
+/*static*/uint32_t
+SblDevice::getChipType(uint32_t ui32DeviceId)
+{
+    switch(ui32DeviceId & 0xFFFF)
+    {
+    case 0xB964:
+    case 0xB965: return SblTraitsCC2538::CHIP_TYPE;
+    default:     return SblTraitsCC2650::CHIP_TYPE;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Take over the open, initialized port of \e other. Used when the
+ *      device turns out to need a different driver than the one that
+ *      connected to it. \e other is left without a port.
+ *
+ * \param[in|out] other
+ *      The device to take the port from.
+ *
+ * \return
+ *      void
+ */
+//-----------------------------------------------------------------------------
+void
+SblDevice::takeOverPort(SblDevice &other)
+{
+    if(m_pCom) { delete m_pCom; }
+    m_pCom = other.m_pCom;
+    m_csComPort = other.m_csComPort;
+    m_baudRate = other.m_baudRate;
+    m_bCommInitialized = other.m_bCommInitialized;
+    m_bFlowControl = other.m_bFlowControl;
+
+    other.m_pCom = NULL;
+    other.m_csComPort.clear();
+    other.m_bCommInitialized = false;
+    other.m_bFlowControl = false;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Utility function calculating a CRC32 checksum the same way the
+ *      CC2538 and CC26xx bootloaders do (CMD_CRC32).
+ *
+ * \param[in] pcData
+ *      Pointer to the data.
+ * \param[in] ui32ByteCount
+ *      Number of bytes.
+ * \param[in] ui32Crc (optional)
+ *      Checksum of the data preceding \e pcData, to calculate a checksum in
+ *      several steps. Defaults to 0 (no preceding data).
+ *
+ * \return
+ *      Returns the checksum.
+ */
+//-----------------------------------------------------------------------------
+/*static*/uint32_t
+SblDevice::calcCrc32(const char *pcData, uint32_t ui32ByteCount, uint32_t ui32Crc/* = 0*/)
+{
+    const unsigned char *pData = (const unsigned char *)pcData;
+    uint32_t d, ind;
+    uint32_t acc = ui32Crc ^ 0xFFFFFFFF;
+    static const uint32_t ui32CrcRand32Lut[] =
+    {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 
+        0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C, 
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 
+        0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+
+    while (ui32ByteCount--)
+    {
+        d = *pData++;
+        ind = (acc & 0x0F) ^ (d & 0x0F);
+        acc = (acc >> 4) ^ ui32CrcRand32Lut[ind];
+        ind = (acc & 0x0F) ^ (d >> 4);
+        acc = (acc >> 4) ^ ui32CrcRand32Lut[ind];
+    }
+
+    return (acc ^ 0xFFFFFFFF);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief CRC32 (see calcCrc32()) of \e ui32ByteCount bytes of blank flash
+ *      (0xFF), to compare with the device CRC of an erased range.
+ */
+//-----------------------------------------------------------------------------
+/*static*/uint32_t
+SblDevice::calcBlankCrc32(uint32_t ui32ByteCount)
+{
+    char pcBlank[256];
+    uint32_t ui32Crc = 0;
+
+    memset(pcBlank, 0xFF, sizeof(pcBlank));
+    while(ui32ByteCount)
+    {
+        uint32_t ui32Count = GTmin(ui32ByteCount, (uint32_t)sizeof(pcBlank));
+        ui32Crc = calcCrc32(pcBlank, ui32Count, ui32Crc);
+        ui32ByteCount -= ui32Count;
+    }
+    return ui32Crc;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Read a flash download checkpoint from \e csFile.
+ *
+ * \param[in] csFile
+ *      Path of the checkpoint file.
+ * \param[out] ckpt
+ *      Populated with the checkpoint.
+ *
+ * \return
+ *      Returns true if a checkpoint was read.
+ */
+//-----------------------------------------------------------------------------
+/*static*/bool
+SblDevice::loadCheckpoint(const std::string &csFile, tSblCheckpoint &ckpt)
+{
+    FILE *pFile = fopen(csFile.c_str(), "r");
+    if(!pFile)
+    {
+        return false;
+    }
+
+    //
+    // <image crc> <byte count> <device id> <start address> <page size> <pages done>
+    //
+    unsigned int crc, count, id, start, pageSize, done;
+    bool bOk = (fscanf(pFile, "%x %u %x %x %u %u", &crc, &count, &id, &start, &pageSize, &done) == 6);
+    fclose(pFile);
+    if(bOk)
+    {
+        ckpt.ui32ImageCrc = crc;
+        ckpt.ui32ByteCount = count;
+        ckpt.ui32DeviceId = id;
+        ckpt.ui32StartAddress = start;
+        ckpt.ui32PageSize = pageSize;
+        ckpt.ui32PagesDone = done;
+    }
+    return bOk;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Write a flash download checkpoint to \e csFile.
+ *
+ * \param[in] csFile
+ *      Path of the checkpoint file.
+ * \param[in] ckpt
+ *      The checkpoint.
+ *
+ * \return
+ *      void
+ */
+//-----------------------------------------------------------------------------
+/*static*/void
+SblDevice::storeCheckpoint(const std::string &csFile, const tSblCheckpoint &ckpt)
+{
+    //
+    // Write to a temporary file and rename it, a checkpoint must never be
+    // half written.
+    //
+    std::string csTmp = csFile + ".tmp";
+    FILE *pFile = fopen(csTmp.c_str(), "w");
+    if(!pFile)
+    {
+        return;
+    }
+    fprintf(pFile, "%08X %u %08X %08X %u %u\n", ckpt.ui32ImageCrc, ckpt.ui32ByteCount, ckpt.ui32DeviceId, 
+            ckpt.ui32StartAddress, ckpt.ui32PageSize, ckpt.ui32PagesDone);
+    fclose(pFile);
+    rename(csTmp.c_str(), csFile.c_str());
+}
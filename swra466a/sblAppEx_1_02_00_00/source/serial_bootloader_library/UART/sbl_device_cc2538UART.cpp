@@ -41,20 +41,12 @@
 //#include "sbl_device.h"
 //#include "sbl_device_cc2538.h"
 
-#include "UART_ComPort.h"
+#include "sbl_transportUART.h"
 #include "ComPortElement.h"
 
 #include <vector>
 
 
-/// Struct used when splitting long transfers
-typedef struct {
-    uint32_t startAddr;
-    uint32_t byteCount;
-    uint32_t startOffset;
-    bool     bExpectAck;
-} tTransfer;
-
 //-----------------------------------------------------------------------------
 /** \brief Constructor
  */
@@ -63,7 +55,7 @@ SblDeviceCC2538::SblDeviceCC2538()
 {
     if(!m_pCom)
     {
-        m_pCom = new UART_ComPort();
+        m_pCom = new SblTransport();
     }
 }
 
@@ -276,11 +268,11 @@ SblDeviceCC2538::readFlashSize(uint32_t *pui32FlashSize)
     //
     // Read CC2538 DIECFG0 (contains FLASH size information)
     //
-    uint32_t addr = SBL_CC2538_DIECFG0;
+    uint32_t addr = Chip::DIECFG0;
     uint32_t value;
     if((retCode = readMemory32(addr, 1, &value)) != SBL_SUCCESS)
     {
-        setState((tSblStatus)retCode, "Failed to read device FLASH size: %s", getLastError().c_str());
+        setState((tSblStatus)retCode, "Failed to read device FLASH size: %s", m_csLastError.c_str());
         return retCode;
     }
 
@@ -321,11 +313,11 @@ SblDeviceCC2538::readRamSize(uint32_t *pui32RamSize)
     //
     // Read CC2538 DIECFG0 (contains RAM size information
     //
-    uint32_t addr = SBL_CC2538_DIECFG0;
+    uint32_t addr = Chip::DIECFG0;
     uint32_t value;
     if((retCode = readMemory32(addr, 1, &value)) != SBL_SUCCESS)
     {
-        setState(retCode, "Failed to read device RAM size: %s", getLastError().c_str());
+        setState(retCode, "Failed to read device RAM size: %s", m_csLastError.c_str());
         return retCode;
     }
 
@@ -453,6 +445,10 @@ SblDeviceCC2538::reset()
  *      that includes the address <startAddress + byteCount>. CC2538 erase 
  *      size is 2KB.
  *
+ *      With setBlankCheck() on, pages that are already blank are not
+ *      erased (see findDirtyPages()). Each run of pages to erase takes one
+ *      erase command.
+ *
  * \param[in] ui32StartAddress
  *      The start address in flash.
  * \param[in] ui32ByteCount
@@ -467,9 +463,6 @@ SblDeviceCC2538::eraseFlashRange(uint32_t ui32StartAddress,
                                  uint32_t ui32ByteCount)
 {
     uint32_t retCode = SBL_SUCCESS;
-    bool bSuccess = false;
-    char pcPayload[8];
-    uint32_t devStatus;
 
     //
     // Initial check
@@ -479,12 +472,72 @@ SblDeviceCC2538::eraseFlashRange(uint32_t ui32StartAddress,
         return SBL_PORT_ERROR;
     }
 
+    m_ui32BlankPages = 0;
+    if(!m_bBlankCheck)
+    {
+        setProgress(0);
+        if((retCode = cmdErase(ui32StartAddress, ui32ByteCount)) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+        setProgress(100);
+        return SBL_SUCCESS;
+    }
+
+    //
+    // Erase only the runs of pages that are not blank
+    //
+    uint32_t ui32StartPage = addressToPage(ui32StartAddress);
+    uint32_t ui32PageCount = Chip::pageCount(ui32StartAddress, ui32ByteCount);
+    std::vector<bool> pvDirty;
+    if((retCode = findDirtyPages(Chip::pageToAddress(ui32StartPage), ui32PageCount, pvDirty)) != SBL_SUCCESS)
+    {
+        return retCode;
+    }
+
+    setProgress(0);
+    uint32_t runCount;
+    for(uint32_t i = 0; (runCount = nextDirtyRun(pvDirty, i, ui32PageCount)) != 0; )
+    {
+        if((retCode = cmdErase(Chip::pageToAddress(ui32StartPage + i), runCount * Chip::PAGE_ERASE_SIZE)) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+        i += runCount;
+        setProgress(100*i/ui32PageCount);
+    }
+    setProgress(100);
+
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Send one erase command for the pages from \e ui32StartAddress to
+ *      <startAddress + byteCount> and check the device status.
+ *
+ * \param[in] ui32StartAddress
+ *      The start address in flash.
+ * \param[in] ui32ByteCount
+ *      The number of bytes to erase.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblDeviceCC2538::cmdErase(uint32_t ui32StartAddress, uint32_t ui32ByteCount)
+{
+    uint32_t retCode = SBL_SUCCESS;
+    bool bSuccess = false;
+    char pcPayload[8];
+    uint32_t devStatus;
+
     //
     // Calculate retry count
     //
-    uint32_t ui32PageCount = ui32ByteCount / SBL_CC2538_PAGE_ERASE_SIZE;
-    if( ui32ByteCount % SBL_CC2538_PAGE_ERASE_SIZE) ui32PageCount ++;
-    uint32_t ui32TryCount = (((ui32PageCount * SBL_CC2538_PAGE_ERASE_TIME_MS) / \
+    uint32_t ui32PageCount = Chip::pageCount(ui32StartAddress, ui32ByteCount);
+    uint32_t ui32TryCount = (((ui32PageCount * Chip::PAGE_ERASE_TIME_MS) / \
                              SBL_DEFAULT_READ_TIMEOUT) + 1);
 
     //
@@ -495,11 +548,6 @@ SblDeviceCC2538::eraseFlashRange(uint32_t ui32StartAddress,
     ulToCharArray(ui32StartAddress, &pcPayload[0]);
     ulToCharArray(ui32ByteCount, &pcPayload[4]);
 
-    //
-    // Set progress
-    //
-    setProgress(0);
-
     //
     // Send command
     //
@@ -530,11 +578,6 @@ SblDeviceCC2538::eraseFlashRange(uint32_t ui32StartAddress,
         return SBL_ERROR;
     }
 
-    //
-    // Set progress
-    //
-    setProgress(100);
-
     return SBL_SUCCESS;
 }
 
@@ -590,7 +633,7 @@ SblDeviceCC2538::readMemory32(uint32_t ui32StartAddress, uint32_t ui32UnitCount,
         // - 1B access width
         //
         ulToCharArray((ui32StartAddress + (i*4)), &pcPayload[0]);
-        pcPayload[4] = SBL_CC2538_ACCESS_WIDTH_4B;
+        pcPayload[4] = Chip::ACCESS_WIDTH_4B;
 
         //
         // Set progress
@@ -716,7 +759,7 @@ SblDeviceCC2538::readMemory8(uint32_t ui32StartAddress, uint32_t ui32UnitCount,
         // - 1B access width
         //
         ulToCharArray((ui32StartAddress + (i*4)), &pcPayload[0]);
-        pcPayload[4] = SBL_CC2538_ACCESS_WIDTH_4B;
+        pcPayload[4] = Chip::ACCESS_WIDTH_4B;
 
         //
         // Set progress
@@ -851,7 +894,7 @@ SblDeviceCC2538::writeMemory32(uint32_t ui32StartAddress,
         //
         ulToCharArray(currAddr, &pcPayload[0]);
         ulToCharArray(pui32Data[i], &pcPayload[4]);
-        pcPayload[8] = SBL_CC2538_ACCESS_WIDTH_4B;
+        pcPayload[8] = Chip::ACCESS_WIDTH_4B;
 
         //
         // Set progress
@@ -950,7 +993,7 @@ SblDeviceCC2538::writeMemory8(uint32_t ui32StartAddress,
         //
         ulToCharArray(currAddr, &pcPayload[0]);
         memcpy(&pcPayload[4], &pcData[(i * 4)], 4);
-        pcPayload[8] = SBL_CC2538_ACCESS_WIDTH_4B;
+        pcPayload[8] = Chip::ACCESS_WIDTH_4B;
 
         //
         // Set progress
@@ -1099,6 +1142,15 @@ SblDeviceCC2538::calculateCrc32(uint32_t ui32StartAddress,
  *      Number of bytes to program. Must be a multiple of 4.
  * \param[in] pcData
  *      Pointer to source data.
+ *
+ * A chunk that is NAKed or gets a bad status is sent again after resyncing
+ * with the device, within the budget set by setRetryPolicy().
+ *
+ * With setPageVerify() on, each page is checked by a device CRC as soon as
+ * it is written, and rewritten if it does not match (see verifyPage()).
+ * Page CRCs given to setPageCrcs() for this image are dropped when the
+ * write ends, whether it succeeded or not.
+ *
  * \return
  *      Returns SBL_SUCCESS, ...
  */
@@ -1106,25 +1158,49 @@ SblDeviceCC2538::calculateCrc32(uint32_t ui32StartAddress,
 uint32_t 
 SblDeviceCC2538::writeFlashRange(uint32_t ui32StartAddress, 
                                  uint32_t ui32ByteCount, const char *pcData)
+{
+    uint32_t retCode = writeTransfers(ui32StartAddress, ui32ByteCount, pcData);
+
+    //
+    // The page CRCs of setPageCrcs() are only good for one write of the image
+    //
+    releasePageCrcs(ui32StartAddress, ui32ByteCount, pcData);
+    return retCode;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief The transfers of writeFlashRange(), which takes the same
+ *      parameters.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+uint32_t 
+SblDeviceCC2538::writeTransfers(uint32_t ui32StartAddress, 
+                                uint32_t ui32ByteCount, const char *pcData)
 {
     uint32_t devStatus = SblDeviceCC2538::CMD_RET_UNKNOWN_CMD;
     uint32_t retCode = SBL_SUCCESS;
     uint32_t bytesLeft, dataIdx, bytesInTransfer;
+    uint32_t ui32VerifyAddress;         // First byte not yet verified (setPageVerify())
     uint32_t transferNumber = 1;
-    bool bIsRetry = false;
+    uint32_t chunkRetries = 0, totalRetries = 0;
+    bool bVerifyChunk = false;          // Chunk must be checked once written, see recoverTransfer()
     bool bBlToBeDisabled = false;
-    std::vector<tTransfer> pvTransfer;
-    uint32_t ui32TotChunks = (ui32ByteCount / SBL_CC2538_MAX_BYTES_PER_TRANSFER);
-    if(ui32ByteCount % SBL_CC2538_MAX_BYTES_PER_TRANSFER) ui32TotChunks++;
+    std::vector<tSblTransfer> pvTransfer;
+    uint32_t ui32TotChunks = (ui32ByteCount / Chip::MAX_BYTES_PER_TRANSFER);
+    if(ui32ByteCount % Chip::MAX_BYTES_PER_TRANSFER) ui32TotChunks++;
     uint32_t ui32CurrChunk = 0;
 
     //
     // Calculate BL configuration address (depends on flash size)
     //
-    uint32_t ui32BlCfgAddr = SBL_CC2538_FLASH_START_ADDRESS +                 \
+    uint32_t ui32BlCfgAddr = Chip::FLASH_START_ADDRESS +                 \
                              getFlashSize() -                                 \
-                             SBL_CC2538_PAGE_ERASE_SIZE +                     \
-                             SBL_CC2538_BL_CONFIG_PAGE_OFFSET;
+                             Chip::PAGE_ERASE_SIZE +                     \
+                             Chip::BL_CONFIG_PAGE_OFFSET;
 
     //
     // Calculate BL configuration buffer index
@@ -1136,7 +1212,7 @@ SblDeviceCC2538::writeFlashRange(uint32_t ui32StartAddress,
     //
     if(ui32BlCfgDataIdx <= ui32ByteCount)
     {
-        if((pcData[ui32BlCfgDataIdx] & SBL_CC2538_BL_CONFIG_ENABLED_BM) == 0)
+        if((pcData[ui32BlCfgDataIdx] & Chip::BL_CONFIG_ENABLED_BM) == 0)
         {
             bBlToBeDisabled = true;
             setState(SBL_SUCCESS, "Warning: CC2538 bootloader will be disabled.\n");
@@ -1223,70 +1299,33 @@ SblDeviceCC2538::writeFlashRange(uint32_t ui32StartAddress,
         //
         bytesLeft = pvTransfer[i].byteCount;
         dataIdx   = pvTransfer[i].startOffset;
+        ui32VerifyAddress = pvTransfer[i].startAddr;
         while(bytesLeft)
         {
-            //
-            // Set progress
-            //
-            //setProgress(addressToPage(ui32StartAddress + dataIdx));
-            setProgress( ((100*(++ui32CurrChunk))/ui32TotChunks) );
-
             //
             // Limit transfer count
             //
-            bytesInTransfer = GTmin(SBL_CC2538_MAX_BYTES_PER_TRANSFER, bytesLeft);
+            bytesInTransfer = GTmin(Chip::MAX_BYTES_PER_TRANSFER, bytesLeft);
+
             //
             // Send Data command
             //
-            if(retCode = cmdSendData(&pcData[dataIdx], bytesInTransfer) != SBL_SUCCESS)
-            {
-                setState(retCode, "Error during flash download. \n- Start address 0x%08X (page %d). \n- Tried to transfer %d bytes. \n- This was transfer %d.\n", 
-                         (ui32StartAddress+dataIdx), 
-                         addressToPage(ui32StartAddress+dataIdx),
-                         bytesInTransfer, 
-                         (transferNumber));
-                return retCode;
-            }
+            devStatus = 0;
+            retCode = cmdSendData(&pcData[dataIdx], bytesInTransfer);
 
-            if(pvTransfer[i].bExpectAck)
+            if(retCode == SBL_SUCCESS && pvTransfer[i].bExpectAck)
             {
                 //
                 // Check status after send data command
                 //
-                devStatus = 0;
                 retCode = readStatus(&devStatus);
-                if(retCode != SBL_SUCCESS)
-                {
-                    setState(retCode, "Error during flash download. Failed to read device status.\n- Start address 0x%08X (page %d). \n- Tried to transfer %d bytes. \n- This was transfer %d in chunk %d.\n", 
-                                 (ui32StartAddress+dataIdx), 
-                                 addressToPage(ui32StartAddress + dataIdx),
-                                 (bytesInTransfer), (transferNumber), 
-                                 (i));
-                    return retCode;
-                }
-                if(devStatus != SblDeviceCC2538::CMD_RET_SUCCESS)
+                if(retCode == SBL_SUCCESS && devStatus != SblDeviceCC2538::CMD_RET_SUCCESS)
                 {
                     setState(SBL_SUCCESS, "Device returned status %s\n", getCmdStatusString(devStatus).c_str());
-                    if(bIsRetry)
-                    {
-                        //
-                        // We have failed a second time. Aborting.
-                        setState(SBL_ERROR, "Error retrying flash download.\n- Start address 0x%08X (page %d). \n- Tried to transfer %d bytes. \n- This was transfer %d in chunk %d.\n", 
-                                 (ui32StartAddress+dataIdx), 
-                                 addressToPage(ui32StartAddress + dataIdx),
-                                 (bytesInTransfer), (transferNumber), 
-                                 (i));
-                        return SBL_ERROR;
-                    }
-
-                    //
-                    // Retry to send data one more time.
-                    //
-                    bIsRetry = true;
-                    continue;
+                    retCode = SBL_ERROR;
                 }
             }
-            else
+            else if(retCode == SBL_SUCCESS && !pvTransfer[i].bExpectAck)
             {
                 //
                 // We're locking device and will lose access
@@ -1295,13 +1334,71 @@ SblDeviceCC2538::writeFlashRange(uint32_t ui32StartAddress,
 
             }
 
+            if(retCode != SBL_SUCCESS)
+            {
+                //
+                // Resync and restart the download at this chunk. Gives up when
+                // the retry budget is spent.
+                //
+                if((retCode = recoverTransfer(ui32StartAddress + dataIdx, bytesLeft, bytesInTransfer, 
+                                              transferNumber, chunkRetries, totalRetries, 
+                                              bVerifyChunk)) != SBL_SUCCESS)
+                {
+                    return retCode;
+                }
+                continue;
+            }
+
+            //
+            // The device may have programmed zeros over this chunk before it
+            // was sent again. Check it, rewriting its page if needed.
+            //
+            if(bVerifyChunk && pvTransfer[i].bExpectAck)
+            {
+                bVerifyChunk = false;
+                if((retCode = verifyChunk(ui32StartAddress + dataIdx, bytesInTransfer, &pcData[dataIdx])) != SBL_SUCCESS)
+                {
+                    return retCode;
+                }
+                if(bytesLeft > bytesInTransfer && 
+                   (retCode = restartDownload(ui32StartAddress + dataIdx + bytesInTransfer, 
+                                              bytesLeft - bytesInTransfer)) != SBL_SUCCESS)
+                {
+                    return retCode;
+                }
+            }
+
             //
             // Update index and bytesLeft
             //
             bytesLeft -= bytesInTransfer;
             dataIdx += bytesInTransfer;
             transferNumber++;
-            bIsRetry = false;
+            chunkRetries = 0;
+
+            //
+            // Set progress
+            //
+            setProgress(((100*(++ui32CurrChunk))/ui32TotChunks));
+
+            //
+            // Verify-as-you-go: CRC each page as soon as it is written
+            //
+            if(m_bPageVerify && pvTransfer[i].bExpectAck)
+            {
+                bool bVerified;
+                if((retCode = verifyPages(ui32VerifyAddress, ui32StartAddress + dataIdx, 
+                                          pvTransfer[i].startAddr + pvTransfer[i].byteCount, 
+                                          ui32StartAddress, pcData, bVerified)) != SBL_SUCCESS)
+                {
+                    return retCode;
+                }
+                if(bVerified && bytesLeft && 
+                   (retCode = restartDownload(ui32StartAddress + dataIdx, bytesLeft)) != SBL_SUCCESS)
+                {
+                    return retCode;
+                }
+            }
         }
     }
 
@@ -1383,9 +1480,22 @@ SblDeviceCC2538::setBootloaderMode(int pigpiodID)
         setState(SBL_PORT_ERROR, "COM port not initiated.\n");
         return SBL_PORT_ERROR;
     }
-    if(m_pCom->setBootloaderMode(pigpiodID) != SBL_SUCCESS) {
+    int result = m_pCom->setBootloaderMode(pigpiodID);
+    if(result == SBL_PORT_BUSY_ERROR) {
+        if(m_pCom->getBusyOwner() > 0)
+            setState(SBL_PORT_BUSY_ERROR, "SBL: Bootloader GPIOs are in use by process %d.\n", m_pCom->getBusyOwner());
+        else
+            setState(SBL_PORT_BUSY_ERROR, "SBL: Bootloader GPIOs are in use by another process.\n");
+        return SBL_PORT_BUSY_ERROR;
+    }
+    if(result == SBL_PORT_ERROR && !m_pCom->getLockError().empty()) {
+        setState(SBL_PORT_ERROR, "SBL: %s.\n", m_pCom->getLockError().c_str());
+        return SBL_PORT_ERROR;
+    }
+    if(result != SBL_SUCCESS) {
         return SBL_ERROR;
     }
+    return SBL_SUCCESS;
 }
 
 //-----------------------------------------------------------------------------
@@ -1419,10 +1529,14 @@ SblDeviceCC2538::initCommunication(bool bSetXosc)
     }
 
     //
-    // Do we get a response (ACK/NAK)?
+    // Do we get a response (ACK/NAK)? When reconnecting to a device left in
+    // bootloader mode, give it SBL_PROBE_TIMEOUT to answer.
     //
     bSuccess = false;
-    if(getCmdResponse(bSuccess, SBL_DEFAULT_RETRY_COUNT, true) != SBL_SUCCESS)
+    if(m_bTryPing) setDeadline(SBL_PROBE_TIMEOUT);
+    retCode = getCmdResponse(bSuccess, (m_bTryPing) ? 1000000 : SBL_DEFAULT_RETRY_COUNT, true);
+    setDeadline(0);
+    if(retCode != SBL_SUCCESS)
     {
         //
         // No response received. Try auto baud
@@ -1595,7 +1709,7 @@ SblDeviceCC2538::cmdDownload(uint32_t ui32Address, uint32_t ui32Size)
 //-----------------------------------------------------------------------------
 /** \brief This function sends the CC2538 SendData command and handles the
  *      device response. \e ui32ByteCount is limited by 
- *      SBL_CC2538_MAX_BYTES_PER_TRANSFER.
+ *      Chip::MAX_BYTES_PER_TRANSFER.
  *
  * \param[in] pcData
  *      Pointer to the data to send.
@@ -1615,9 +1729,9 @@ SblDeviceCC2538::cmdSendData(const char *pcData, uint32_t ui32ByteCount)
     //
     // Check input arguments
     //
-    if(ui32ByteCount > SBL_CC2538_MAX_BYTES_PER_TRANSFER)
+    if(ui32ByteCount > Chip::MAX_BYTES_PER_TRANSFER)
     {
-        setState(SBL_ERROR, "Error: Byte count (%d) exceeds maximum transfer size %d.\n", ui32ByteCount, SBL_CC2538_MAX_BYTES_PER_TRANSFER);
+        setState(SBL_ERROR, "Error: Byte count (%d) exceeds maximum transfer size %d.\n", ui32ByteCount, Chip::MAX_BYTES_PER_TRANSFER);
         return SBL_ERROR;
     }
 
@@ -1683,70 +1797,3 @@ SblDeviceCC2538::setXosc()
 }
 
 
-//-----------------------------------------------------------------------------
-/** \brief This function returns the address within which the specified
- *      \e ui32Address is  located.
- *
- * \return
- *      Returns the flash page within which an address is located.
- */
-//-----------------------------------------------------------------------------
-uint32_t
-SblDeviceCC2538::addressToPage(uint32_t ui32Address)
-{
-    return ((ui32Address - SBL_CC2538_FLASH_START_ADDRESS) /                  \
-            SBL_CC2538_PAGE_ERASE_SIZE);
-}
-
-
-//-----------------------------------------------------------------------------
-/** \brief This function checks if the specified \e ui32StartAddress (or range)
- *      is located within the device RAM area.
- *
- * \return
- *      Returns true if the address/range is within the device RAM.
- */
-//-----------------------------------------------------------------------------
-bool 
-SblDeviceCC2538::addressInRam(uint32_t ui32StartAddress, 
-                              uint32_t ui32ByteCount/* = 1*/)
-{
-    uint32_t ui32EndAddr = ui32StartAddress + ui32ByteCount;
-
-    if(ui32StartAddress < SBL_CC2538_RAM_START_ADDRESS)
-    {
-        return false;
-    }
-    if(ui32EndAddr > (SBL_CC2538_RAM_START_ADDRESS + getRamSize()))
-    {
-        return false;
-    }
-    return true;
-}
-
-
-//-----------------------------------------------------------------------------
-/** \brief This function checks if the specified \e ui32StartAddress (or range)
- *      is located within the device FLASH area.
- *
- * \return
- *      Returns true if the address/range is within the device FLASH.
- */
-//-----------------------------------------------------------------------------
-bool
-SblDeviceCC2538::addressInFlash(uint32_t ui32StartAddress, 
-                                         uint32_t ui32ByteCount/* = 1*/)
-{
-    uint32_t ui32EndAddr = ui32StartAddress + ui32ByteCount;
-
-    if(ui32StartAddress < SBL_CC2538_FLASH_START_ADDRESS)
-    {
-        return false;
-    }
-    if(ui32EndAddr > (SBL_CC2538_FLASH_START_ADDRESS + getFlashSize()))
-    {
-        return false;
-    }
-    
-    return true;
-}
@@ -42,21 +42,13 @@
 //#include "sbl_device_cc2650.h"
 #include <stdio.h>
 
-#include "UART_ComPort.h"
+#include "sbl_transportUART.h"
 #include "ComPortElement.h"
 
 #include <vector>
 #include <math.h>
 
 
-/// Struct used when splitting long transfers
-typedef struct {
-    uint32_t startAddr;
-    uint32_t byteCount;
-    uint32_t startOffset;
-    bool     bExpectAck;
-} tTransfer;
-
 static uint32_t getDeviceRev(uint32_t deviceId)
 {
     uint32_t tmp = deviceId >> 28;
@@ -76,13 +68,14 @@ static uint32_t getDeviceRev(uint32_t deviceId)
 /** \brief Constructor
  */
 //-----------------------------------------------------------------------------
-SblDeviceCC2650::SblDeviceCC2650()
+template <class TTraits>
+SblDeviceCC26xx<TTraits>::SblDeviceCC26xx()
 {
     m_deviceRev = 0;
 
     if(!m_pCom)
     {
-        m_pCom = new UART_ComPort();
+        m_pCom = new SblTransport();
     }
 }
 
@@ -90,7 +83,8 @@ SblDeviceCC2650::SblDeviceCC2650()
 /** \brief Destructor
  */
 //-----------------------------------------------------------------------------
-SblDeviceCC2650::~SblDeviceCC2650()
+template <class TTraits>
+SblDeviceCC26xx<TTraits>::~SblDeviceCC26xx()
 {
 }
 
@@ -101,8 +95,9 @@ SblDeviceCC2650::~SblDeviceCC2650()
  *      Returns SBL_SUCCESS, ...
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 uint32_t
-SblDeviceCC2650::ping()
+SblDeviceCC26xx<TTraits>::ping()
 {
     int retCode = SBL_SUCCESS;
     bool bResponse = false;
@@ -115,7 +110,7 @@ SblDeviceCC2650::ping()
     //
     // Send command
     //
-    if((retCode = sendCmd(SblDeviceCC2650::CMD_PING)) != SBL_SUCCESS)
+    if((retCode = sendCmd(SblDeviceCC26xx::CMD_PING)) != SBL_SUCCESS)
     {
         return retCode;
     }
@@ -141,8 +136,9 @@ SblDeviceCC2650::ping()
  *      Returns SBL_SUCCESS, ...
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 uint32_t
-SblDeviceCC2650::readStatus(uint32_t *pui32Status)
+SblDeviceCC26xx<TTraits>::readStatus(uint32_t *pui32Status)
 {
     uint32_t retCode = SBL_SUCCESS;
     bool bSuccess = false;
@@ -155,7 +151,7 @@ SblDeviceCC2650::readStatus(uint32_t *pui32Status)
     //
     // Send command
     //
-    if((retCode = sendCmd(SblDeviceCC2650::CMD_GET_STATUS)) != SBL_SUCCESS)
+    if((retCode = sendCmd(SblDeviceCC26xx::CMD_GET_STATUS)) != SBL_SUCCESS)
     {
         return retCode;        
     }
@@ -207,8 +203,9 @@ SblDeviceCC2650::readStatus(uint32_t *pui32Status)
  *      Returns SBL_SUCCESS, ...
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 uint32_t 
-SblDeviceCC2650::readDeviceId(uint32_t *pui32DeviceId)
+SblDeviceCC26xx<TTraits>::readDeviceId(uint32_t *pui32DeviceId)
 {
     int retCode = SBL_SUCCESS;
     bool bSuccess = false;
@@ -221,7 +218,7 @@ SblDeviceCC2650::readDeviceId(uint32_t *pui32DeviceId)
     //
     // Send command
     //
-    if((retCode = sendCmd(SblDeviceCC2650::CMD_GET_CHIP_ID)) != SBL_SUCCESS)
+    if((retCode = sendCmd(SblDeviceCC26xx::CMD_GET_CHIP_ID)) != SBL_SUCCESS)
     {
         return retCode;
     }
@@ -292,26 +289,27 @@ SblDeviceCC2650::readDeviceId(uint32_t *pui32DeviceId)
  *      Returns SBL_SUCCESS, ...
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 uint32_t 
-SblDeviceCC2650::readFlashSize(uint32_t *pui32FlashSize)
+SblDeviceCC26xx<TTraits>::readFlashSize(uint32_t *pui32FlashSize)
 {
     uint32_t retCode = SBL_SUCCESS;
 
     //
     // Read CC2650 DIECFG0 (contains FLASH size information)
     //
-    uint32_t addr = SBL_CC2650_FLASH_SIZE_CFG;
+    uint32_t addr = Chip::FLASH_SIZE_CFG;
     uint32_t value;
     if((retCode = readMemory32(addr, 1, &value)) != SBL_SUCCESS)
     {
-        setState((tSblStatus)retCode, "Failed to read device FLASH size: %s", getLastError().c_str());
+        setState((tSblStatus)retCode, "Failed to read device FLASH size: %s", m_csLastError.c_str());
         return retCode;
     }
     //
     // Calculate flash size (The number of flash sectors are at bits [7:0])
     //
     value &= 0xFF;
-    *pui32FlashSize = value*SBL_CC2650_PAGE_ERASE_SIZE;
+    *pui32FlashSize = value*Chip::PAGE_ERASE_SIZE;
 
     m_flashSize = *pui32FlashSize;
 
@@ -328,19 +326,20 @@ SblDeviceCC2650::readFlashSize(uint32_t *pui32FlashSize)
  *      Returns SBL_SUCCESS, ...
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 uint32_t 
-SblDeviceCC2650::readRamSize(uint32_t *pui32RamSize)
+SblDeviceCC26xx<TTraits>::readRamSize(uint32_t *pui32RamSize)
 {
     int retCode = SBL_SUCCESS;
 
     //
     // Read CC2650 DIECFG0 (contains RAM size information
     //
-    uint32_t addr = SBL_CC2650_RAM_SIZE_CFG;
+    uint32_t addr = Chip::RAM_SIZE_CFG;
     uint32_t value;
     if((retCode = readMemory32(addr, 1, &value)) != SBL_SUCCESS)
     {
-        setState(retCode, "Failed to read device RAM size: %s", getLastError().c_str());
+        setState(retCode, "Failed to read device RAM size: %s", m_csLastError.c_str());
         return retCode;
     }
 
@@ -388,8 +387,9 @@ SblDeviceCC2650::readRamSize(uint32_t *pui32RamSize)
  *      Returns SBL_SUCCESS, ...
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 uint32_t
-SblDeviceCC2650::reset()
+SblDeviceCC26xx<TTraits>::reset()
 {
     int retCode = SBL_SUCCESS;
     bool bSuccess = false;
@@ -402,7 +402,7 @@ SblDeviceCC2650::reset()
     //
     // Send command
     //
-    if((retCode = sendCmd(SblDeviceCC2650::CMD_RESET)) != SBL_SUCCESS)
+    if((retCode = sendCmd(SblDeviceCC26xx::CMD_RESET)) != SBL_SUCCESS)
     {
         return retCode;        
     }
@@ -431,6 +431,15 @@ SblDeviceCC2650::reset()
  *      that includes the address <startAddress + byteCount>. CC13/CC26xx erase 
  *      size is 4KB.
  *
+ *      Pages are erased in batches of Chip::SECTOR_ERASE_BATCH (see
+ *      sectorEraseBatch()) with one status read and one CRC per batch. The
+ *      status only tells how the last erase of a batch went; the CRC tells
+ *      whether all of it is blank. A batch that fails either check is
+ *      erased again page by page to find the page at fault.
+ *
+ *      With setBlankCheck() on, pages that are already blank are not
+ *      erased (see findDirtyPages()).
+ *
  * \param[in] ui32StartAddress
  *      The start address in flash.
  * \param[in] ui32ByteCount
@@ -440,13 +449,12 @@ SblDeviceCC2650::reset()
  *      Returns SBL_SUCCESS, ...
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 uint32_t
-SblDeviceCC2650::eraseFlashRange(uint32_t ui32StartAddress, 
+SblDeviceCC26xx<TTraits>::eraseFlashRange(uint32_t ui32StartAddress, 
                                  uint32_t ui32ByteCount)
 {
     uint32_t retCode = SBL_SUCCESS;
-    bool bSuccess = false;
-    char pcPayload[4];
     uint32_t devStatus;
 
     //
@@ -457,59 +465,171 @@ SblDeviceCC2650::eraseFlashRange(uint32_t ui32StartAddress,
         return SBL_PORT_ERROR;
     }
 
-    //
-    // Calculate retry count
-    //
-    uint32_t ui32PageCount = ui32ByteCount / SBL_CC2650_PAGE_ERASE_SIZE;
-    if(ui32ByteCount % SBL_CC2650_PAGE_ERASE_SIZE) ui32PageCount ++;
-    setProgress(0);
-    for(uint32_t i = 0; i < ui32PageCount; i++)
+    uint32_t ui32StartPage = addressToPage(ui32StartAddress);
+    uint32_t ui32PageCount = Chip::pageCount(ui32StartAddress, ui32ByteCount);
+    std::vector<bool> pvDirty(ui32PageCount, true);
+    m_ui32BlankPages = 0;
+    if(m_bBlankCheck && 
+       (retCode = findDirtyPages(Chip::pageToAddress(ui32StartPage), ui32PageCount, pvDirty)) != SBL_SUCCESS)
     {
+        return retCode;
+    }
 
+    setProgress(0);
+    uint32_t batchCount;
+    for(uint32_t i = 0; (batchCount = nextDirtyRun(pvDirty, i, Chip::SECTOR_ERASE_BATCH)) != 0; )
+    {
         //
-        // Build payload
-        // - 4B address (MSB first)
+        // A batch is a run of pages to erase
         //
-        ulToCharArray(ui32StartAddress + i*(4096), &pcPayload[0]);
 
         //
-        // Send command
+        // Erase the batch and check device status (Flash failed if page(s)
+        // locked). The status is that of the last erase only, so the batch
+        // is also checked to be blank, with one CRC.
         //
-        if((retCode = sendCmd(SblDeviceCC2650::CMD_SECTOR_ERASE, pcPayload, 4)) != SBL_SUCCESS)
+        bool bBlank = false;
+        retCode = sectorEraseBatch(ui32StartPage + i, batchCount);
+        if(retCode == SBL_SUCCESS)
         {
-            return retCode;
+            retCode = readStatus(&devStatus);
         }
-
-        //
-        // Receive command response (ACK/NAK)
-        //
-        if((retCode = getCmdResponse(bSuccess, 10000000)) != SBL_SUCCESS)
+        if(retCode == SBL_SUCCESS && devStatus == SblDeviceCC26xx::CMD_RET_SUCCESS &&
+           (retCode = checkBlank(Chip::pageToAddress(ui32StartPage + i), batchCount * Chip::PAGE_ERASE_SIZE, 
+                                 bBlank)) != SBL_SUCCESS)
         {
             return retCode;
         }
-        if(!bSuccess)
+        if(bBlank)
         {
-            return SBL_ERROR;
+            i += batchCount;
+            setProgress(100*i/ui32PageCount);
+            continue;
         }
 
         //
-        // Check device status (Flash failed if page(s) locked)
+        // Find the page at fault
         //
-        readStatus(&devStatus);
-        if(devStatus != SblDeviceCC2650::CMD_RET_SUCCESS)
+        for(uint32_t j = 0; j < batchCount; j++)
         {
-            setState(SBL_ERROR, "Flash erase failed. (Status 0x%02X = '%s'). Flash pages may be locked.\n", devStatus, getCmdStatusString(devStatus).c_str());
-            return SBL_ERROR;
+            uint32_t ui32Page = ui32StartPage + i + j;
+            if((retCode = sectorEraseBatch(ui32Page, 1)) != SBL_SUCCESS ||
+               (retCode = readStatus(&devStatus)) != SBL_SUCCESS)
+            {
+                return retCode;
+            }
+            if(devStatus != SblDeviceCC26xx::CMD_RET_SUCCESS)
+            {
+                setState(SBL_ERROR, "Flash erase of page %d (0x%08X) failed. (Status 0x%02X = '%s'). Flash pages may be locked.\n", 
+                         ui32Page, Chip::pageToAddress(ui32Page), devStatus, getCmdStatusString(devStatus).c_str());
+                return SBL_ERROR;
+            }
+            if((retCode = checkBlank(Chip::pageToAddress(ui32Page), Chip::PAGE_ERASE_SIZE, bBlank)) != SBL_SUCCESS)
+            {
+                return retCode;
+            }
+            if(!bBlank)
+            {
+                setState(SBL_ERROR, "Flash page %d (0x%08X) is not blank after erase. Flash pages may be locked.\n", 
+                         ui32Page, Chip::pageToAddress(ui32Page));
+                return SBL_ERROR;
+            }
         }
-
-        setProgress(100*(i+1)/ui32PageCount);
+        i += batchCount;
+        setProgress(100*i/ui32PageCount);
     }
-  
 
     return SBL_SUCCESS;
 }
 
 
+//-----------------------------------------------------------------------------
+/** \brief Erase \e ui32PageCount pages from \e ui32FirstPage on. The sector
+ *      erase commands go out in one write and their ACKs are collected
+ *      afterwards, so the device erases page after page without waiting for
+ *      the host. The device UART buffers the queued commands while a page is
+ *      erased, which is what limits a batch to Chip::SECTOR_ERASE_BATCH.
+ *
+ *      Instead of a fixed retry count, the ACKs are waited for until a
+ *      deadline derived from the page erase time.
+ *
+ * \param[in] ui32FirstPage
+ *      First page to erase.
+ * \param[in] ui32PageCount
+ *      Number of pages, at most Chip::SECTOR_ERASE_BATCH.
+ *
+ * \return
+ *      Returns SBL_SUCCESS if every command was ACKed, ...
+ */
+//-----------------------------------------------------------------------------
+template <class TTraits>
+uint32_t
+SblDeviceCC26xx<TTraits>::sectorEraseBatch(uint32_t ui32FirstPage, uint32_t ui32PageCount)
+{
+    uint32_t retCode = SBL_SUCCESS;
+    bool bSuccess = false;
+    char pcPayload[4];
+    std::vector<char> pvPkt, pvBatch;
+
+    //
+    // Build one packet per page
+    // - 4B address (MSB first)
+    //
+    for(uint32_t i = 0; i < ui32PageCount; i++)
+    {
+        ulToCharArray(Chip::pageToAddress(ui32FirstPage + i), &pcPayload[0]);
+        buildCmdPacket(convertCmdForEarlySamples(SblDeviceCC26xx::CMD_SECTOR_ERASE), pcPayload, 4, pvPkt);
+        pvBatch.insert(pvBatch.end(), pvPkt.begin(), pvPkt.end());
+    }
+
+    //
+    // Send them at once
+    //
+    int numBytes = 0, retry = 0;
+    do
+    {
+        retry++;
+        int ret = m_pCom->writeBytes(&pvBatch[0]+numBytes, pvBatch.size()-numBytes);
+        if (ret < 0) continue;
+        numBytes += ret;
+    }
+    while (numBytes < (int)pvBatch.size() && retry < 10000000);
+
+    if (numBytes < (int)pvBatch.size())
+    {
+        setState(SBL_PORT_ERROR, "Writing to device failed (Command '%s').\n", 
+                 getCmdString(SblDeviceCC26xx::CMD_SECTOR_ERASE).c_str());
+        return SBL_PORT_ERROR;
+    }
+
+    //
+    // Receive command responses (ACK/NAK). The last one comes once the
+    // pages before it are erased; allow twice the nominal erase time. After
+    // a NAK the ACKs of the rest are still read, up to the deadline, so
+    // none is taken for the response to the next command.
+    //
+    setDeadline(ui32PageCount * Chip::PAGE_ERASE_TIME_MS * 2 + SBL_DEFAULT_READ_TIMEOUT);
+    for(uint32_t i = 0; i < ui32PageCount && !deadlineExpired(); i++)
+    {
+        uint32_t ret = getCmdResponse(bSuccess, 1000000, retCode != SBL_SUCCESS);
+        if(retCode != SBL_SUCCESS)
+        {
+            continue;
+        }
+        if(ret == SBL_SUCCESS && !bSuccess)
+        {
+            setState(SBL_ERROR, "Device NAKed erase of page %d (0x%08X).\n", 
+                     ui32FirstPage + i, Chip::pageToAddress(ui32FirstPage + i));
+            ret = SBL_ERROR;
+        }
+        retCode = ret;
+    }
+    setDeadline(0);
+
+    return retCode;
+}
+
+
 //-----------------------------------------------------------------------------
 /** \brief This function reads \e ui32UnitCount (32 bit) words of data from 
  *      device. Destination array is 32 bit wide. The start address must be 4 
@@ -525,12 +645,12 @@ SblDeviceCC2650::eraseFlashRange(uint32_t ui32StartAddress,
  *      Returns SBL_SUCCESS, ...
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 uint32_t 
-SblDeviceCC2650::readMemory32(uint32_t ui32StartAddress, uint32_t ui32UnitCount, 
+SblDeviceCC26xx<TTraits>::readMemory32(uint32_t ui32StartAddress, uint32_t ui32UnitCount, 
                               uint32_t *pui32Data)
 {
     int retCode = SBL_SUCCESS;
-    bool bSuccess = false;
 
     //
     // Check input arguments
@@ -551,84 +671,11 @@ SblDeviceCC2650::readMemory32(uint32_t ui32StartAddress, uint32_t ui32UnitCount,
         return SBL_PORT_ERROR;
     }
 
-    unsigned char pcPayload[6];
-	uint32_t responseData[SBL_CC2650_MAX_MEMREAD_WORDS];
-	uint32_t chunkCount = ui32UnitCount / SBL_CC2650_MAX_MEMREAD_WORDS;
-	if(ui32UnitCount % SBL_CC2650_MAX_MEMREAD_WORDS) chunkCount++;
-	uint32_t remainingCount = ui32UnitCount;
-
-	for(uint32_t i = 0; i < chunkCount; i++)
-	{
-		uint32_t dataOffset = (i * SBL_CC2650_MAX_MEMREAD_WORDS);
-		uint32_t chunkStart = ui32StartAddress + dataOffset;
-		uint32_t chunkSize  = GTmin(remainingCount, SBL_CC2650_MAX_MEMREAD_WORDS);
-		remainingCount -= chunkSize;
-    
-        //
-        // Build payload
-        // - 4B address (MSB first)
-        // - 1B access width
-		// - 1B Number of accesses (in words)
-        //
-        ulToCharArray(chunkStart, (char *)&pcPayload[0]);
-        pcPayload[4] = SBL_CC2650_ACCESS_WIDTH_32B;
-        pcPayload[5] = chunkSize;
-		//
-        // Set progress
-        //
-        setProgress(((i * 100) / chunkCount));
-
-        //
-        // Send command
-        //
-        if((retCode = sendCmd(SblDeviceCC2650::CMD_MEMORY_READ, (char *)pcPayload, 6)) != SBL_SUCCESS)
-        {
-            return retCode;
-        }
-
-        //
-        // Receive command response (ACK/NAK)
-        //
-        if((retCode = getCmdResponse(bSuccess, 1000000)) != SBL_SUCCESS)
-        {
-            return retCode;
-        }
-        if(!bSuccess)
-        {
-            return SBL_ERROR;
-        }
-
-        //
-        // Receive 4B response
-        //
-		uint32_t expectedBytes = chunkSize * 4;
-		uint32_t recvBytes = expectedBytes;
-        if((retCode = getResponseData((char*)responseData, recvBytes, 100000)) != SBL_SUCCESS)
-        {
-            //
-            // Respond with NAK
-            //
-            sendCmdResponse(false);
-            return retCode;
-        }
-	
-		if(recvBytes != expectedBytes)
-        {
-            //
-            // Respond with NAK
-            //
-            sendCmdResponse(false);
-            setState(SBL_ERROR, "Didn't receive 4 B.\n");
-            return SBL_ERROR;
-        }
-
-		memcpy(&pui32Data[dataOffset], responseData, expectedBytes);
-		//delete [] responseData;
-        //
-        // Respond with ACK
-        //
-        sendCmdResponse(true);
-	}
+    if((retCode = readMemoryChunks(ui32StartAddress, ui32UnitCount, Chip::ACCESS_WIDTH_32B, 
+                                   (char *)pui32Data)) != SBL_SUCCESS)
+    {
+        return retCode;
+    }
 
     //
     // Set progress
@@ -653,12 +700,12 @@ SblDeviceCC2650::readMemory32(uint32_t ui32StartAddress, uint32_t ui32UnitCount,
  *      Returns SBL_SUCCESS, ...
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 uint32_t 
-SblDeviceCC2650::readMemory8(uint32_t ui32StartAddress, uint32_t ui32UnitCount, 
+SblDeviceCC26xx<TTraits>::readMemory8(uint32_t ui32StartAddress, uint32_t ui32UnitCount, 
                               char *pcData)
 {
     int retCode = SBL_SUCCESS;
-    bool bSuccess = false;
 
     //
     // Check input arguments
@@ -674,86 +721,139 @@ SblDeviceCC2650::readMemory8(uint32_t ui32StartAddress, uint32_t ui32UnitCount,
         return SBL_PORT_ERROR;
     }
 
-    unsigned char pcPayload[6];
-	uint32_t chunkCount = ui32UnitCount / SBL_CC2650_MAX_MEMREAD_BYTES;
-	if(ui32UnitCount % SBL_CC2650_MAX_MEMREAD_BYTES) chunkCount++;
-	uint32_t remainingCount = ui32UnitCount;
+    if((retCode = readMemoryChunks(ui32StartAddress, ui32UnitCount, Chip::ACCESS_WIDTH_8B, 
+                                   pcData)) != SBL_SUCCESS)
+    {
+        return retCode;
+    }
 
-	for(uint32_t i = 0; i < chunkCount; i++)
-	{
-		uint32_t dataOffset = (i * SBL_CC2650_MAX_MEMREAD_BYTES);
-		uint32_t chunkStart = ui32StartAddress + dataOffset;
-		uint32_t chunkSize  = GTmin(remainingCount, SBL_CC2650_MAX_MEMREAD_BYTES);
-		remainingCount -= chunkSize;
-    
-		//
-		// Build payload
-		// - 4B address (MSB first)
-		// - 1B access width
-		// - 1B number of accesses (in bytes)
-		//
-		ulToCharArray(chunkStart, (char *)&pcPayload[0]);
-		pcPayload[4] = SBL_CC2650_ACCESS_WIDTH_8B;
-		pcPayload[5] = chunkSize;
+    //
+    // Set progress
+    //
+    setProgress(100);
 
-		//
-		// Set progress
-		//
-		setProgress(((i*100) / chunkCount));
+    return SBL_SUCCESS;
+}
 
-		//
-		// Send command
-		//
-		if((retCode = sendCmd(SblDeviceCC2650::CMD_MEMORY_READ, (char *)pcPayload, 6)) != SBL_SUCCESS)
-		{
-			return retCode;        
-		}
 
-		//
-		// Receive command response (ACK/NAK)
-		//
-		if((retCode = getCmdResponse(bSuccess, 1000000)) != SBL_SUCCESS)
-		{
-			return retCode;
-		}
-		if(!bSuccess)
-		{
-			return SBL_ERROR;
-		}
+//-----------------------------------------------------------------------------
+/** \brief This function reads \e ui32UnitCount units of data from device,
+ *      split in as many CMD_MEMORY_READ commands as needed.
+ *
+ *      The reads are pipelined: the command for the next chunk is sent in
+ *      the same write as the ACK for the current one, and the ACK and data
+ *      frame of each response are parsed in one receive loop. This gives
+ *      one turnaround per chunk instead of two.
+ *
+ * \param[in] ui32StartAddress
+ *      Start address in device.
+ * \param[in] ui32UnitCount
+ *      Number of units to read.
+ * \param[in] ui32AccessWidth
+ *      Chip::ACCESS_WIDTH_8B or Chip::ACCESS_WIDTH_32B.
+ * \param[out] pcData
+ *      Pointer to where read data is stored.
+ * \return
+ *      Returns SBL_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+template <class TTraits>
+uint32_t
+SblDeviceCC26xx<TTraits>::readMemoryChunks(uint32_t ui32StartAddress, uint32_t ui32UnitCount, 
+                                  uint32_t ui32AccessWidth, char *pcData)
+{
+    int retCode = SBL_SUCCESS;
+    bool bSuccess = false;
+    uint32_t unitSize = (ui32AccessWidth == Chip::ACCESS_WIDTH_32B) ? 4 : 1;
+    uint32_t maxUnits = (ui32AccessWidth == Chip::ACCESS_WIDTH_32B) ? 
+                        Chip::MAX_MEMREAD_WORDS : Chip::MAX_MEMREAD_BYTES;
+    uint32_t chunkCount = ui32UnitCount / maxUnits;
+    if(ui32UnitCount % maxUnits) chunkCount++;
 
-		//
-		// Receive response
-		//
-		uint32_t expectedBytes = chunkSize;
-		if((retCode = getResponseData(&pcData[dataOffset], chunkSize, 100000)) != SBL_SUCCESS)
-		{
-			//
-			// Respond with NAK
-			//
-			sendCmdResponse(false);
-			return retCode;            
-		}
+    unsigned char pcPayload[6];
+    std::vector<char> pvPkt;
+    uint32_t cmd = convertCmdForEarlySamples(SblDeviceCC26xx::CMD_MEMORY_READ);
 
-		if(chunkSize != expectedBytes)
-		{
-			//
-			// Respond with NAK
-			//
-			sendCmdResponse(false);
-			setState(SBL_ERROR, "readMemory8(): Received %d bytes (%d B expected) in iteration %d.\n", chunkSize, expectedBytes, i);
-			return SBL_ERROR;
-		}
+    for(uint32_t i = 0; i < chunkCount; i++)
+    {
+        uint32_t dataOffset = i * maxUnits * unitSize;
+        uint32_t chunkSize  = GTmin(ui32UnitCount - (i * maxUnits), maxUnits);
 
-		//
-		// Respond with ACK
-		//
-		sendCmdResponse(true);
-	}
+        //
+        // The first command is sent on its own, the others go out together
+        // with the ACK for the previous chunk (see below).
+        //
+        if(i == 0)
+        {
+            //
+            // Build payload
+            // - 4B address (MSB first)
+            // - 1B access width
+            // - 1B number of accesses
+            //
+            ulToCharArray(ui32StartAddress, (char *)&pcPayload[0]);
+            pcPayload[4] = ui32AccessWidth;
+            pcPayload[5] = chunkSize;
+            if((retCode = sendCmd(SblDeviceCC26xx::CMD_MEMORY_READ, (char *)pcPayload, 6)) != SBL_SUCCESS)
+            {
+                return retCode;
+            }
+        }
 
-    //
-    // Set progress
-    //
-    setProgress(100);
+        //
+        // Set progress
+        //
+        setProgress(((i * 100) / chunkCount));
+
+        //
+        // Receive command response (ACK/NAK) and data
+        //
+        uint32_t expectedBytes = chunkSize * unitSize;
+        uint32_t recvBytes = expectedBytes;
+        if((retCode = getCmdResponseData(bSuccess, &pcData[dataOffset], recvBytes, 1000000)) != SBL_SUCCESS)
+        {
+            //
+            // Respond with NAK
+            //
+            if(bSuccess) sendCmdResponse(false);
+            return retCode;
+        }
+        if(!bSuccess)
+        {
+            return SBL_ERROR;
+        }
+
+        if(recvBytes != expectedBytes)
+        {
+            //
+            // Respond with NAK
+            //
+            sendCmdResponse(false);
+            setState(SBL_ERROR, "readMemory(): Received %d bytes (%d B expected) in iteration %d.\n", recvBytes, expectedBytes, i);
+            return SBL_ERROR;
+        }
+
+        //
+        // Respond with ACK, followed by the next command if any
+        //
+        if(i + 1 < chunkCount)
+        {
+            uint32_t nextCount = GTmin(ui32UnitCount - ((i + 1) * maxUnits), maxUnits);
+            ulToCharArray(ui32StartAddress + ((i + 1) * maxUnits * unitSize), (char *)&pcPayload[0]);
+            pcPayload[4] = ui32AccessWidth;
+            pcPayload[5] = nextCount;
+            buildCmdPacket(cmd, (char *)pcPayload, 6, pvPkt);
+            retCode = sendCmdResponse(true, &pvPkt[0], pvPkt.size());
+        }
+        else
+        {
+            retCode = sendCmdResponse(true);
+        }
+        if(retCode != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+    }
 
     return SBL_SUCCESS;
 }
@@ -775,8 +875,9 @@ SblDeviceCC2650::readMemory8(uint32_t ui32StartAddress, uint32_t ui32UnitCount,
  *      Returns SBL_SUCCESS, ...
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 uint32_t 
-SblDeviceCC2650::writeMemory32(uint32_t ui32StartAddress, 
+SblDeviceCC26xx<TTraits>::writeMemory32(uint32_t ui32StartAddress, 
                                uint32_t ui32UnitCount, 
                                const uint32_t *pui32Data)
 {
@@ -795,7 +896,7 @@ SblDeviceCC2650::writeMemory32(uint32_t ui32StartAddress,
 	{
 		// Issue warning
 		setState(SBL_ARGUMENT_ERROR, "writeMemory32(): Writing to bootloader work memory/stack:\n(0x%08X-0x%08X, 0x%08X-0x%08X)\n",
-			SBL_CC2650_BL_WORK_MEMORY_START,SBL_CC2650_BL_WORK_MEMORY_END, SBL_CC2650_BL_STACK_MEMORY_START,SBL_CC2650_BL_STACK_MEMORY_END);
+			Chip::BL_WORK_MEMORY_START,Chip::BL_WORK_MEMORY_END, Chip::BL_STACK_MEMORY_START,Chip::BL_STACK_MEMORY_END);
 		return SBL_ARGUMENT_ERROR;
 	}
 
@@ -804,26 +905,26 @@ SblDeviceCC2650::writeMemory32(uint32_t ui32StartAddress,
         return SBL_PORT_ERROR;
     }
 
-	uint32_t chunkCount = (ui32UnitCount / SBL_CC2650_MAX_MEMWRITE_WORDS);
-	if(ui32UnitCount % SBL_CC2650_MAX_MEMWRITE_WORDS) chunkCount++;
+	uint32_t chunkCount = (ui32UnitCount / Chip::MAX_MEMWRITE_WORDS);
+	if(ui32UnitCount % Chip::MAX_MEMWRITE_WORDS) chunkCount++;
 	uint32_t remainingCount = ui32UnitCount;
-	char* pcPayload = new char[5 + (SBL_CC2650_MAX_MEMWRITE_WORDS*4)];
+	char* pcPayload = new char[5 + (Chip::MAX_MEMWRITE_WORDS*4)];
 
 	for(uint32_t i = 0; i < chunkCount; i++)
 	{
-		uint32_t chunkOffset = i * SBL_CC2650_MAX_MEMWRITE_WORDS;
+		uint32_t chunkOffset = i * Chip::MAX_MEMWRITE_WORDS;
 		uint32_t chunkStart  = ui32StartAddress + (chunkOffset * 4);
-		uint32_t chunkSize   = GTmin(remainingCount, SBL_CC2650_MAX_MEMWRITE_WORDS);
+		uint32_t chunkSize   = GTmin(remainingCount, Chip::MAX_MEMWRITE_WORDS);
 		remainingCount -= chunkSize;
 
 		//
 		// Build payload
 		// - 4B address (MSB first)
 		// - 1B access width
-		// - 1-SBL_CC2650_MAX_MEMWRITE_WORDS data (MSB first)
+		// - 1-MAX_MEMWRITE_WORDS data (MSB first)
 		//
 		ulToCharArray(chunkStart, &pcPayload[0]);
-		pcPayload[4] = SBL_CC2650_ACCESS_WIDTH_32B;
+		pcPayload[4] = Chip::ACCESS_WIDTH_32B;
 		for(uint32_t j = 0; j < chunkSize; j++)
 		{
 			ulToCharArray(pui32Data[j + chunkOffset], &pcPayload[5 + j*4]);
@@ -837,7 +938,7 @@ SblDeviceCC2650::writeMemory32(uint32_t ui32StartAddress,
 		//
 		// Send command
 		//
-		if((retCode = sendCmd(SblDeviceCC2650::CMD_MEMORY_WRITE, pcPayload, 5 + chunkSize*4)) != SBL_SUCCESS)
+		if((retCode = sendCmd(SblDeviceCC26xx::CMD_MEMORY_WRITE, pcPayload, 5 + chunkSize*4)) != SBL_SUCCESS)
 		{
 			return retCode;        
 		}
@@ -886,8 +987,9 @@ SblDeviceCC2650::writeMemory32(uint32_t ui32StartAddress,
  *      Returns SBL_SUCCESS, ...
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 uint32_t 
-SblDeviceCC2650::writeMemory8(uint32_t ui32StartAddress, 
+SblDeviceCC26xx<TTraits>::writeMemory8(uint32_t ui32StartAddress, 
                               uint32_t ui32UnitCount, 
                               const char *pcData)
 {
@@ -901,7 +1003,7 @@ SblDeviceCC2650::writeMemory8(uint32_t ui32StartAddress,
 	{
 		// Issue warning
 		setState(SBL_ARGUMENT_ERROR, "writeMemory8(): Writing to bootloader work memory/stack:\n(0x%08X-0x%08X, 0x%08X-0x%08X)\n",
-			SBL_CC2650_BL_WORK_MEMORY_START,SBL_CC2650_BL_WORK_MEMORY_END, SBL_CC2650_BL_STACK_MEMORY_START,SBL_CC2650_BL_STACK_MEMORY_END);
+			Chip::BL_WORK_MEMORY_START,Chip::BL_WORK_MEMORY_END, Chip::BL_STACK_MEMORY_START,Chip::BL_STACK_MEMORY_END);
 		return SBL_ARGUMENT_ERROR;
 	}
 
@@ -910,26 +1012,26 @@ SblDeviceCC2650::writeMemory8(uint32_t ui32StartAddress,
         return SBL_PORT_ERROR;
     }
 
-	uint32_t chunkCount = (ui32UnitCount / SBL_CC2650_MAX_MEMWRITE_BYTES);
-	if(ui32UnitCount % SBL_CC2650_MAX_MEMWRITE_BYTES) chunkCount++;
+	uint32_t chunkCount = (ui32UnitCount / Chip::MAX_MEMWRITE_BYTES);
+	if(ui32UnitCount % Chip::MAX_MEMWRITE_BYTES) chunkCount++;
 	uint32_t remainingCount = ui32UnitCount;
-	char* pcPayload = new char[5 + SBL_CC2650_MAX_MEMWRITE_BYTES];
+	char* pcPayload = new char[5 + Chip::MAX_MEMWRITE_BYTES];
 
 	for(uint32_t i = 0; i < chunkCount; i++)
 	{
-		uint32_t chunkOffset = i * SBL_CC2650_MAX_MEMWRITE_BYTES;
+		uint32_t chunkOffset = i * Chip::MAX_MEMWRITE_BYTES;
 		uint32_t chunkStart  = ui32StartAddress + chunkOffset;
-		uint32_t chunkSize   = GTmin(remainingCount, SBL_CC2650_MAX_MEMWRITE_BYTES);
+		uint32_t chunkSize   = GTmin(remainingCount, Chip::MAX_MEMWRITE_BYTES);
 		remainingCount -= chunkSize;
 
 		//
 		// Build payload
 		// - 4B address (MSB first)
 		// - 1B access width
-		// - 1-SBL_CC2650_MAX_MEMWRITE_BYTES bytes data
+		// - 1-MAX_MEMWRITE_BYTES bytes data
 		//
 		ulToCharArray(chunkStart, &pcPayload[0]);
-		pcPayload[4] = SBL_CC2650_ACCESS_WIDTH_8B;
+		pcPayload[4] = Chip::ACCESS_WIDTH_8B;
 		memcpy(&pcPayload[5], &pcData[chunkOffset], chunkSize);
 
 		//
@@ -940,7 +1042,7 @@ SblDeviceCC2650::writeMemory8(uint32_t ui32StartAddress,
 		//
 		// Send command
 		//
-		if((retCode = sendCmd(SblDeviceCC2650::CMD_MEMORY_WRITE, pcPayload, 5 + chunkSize)) != SBL_SUCCESS)
+		if((retCode = sendCmd(SblDeviceCC26xx::CMD_MEMORY_WRITE, pcPayload, 5 + chunkSize)) != SBL_SUCCESS)
 		{
 			return retCode;        
 		}
@@ -988,8 +1090,9 @@ SblDeviceCC2650::writeMemory8(uint32_t ui32StartAddress,
  *      Returns SBL_SUCCESS, ...
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 uint32_t 
-SblDeviceCC2650::calculateCrc32(uint32_t ui32StartAddress, 
+SblDeviceCC26xx<TTraits>::calculateCrc32(uint32_t ui32StartAddress, 
                                 uint32_t ui32ByteCount, uint32_t *pui32Crc)
 {
     uint32_t retCode = SBL_SUCCESS;
@@ -1031,7 +1134,7 @@ SblDeviceCC2650::calculateCrc32(uint32_t ui32StartAddress,
     //
     // Send command
     //
-    if((retCode = sendCmd(SblDeviceCC2650::CMD_CRC32, pcPayload, 12)) != SBL_SUCCESS)
+    if((retCode = sendCmd(SblDeviceCC26xx::CMD_CRC32, pcPayload, 12)) != SBL_SUCCESS)
     {
         return retCode;        
     }
@@ -1088,32 +1191,67 @@ SblDeviceCC2650::calculateCrc32(uint32_t ui32StartAddress,
  *      Number of bytes to program. Must be a multiple of 4.
  * \param[in] pcData
  *      Pointer to source data.
+ *
+ * A chunk that is NAKed or gets a bad status is sent again after resyncing
+ * with the device, within the budget set by setRetryPolicy().
+ *
+ * With setPageVerify() on, each page is checked by a device CRC as soon as
+ * it is written, and rewritten if it does not match (see verifyPage()).
+ * Page CRCs given to setPageCrcs() for this image are dropped when the
+ * write ends, whether it succeeded or not.
+ *
  * \return
  *      Returns SBL_SUCCESS, ...
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 uint32_t 
-SblDeviceCC2650::writeFlashRange(uint32_t ui32StartAddress, 
+SblDeviceCC26xx<TTraits>::writeFlashRange(uint32_t ui32StartAddress, 
                                  uint32_t ui32ByteCount, const char *pcData)
 {
-    uint32_t devStatus = SblDeviceCC2650::CMD_RET_UNKNOWN_CMD;
+    uint32_t retCode = writeTransfers(ui32StartAddress, ui32ByteCount, pcData);
+
+    //
+    // The page CRCs of setPageCrcs() are only good for one write of the image
+    //
+    releasePageCrcs(ui32StartAddress, ui32ByteCount, pcData);
+    return retCode;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief The transfers of writeFlashRange(), which takes the same
+ *      parameters.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+template <class TTraits>
+uint32_t 
+SblDeviceCC26xx<TTraits>::writeTransfers(uint32_t ui32StartAddress, 
+                                uint32_t ui32ByteCount, const char *pcData)
+{
+    uint32_t devStatus = SblDeviceCC26xx::CMD_RET_UNKNOWN_CMD;
     uint32_t retCode = SBL_SUCCESS;
     uint32_t bytesLeft, dataIdx, bytesInTransfer;
+    uint32_t ui32VerifyAddress;         // First byte not yet verified (setPageVerify())
     uint32_t transferNumber = 1;
-    bool bIsRetry = false;
+    uint32_t chunkRetries = 0, totalRetries = 0;
+    bool bVerifyChunk = false;          // Chunk must be checked once written, see recoverTransfer()
     bool bBlToBeDisabled = false;
-    std::vector<tTransfer> pvTransfer;
-    uint32_t ui32TotChunks = (ui32ByteCount / SBL_CC2650_MAX_BYTES_PER_TRANSFER);
-    if(ui32ByteCount % SBL_CC2650_MAX_BYTES_PER_TRANSFER) ui32TotChunks++;
+    std::vector<tSblTransfer> pvTransfer;
+    uint32_t ui32TotChunks = (ui32ByteCount / Chip::MAX_BYTES_PER_TRANSFER);
+    if(ui32ByteCount % Chip::MAX_BYTES_PER_TRANSFER) ui32TotChunks++;
     uint32_t ui32CurrChunk = 0;
 
     //
     // Calculate BL configuration address (depends on flash size)
     //
-    uint32_t ui32BlCfgAddr = SBL_CC2650_FLASH_START_ADDRESS +                 \
+    uint32_t ui32BlCfgAddr = Chip::FLASH_START_ADDRESS +                 \
                              getFlashSize() -                                 \
-                             SBL_CC2650_PAGE_ERASE_SIZE +                     \
-                             SBL_CC2650_BL_CONFIG_PAGE_OFFSET;
+                             Chip::PAGE_ERASE_SIZE +                     \
+                             Chip::BL_CONFIG_PAGE_OFFSET;
 
     //
     // Calculate BL configuration buffer index
@@ -1125,7 +1263,7 @@ SblDeviceCC2650::writeFlashRange(uint32_t ui32StartAddress,
     //
     if(ui32BlCfgDataIdx <= ui32ByteCount)
     {
-        if(((pcData[ui32BlCfgDataIdx]) & 0xFF) != SBL_CC2650_BL_CONFIG_ENABLED_BM)
+        if(((pcData[ui32BlCfgDataIdx]) & 0xFF) != Chip::BL_CONFIG_ENABLED_BM)
         {
             bBlToBeDisabled = false;
             setState(SBL_SUCCESS, "Warning: CC2650 bootloader will be disabled.\n");
@@ -1201,7 +1339,7 @@ SblDeviceCC2650::writeFlashRange(uint32_t ui32StartAddress,
             setState(retCode, "Error during download initialization. Failed to read device status after sending download command.\n");
             return retCode;
         }
-        if(devStatus != SblDeviceCC2650::CMD_RET_SUCCESS)
+        if(devStatus != SblDeviceCC26xx::CMD_RET_SUCCESS)
         {
             setState(SBL_ERROR, "Error during download initialization. Device returned status %d (%s).\n", devStatus, getCmdStatusString(devStatus).c_str());
             return SBL_ERROR;
@@ -1212,71 +1350,33 @@ SblDeviceCC2650::writeFlashRange(uint32_t ui32StartAddress,
         //
         bytesLeft = pvTransfer[i].byteCount;
         dataIdx   = pvTransfer[i].startOffset;
+        ui32VerifyAddress = pvTransfer[i].startAddr;
         while(bytesLeft)
         {
-            //
-            // Set progress
-            //
-            //setProgress(addressToPage(ui32StartAddress + dataIdx));
-            setProgress(((100*(++ui32CurrChunk))/ui32TotChunks));
-
             //
             // Limit transfer count
             //
-            bytesInTransfer = GTmin(SBL_CC2650_MAX_BYTES_PER_TRANSFER, bytesLeft);
+            bytesInTransfer = GTmin(Chip::MAX_BYTES_PER_TRANSFER, bytesLeft);
 
             //
             // Send Data command
             //
-            if(retCode = cmdSendData(&pcData[dataIdx], bytesInTransfer) != SBL_SUCCESS)
-            {
-                setState(retCode, "Error during flash download. \n- Start address 0x%08X (page %d). \n- Tried to transfer %d bytes. \n- This was transfer %d.\n", 
-                         (ui32StartAddress+dataIdx), 
-                         addressToPage(ui32StartAddress+dataIdx),
-                         bytesInTransfer, 
-                         (transferNumber));
-                return retCode;
-            }
+            devStatus = 0;
+            retCode = cmdSendData(&pcData[dataIdx], bytesInTransfer);
 
-            if(pvTransfer[i].bExpectAck)
+            if(retCode == SBL_SUCCESS && pvTransfer[i].bExpectAck)
             {
                 //
                 // Check status after send data command
                 //
-                devStatus = 0;
                 retCode = readStatus(&devStatus);
-                if(retCode != SBL_SUCCESS)
-                {
-                    setState(retCode, "Error during flash download. Failed to read device status.\n- Start address 0x%08X (page %d). \n- Tried to transfer %d bytes. \n- This was transfer %d in chunk %d.\n", 
-                                 (ui32StartAddress+dataIdx), 
-                                 addressToPage(ui32StartAddress + dataIdx),
-                                 (bytesInTransfer), (transferNumber), 
-                                 (i));
-                    return retCode;
-                }
-                if(devStatus != SblDeviceCC2650::CMD_RET_SUCCESS)
+                if(retCode == SBL_SUCCESS && devStatus != SblDeviceCC26xx::CMD_RET_SUCCESS)
                 {
                     setState(SBL_SUCCESS, "Device returned status %s\n", getCmdStatusString(devStatus).c_str());
-                    if(bIsRetry)
-                    {
-                        //
-                        // We have failed a second time. Aborting.
-                        setState(SBL_ERROR, "Error retrying flash download.\n- Start address 0x%08X (page %d). \n- Tried to transfer %d bytes. \n- This was transfer %d in chunk %d.\n", 
-                                 (ui32StartAddress+dataIdx), 
-                                 addressToPage(ui32StartAddress + dataIdx),
-                                 (bytesInTransfer), (transferNumber), 
-                                 (i));
-                        return SBL_ERROR;
-                    }
-
-                    //
-                    // Retry to send data one more time.
-                    //
-                    bIsRetry = true;
-                    continue;
+                    retCode = SBL_ERROR;
                 }
             }
-            else
+            else if(retCode == SBL_SUCCESS && !pvTransfer[i].bExpectAck)
             {
                 //
                 // We're locking device and will lose access
@@ -1285,13 +1385,71 @@ SblDeviceCC2650::writeFlashRange(uint32_t ui32StartAddress,
 
             }
 
+            if(retCode != SBL_SUCCESS)
+            {
+                //
+                // Resync and restart the download at this chunk. Gives up when
+                // the retry budget is spent.
+                //
+                if((retCode = recoverTransfer(ui32StartAddress + dataIdx, bytesLeft, bytesInTransfer, 
+                                              transferNumber, chunkRetries, totalRetries, 
+                                              bVerifyChunk)) != SBL_SUCCESS)
+                {
+                    return retCode;
+                }
+                continue;
+            }
+
+            //
+            // The device may have programmed zeros over this chunk before it
+            // was sent again. Check it, rewriting its page if needed.
+            //
+            if(bVerifyChunk && pvTransfer[i].bExpectAck)
+            {
+                bVerifyChunk = false;
+                if((retCode = verifyChunk(ui32StartAddress + dataIdx, bytesInTransfer, &pcData[dataIdx])) != SBL_SUCCESS)
+                {
+                    return retCode;
+                }
+                if(bytesLeft > bytesInTransfer && 
+                   (retCode = restartDownload(ui32StartAddress + dataIdx + bytesInTransfer, 
+                                              bytesLeft - bytesInTransfer)) != SBL_SUCCESS)
+                {
+                    return retCode;
+                }
+            }
+
             //
             // Update index and bytesLeft
             //
             bytesLeft -= bytesInTransfer;
             dataIdx += bytesInTransfer;
             transferNumber++;
-            bIsRetry = false;
+            chunkRetries = 0;
+
+            //
+            // Set progress
+            //
+            setProgress(((100*(++ui32CurrChunk))/ui32TotChunks));
+
+            //
+            // Verify-as-you-go: CRC each page as soon as it is written
+            //
+            if(m_bPageVerify && pvTransfer[i].bExpectAck)
+            {
+                bool bVerified;
+                if((retCode = verifyPages(ui32VerifyAddress, ui32StartAddress + dataIdx, 
+                                          pvTransfer[i].startAddr + pvTransfer[i].byteCount, 
+                                          ui32StartAddress, pcData, bVerified)) != SBL_SUCCESS)
+                {
+                    return retCode;
+                }
+                if(bVerified && bytesLeft && 
+                   (retCode = restartDownload(ui32StartAddress + dataIdx, bytesLeft)) != SBL_SUCCESS)
+                {
+                    return retCode;
+                }
+            }
         }
     }
 
@@ -1306,8 +1464,9 @@ SblDeviceCC2650::writeFlashRange(uint32_t ui32StartAddress,
  *      Returns SBL_SUCCESS, ...
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 uint32_t
-SblDeviceCC2650::eraseFlashBank()
+SblDeviceCC26xx<TTraits>::eraseFlashBank()
 {
     int retCode = SBL_SUCCESS;
     bool bResponse = false;
@@ -1320,7 +1479,7 @@ SblDeviceCC2650::eraseFlashBank()
     //
     // Send command
     //
-    if((retCode = sendCmd(SblDeviceCC2650::CMD_BANK_ERASE)) != SBL_SUCCESS)
+    if((retCode = sendCmd(SblDeviceCC26xx::CMD_BANK_ERASE)) != SBL_SUCCESS)
     {
         return retCode;
     }
@@ -1350,7 +1509,8 @@ SblDeviceCC2650::eraseFlashBank()
  */
 //-----------------------------------------------------------------------------
 
-uint32_t SblDeviceCC2650::setCCFG(uint32_t ui32Field, uint32_t ui32FieldValue){
+template <class TTraits>
+uint32_t SblDeviceCC26xx<TTraits>::setCCFG(uint32_t ui32Field, uint32_t ui32FieldValue){
     int retCode = SBL_SUCCESS;
     bool bSuccess = false;
 
@@ -1371,7 +1531,7 @@ uint32_t SblDeviceCC2650::setCCFG(uint32_t ui32Field, uint32_t ui32FieldValue){
     //
     // Send command
     //
-    if((retCode = sendCmd(SblDeviceCC2650::CMD_SET_CCFG, pcPayload, 8)) != SBL_SUCCESS)
+    if((retCode = sendCmd(SblDeviceCC26xx::CMD_SET_CCFG, pcPayload, 8)) != SBL_SUCCESS)
     {
         return retCode;
     }
@@ -1406,8 +1566,9 @@ uint32_t SblDeviceCC2650::setCCFG(uint32_t ui32Field, uint32_t ui32FieldValue){
  *      Returns SBL_SUCCESS, ...
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 uint32_t 
-SblDeviceCC2650::sendCmd(uint32_t ui32Cmd, const char *pcSendData/* = NULL*/, 
+SblDeviceCC26xx<TTraits>::sendCmd(uint32_t ui32Cmd, const char *pcSendData/* = NULL*/, 
                          uint32_t ui32SendLen/* = 0*/)
 {
     //
@@ -1425,28 +1586,18 @@ SblDeviceCC2650::sendCmd(uint32_t ui32Cmd, const char *pcSendData/* = NULL*/,
     //
     ui32Cmd = convertCmdForEarlySamples(ui32Cmd);
 
-
-    unsigned char pktLen = ui32SendLen + 3; // +3 => <1b Length>, <1b cksum>, <1b cmd>
-    std::vector<char> pvPkt((pktLen));
-    unsigned char pktSum = generateCheckSum(ui32Cmd, pcSendData, ui32SendLen);
-
     //
     // Build packet
     //
-    pvPkt.at(0) = pktLen;
-    pvPkt.at(1) = pktSum;
-    pvPkt.at(2) = (unsigned char)ui32Cmd;
-    if(ui32SendLen)
-    {
-        memcpy(&pvPkt[3], pcSendData, ui32SendLen);
-    }
+    std::vector<char> pvPkt;
+    buildCmdPacket(ui32Cmd, pcSendData, ui32SendLen, pvPkt);
 
     //
     // Send packet
     //
     do
     {
-
+        retry++;
         int ret = m_pCom->writeBytes(&pvPkt[0]+numBytes, pvPkt.size()-numBytes);
         if (ret < 0) continue;
         numBytes += ret;
@@ -1468,6 +1619,38 @@ SblDeviceCC2650::sendCmd(uint32_t ui32Cmd, const char *pcSendData/* = NULL*/,
     return SBL_SUCCESS;
 }
 
+
+//-----------------------------------------------------------------------------
+/** \brief This function builds a command packet.
+ *
+ * \param[in] ui32Cmd
+ *      The command to send (after early sample conversion).
+ * \param[in] pcSendData
+ *      Pointer to the data to send with the command.
+ * \param[in] ui32SendLen
+ *      The number of bytes to send from \e pcSendData.
+ * \param[out] pvPkt
+ *      Populated with <1B length> <1B checksum> <1B cmd> <data>.
+ */
+//-----------------------------------------------------------------------------
+template <class TTraits>
+void
+SblDeviceCC26xx<TTraits>::buildCmdPacket(uint32_t ui32Cmd, const char *pcSendData, 
+                                uint32_t ui32SendLen, std::vector<char> &pvPkt)
+{
+    unsigned char pktLen = ui32SendLen + 3; // +3 => <1b Length>, <1b cksum>, <1b cmd>
+    unsigned char pktSum = generateCheckSum(ui32Cmd, pcSendData, ui32SendLen);
+
+    pvPkt.resize(pktLen);
+    pvPkt.at(0) = pktLen;
+    pvPkt.at(1) = pktSum;
+    pvPkt.at(2) = (unsigned char)ui32Cmd;
+    if(ui32SendLen)
+    {
+        memcpy(&pvPkt[3], pcSendData, ui32SendLen);
+    }
+}
+
 //-----------------------------------------------------------------------------
 /** \brief Set to bootloader mode
  *
@@ -1475,17 +1658,31 @@ SblDeviceCC2650::sendCmd(uint32_t ui32Cmd, const char *pcSendData/* = NULL*/,
  *      Returns SBL_SUCCESS, ...
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 uint32_t 
-SblDeviceCC2650::setBootloaderMode(int pigpiodID)
+SblDeviceCC26xx<TTraits>::setBootloaderMode(int pigpiodID)
 {
     if(!m_pCom->isInitiated())
     {
         setState(SBL_PORT_ERROR, "COM port not initiated.\n");
         return SBL_PORT_ERROR;
     }
-    if(m_pCom->setBootloaderMode(pigpiodID) != SBL_SUCCESS) {
+    int result = m_pCom->setBootloaderMode(pigpiodID);
+    if(result == SBL_PORT_BUSY_ERROR) {
+        if(m_pCom->getBusyOwner() > 0)
+            setState(SBL_PORT_BUSY_ERROR, "SBL: Bootloader GPIOs are in use by process %d.\n", m_pCom->getBusyOwner());
+        else
+            setState(SBL_PORT_BUSY_ERROR, "SBL: Bootloader GPIOs are in use by another process.\n");
+        return SBL_PORT_BUSY_ERROR;
+    }
+    if(result == SBL_PORT_ERROR && !m_pCom->getLockError().empty()) {
+        setState(SBL_PORT_ERROR, "SBL: %s.\n", m_pCom->getLockError().c_str());
+        return SBL_PORT_ERROR;
+    }
+    if(result != SBL_SUCCESS) {
         return SBL_ERROR;
     }
+    return SBL_SUCCESS;
 }
 
 //-----------------------------------------------------------------------------
@@ -1497,8 +1694,9 @@ SblDeviceCC2650::setBootloaderMode(int pigpiodID)
  *      Returns SBL_SUCCESS, ...
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 uint32_t
-SblDeviceCC2650::initCommunication(bool bSetXosc)
+SblDeviceCC26xx<TTraits>::initCommunication(bool bSetXosc)
 {
     bool bSuccess, bBaudSetOk;
     int retCode = SBL_ERROR;
@@ -1510,27 +1708,41 @@ SblDeviceCC2650::initCommunication(bool bSetXosc)
     }
 
     //
-    // Send dummy command to see if device is already initialized at
-    // this baud rate.
+    // The device was left in bootloader mode (see SblDevice::connect()).
+    // Send ping to see if it is still initialized at this baud rate.
     //
-    /*if(sendCmd(0) != SBL_SUCCESS)
+    if(m_bTryPing)
     {
-        return SBL_ERROR;
-    }*/
-    //
-    // Do we get a response (ACK/NAK)?
-    //
-    bSuccess = false;
-    /*if(getCmdResponse(bSuccess, SBL_DEFAULT_RETRY_COUNT, true) != SBL_SUCCESS)
-    {*/
+        if(sendCmd(SblDeviceCC26xx::CMD_PING) != SBL_SUCCESS)
+        {
+            return SBL_ERROR;
+        }
+
         //
-        // No response received. Try auto baud
+        // Do we get a response (ACK/NAK)? If not, the caller resets the
+        // device into bootloader mode and does auto baud.
         //
-        if(retCode = sendAutoBaud(bBaudSetOk) != SBL_SUCCESS)
+        bSuccess = false;
+        setDeadline(SBL_PROBE_TIMEOUT);
+        retCode = getCmdResponse(bSuccess, 1000000, true);
+        setDeadline(0);
+        if(retCode != SBL_SUCCESS || !bSuccess)
         {
-            return retCode;
+            return SBL_TIMEOUT_ERROR;
         }
-    //}
+
+        m_bCommInitialized = true;
+        return SBL_SUCCESS;
+    }
+
+    //
+    // Try auto baud. A dummy command is not sent first on a freshly reset
+    // device as it would be taken as the start of the auto baud sequence.
+    //
+    if(retCode = sendAutoBaud(bBaudSetOk) != SBL_SUCCESS)
+    {
+        return retCode;
+    }
 
 
     m_bCommInitialized = true;
@@ -1548,19 +1760,20 @@ SblDeviceCC2650::initCommunication(bool bSetXosc)
  *      Returns std::string with name of device command.
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 std::string
-SblDeviceCC2650::getCmdString(uint32_t ui32Cmd)
+SblDeviceCC26xx<TTraits>::getCmdString(uint32_t ui32Cmd)
 {
     switch(ui32Cmd)
     {
-    case SblDeviceCC2650::CMD_PING:             return "CMD_PING"; break;
-    case SblDeviceCC2650::CMD_CRC32:            return "CMD_CRC32"; break;
-    case SblDeviceCC2650::CMD_DOWNLOAD:         return "CMD_DOWNLOAD"; break;
-    case SblDeviceCC2650::CMD_GET_CHIP_ID:      return "CMD_GET_CHIP_ID"; break;
-    case SblDeviceCC2650::CMD_GET_STATUS:       return "CMD_GET_STATUS"; break;
-    case SblDeviceCC2650::CMD_MEMORY_READ:      return "CMD_MEMORY_READ"; break;
-    case SblDeviceCC2650::CMD_MEMORY_WRITE:     return "CMD_MEMORY_WRITE"; break;
-    case SblDeviceCC2650::CMD_RESET:            return "CMD_RESET"; break;
+    case SblDeviceCC26xx::CMD_PING:             return "CMD_PING"; break;
+    case SblDeviceCC26xx::CMD_CRC32:            return "CMD_CRC32"; break;
+    case SblDeviceCC26xx::CMD_DOWNLOAD:         return "CMD_DOWNLOAD"; break;
+    case SblDeviceCC26xx::CMD_GET_CHIP_ID:      return "CMD_GET_CHIP_ID"; break;
+    case SblDeviceCC26xx::CMD_GET_STATUS:       return "CMD_GET_STATUS"; break;
+    case SblDeviceCC26xx::CMD_MEMORY_READ:      return "CMD_MEMORY_READ"; break;
+    case SblDeviceCC26xx::CMD_MEMORY_WRITE:     return "CMD_MEMORY_WRITE"; break;
+    case SblDeviceCC26xx::CMD_RESET:            return "CMD_RESET"; break;
     default: return "Unknown command"; break;
     }
 }
@@ -1576,16 +1789,17 @@ SblDeviceCC2650::getCmdString(uint32_t ui32Cmd)
  *      Returns std::string with name of device status.
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 std::string
-SblDeviceCC2650::getCmdStatusString(uint32_t ui32Status)
+SblDeviceCC26xx<TTraits>::getCmdStatusString(uint32_t ui32Status)
 {
     switch(ui32Status)
     {
-    case SblDeviceCC2650::CMD_RET_FLASH_FAIL:   return "FLASH_FAIL"; break;
-    case SblDeviceCC2650::CMD_RET_INVALID_ADR:  return "INVALID_ADR"; break;
-    case SblDeviceCC2650::CMD_RET_INVALID_CMD:  return "INVALID_CMD"; break;
-    case SblDeviceCC2650::CMD_RET_SUCCESS:      return "SUCCESS"; break;
-    case SblDeviceCC2650::CMD_RET_UNKNOWN_CMD:  return "UNKNOWN_CMD"; break;
+    case SblDeviceCC26xx::CMD_RET_FLASH_FAIL:   return "FLASH_FAIL"; break;
+    case SblDeviceCC26xx::CMD_RET_INVALID_ADR:  return "INVALID_ADR"; break;
+    case SblDeviceCC26xx::CMD_RET_INVALID_CMD:  return "INVALID_CMD"; break;
+    case SblDeviceCC26xx::CMD_RET_SUCCESS:      return "SUCCESS"; break;
+    case SblDeviceCC26xx::CMD_RET_UNKNOWN_CMD:  return "UNKNOWN_CMD"; break;
     default: return "Unknown status"; break;
     }
 }
@@ -1604,8 +1818,9 @@ SblDeviceCC2650::getCmdStatusString(uint32_t ui32Status)
  *      Returns SBL_SUCCESS if command and response was successful.
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 uint32_t 
-SblDeviceCC2650::cmdDownload(uint32_t ui32Address, uint32_t ui32Size)
+SblDeviceCC26xx<TTraits>::cmdDownload(uint32_t ui32Address, uint32_t ui32Size)
 {
     int retCode = SBL_SUCCESS;
     bool bSuccess = false;
@@ -1637,7 +1852,7 @@ SblDeviceCC2650::cmdDownload(uint32_t ui32Address, uint32_t ui32Size)
     //
     // Send command
     //
-    if((retCode = sendCmd(SblDeviceCC2650::CMD_DOWNLOAD, pcPayload, 8)) != SBL_SUCCESS)
+    if((retCode = sendCmd(SblDeviceCC26xx::CMD_DOWNLOAD, pcPayload, 8)) != SBL_SUCCESS)
     {
         return retCode;        
     }
@@ -1670,8 +1885,9 @@ SblDeviceCC2650::cmdDownload(uint32_t ui32Address, uint32_t ui32Size)
  *      Returns SBL_SUCCESS if command and response was successful.
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 uint32_t
-SblDeviceCC2650::cmdSendData(const char *pcData, uint32_t ui32ByteCount)
+SblDeviceCC26xx<TTraits>::cmdSendData(const char *pcData, uint32_t ui32ByteCount)
 {   
     uint32_t retCode = SBL_SUCCESS;
     bool bSuccess = false;
@@ -1679,16 +1895,16 @@ SblDeviceCC2650::cmdSendData(const char *pcData, uint32_t ui32ByteCount)
     //
     // Check input arguments
     //
-    if(ui32ByteCount > SBL_CC2650_MAX_BYTES_PER_TRANSFER)
+    if(ui32ByteCount > Chip::MAX_BYTES_PER_TRANSFER)
     {
-        setState(SBL_ERROR, "Error: Byte count (%d) exceeds maximum transfer size %d.\n", ui32ByteCount, SBL_CC2650_MAX_BYTES_PER_TRANSFER);
+        setState(SBL_ERROR, "Error: Byte count (%d) exceeds maximum transfer size %d.\n", ui32ByteCount, Chip::MAX_BYTES_PER_TRANSFER);
         return SBL_ERROR;
     }
 
     //
     // Send command
     //
-    if((retCode = sendCmd(SblDeviceCC2650::CMD_SEND_DATA, pcData, ui32ByteCount)) != SBL_SUCCESS)
+    if((retCode = sendCmd(SblDeviceCC26xx::CMD_SEND_DATA, pcData, ui32ByteCount)) != SBL_SUCCESS)
     {
         return retCode;        
     }
@@ -1708,86 +1924,6 @@ SblDeviceCC2650::cmdSendData(const char *pcData, uint32_t ui32ByteCount)
     return SBL_SUCCESS;
 }
 
-//-----------------------------------------------------------------------------
-/** \brief This function returns the page within which address \e ui32Address
- *      is located.
- *
- * \param[in] ui32Address
- *      The address.
- *
- * \return
- *      Returns the flash page within which an address is located.
- */
-//-----------------------------------------------------------------------------
-uint32_t
-SblDeviceCC2650::addressToPage(uint32_t ui32Address)
-{
-    return ((ui32Address - SBL_CC2650_FLASH_START_ADDRESS) /                  \
-            SBL_CC2650_PAGE_ERASE_SIZE);
-}
-
-
-//-----------------------------------------------------------------------------
-/** \brief This function checks if the specified \e ui32StartAddress (and range)
- *      is located within the device RAM area.
- *
- * \param[in] ui32StartAddress
- *      The start address of the range
- * \param[in] pui32Bytecount
- *      (Optional) The number of bytes in the range.
- * \return
- *      Returns true if the address/range is within the device RAM.
- */
-//-----------------------------------------------------------------------------
-bool 
-SblDeviceCC2650::addressInRam(uint32_t ui32StartAddress, 
-                              uint32_t ui32ByteCount/* = 1*/)
-{
-    uint32_t ui32EndAddr = ui32StartAddress + ui32ByteCount;
-
-    if(ui32StartAddress < SBL_CC2650_RAM_START_ADDRESS)
-    {
-        return false;
-    }
-    if(ui32EndAddr > (SBL_CC2650_RAM_START_ADDRESS + getRamSize()))
-    {
-        return false;
-    }
-    return true;
-}
-
-
-//-----------------------------------------------------------------------------
-/** \brief This function checks if the specified \e ui32StartAddress (and range)
- *      is located within the device FLASH area.
- *
- * \param[in] ui32StartAddress
- *      The start address of the range
- * \param[in] pui32Bytecount
- *      (Optional) The number of bytes in the range.
- *
- * \return
- *      Returns true if the address/range is within the device RAM.
- */
-//-----------------------------------------------------------------------------
-bool
-SblDeviceCC2650::addressInFlash(uint32_t ui32StartAddress, 
-                                         uint32_t ui32ByteCount/* = 1*/)
-{
-    uint32_t ui32EndAddr = ui32StartAddress + ui32ByteCount;
-
-    if(ui32StartAddress < SBL_CC2650_FLASH_START_ADDRESS)
-    {
-        return false;
-    }
-    if(ui32EndAddr > (SBL_CC2650_FLASH_START_ADDRESS + getFlashSize()))
-    {
-        return false;
-    }
-    
-    return true;
-}
-
 //-----------------------------------------------------------------------------
 /** \brief This function checks if the specified \e ui32StartAddress (and range)
  *      overlaps the bootloader's working memory or stack area. 
@@ -1807,23 +1943,24 @@ SblDeviceCC2650::addressInFlash(uint32_t ui32StartAddress,
  *      Returns true if the address/range is within the device RAM.
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 bool 
-SblDeviceCC2650::addressInBLWorkMemory(uint32_t ui32StartAddress, 
+SblDeviceCC26xx<TTraits>::addressInBLWorkMemory(uint32_t ui32StartAddress, 
 									   uint32_t ui32ByteCount/* = 1*/)
 {
     uint32_t ui32EndAddr = ui32StartAddress + ui32ByteCount;
 
-	if(ui32StartAddress <= SBL_CC2650_BL_WORK_MEMORY_END)
+	if(ui32StartAddress <= Chip::BL_WORK_MEMORY_END)
 	{
 		return true;
 	}
-	if((ui32StartAddress >= SBL_CC2650_BL_STACK_MEMORY_START) && 
-	   (ui32StartAddress <= SBL_CC2650_BL_STACK_MEMORY_END))
+	if((ui32StartAddress >= Chip::BL_STACK_MEMORY_START) && 
+	   (ui32StartAddress <= Chip::BL_STACK_MEMORY_END))
 	{
 		return true;
 	}
-	if((ui32EndAddr >= SBL_CC2650_BL_STACK_MEMORY_START) && 
-	   (ui32EndAddr <= SBL_CC2650_BL_STACK_MEMORY_END))
+	if((ui32EndAddr >= Chip::BL_STACK_MEMORY_START) && 
+	   (ui32EndAddr <= Chip::BL_STACK_MEMORY_END))
 	{
 		return true;
 	}
@@ -1846,7 +1983,8 @@ SblDeviceCC2650::addressInBLWorkMemory(uint32_t ui32StartAddress,
  *      Returns the correct command ID for the connected device.
  */
 //-----------------------------------------------------------------------------
-uint32_t SblDeviceCC2650::convertCmdForEarlySamples(uint32_t ui32Cmd)
+template <class TTraits>
+uint32_t SblDeviceCC26xx<TTraits>::convertCmdForEarlySamples(uint32_t ui32Cmd)
 {
     if(m_deviceRev != 1)
     {
@@ -1855,14 +1993,14 @@ uint32_t SblDeviceCC2650::convertCmdForEarlySamples(uint32_t ui32Cmd)
     }
     switch(ui32Cmd)
     {
-    case SblDeviceCC2650::CMD_MEMORY_READ: 
-        return SblDeviceCC2650::REV1_CMD_MEMORY_READ;
-    case SblDeviceCC2650::CMD_MEMORY_WRITE:
-        return SblDeviceCC2650::REV1_CMD_MEMORY_WRITE;
-    case SblDeviceCC2650::CMD_SET_CCFG:
-        return SblDeviceCC2650::REV1_CMD_SET_CCFG;
-    case SblDeviceCC2650::CMD_BANK_ERASE:
-        return SblDeviceCC2650::REV1_CMD_BANK_ERASE;
+    case SblDeviceCC26xx::CMD_MEMORY_READ: 
+        return SblDeviceCC26xx::REV1_CMD_MEMORY_READ;
+    case SblDeviceCC26xx::CMD_MEMORY_WRITE:
+        return SblDeviceCC26xx::REV1_CMD_MEMORY_WRITE;
+    case SblDeviceCC26xx::CMD_SET_CCFG:
+        return SblDeviceCC26xx::REV1_CMD_SET_CCFG;
+    case SblDeviceCC26xx::CMD_BANK_ERASE:
+        return SblDeviceCC26xx::REV1_CMD_BANK_ERASE;
     default: 
         // No conversion needed, return original commad.
         return ui32Cmd;
@@ -1879,21 +2017,22 @@ uint32_t SblDeviceCC2650::convertCmdForEarlySamples(uint32_t ui32Cmd)
  *      Returns a vector of the addresses found; caller must free
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 uint32_t
-SblDeviceCC2650::findBytes(uint32_t ui32ByteCount, const char* pcData, std::vector<uint32_t> &pvAddresses)
+SblDeviceCC26xx<TTraits>::findBytes(uint32_t ui32ByteCount, const char* pcData, std::vector<uint32_t> &pvAddresses)
 {
     int ret;
     char** pcFlashPages = new char*[2];
-    pcFlashPages[0] = new char[SBL_CC2650_PAGE_ERASE_SIZE], pcFlashPages[1] = new char[SBL_CC2650_PAGE_ERASE_SIZE];
+    pcFlashPages[0] = new char[Chip::PAGE_ERASE_SIZE], pcFlashPages[1] = new char[Chip::PAGE_ERASE_SIZE];
     
     int count = 0, page = 0, pos = 0, pageNum = 0;
     while (pos < m_flashSize)
     {
-        ret = readMemory8(SBL_CC2650_FLASH_START_ADDRESS + (pageNum*SBL_CC2650_PAGE_ERASE_SIZE),
-                            SBL_CC2650_PAGE_ERASE_SIZE, pcFlashPages[page]);
+        ret = readMemory8(Chip::FLASH_START_ADDRESS + (pageNum*Chip::PAGE_ERASE_SIZE),
+                            Chip::PAGE_ERASE_SIZE, pcFlashPages[page]);
         if (ret != SBL_SUCCESS) { return SBL_ERROR; }
 
-        for (int i = 0; i < SBL_CC2650_PAGE_ERASE_SIZE && pos < m_flashSize; i++, pos++)
+        for (int i = 0; i < Chip::PAGE_ERASE_SIZE && pos < m_flashSize; i++, pos++)
         {
             while (pcFlashPages[page][i] == pcData[count] && count < ui32ByteCount)
             {
@@ -1902,7 +2041,7 @@ SblDeviceCC2650::findBytes(uint32_t ui32ByteCount, const char* pcData, std::vect
                 pos++;
                 if (count == ui32ByteCount)
                 {
-                    pvAddresses.push_back((pageNum * SBL_CC2650_PAGE_ERASE_SIZE) + i - ui32ByteCount);
+                    pvAddresses.push_back((pageNum * Chip::PAGE_ERASE_SIZE) + i - ui32ByteCount);
                 }
             }
             count = 0;
@@ -1931,8 +2070,9 @@ SblDeviceCC2650::findBytes(uint32_t ui32ByteCount, const char* pcData, std::vect
  *      Returns SBL_SUCCESS, ...
  */
 //-----------------------------------------------------------------------------
+template <class TTraits>
 uint32_t
-SblDeviceCC2650::writeFlashRangeAutoErase(uint32_t ui32StartAddress, uint32_t ui32ByteCount, const char *pcData)
+SblDeviceCC26xx<TTraits>::writeFlashRangeAutoErase(uint32_t ui32StartAddress, uint32_t ui32ByteCount, const char *pcData)
 {
     /*if((ui32StartAddress & 0x03))
     {
@@ -1942,18 +2082,17 @@ SblDeviceCC2650::writeFlashRangeAutoErase(uint32_t ui32StartAddress, uint32_t ui
 
     // Find how many pages we need to read
     int nPages, ret;
-    uint32_t ui32PositionInStartPage = ui32StartAddress % SBL_CC2650_PAGE_ERASE_SIZE;
-    uint32_t ui32StartPage = addressToPage(ui32StartAddress);
-    uint32_t ui32StartPageAddress = ui32StartPage*SBL_CC2650_PAGE_ERASE_SIZE;
+    uint32_t ui32StartPageAddress = Chip::pageToAddress(addressToPage(ui32StartAddress));
+    uint32_t ui32PositionInStartPage = ui32StartAddress - ui32StartPageAddress;
 
-    nPages = ceil(((double)(ui32ByteCount + ui32PositionInStartPage))/(double)SBL_CC2650_PAGE_ERASE_SIZE);
+    nPages = Chip::pageCount(ui32StartAddress, ui32ByteCount);
 
-    char* pcFlashPages = new char[nPages*SBL_CC2650_PAGE_ERASE_SIZE];
-    ret = readMemory8(ui32StartPageAddress, nPages*SBL_CC2650_PAGE_ERASE_SIZE, pcFlashPages);
+    char* pcFlashPages = new char[nPages*Chip::PAGE_ERASE_SIZE];
+    ret = readMemory8(ui32StartPageAddress, nPages*Chip::PAGE_ERASE_SIZE, pcFlashPages);
     if (ret != SBL_SUCCESS) { return SBL_ERROR; }
 
 
-    ret = eraseFlashRange(ui32StartPageAddress, nPages*SBL_CC2650_PAGE_ERASE_SIZE);
+    ret = eraseFlashRange(ui32StartPageAddress, nPages*Chip::PAGE_ERASE_SIZE);
     if (ret != SBL_SUCCESS) { return SBL_ERROR; }
 
     for (int i = 0; i < ui32ByteCount; i++)
@@ -1961,7 +2100,7 @@ SblDeviceCC2650::writeFlashRangeAutoErase(uint32_t ui32StartAddress, uint32_t ui
         pcFlashPages[ui32PositionInStartPage + i] = pcData[i];
     }
     
-    ret = writeFlashRange(ui32StartPageAddress, nPages*SBL_CC2650_PAGE_ERASE_SIZE, pcFlashPages);
+    ret = writeFlashRange(ui32StartPageAddress, nPages*Chip::PAGE_ERASE_SIZE, pcFlashPages);
     if (ret != SBL_SUCCESS) { return SBL_ERROR; }
 
     //Clean up
@@ -1969,3 +2108,8 @@ SblDeviceCC2650::writeFlashRangeAutoErase(uint32_t ui32StartAddress, uint32_t ui
     return SBL_SUCCESS;
 }
 
+
+//
+// Instantiate the driver for the supported chips
+//
+template class SblDeviceCC26xx<SblTraitsCC2650>;
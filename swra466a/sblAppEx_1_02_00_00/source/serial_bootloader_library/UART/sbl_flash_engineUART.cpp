@@ -0,0 +1,1456 @@
+/******************************************************************************
+*  Filename:       sbl_flash_engine.cpp
+*
+*  Description:    Serial Bootloader event driven flash engine file.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+
+#include "sbl_flash_engineUART.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+//
+// Bootloader commands and status codes shared by CC2538 and CC26xx
+//
+enum
+{
+    CMD_DOWNLOAD         = 0x21,
+    CMD_GET_STATUS       = 0x23,
+    CMD_SEND_DATA        = 0x24,
+    CMD_RESET            = 0x25,
+    CMD_ERASE            = 0x26,    // CC2538 range erase, CC26xx sector erase
+    CMD_CRC32            = 0x27,
+    CMD_GET_CHIP_ID      = 0x28,
+    CMD_MEMORY_READ      = 0x2A,
+    CMD_SET_CCFG         = 0x2D,    // CC26xx only
+    REV1_CMD_SET_CCFG    = 0x2B,    // CC26xx early samples
+    REV1_CMD_MEMORY_READ = 0x2C,
+    CMD_RET_SUCCESS      = 0x40,
+};
+
+typedef SblChip<SblTraitsCC2650> ChipCC2650;
+typedef SblChip<SblTraitsCC2538> ChipCC2538;
+
+
+/// Store \e ui32Src MSB first
+static void
+putUL(uint32_t ui32Src, char *pcDst)
+{
+    pcDst[0] = (char)(ui32Src >> 24);
+    pcDst[1] = (char)(ui32Src >> 16);
+    pcDst[2] = (char)(ui32Src >> 8);
+    pcDst[3] = (char)ui32Src;
+}
+
+
+/// Read a MSB first word
+static uint32_t
+getUL(const unsigned char *pData)
+{
+    return ((uint32_t)pData[0] << 24) | ((uint32_t)pData[1] << 16) | ((uint32_t)pData[2] << 8) | pData[3];
+}
+
+
+/// Command \e ui32Cmd as numbered by a device of revision \e ui32DeviceRev,
+/// see SblDeviceCC26xx::convertCmdForEarlySamples()
+static uint32_t
+convertCmd(uint32_t ui32DeviceRev, uint32_t ui32Cmd)
+{
+    if(ui32DeviceRev != 1)
+    {
+        return ui32Cmd;
+    }
+    switch(ui32Cmd)
+    {
+    case CMD_MEMORY_READ:   return REV1_CMD_MEMORY_READ;
+    case CMD_SET_CCFG:      return REV1_CMD_SET_CCFG;
+    default:                return ui32Cmd;
+    }
+}
+
+
+/// Monotonic time in ms
+static uint64_t
+getTimeMs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+/// Name of job step \e state for error messages
+static const char *
+stepName(tSblJobState state)
+{
+    switch(state)
+    {
+    case SBL_JOB_AUTOBAUD:          return "auto baud";
+    case SBL_JOB_CHIP_ID:           return "CMD_GET_CHIP_ID";
+    case SBL_JOB_FLASH_SIZE:        return "flash size read";
+    case SBL_JOB_ERASE:             return "erase";
+    case SBL_JOB_DOWNLOAD:          return "CMD_DOWNLOAD";
+    case SBL_JOB_SEND_DATA:         return "CMD_SEND_DATA";
+    case SBL_JOB_CRC:               return "CMD_CRC32";
+    case SBL_JOB_CCFG:              return "CMD_SET_CCFG";
+    case SBL_JOB_RESET:             return "CMD_RESET";
+    case SBL_JOB_ERASE_STATUS:      return "erase status";
+    case SBL_JOB_ERASE_CHECK:       return "erase check";
+    case SBL_JOB_DOWNLOAD_STATUS:   return "download status";
+    case SBL_JOB_SEND_DATA_STATUS:  return "send data status";
+    default:                        return "idle";
+    }
+}
+
+
+/// termios speed of \e ui32BaudRate, or B0 if not supported
+static speed_t
+ttySpeed(uint32_t ui32BaudRate)
+{
+    switch(ui32BaudRate)
+    {
+    case 9600:      return B9600;
+    case 19200:     return B19200;
+    case 38400:     return B38400;
+    case 57600:     return B57600;
+    case 115200:    return B115200;
+    case 230400:    return B230400;
+    case 460800:    return B460800;
+    case 500000:    return B500000;
+    case 921600:    return B921600;
+    case 1000000:   return B1000000;
+    case 1500000:   return B1500000;
+    default:        return B0;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Add a step that erases the flash pages holding \e ui32ByteCount
+ *      bytes from \e ui32Offset.
+ *
+ * \return
+ *      Returns the workflow, so steps can be chained.
+ */
+//-----------------------------------------------------------------------------
+SblWorkflow &
+SblWorkflow::erase(uint32_t ui32Offset, uint32_t ui32ByteCount)
+{
+    tSblStep step = { SBL_STEP_ERASE, ui32Offset, ui32ByteCount, 0, 0, 0 };
+    m_steps.push_back(step);
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Add a step that writes \e pcData to erased flash at \e ui32Offset.
+ *      The data is padded with 0xFF to a multiple of 4 bytes.
+ */
+//-----------------------------------------------------------------------------
+SblWorkflow &
+SblWorkflow::write(uint32_t ui32Offset, const char *pcData, uint32_t ui32ByteCount)
+{
+    uint32_t ui32Index = addData(pcData, ui32ByteCount);
+    tSblStep step = { SBL_STEP_WRITE, ui32Offset, (ui32ByteCount + 3) & ~3, ui32Index, 0, 0 };
+    m_steps.push_back(step);
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Add a step that compares the CRC32 of flash at \e ui32Offset with
+ *      that of \e pcData, padded as by write().
+ */
+//-----------------------------------------------------------------------------
+SblWorkflow &
+SblWorkflow::verify(uint32_t ui32Offset, const char *pcData, uint32_t ui32ByteCount)
+{
+    uint32_t ui32Index = addData(pcData, ui32ByteCount);
+    tSblStep step = { SBL_STEP_VERIFY, ui32Offset, (ui32ByteCount + 3) & ~3, ui32Index, 0, 0 };
+    m_steps.push_back(step);
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Erase, write and verify. The data is stored once.
+ */
+//-----------------------------------------------------------------------------
+SblWorkflow &
+SblWorkflow::program(uint32_t ui32Offset, const char *pcData, uint32_t ui32ByteCount)
+{
+    write(ui32Offset, pcData, ui32ByteCount);
+    tSblStep step = m_steps.back();
+
+    step.type = SBL_STEP_ERASE;
+    m_steps.insert(m_steps.end() - 1, step);
+    step.type = SBL_STEP_VERIFY;
+    m_steps.push_back(step);
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Add a step that writes CCFG field \e ui32Field (CC26xx only).
+ */
+//-----------------------------------------------------------------------------
+SblWorkflow &
+SblWorkflow::setCCFG(uint32_t ui32Field, uint32_t ui32Value)
+{
+    tSblStep step = { SBL_STEP_SET_CCFG, 0, 0, 0, ui32Field, ui32Value };
+    m_steps.push_back(step);
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Add a step that resets the device. It leaves the bootloader, so
+ *      this must be the last step.
+ */
+//-----------------------------------------------------------------------------
+SblWorkflow &
+SblWorkflow::reset()
+{
+    tSblStep step = { SBL_STEP_RESET, 0, 0, 0, 0, 0 };
+    m_steps.push_back(step);
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Get the number of bytes written by all write steps, for progress.
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblWorkflow::getWriteBytes() const
+{
+    uint32_t ui32Bytes = 0;
+    for(size_t i = 0; i < m_steps.size(); i++)
+    {
+        if(m_steps[i].type == SBL_STEP_WRITE) ui32Bytes += m_steps[i].ui32ByteCount;
+    }
+    return ui32Bytes;
+}
+
+
+/// Append \e pcData padded with 0xFF to a multiple of 4 bytes, return its index
+uint32_t
+SblWorkflow::addData(const char *pcData, uint32_t ui32ByteCount)
+{
+    uint32_t ui32Index = m_pvData.size();
+    m_pvData.insert(m_pvData.end(), pcData, pcData + ui32ByteCount);
+    m_pvData.resize(ui32Index + ((ui32ByteCount + 3) & ~3), (char)0xFF);
+    return ui32Index;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Constructor
+ */
+//-----------------------------------------------------------------------------
+SblFlashEngine::SblFlashEngine()
+{
+    struct epoll_event ev;
+
+    m_nextId = 1;
+    m_activeJobs = 0;
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeFd, &ev);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Destructor. Jobs still running are abandoned.
+ */
+//-----------------------------------------------------------------------------
+SblFlashEngine::~SblFlashEngine()
+{
+    while(!m_jobs.empty())
+    {
+        removeJob(m_jobs.begin()->first);
+    }
+    close(m_wakeFd);
+    close(m_epoll);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Start running \e workflow on the device on \e csPortNum. The job
+ *      then advances with step().
+ *
+ * \param[in] csPortNum
+ *      Serial port, e.g. "ttyUSB0".
+ * \param[in] ui32BaudRate
+ *      Baud rate.
+ * \param[in] workflow
+ *      Steps to run. Not copied; it must outlive the job.
+ *
+ * \return
+ *      Returns the job ID. A job that cannot start (port busy, unknown baud
+ *      rate, ...) is created in state SBL_JOB_FAILED.
+ */
+//-----------------------------------------------------------------------------
+int
+SblFlashEngine::addJob(const std::string &csPortNum, uint32_t ui32BaudRate, const SblWorkflow &workflow)
+{
+    struct termios tio;
+    struct epoll_event ev;
+    tJob *pJob = new tJob;
+    int id = m_nextId++;
+
+    pJob->csPortNum = csPortNum;
+    pJob->fd = -1;
+    pJob->pLock = new SblPortLock();
+    pJob->ui32BaudRate = ui32BaudRate;
+    pJob->bRunning = true;
+    pJob->bDraining = false;
+    pJob->ui64DrainEndMs = 0;
+    pJob->state = SBL_JOB_AUTOBAUD;
+    pJob->pWorkflow = &workflow;
+    pJob->pOwnWorkflow = NULL;
+    pJob->ui32Step = 0;
+    pJob->ui32WriteBytes = workflow.getWriteBytes();
+    pJob->ui32WriteDone = 0;
+    pJob->ui32ChipType = 0;
+    pJob->ui32DeviceRev = 0;
+    pJob->ui32FlashBase = 0;
+    pJob->ui32FlashSize = 0;
+    pJob->ui32Page = pJob->ui32PageEnd = 0;
+    pJob->ui32BatchPage = pJob->ui32RetryEnd = 0;
+    pJob->ui32Offset = pJob->ui32WriteEnd = pJob->ui32Chunk = 0;
+    pJob->bNoStatus = pJob->bBlDisabled = false;
+    pJob->ui32Tries = 0;
+    pJob->ui32PendingAcks = 0;
+    pJob->bExpectData = false;
+    pJob->ui64DeadlineMs = 0;
+    pJob->bWantWrite = false;
+    pJob->ui32Status = SBL_SUCCESS;
+    pJob->ui32Progress = 0;
+    m_jobs[id] = pJob;
+    m_activeJobs++;
+
+    if(ttySpeed(ui32BaudRate) == B0)
+    {
+        fail(pJob, SBL_ARGUMENT_ERROR, "Baud rate %d is not supported.", ui32BaudRate);
+        return id;
+    }
+    if(workflow.getSteps().empty())
+    {
+        fail(pJob, SBL_ARGUMENT_ERROR, "Workflow is empty.");
+        return id;
+    }
+
+    //
+    // Claim and open the port the way SblTransport does
+    //
+    uint32_t retCode = pJob->pLock->lock(SblPortLock::lockName(csPortNum));
+    if(retCode == SBL_PORT_ERROR)
+    {
+        fail(pJob, SBL_PORT_ERROR, "Unable to create lock file %s (%s).", 
+             pJob->pLock->getPath().c_str(), strerror(pJob->pLock->getError()));
+        return id;
+    }
+    if(retCode != SBL_SUCCESS)
+    {
+        if(pJob->pLock->getOwner() > 0)
+            fail(pJob, SBL_PORT_BUSY_ERROR, "%s is in use by process %d.", csPortNum.c_str(), pJob->pLock->getOwner());
+        else
+            fail(pJob, SBL_PORT_BUSY_ERROR, "%s is in use by another process.", csPortNum.c_str());
+        return id;
+    }
+    pJob->fd = open(SblPortLock::ttyPath(csPortNum).c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if(pJob->fd < 0)
+    {
+        fail(pJob, (errno == EBUSY) ? SBL_PORT_BUSY_ERROR : SBL_PORT_ERROR, 
+             "Unable to open %s: %s.", csPortNum.c_str(), strerror(errno));
+        return id;
+    }
+    ioctl(pJob->fd, TIOCEXCL);
+
+    //
+    // Raw 8N1, no flow control. VMIN 1 makes a read with no data fail with
+    // EAGAIN, so a read of 0 bytes means the port hung up.
+    //
+    if(tcgetattr(pJob->fd, &tio) != 0)
+    {
+        fail(pJob, SBL_PORT_ERROR, "%s is not a serial port.", csPortNum.c_str());
+        return id;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, ttySpeed(ui32BaudRate));
+    cfsetospeed(&tio, ttySpeed(ui32BaudRate));
+    tcsetattr(pJob->fd, TCSANOW, &tio);
+    tcflush(pJob->fd, TCIOFLUSH);
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = pJob;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, pJob->fd, &ev);
+
+    sendAutoBaud(pJob);
+    return id;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Start flashing \e pcData to the start of flash of the device on
+ *      \e csPortNum: erase, write, verify and reset.
+ *
+ * \param[in] pcData
+ *      Image. It is copied, padded with 0xFF to a multiple of 4 bytes.
+ * \param[in] ui32ByteCount
+ *      Image size.
+ *
+ * \return
+ *      Returns the job ID, see addJob() above.
+ */
+//-----------------------------------------------------------------------------
+int
+SblFlashEngine::addJob(const std::string &csPortNum, uint32_t ui32BaudRate, 
+                       const char *pcData, uint32_t ui32ByteCount)
+{
+    SblWorkflow *pWorkflow = new SblWorkflow();
+    if(ui32ByteCount)
+    {
+        pWorkflow->program(0, pcData, ui32ByteCount).reset();
+    }
+
+    int id = addJob(csPortNum, ui32BaudRate, *pWorkflow);
+    m_jobs[id]->pOwnWorkflow = pWorkflow;
+    return id;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Forget job \e job, abandoning it if still running.
+ */
+//-----------------------------------------------------------------------------
+void
+SblFlashEngine::removeJob(int job)
+{
+    tJob *pJob = findJob(job);
+    if(pJob == NULL)
+    {
+        return;
+    }
+    closeJob(pJob);
+    delete pJob->pLock;
+    delete pJob->pOwnWorkflow;
+    delete pJob;
+    m_jobs.erase(job);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Wait up to \e timeoutMs for the ports, and advance every job that
+ *      got a response or timed out.
+ *
+ * \param[in] timeoutMs
+ *      Longest wait. wake() cuts it short.
+ *
+ * \return
+ *      Returns the number of jobs still running.
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblFlashEngine::step(int timeoutMs)
+{
+    struct epoll_event pEvents[64];
+    uint64_t now = getTimeMs();
+    std::map<int, tJob *>::iterator it;
+
+    //
+    // Wake up for the nearest deadline
+    //
+    for(it = m_jobs.begin(); it != m_jobs.end(); ++it)
+    {
+        tJob *pJob = it->second;
+        if(pJob->fd >= 0 && pJob->ui64DeadlineMs)
+        {
+            int wait = (pJob->ui64DeadlineMs > now) ? (int)(pJob->ui64DeadlineMs - now) : 0;
+            if(timeoutMs < 0 || wait < timeoutMs) timeoutMs = wait;
+        }
+    }
+
+    int n = epoll_wait(m_epoll, pEvents, 64, timeoutMs);
+    for(int i = 0; i < n; i++)
+    {
+        tJob *pJob = (tJob *)pEvents[i].data.ptr;
+        if(pJob == NULL)
+        {
+            uint64_t ui64Count;
+            if(read(m_wakeFd, &ui64Count, sizeof(ui64Count)) < 0) { /* Already drained */ }
+            continue;
+        }
+        if(pEvents[i].events & EPOLLOUT)
+        {
+            flushTx(pJob);
+            if(pJob->bDraining)
+            {
+                checkDrained(pJob);
+            }
+        }
+        if(pEvents[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+        {
+            onReadable(pJob);
+        }
+        if((pEvents[i].events & (EPOLLERR | EPOLLHUP)) && pJob->fd >= 0)
+        {
+            //
+            // The port stays readable after a hang up, so it must not be
+            // watched any longer
+            //
+            portLost(pJob, "hang up");
+        }
+    }
+
+    now = getTimeMs();
+    for(it = m_jobs.begin(); it != m_jobs.end(); ++it)
+    {
+        tJob *pJob = it->second;
+        if(pJob->fd >= 0 && pJob->ui64DeadlineMs && now >= pJob->ui64DeadlineMs)
+        {
+            onTimeout(pJob);
+        }
+    }
+
+    return m_activeJobs;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Run until every job has finished.
+ *
+ * \return
+ *      Returns SBL_SUCCESS if all jobs succeeded, else SBL_ERROR.
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblFlashEngine::run()
+{
+    //
+    // Jobs that failed in addJob() (port busy, no lock file) are not
+    // running, and with none running step(-1) would wait forever
+    //
+    while(m_activeJobs > 0 && step(-1) > 0)
+    {
+    }
+
+    for(std::map<int, tJob *>::iterator it = m_jobs.begin(); it != m_jobs.end(); ++it)
+    {
+        if(it->second->state != SBL_JOB_DONE)
+        {
+            return SBL_ERROR;
+        }
+    }
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Make a step() waiting in another thread return early, e.g. to
+ *      add new jobs. Safe to call from any thread.
+ */
+//-----------------------------------------------------------------------------
+void
+SblFlashEngine::wake()
+{
+    uint64_t ui64One = 1;
+    if(write(m_wakeFd, &ui64One, sizeof(ui64One)) < 0) { /* Counter full, step() wakes anyway */ }
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Job accessors. Unknown jobs read as failed. A job is active
+ *      until its port is released, which is shortly after it is done.
+ */
+//-----------------------------------------------------------------------------
+tSblJobState
+SblFlashEngine::getState(int job)
+{
+    tJob *pJob = findJob(job);
+    return (pJob) ? pJob->state : SBL_JOB_FAILED;
+}
+
+bool
+SblFlashEngine::isActive(int job)
+{
+    tJob *pJob = findJob(job);
+    return (pJob) ? pJob->bRunning : false;
+}
+
+uint32_t
+SblFlashEngine::getStatus(int job)
+{
+    tJob *pJob = findJob(job);
+    return (pJob) ? pJob->ui32Status : (uint32_t)SBL_ARGUMENT_ERROR;
+}
+
+std::string
+SblFlashEngine::getError(int job)
+{
+    tJob *pJob = findJob(job);
+    return (pJob) ? pJob->csError : std::string("Unknown job");
+}
+
+uint32_t
+SblFlashEngine::getProgress(int job)
+{
+    tJob *pJob = findJob(job);
+    return (pJob) ? pJob->ui32Progress : 0;
+}
+
+uint32_t
+SblFlashEngine::getChipType(int job)
+{
+    tJob *pJob = findJob(job);
+    return (pJob) ? pJob->ui32ChipType : 0;
+}
+
+
+SblFlashEngine::tJob *
+SblFlashEngine::findJob(int job)
+{
+    std::map<int, tJob *>::iterator it = m_jobs.find(job);
+    return (it != m_jobs.end()) ? it->second : NULL;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Queue a command packet and expect its ACK, and a data packet if
+ *      \e bExpectData. Several commands may be queued before the responses
+ *      come in; the deadline covers them all.
+ */
+//-----------------------------------------------------------------------------
+void
+SblFlashEngine::sendCmd(tJob *pJob, uint32_t ui32Cmd, const char *pcData, uint32_t ui32Len, 
+                        bool bExpectData, uint32_t ui32TimeoutMs)
+{
+    unsigned char ui8Sum = ui32Cmd;
+    for(uint32_t i = 0; i < ui32Len; i++)
+    {
+        ui8Sum += pcData[i];
+    }
+
+    pJob->pvTx.push_back(ui32Len + 3);
+    pJob->pvTx.push_back(ui8Sum);
+    pJob->pvTx.push_back(ui32Cmd);
+    pJob->pvTx.insert(pJob->pvTx.end(), pcData, pcData + ui32Len);
+    pJob->ui32PendingAcks++;
+    pJob->bExpectData = bExpectData;
+    pJob->ui64DeadlineMs = getTimeMs() + ui32TimeoutMs;
+    flushTx(pJob);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Send the auto baud sequence. It is ACKed like a command.
+ */
+//-----------------------------------------------------------------------------
+void
+SblFlashEngine::sendAutoBaud(tJob *pJob)
+{
+    pJob->ui32Tries++;
+    pJob->pvTx.push_back(0x55);
+    pJob->pvTx.push_back(0x55);
+    pJob->ui32PendingAcks = 1;
+    pJob->bExpectData = false;
+    pJob->ui64DeadlineMs = getTimeMs() + SBL_DEFAULT_READ_TIMEOUT;
+    flushTx(pJob);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Write what the port takes of the queued bytes. The rest goes out
+ *      when the port signals EPOLLOUT.
+ */
+//-----------------------------------------------------------------------------
+void
+SblFlashEngine::flushTx(tJob *pJob)
+{
+    while(!pJob->pvTx.empty() && pJob->fd >= 0)
+    {
+        int ret = write(pJob->fd, &pJob->pvTx[0], pJob->pvTx.size());
+        if(ret < 0)
+        {
+            if(errno == EINTR) continue;
+            if(errno != EAGAIN)
+            {
+                fail(pJob, SBL_PORT_ERROR, "Writing to %s failed: %s.", pJob->csPortNum.c_str(), strerror(errno));
+                pJob->pvTx.clear();
+            }
+            break;
+        }
+        pJob->pvTx.erase(pJob->pvTx.begin(), pJob->pvTx.begin() + ret);
+    }
+    updateEvents(pJob);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Read what arrived and parse it as the ACKs and data packet the
+ *      job waits for. A complete response advances the job.
+ */
+//-----------------------------------------------------------------------------
+void
+SblFlashEngine::onReadable(tJob *pJob)
+{
+    unsigned char pBuf[512];
+    int ret;
+
+    while(pJob->fd >= 0)
+    {
+        ret = read(pJob->fd, pBuf, sizeof(pBuf));
+        if(ret == 0)
+        {
+            portLost(pJob, "hang up");
+            return;
+        }
+        if(ret < 0)
+        {
+            if(errno == EINTR) continue;
+            if(errno != EAGAIN)
+            {
+                portLost(pJob, strerror(errno));
+                return;
+            }
+            break;
+        }
+        pJob->pvRx.insert(pJob->pvRx.end(), pBuf, pBuf + ret);
+    }
+
+    std::vector<unsigned char> &rx = pJob->pvRx;
+    while(pJob->fd >= 0 && (pJob->ui32PendingAcks || pJob->bExpectData))
+    {
+        if(pJob->ui32PendingAcks)
+        {
+            //
+            // Expect 2 bytes (ACK or NAK)
+            //
+            if(rx.size() < 2)
+            {
+                return;
+            }
+            bool bAck = (rx[0] == 0x00 && rx[1] == 0xCC);
+            bool bNak = (rx[0] == 0x00 && rx[1] == 0x33);
+            unsigned char pIn[2] = { rx[0], rx[1] };
+            rx.erase(rx.begin(), rx.begin() + 2);
+            if(bNak && pJob->state == SBL_JOB_AUTOBAUD && pJob->ui32Tries < SBL_ENGINE_AUTOBAUD_TRIES)
+            {
+                sendAutoBaud(pJob);
+                continue;
+            }
+            if(bNak && pJob->state == SBL_JOB_SEND_DATA && pJob->ui32Tries++ < SBL_DEFAULT_CHUNK_RETRIES)
+            {
+                //
+                // The device drops a chunk it NAKs, so it is sent again
+                //
+                const tSblStep &step = pJob->pWorkflow->getSteps()[pJob->ui32Step];
+                pJob->ui32PendingAcks = 0;
+                sendCmd(pJob, CMD_SEND_DATA, pJob->pWorkflow->getData(step) + pJob->ui32Offset, pJob->ui32Chunk, 
+                        false, SBL_ENGINE_CMD_TIMEOUT);
+                continue;
+            }
+            if(!bAck)
+            {
+                if(bNak) fail(pJob, SBL_ERROR, "Device NAKed %s.", stepName(pJob->state));
+                else fail(pJob, SBL_ERROR, "ACK/NAK not received in %s. Expected 0x00 0xCC or 0x00 0x33, received 0x%02X 0x%02X.", 
+                              stepName(pJob->state), pIn[0], pIn[1]);
+                return;
+            }
+            if(--pJob->ui32PendingAcks == 0 && !pJob->bExpectData)
+            {
+                pJob->ui64DeadlineMs = 0;
+                onResponse(pJob, NULL, 0);
+            }
+            continue;
+        }
+
+        //
+        // Data packet: <1B length> <1B checksum> <data>. ACKed by the host.
+        //
+        if(rx.empty() || rx.size() < rx[0])
+        {
+            return;
+        }
+        uint32_t ui32Len = rx[0];
+        unsigned char ui8Sum = 0;
+        for(uint32_t i = 2; i < ui32Len; i++)
+        {
+            ui8Sum += rx[i];
+        }
+        if(ui32Len < 3 || ui8Sum != rx[1])
+        {
+            fail(pJob, SBL_ERROR, "Checksum verification error in %s response.", stepName(pJob->state));
+            return;
+        }
+        std::vector<unsigned char> pvData(rx.begin() + 2, rx.begin() + ui32Len);
+        rx.erase(rx.begin(), rx.begin() + ui32Len);
+        pJob->bExpectData = false;
+        pJob->ui64DeadlineMs = 0;
+        //
+        // ACK it before acting on it. The response may end the job.
+        //
+        pJob->pvTx.push_back(0x00);
+        pJob->pvTx.push_back((char)0xCC);
+        flushTx(pJob);
+        if(pJob->state == SBL_JOB_FAILED)
+        {
+            return;
+        }
+        onResponse(pJob, &pvData[0], pvData.size());
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief The port of \e pJob hung up or failed. Fail the job, unless it was
+ *      done already, and stop watching the port.
+ *
+ * \param[in] pcReason
+ *      What happened, for the error text.
+ */
+//-----------------------------------------------------------------------------
+void
+SblFlashEngine::portLost(tJob *pJob, const char *pcReason)
+{
+    fail(pJob, SBL_PORT_ERROR, "Lost %s: %s.", pJob->csPortNum.c_str(), pcReason);
+    closeJob(pJob);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief The device did not answer in time. Auto baud is retried, anything
+ *      else fails the job.
+ */
+//-----------------------------------------------------------------------------
+void
+SblFlashEngine::onTimeout(tJob *pJob)
+{
+    if(pJob->bDraining)
+    {
+        checkDrained(pJob);
+        return;
+    }
+    if(pJob->state == SBL_JOB_AUTOBAUD && pJob->ui32Tries < SBL_ENGINE_AUTOBAUD_TRIES)
+    {
+        sendAutoBaud(pJob);
+        return;
+    }
+    if(pJob->state == SBL_JOB_AUTOBAUD)
+    {
+        fail(pJob, SBL_TIMEOUT_ERROR, "No response to auto baud on %s. Is the device in bootloader mode?", 
+             pJob->csPortNum.c_str());
+        return;
+    }
+    fail(pJob, SBL_TIMEOUT_ERROR, "Timed out waiting for the device in %s.%s", stepName(pJob->state), 
+         (pJob->bBlDisabled) ? " The image disabled the bootloader." : "");
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief The response the job waited for is complete: check it and send
+ *      the command of the next step.
+ *
+ * \param[in] pData
+ *      Data packet payload, if one was expected.
+ */
+//-----------------------------------------------------------------------------
+void
+SblFlashEngine::onResponse(tJob *pJob, const unsigned char *pData, uint32_t ui32Len)
+{
+    //
+    // Every *_STATUS step reads the status of the command before it
+    //
+    if(pJob->state == SBL_JOB_ERASE_STATUS || pJob->state == SBL_JOB_DOWNLOAD_STATUS || 
+       pJob->state == SBL_JOB_SEND_DATA_STATUS)
+    {
+        if(ui32Len < 1 || pData[0] != CMD_RET_SUCCESS)
+        {
+            if(pJob->state == SBL_JOB_ERASE_STATUS && pJob->ui32ChipType != SblTraitsCC2538::CHIP_TYPE)
+            {
+                if(!retryErase(pJob))
+                {
+                    fail(pJob, SBL_ERROR, "Flash erase of page %d (0x%08X) failed. (Status 0x%02X). Flash pages may be locked.", 
+                         pJob->ui32BatchPage, ChipCC2650::pageToAddress(pJob->ui32BatchPage), (ui32Len) ? pData[0] : 0);
+                }
+                return;
+            }
+            fail(pJob, SBL_ERROR, "Device returned status 0x%02X in %s.", (ui32Len) ? pData[0] : 0, stepName(pJob->state));
+            return;
+        }
+    }
+
+    switch(pJob->state)
+    {
+    case SBL_JOB_AUTOBAUD:
+        pJob->state = SBL_JOB_CHIP_ID;
+        sendCmd(pJob, CMD_GET_CHIP_ID, NULL, 0, true, SBL_ENGINE_CMD_TIMEOUT);
+        break;
+
+    case SBL_JOB_CHIP_ID:
+        if(ui32Len != 4)
+        {
+            fail(pJob, SBL_ERROR, "Invalid chip ID response.");
+            return;
+        }
+    {
+        char pcPayload[6];
+        pJob->ui32ChipType = SblDevice::getChipType(getUL(pData));
+
+        //
+        // Read the flash size register, as readFlashSize() in the drivers
+        //
+        pJob->state = SBL_JOB_FLASH_SIZE;
+        if(pJob->ui32ChipType == SblTraitsCC2538::CHIP_TYPE)
+        {
+            pJob->ui32FlashBase = ChipCC2538::FLASH_START_ADDRESS;
+            putUL(ChipCC2538::DIECFG0, &pcPayload[0]);
+            pcPayload[4] = ChipCC2538::ACCESS_WIDTH_4B;
+            sendCmd(pJob, CMD_MEMORY_READ, pcPayload, 5, true, SBL_ENGINE_CMD_TIMEOUT);
+        }
+        else
+        {
+            pJob->ui32DeviceRev = ((getUL(pData) >> 28) <= 1) ? 1 : 2;
+            pJob->ui32FlashBase = ChipCC2650::FLASH_START_ADDRESS;
+            putUL(ChipCC2650::FLASH_SIZE_CFG, &pcPayload[0]);
+            pcPayload[4] = ChipCC2650::ACCESS_WIDTH_32B;
+            pcPayload[5] = 1;
+            sendCmd(pJob, convertCmd(pJob->ui32DeviceRev, CMD_MEMORY_READ), pcPayload, 6, 
+                    true, SBL_ENGINE_CMD_TIMEOUT);
+        }
+        break;
+    }
+
+    case SBL_JOB_FLASH_SIZE:
+        if(ui32Len != 4)
+        {
+            fail(pJob, SBL_ERROR, "Invalid flash size response.");
+            return;
+        }
+        if(pJob->ui32ChipType == SblTraitsCC2538::CHIP_TYPE)
+        {
+            //
+            // DIECFG0 bits [6:4], MSB first. Invalid values read as 64 KB.
+            //
+            uint32_t ui32Code = (getUL(pData) >> 4) & 0x07;
+            pJob->ui32FlashSize = (ui32Code >= 1 && ui32Code <= 4) ? ui32Code * 0x20000 : 0x10000;
+        }
+        else
+        {
+            //
+            // Number of sectors in bits [7:0] of a little endian word
+            //
+            pJob->ui32FlashSize = pData[0] * ChipCC2650::PAGE_ERASE_SIZE;
+        }
+        startStep(pJob);
+        break;
+
+    case SBL_JOB_ERASE:
+        pJob->state = SBL_JOB_ERASE_STATUS;
+        sendCmd(pJob, CMD_GET_STATUS, NULL, 0, true, SBL_ENGINE_CMD_TIMEOUT);
+        break;
+
+    case SBL_JOB_ERASE_STATUS:
+        if(pJob->ui32ChipType != SblTraitsCC2538::CHIP_TYPE)
+        {
+            //
+            // The status is that of the last erase of the batch. Check
+            // that all of it is blank.
+            //
+            char pcPayload[12];
+            memset(pcPayload, 0, sizeof(pcPayload));
+            putUL(ChipCC2650::pageToAddress(pJob->ui32BatchPage), &pcPayload[0]);
+            putUL((pJob->ui32Page - pJob->ui32BatchPage) * ChipCC2650::PAGE_ERASE_SIZE, &pcPayload[4]);
+            pJob->state = SBL_JOB_ERASE_CHECK;
+            sendCmd(pJob, CMD_CRC32, pcPayload, 12, true, SBL_ENGINE_CMD_TIMEOUT);
+            break;
+        }
+        pJob->ui32Step++;
+        startStep(pJob);
+        break;
+
+    case SBL_JOB_ERASE_CHECK:
+    {
+        uint32_t ui32Pages = pJob->ui32Page - pJob->ui32BatchPage;
+        if(ui32Len != 4 || getUL(pData) != SblDevice::calcBlankCrc32(ui32Pages * ChipCC2650::PAGE_ERASE_SIZE))
+        {
+            if(retryErase(pJob))
+            {
+                break;
+            }
+            fail(pJob, SBL_ERROR, "Flash page %d (0x%08X) is not blank after erase. Flash pages may be locked.", 
+                 pJob->ui32BatchPage, ChipCC2650::pageToAddress(pJob->ui32BatchPage));
+            return;
+        }
+        if(pJob->ui32Page >= pJob->ui32RetryEnd)
+        {
+            pJob->ui32RetryEnd = 0;
+        }
+        if(pJob->ui32Page < pJob->ui32PageEnd)
+        {
+            nextErase(pJob);
+            break;
+        }
+        pJob->ui32Step++;
+        startStep(pJob);
+        break;
+    }
+
+    case SBL_JOB_DOWNLOAD:
+        pJob->state = SBL_JOB_DOWNLOAD_STATUS;
+        sendCmd(pJob, CMD_GET_STATUS, NULL, 0, true, SBL_ENGINE_CMD_TIMEOUT);
+        break;
+
+    case SBL_JOB_DOWNLOAD_STATUS:
+        nextSendData(pJob);
+        break;
+
+    case SBL_JOB_SEND_DATA:
+        if(pJob->bNoStatus)
+        {
+            //
+            // We're locking the device and will lose access
+            //
+            sendDataDone(pJob);
+            break;
+        }
+        pJob->state = SBL_JOB_SEND_DATA_STATUS;
+        sendCmd(pJob, CMD_GET_STATUS, NULL, 0, true, SBL_ENGINE_CMD_TIMEOUT);
+        break;
+
+    case SBL_JOB_SEND_DATA_STATUS:
+        sendDataDone(pJob);
+        break;
+
+    case SBL_JOB_CRC:
+    {
+        const tSblStep &step = pJob->pWorkflow->getSteps()[pJob->ui32Step];
+        uint32_t ui32Crc = SblDevice::calcCrc32(pJob->pWorkflow->getData(step), step.ui32ByteCount);
+        if(ui32Len != 4 || getUL(pData) != ui32Crc)
+        {
+            fail(pJob, SBL_ERROR, "CRC mismatch at 0x%08X. Device 0x%08X, image 0x%08X.", 
+                 pJob->ui32FlashBase + step.ui32Offset, (ui32Len == 4) ? getUL(pData) : 0, ui32Crc);
+            return;
+        }
+        pJob->ui32Step++;
+        startStep(pJob);
+        break;
+    }
+
+    case SBL_JOB_CCFG:
+    case SBL_JOB_RESET:
+        pJob->ui32Step++;
+        startStep(pJob);
+        break;
+
+    default:
+        break;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Send the first command of workflow step \e ui32Step, or end the
+ *      job if all steps are done.
+ */
+//-----------------------------------------------------------------------------
+void
+SblFlashEngine::startStep(tJob *pJob)
+{
+    char pcPayload[12];
+    bool bCC2538 = (pJob->ui32ChipType == SblTraitsCC2538::CHIP_TYPE);
+
+    if(pJob->ui32Step >= pJob->pWorkflow->getSteps().size())
+    {
+        pJob->state = SBL_JOB_DONE;
+        pJob->ui32Progress = 100;
+        finishJob(pJob);
+        return;
+    }
+
+    const tSblStep &step = pJob->pWorkflow->getSteps()[pJob->ui32Step];
+    uint32_t ui32Address = pJob->ui32FlashBase + step.ui32Offset;
+
+    switch(step.type)
+    {
+    case SBL_STEP_ERASE:
+        if(bCC2538)
+        {
+            //
+            // CC2538 erases the whole range with one command
+            //
+            uint32_t ui32Pages = ChipCC2538::pageCount(ui32Address, step.ui32ByteCount);
+            putUL(ui32Address, &pcPayload[0]);
+            putUL(step.ui32ByteCount, &pcPayload[4]);
+            pJob->state = SBL_JOB_ERASE;
+            sendCmd(pJob, CMD_ERASE, pcPayload, 8, false, 
+                    ui32Pages * ChipCC2538::PAGE_ERASE_TIME_MS * 2 + SBL_ENGINE_CMD_TIMEOUT);
+        }
+        else
+        {
+            pJob->ui32Page = ChipCC2650::addressToPage(ui32Address);
+            pJob->ui32PageEnd = pJob->ui32Page + ChipCC2650::pageCount(ui32Address, step.ui32ByteCount);
+            nextErase(pJob);
+        }
+        break;
+
+    case SBL_STEP_WRITE:
+    {
+        //
+        // Does the data disable the bootloader? Then the download ends at
+        // the word holding the bootloader config byte.
+        //
+        uint32_t ui32BlCfgAddr = pJob->ui32FlashBase + pJob->ui32FlashSize + ((bCC2538) ? 
+                                 (uint32_t)(ChipCC2538::BL_CONFIG_PAGE_OFFSET - ChipCC2538::PAGE_ERASE_SIZE) : 
+                                 (uint32_t)(ChipCC2650::BL_CONFIG_PAGE_OFFSET - ChipCC2650::PAGE_ERASE_SIZE));
+        pJob->ui32Offset = 0;
+        pJob->ui32WriteEnd = step.ui32ByteCount;
+        pJob->bNoStatus = false;
+        if(ui32BlCfgAddr >= ui32Address && ui32BlCfgAddr - ui32Address < step.ui32ByteCount)
+        {
+            uint8_t ui8BlCfg = pJob->pWorkflow->getData(step)[ui32BlCfgAddr - ui32Address];
+            if((bCC2538) ? ((ui8BlCfg & ChipCC2538::BL_CONFIG_ENABLED_BM) == 0) : 
+                           (ui8BlCfg != ChipCC2650::BL_CONFIG_ENABLED_BM))
+            {
+                pJob->ui32WriteEnd = (ui32BlCfgAddr - ui32Address) & ~0x03;
+            }
+        }
+        startDownload(pJob);
+        break;
+    }
+
+    case SBL_STEP_VERIFY:
+        //
+        // CC26xx takes a read repeat count after address and size
+        //
+        memset(pcPayload, 0, sizeof(pcPayload));
+        putUL(ui32Address, &pcPayload[0]);
+        putUL(step.ui32ByteCount, &pcPayload[4]);
+        pJob->state = SBL_JOB_CRC;
+        sendCmd(pJob, CMD_CRC32, pcPayload, (bCC2538) ? 8 : 12, 
+                true, SBL_ENGINE_CMD_TIMEOUT + (step.ui32ByteCount >> 10));
+        break;
+
+    case SBL_STEP_SET_CCFG:
+        if(bCC2538)
+        {
+            fail(pJob, SBL_UNSUPPORTED_FUNCTION, "CC2538 has no CCFG.");
+            return;
+        }
+        putUL(step.ui32Field, &pcPayload[0]);
+        putUL(step.ui32Value, &pcPayload[4]);
+        pJob->state = SBL_JOB_CCFG;
+        sendCmd(pJob, convertCmd(pJob->ui32DeviceRev, CMD_SET_CCFG), pcPayload, 8, false, SBL_ENGINE_CMD_TIMEOUT);
+        break;
+
+    case SBL_STEP_RESET:
+        pJob->state = SBL_JOB_RESET;
+        sendCmd(pJob, CMD_RESET, NULL, 0, false, SBL_ENGINE_CMD_TIMEOUT);
+        break;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Send the next batch of CC26xx sector erases, queued back to back
+ *      as in SblDeviceCC26xx::eraseFlashRange(), with one status read and
+ *      one CRC after. While retryErase() has the job erase page by page, a
+ *      batch is one page.
+ */
+//-----------------------------------------------------------------------------
+void
+SblFlashEngine::nextErase(tJob *pJob)
+{
+    char pcPayload[4];
+    uint32_t ui32Count = GTmin(pJob->ui32PageEnd - pJob->ui32Page, (uint32_t)ChipCC2650::SECTOR_ERASE_BATCH);
+    if(pJob->ui32RetryEnd)
+    {
+        ui32Count = 1;
+    }
+
+    pJob->ui32BatchPage = pJob->ui32Page;
+    pJob->state = SBL_JOB_ERASE;
+    for(uint32_t i = 0; i < ui32Count; i++)
+    {
+        putUL(ChipCC2650::pageToAddress(pJob->ui32Page++), pcPayload);
+        sendCmd(pJob, CMD_ERASE, pcPayload, 4, false, 
+                ui32Count * ChipCC2650::PAGE_ERASE_TIME_MS * 2 + SBL_DEFAULT_READ_TIMEOUT);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief A CC26xx erase batch failed its status or blank check. Erase it
+ *      again page by page to find the page at fault.
+ *
+ * \return
+ *      Returns true if the retry was started, false if the batch was a
+ *      single page already.
+ */
+//-----------------------------------------------------------------------------
+bool
+SblFlashEngine::retryErase(tJob *pJob)
+{
+    if(pJob->ui32ChipType == SblTraitsCC2538::CHIP_TYPE || pJob->ui32RetryEnd || 
+       pJob->ui32Page - pJob->ui32BatchPage < 2)
+    {
+        return false;
+    }
+    pJob->ui32RetryEnd = pJob->ui32Page;
+    pJob->ui32Page = pJob->ui32BatchPage;
+    nextErase(pJob);
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Send the DOWNLOAD command for the data of the current write step
+ *      from ui32Offset up to ui32WriteEnd. Once that is sent, the rest of
+ *      the step disables the bootloader and gets a download of its own.
+ */
+//-----------------------------------------------------------------------------
+void
+SblFlashEngine::startDownload(tJob *pJob)
+{
+    const tSblStep &step = pJob->pWorkflow->getSteps()[pJob->ui32Step];
+    char pcPayload[8];
+
+    if(pJob->ui32Offset >= pJob->ui32WriteEnd && pJob->ui32WriteEnd < step.ui32ByteCount)
+    {
+        pJob->ui32WriteEnd = step.ui32ByteCount;
+        pJob->bNoStatus = true;
+        pJob->bBlDisabled = true;
+    }
+
+    putUL(pJob->ui32FlashBase + step.ui32Offset + pJob->ui32Offset, &pcPayload[0]);
+    putUL(pJob->ui32WriteEnd - pJob->ui32Offset, &pcPayload[4]);
+    pJob->state = SBL_JOB_DOWNLOAD;
+    sendCmd(pJob, CMD_DOWNLOAD, pcPayload, 8, false, SBL_ENGINE_CMD_TIMEOUT);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Send the next chunk of the current write step, at most as many
+ *      bytes as the bootloader of the chip found takes per SEND_DATA.
+ */
+//-----------------------------------------------------------------------------
+void
+SblFlashEngine::nextSendData(tJob *pJob)
+{
+    const tSblStep &step = pJob->pWorkflow->getSteps()[pJob->ui32Step];
+    uint32_t ui32MaxChunk = (pJob->ui32ChipType == SblTraitsCC2538::CHIP_TYPE) ? 
+                            (uint32_t)ChipCC2538::MAX_BYTES_PER_TRANSFER : (uint32_t)ChipCC2650::MAX_BYTES_PER_TRANSFER;
+
+    pJob->ui32Tries = 0;
+    pJob->ui32Chunk = GTmin(pJob->ui32WriteEnd - pJob->ui32Offset, ui32MaxChunk);
+    pJob->state = SBL_JOB_SEND_DATA;
+    sendCmd(pJob, CMD_SEND_DATA, pJob->pWorkflow->getData(step) + pJob->ui32Offset, pJob->ui32Chunk, 
+            false, SBL_ENGINE_CMD_TIMEOUT);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief The SEND_DATA in flight was accepted. Send the next chunk, start
+ *      the next download of the step, or go on with the next step.
+ */
+//-----------------------------------------------------------------------------
+void
+SblFlashEngine::sendDataDone(tJob *pJob)
+{
+    const tSblStep &step = pJob->pWorkflow->getSteps()[pJob->ui32Step];
+
+    pJob->ui32Offset += pJob->ui32Chunk;
+    pJob->ui32WriteDone += pJob->ui32Chunk;
+    pJob->ui32Progress = (uint32_t)((uint64_t)pJob->ui32WriteDone * 100 / pJob->ui32WriteBytes);
+    if(pJob->ui32Offset < pJob->ui32WriteEnd)
+    {
+        nextSendData(pJob);
+        return;
+    }
+    if(pJob->ui32Offset < step.ui32ByteCount)
+    {
+        startDownload(pJob);
+        return;
+    }
+    pJob->bNoStatus = false;
+    pJob->ui32Step++;
+    startStep(pJob);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief End job \e pJob with an error.
+ */
+//-----------------------------------------------------------------------------
+void
+SblFlashEngine::fail(tJob *pJob, uint32_t ui32Status, const char *pcFormat, ...)
+{
+    char pcBuf[256];
+    va_list args;
+
+    if(pJob->state == SBL_JOB_DONE || pJob->state == SBL_JOB_FAILED)
+    {
+        return;
+    }
+
+    va_start(args, pcFormat);
+    vsnprintf(pcBuf, sizeof(pcBuf), pcFormat, args);
+    va_end(args);
+
+    pJob->csError = pcBuf;
+    pJob->ui32Status = ui32Status;
+    pJob->state = SBL_JOB_FAILED;
+    finishJob(pJob);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Job \e pJob is done or failed. Expect nothing more from the device
+ *      and close the port once the bytes queued for it are sent.
+ */
+//-----------------------------------------------------------------------------
+void
+SblFlashEngine::finishJob(tJob *pJob)
+{
+    pJob->ui32PendingAcks = 0;
+    pJob->bExpectData = false;
+    pJob->pvRx.clear();
+    if(pJob->fd >= 0 && !pJob->bDraining)
+    {
+        pJob->bDraining = true;
+        pJob->ui64DrainEndMs = getTimeMs() + SBL_ENGINE_CMD_TIMEOUT;
+        flushTx(pJob);
+    }
+    checkDrained(pJob);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Close the port of a finished job if the driver has sent all bytes
+ *      (TIOCOUTQ), or the drain timeout passed. Else look again when they
+ *      should be out at the port's baud rate. Unlike tcdrain() this does not
+ *      hold up the other jobs.
+ */
+//-----------------------------------------------------------------------------
+void
+SblFlashEngine::checkDrained(tJob *pJob)
+{
+    int outq = 0;
+    uint64_t now = getTimeMs();
+
+    if(pJob->fd >= 0 && now < pJob->ui64DrainEndMs)
+    {
+        if(ioctl(pJob->fd, TIOCOUTQ, &outq) != 0)
+        {
+            outq = 0;
+        }
+        if(!pJob->pvTx.empty() || outq > 0)
+        {
+            outq += pJob->pvTx.size();
+            pJob->ui64DeadlineMs = now + 1 + (uint64_t)outq * 10 * 1000 / pJob->ui32BaudRate;
+            return;
+        }
+    }
+    closeJob(pJob);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Release the port of \e pJob at once.
+ */
+//-----------------------------------------------------------------------------
+void
+SblFlashEngine::closeJob(tJob *pJob)
+{
+    if(pJob->fd >= 0)
+    {
+        epoll_ctl(m_epoll, EPOLL_CTL_DEL, pJob->fd, NULL);
+        ioctl(pJob->fd, TIOCNXCL);
+        close(pJob->fd);
+        pJob->fd = -1;
+    }
+    pJob->pLock->unlock();
+    pJob->pvTx.clear();
+    pJob->pvRx.clear();
+    pJob->ui32PendingAcks = 0;
+    pJob->bExpectData = false;
+    pJob->ui64DeadlineMs = 0;
+    pJob->bDraining = false;
+    if(pJob->bRunning)
+    {
+        pJob->bRunning = false;
+        m_activeJobs--;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Watch for EPOLLOUT only while bytes wait to be written.
+ */
+//-----------------------------------------------------------------------------
+void
+SblFlashEngine::updateEvents(tJob *pJob)
+{
+    bool bWantWrite = !pJob->pvTx.empty();
+    if(pJob->fd < 0 || bWantWrite == pJob->bWantWrite)
+    {
+        return;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | ((bWantWrite) ? EPOLLOUT : 0);
+    ev.data.ptr = pJob;
+    epoll_ctl(m_epoll, EPOLL_CTL_MOD, pJob->fd, &ev);
+    pJob->bWantWrite = bWantWrite;
+}
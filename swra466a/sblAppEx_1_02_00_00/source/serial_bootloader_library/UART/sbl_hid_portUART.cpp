@@ -0,0 +1,371 @@
+/******************************************************************************
+*  Filename:       sbl_hid_port.cpp
+*
+*  Description:    Serial Bootloader buffered CP2110 HID port file.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+
+#include "sbl_hid_portUART.h"
+
+#include <string.h>
+#include <time.h>
+
+
+//-----------------------------------------------------------------------------
+/** \brief Constructor
+ */
+//-----------------------------------------------------------------------------
+SblHidPort::SblHidPort()
+{
+    pthread_condattr_t attr;
+
+    m_bRxStarted = false;
+    m_bRxStop = false;
+    m_bRxError = false;
+    m_ui32RxHead = 0;
+    m_ui32RxCount = 0;
+    m_rdTimeoutMs = 100;
+    m_pvRxRing.resize(HID_RX_RING_SIZE);
+    m_pvTx.reserve(HID_TX_BATCH_SIZE);
+
+    pthread_mutex_init(&m_rxMutex, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&m_rxCond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Destructor
+ */
+//-----------------------------------------------------------------------------
+SblHidPort::~SblHidPort()
+{
+    close();
+    pthread_cond_destroy(&m_rxCond);
+    pthread_mutex_destroy(&m_rxMutex);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Open the CP2110 port and start the reader thread.
+ *
+ * \param[in] csPortNumber
+ *      CP2110 port number, without the "hid:" prefix.
+ * \param[in] baudRate
+ *      UART baud rate.
+ * \param[in] rdTimeoutMs
+ *      How long readBytes() waits for data.
+ * \param[in] wrTimeoutMs
+ *      Write timeout of the port.
+ * \param[in] flags
+ *      Port flags.
+ *
+ * \return
+ *      Returns ComPort::COMPORT_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+int
+SblHidPort::open(std::string csPortNumber, int baudRate, int rdTimeoutMs, 
+                 int wrTimeoutMs, int flags)
+{
+    int retCode;
+
+    close();
+
+    //
+    // The port read timeout only bounds how long the reader thread takes
+    // to notice close(). readBytes() uses rdTimeoutMs.
+    //
+    if((retCode = portOpen(csPortNumber, baudRate, HID_RX_POLL_MS, 
+                            wrTimeoutMs, flags)) != ComPort::COMPORT_SUCCESS)
+    {
+        return retCode;
+    }
+
+    m_rdTimeoutMs = rdTimeoutMs;
+    m_ui32RxHead = 0;
+    m_ui32RxCount = 0;
+    m_bRxError = false;
+    m_bRxStop = false;
+    m_pvTx.clear();
+
+    if(pthread_create(&m_rxThread, NULL, &SblHidPort::rxThread, this) != 0)
+    {
+        portClose();
+        return ComPort::COMPORT_ERROR;
+    }
+    m_bRxStarted = true;
+
+    return ComPort::COMPORT_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Send pending writes, stop the reader thread and close the port.
+ *
+ * \return
+ *      Returns ComPort::COMPORT_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+int
+SblHidPort::close()
+{
+    if(!portIsOpen())
+    {
+        return ComPort::COMPORT_SUCCESS;
+    }
+
+    flushTx();
+
+    if(m_bRxStarted)
+    {
+        m_bRxStop = true;
+        pthread_join(m_rxThread, NULL);
+        m_bRxStarted = false;
+    }
+
+    return portClose();
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Read up to \e length bytes. Pending writes are sent first, as the
+ *      data waited for is usually the answer to them.
+ *
+ * \param[out] pData
+ *      Pointer to where the data is stored.
+ * \param[in] length
+ *      Max number of bytes to read.
+ *
+ * \return
+ *      Returns the number of bytes read (0 on timeout) or -1 on error.
+ */
+//-----------------------------------------------------------------------------
+int
+SblHidPort::readBytes(void *pData, int length)
+{
+    struct timespec ts;
+    uint32_t ui32Bytes = 0;
+
+    if(flushTx() < 0)
+    {
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += m_rdTimeoutMs / 1000;
+    ts.tv_nsec += (m_rdTimeoutMs % 1000) * 1000000L;
+    if(ts.tv_nsec >= 1000000000L)
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&m_rxMutex);
+    while(m_ui32RxCount == 0 && !m_bRxError)
+    {
+        if(pthread_cond_timedwait(&m_rxCond, &m_rxMutex, &ts) != 0)
+        {
+            break;
+        }
+    }
+
+    //
+    // Copy out of the ring, at most in two parts
+    //
+    while(ui32Bytes < (uint32_t)length && m_ui32RxCount > 0)
+    {
+        uint32_t ui32Chunk = m_pvRxRing.size() - m_ui32RxHead;
+        if(ui32Chunk > m_ui32RxCount) ui32Chunk = m_ui32RxCount;
+        if(ui32Chunk > length - ui32Bytes) ui32Chunk = length - ui32Bytes;
+
+        memcpy((char *)pData + ui32Bytes, &m_pvRxRing[m_ui32RxHead], ui32Chunk);
+        m_ui32RxHead = (m_ui32RxHead + ui32Chunk) % m_pvRxRing.size();
+        m_ui32RxCount -= ui32Chunk;
+        ui32Bytes += ui32Chunk;
+    }
+    bool bError = m_bRxError && (ui32Bytes == 0);
+    pthread_mutex_unlock(&m_rxMutex);
+
+    return bError ? -1 : (int)ui32Bytes;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Queue \e length bytes for sending. The data goes out at the next
+ *      readBytes(), flushBuffers() or flushTx(), or as soon as a full batch
+ *      is queued.
+ *
+ * \param[in] pData
+ *      Pointer to the data.
+ * \param[in] length
+ *      Number of bytes.
+ *
+ * \return
+ *      Returns \e length or -1 on error.
+ */
+//-----------------------------------------------------------------------------
+int
+SblHidPort::writeBytes(void *pData, int length)
+{
+    if(!portIsOpen())
+    {
+        return -1;
+    }
+
+    m_pvTx.insert(m_pvTx.end(), (char *)pData, (char *)pData + length);
+    if(m_pvTx.size() >= HID_TX_BATCH_SIZE && flushTx() < 0)
+    {
+        return -1;
+    }
+
+    return length;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Send all queued bytes in one write, so HID_ComPort can pack them
+ *      into full reports.
+ *
+ * \return
+ *      Returns the number of bytes sent or -1 on error.
+ */
+//-----------------------------------------------------------------------------
+int
+SblHidPort::flushTx()
+{
+    uint32_t ui32Sent = 0;
+
+    while(ui32Sent < m_pvTx.size())
+    {
+        int ret = portWrite(&m_pvTx[ui32Sent], m_pvTx.size() - ui32Sent);
+        if(ret <= 0)
+        {
+            m_pvTx.clear();
+            return -1;
+        }
+        ui32Sent += ret;
+    }
+    m_pvTx.clear();
+
+    return ui32Sent;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Send queued bytes, then drop all received data.
+ *
+ * \return
+ *      Returns ComPort::COMPORT_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+int
+SblHidPort::flushBuffers()
+{
+    flushTx();
+    int retCode = portFlush();
+
+    pthread_mutex_lock(&m_rxMutex);
+    m_ui32RxHead = 0;
+    m_ui32RxCount = 0;
+    pthread_mutex_unlock(&m_rxMutex);
+
+    return retCode;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Reader thread. Keeps a read pending on the interrupt IN endpoint
+ *      and appends whatever arrives to the RX ring.
+ *
+ * \param[in] pArg
+ *      Pointer to the SblHidPort.
+ *
+ * \return
+ *      NULL
+ */
+//-----------------------------------------------------------------------------
+/*static*/void *
+SblHidPort::rxThread(void *pArg)
+{
+    SblHidPort *pThis = (SblHidPort *)pArg;
+    char pcBuf[4 * HID_REPORT_DATA_SIZE];
+
+    while(!pThis->m_bRxStop)
+    {
+        int ret = pThis->portRead(pcBuf, sizeof(pcBuf));
+        if(ret == 0)
+        {
+            continue;
+        }
+
+        pthread_mutex_lock(&pThis->m_rxMutex);
+        if(ret < 0)
+        {
+            pThis->m_bRxError = true;
+        }
+        else
+        {
+            //
+            // On overflow the oldest data is dropped. The ring is much larger
+            // than any bootloader response, so this only happens if nobody
+            // reads, and the protocol checksums catch it.
+            //
+            uint32_t ui32Size = pThis->m_pvRxRing.size();
+            for(int i = 0; i < ret; i++)
+            {
+                uint32_t ui32Tail = (pThis->m_ui32RxHead + pThis->m_ui32RxCount) % ui32Size;
+                pThis->m_pvRxRing[ui32Tail] = pcBuf[i];
+                if(pThis->m_ui32RxCount < ui32Size)
+                {
+                    pThis->m_ui32RxCount++;
+                }
+                else
+                {
+                    pThis->m_ui32RxHead = (pThis->m_ui32RxHead + 1) % ui32Size;
+                }
+            }
+        }
+        pthread_cond_signal(&pThis->m_rxCond);
+        pthread_mutex_unlock(&pThis->m_rxMutex);
+
+        if(ret < 0)
+        {
+            break;
+        }
+    }
+
+    return NULL;
+}
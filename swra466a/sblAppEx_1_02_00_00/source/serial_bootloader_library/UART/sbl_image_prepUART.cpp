@@ -0,0 +1,355 @@
+/******************************************************************************
+*  Filename:       sbl_image_prep.cpp
+*
+*  Description:    Serial Bootloader host side image preparation file.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+
+
+#include "sbl_image_prepUART.h"
+#include "sbl_manifestUART.h"
+#include "sbllibUART.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+
+//-----------------------------------------------------------------------------
+/** \brief Milliseconds from a monotonic clock
+ */
+//-----------------------------------------------------------------------------
+static uint64_t
+getTimeMs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Constructor
+ */
+//-----------------------------------------------------------------------------
+SblImagePrep::SblImagePrep()
+{
+    m_pManifest = NULL;
+    m_fd = -1;
+    m_pvMap = NULL;
+    m_pcData = NULL;
+    m_ui32ByteCount = 0;
+    m_ui32Crc = 0;
+    m_ui32PrepMs = 0;
+    m_ui32WaitMs = 0;
+    m_ui32Status = SBL_SUCCESS;
+    m_bStarted = false;
+    m_ui32PageSize = 0;
+    m_bWaiting = false;
+
+    pthread_mutex_init(&m_mutex, NULL);
+    pthread_cond_init(&m_cond, NULL);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Destructor. Waits for the worker and unmaps the image.
+ */
+//-----------------------------------------------------------------------------
+SblImagePrep::~SblImagePrep()
+{
+    wait();
+    release();
+    pthread_cond_destroy(&m_cond);
+    pthread_mutex_destroy(&m_mutex);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Start preparing image file \e csFile.
+ *
+ * \param[in] csFile
+ *      Path to the binary image.
+ * \param[in] ui32PageSize
+ *      Flash page size for the page CRC map, or 0 if it will be given with
+ *      setPageSize() once the device is known. The map assumes the image
+ *      is written from the start of a page.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, SBL_ARGUMENT_ERROR with getError() set if the
+ *      file cannot be opened, or SBL_ERROR if the worker cannot be started.
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblImagePrep::start(const std::string &csFile, uint32_t ui32PageSize)
+{
+    struct stat st;
+
+    wait();
+    release();
+    m_pManifest = NULL;
+    m_csFile = csFile;
+    m_ui32PageSize = ui32PageSize;
+    m_csError.clear();
+
+    //
+    // Open the file here so the caller learns the size (and about a missing
+    // file) before it connects
+    //
+    m_fd = open(csFile.c_str(), O_RDONLY);
+    if(m_fd < 0 || fstat(m_fd, &st) != 0)
+    {
+        m_csError = "Unable to open file path: " + csFile;
+        return SBL_ARGUMENT_ERROR;
+    }
+    m_ui32ByteCount = (uint32_t)st.st_size;
+
+    m_bWaiting = false;
+    m_bStarted = (pthread_create(&m_thread, NULL, &SblImagePrep::workerThread, this) == 0);
+    return (m_bStarted) ? SBL_SUCCESS : SBL_ERROR;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Start loading manifest \e csFile into \e pManifest.
+ *
+ * \param[in] pManifest
+ *      Manifest to load. Must not be used until wait() has returned.
+ * \param[in] csFile
+ *      Path to the manifest.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, or SBL_ERROR if the worker cannot be started.
+ *      Errors loading the manifest are returned by wait().
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblImagePrep::start(SblManifest *pManifest, const std::string &csFile)
+{
+    wait();
+    release();
+    m_pManifest = pManifest;
+    m_csFile = csFile;
+    m_ui32PageSize = 0;
+    m_csError.clear();
+
+    m_bWaiting = false;
+    m_bStarted = (pthread_create(&m_thread, NULL, &SblImagePrep::workerThread, this) == 0);
+    return (m_bStarted) ? SBL_SUCCESS : SBL_ERROR;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Give the flash page size for the page CRC map, e.g. from
+ *      SblDevice::getPageSize() after connecting.
+ */
+//-----------------------------------------------------------------------------
+void
+SblImagePrep::setPageSize(uint32_t ui32PageSize)
+{
+    pthread_mutex_lock(&m_mutex);
+    m_ui32PageSize = ui32PageSize;
+    pthread_cond_broadcast(&m_cond);
+    pthread_mutex_unlock(&m_mutex);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Wait for the worker to finish. If the page size has not been
+ *      given by now, no page CRC map is made.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, or the status of the stage that failed with
+ *      getError() set.
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblImagePrep::wait()
+{
+    if(!m_bStarted)
+    {
+        return m_ui32Status;
+    }
+
+    uint64_t ui64Start = getTimeMs();
+    pthread_mutex_lock(&m_mutex);
+    m_bWaiting = true;
+    pthread_cond_broadcast(&m_cond);
+    pthread_mutex_unlock(&m_mutex);
+
+    pthread_join(m_thread, NULL);
+    m_bStarted = false;
+    m_ui32WaitMs = (uint32_t)(getTimeMs() - ui64Start);
+
+    return m_ui32Status;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Worker thread entry
+ */
+//-----------------------------------------------------------------------------
+void *
+SblImagePrep::workerThread(void *pArg)
+{
+    SblImagePrep *pThis = (SblImagePrep *)pArg;
+    uint64_t ui64Start = getTimeMs();
+
+    pThis->m_ui32Status = pThis->prepare();
+    pThis->m_ui32PrepMs = (uint32_t)(getTimeMs() - ui64Start);
+
+    return NULL;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Run the stages. Called on the worker thread.
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblImagePrep::prepare()
+{
+    uint32_t retCode;
+
+    if(m_pManifest)
+    {
+        if((retCode = m_pManifest->load(m_csFile)) != SBL_SUCCESS)
+        {
+            m_csError = m_pManifest->getError();
+        }
+        return retCode;
+    }
+
+    if((retCode = loadImage()) != SBL_SUCCESS)
+    {
+        return retCode;
+    }
+
+    //
+    // Reading every byte here also pages in a mapped file
+    //
+    m_ui32Crc = SblDevice::calcCrc32(m_pcData, m_ui32ByteCount);
+
+    //
+    // The page size is usually only known once the device has connected
+    //
+    pthread_mutex_lock(&m_mutex);
+    while(!m_ui32PageSize && !m_bWaiting)
+    {
+        pthread_cond_wait(&m_cond, &m_mutex);
+    }
+    uint32_t ui32PageSize = m_ui32PageSize;
+    pthread_mutex_unlock(&m_mutex);
+
+    m_pvPageCrcs.clear();
+    for(uint32_t ui32Offset = 0; ui32PageSize && ui32Offset < m_ui32ByteCount; ui32Offset += ui32PageSize)
+    {
+        uint32_t ui32Bytes = (m_ui32ByteCount - ui32Offset < ui32PageSize) ? m_ui32ByteCount - ui32Offset : ui32PageSize;
+        m_pvPageCrcs.push_back(SblDevice::calcCrc32(m_pcData + ui32Offset, ui32Bytes));
+    }
+
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Map the opened file, or read it if it cannot be mapped (e.g. a
+ *      pipe or an empty file).
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblImagePrep::loadImage()
+{
+    if(m_ui32ByteCount)
+    {
+        m_pvMap = mmap(NULL, m_ui32ByteCount, PROT_READ, MAP_PRIVATE, m_fd, 0);
+        if(m_pvMap != MAP_FAILED)
+        {
+            madvise(m_pvMap, m_ui32ByteCount, MADV_SEQUENTIAL);
+            m_pcData = (const char *)m_pvMap;
+            return SBL_SUCCESS;
+        }
+        m_pvMap = NULL;
+    }
+
+    //
+    // Read until EOF; the size from fstat() is only a hint here
+    //
+    char pcBuf[4096];
+    ssize_t bytesRead;
+    m_pvData.clear();
+    m_pvData.reserve(m_ui32ByteCount + 1);
+    while((bytesRead = read(m_fd, pcBuf, sizeof(pcBuf))) > 0)
+    {
+        m_pvData.insert(m_pvData.end(), pcBuf, pcBuf + bytesRead);
+    }
+    if(bytesRead < 0)
+    {
+        m_csError = "Unable to read file: " + m_csFile;
+        return SBL_ARGUMENT_ERROR;
+    }
+    m_ui32ByteCount = m_pvData.size();
+    m_pvData.push_back(0);          // getData() is valid for an empty file too
+    m_pcData = &m_pvData[0];
+
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Unmap and close the image of the previous start()
+ */
+//-----------------------------------------------------------------------------
+void
+SblImagePrep::release()
+{
+    if(m_pvMap)
+    {
+        munmap(m_pvMap, m_ui32ByteCount);
+        m_pvMap = NULL;
+    }
+    if(m_fd >= 0)
+    {
+        close(m_fd);
+        m_fd = -1;
+    }
+    m_pvData.clear();
+    m_pcData = NULL;
+    m_ui32ByteCount = 0;
+    m_ui32Crc = 0;
+    m_pvPageCrcs.clear();
+    m_ui32Status = SBL_SUCCESS;
+}
@@ -0,0 +1,618 @@
+/******************************************************************************
+*  Filename:       sbl_manifest.cpp
+*
+*  Description:    Serial Bootloader job manifest file.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+
+
+#include "sbl_manifestUART.h"
+#include "sbllibUART.h"
+
+#include <algorithm>
+#include <fstream>
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/// Parse a decimal or 0x prefixed hex number. Returns false if \e csText is
+/// not a number.
+static bool
+parseNumber(const std::string &csText, uint32_t &ui32Value)
+{
+    char *pcEnd;
+    if(csText.empty())
+    {
+        return false;
+    }
+    ui32Value = strtoul(csText.c_str(), &pcEnd, 0);
+    return (*pcEnd == '\0');
+}
+
+
+/// Split a manifest line into tokens at whitespace. Text in double quotes
+/// is kept in one token with the quotes removed, where \" and \\ stand for
+/// a quote and a backslash. '#' before a token starts a comment. Returns
+/// NULL, or why the line cannot be split.
+static const char *
+tokenize(const std::string &csLine, std::vector<std::string> &pvTokens)
+{
+    std::string csToken;
+    bool bInToken = false;
+    bool bQuoted = false;
+
+    for(size_t i = 0; i < csLine.size(); i++)
+    {
+        char c = csLine[i];
+        if(bQuoted)
+        {
+            if(c == '"')
+            {
+                bQuoted = false;
+            }
+            else if(c == '\\' && i + 1 < csLine.size() && (csLine[i + 1] == '"' || csLine[i + 1] == '\\'))
+            {
+                csToken += csLine[++i];
+            }
+            else
+            {
+                csToken += c;
+            }
+        }
+        else if(c == '#')
+        {
+            if(bInToken) return "'#' inside an argument, put it in quotes";
+            break;
+        }
+        else if(isspace((unsigned char)c))
+        {
+            if(bInToken) pvTokens.push_back(csToken);
+            csToken.clear();
+            bInToken = false;
+        }
+        else
+        {
+            if(c == '"') bQuoted = true;
+            else csToken += c;
+            bInToken = true;
+        }
+    }
+    if(bQuoted) return "missing closing quote";
+    if(bInToken) pvTokens.push_back(csToken);
+    return NULL;
+}
+
+
+/// Parse "verify=<policy>"
+static bool
+parseVerify(const std::string &csText, tSblVerify &verify)
+{
+    if(csText == "verify=crc")              verify = SBL_VERIFY_CRC;
+    else if(csText == "verify=readback")    verify = SBL_VERIFY_READBACK;
+    else if(csText == "verify=none")        verify = SBL_VERIFY_NONE;
+    else return false;
+    return true;
+}
+
+
+/// Start of flash of the connected device
+static uint32_t
+flashBase(SblDevice *pDevice)
+{
+    if(SblDevice::getChipType(pDevice->getDeviceId()) == SblTraitsCC2538::CHIP_TYPE)
+    {
+        return SblTraitsCC2538::FLASH_START_ADDRESS;
+    }
+    return SblTraitsCC2650::FLASH_START_ADDRESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Read manifest \e csFile and the image files it lists.
+ *
+ * \param[in] csFile
+ *      Path to the manifest.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, or SBL_ARGUMENT_ERROR with getError() set if a
+ *      file cannot be read or a line is invalid.
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblManifest::load(const std::string &csFile)
+{
+    std::ifstream manifest(csFile.c_str());
+    std::string csLine, csDir;
+    uint32_t ui32LineNo = 0;
+
+    m_regions.clear();
+    m_ramPatches.clear();
+    m_ccfgFields.clear();
+    m_patches.clear();
+    m_eraseRanges.clear();
+    m_csError.clear();
+
+    if(!manifest.is_open())
+    {
+        return error(SBL_ARGUMENT_ERROR, "Unable to open manifest %s.", csFile.c_str());
+    }
+    if(csFile.find('/') != std::string::npos)
+    {
+        csDir = csFile.substr(0, csFile.rfind('/') + 1);
+    }
+
+    while(std::getline(manifest, csLine))
+    {
+        std::vector<std::string> pvTokens;
+        const char *pcSyntaxError;
+
+        ui32LineNo++;
+        if((pcSyntaxError = tokenize(csLine, pvTokens)) != NULL)
+        {
+            return error(SBL_ARGUMENT_ERROR, "%s:%d: %s.", csFile.c_str(), ui32LineNo, pcSyntaxError);
+        }
+        if(pvTokens.empty())
+        {
+            continue;
+        }
+
+        if(pvTokens[0] == "image" && pvTokens.size() >= 2 && pvTokens.size() <= 4)
+        {
+            tSblRegion region;
+            region.csFile = (pvTokens[1][0] == '/') ? pvTokens[1] : csDir + pvTokens[1];
+            region.ui32Address = 0;
+            region.bFlashStart = true;
+            region.verify = SBL_VERIFY_CRC;
+            for(size_t i = 2; i < pvTokens.size(); i++)
+            {
+                if(parseVerify(pvTokens[i], region.verify)) continue;
+                if(!region.bFlashStart || !parseNumber(pvTokens[i], region.ui32Address))
+                {
+                    return error(SBL_ARGUMENT_ERROR, "%s:%d: invalid argument '%s'.", csFile.c_str(), ui32LineNo, 
+                                 pvTokens[i].c_str());
+                }
+                region.bFlashStart = false;
+            }
+
+            std::ifstream image(region.csFile.c_str(), std::ios::binary);
+            if(!image.is_open())
+            {
+                return error(SBL_ARGUMENT_ERROR, "%s:%d: unable to open %s.", csFile.c_str(), ui32LineNo, 
+                             region.csFile.c_str());
+            }
+            image.seekg(0, std::ios::end);
+            uint32_t ui32Size = (uint32_t)image.tellg();
+            image.seekg(0, std::ios::beg);
+            if(ui32Size == 0)
+            {
+                return error(SBL_ARGUMENT_ERROR, "%s:%d: %s is empty.", csFile.c_str(), ui32LineNo, region.csFile.c_str());
+            }
+            region.pvData.resize(ui32Size);
+            image.read(&region.pvData[0], ui32Size);
+            region.pvData.resize((ui32Size + 3) & ~3, (char)0xFF);
+            m_regions.push_back(region);
+        }
+        else if(pvTokens[0] == "ccfg" && pvTokens.size() == 3)
+        {
+            tSblCcfgField field;
+            if(!parseNumber(pvTokens[1], field.ui32Field) || !parseNumber(pvTokens[2], field.ui32Value))
+            {
+                return error(SBL_ARGUMENT_ERROR, "%s:%d: invalid ccfg line.", csFile.c_str(), ui32LineNo);
+            }
+            m_ccfgFields.push_back(field);
+        }
+        else if(pvTokens[0] == "ram32" && pvTokens.size() >= 3)
+        {
+            tSblRamPatch patch;
+            patch.verify = SBL_VERIFY_READBACK;
+            if(!parseNumber(pvTokens[1], patch.ui32Address) || (patch.ui32Address & 3))
+            {
+                return error(SBL_ARGUMENT_ERROR, "%s:%d: invalid ram32 address.", csFile.c_str(), ui32LineNo);
+            }
+            for(size_t i = 2; i < pvTokens.size(); i++)
+            {
+                uint32_t ui32Word;
+                if(parseVerify(pvTokens[i], patch.verify)) continue;
+                if(!parseNumber(pvTokens[i], ui32Word))
+                {
+                    return error(SBL_ARGUMENT_ERROR, "%s:%d: invalid word '%s'.", csFile.c_str(), ui32LineNo, 
+                                 pvTokens[i].c_str());
+                }
+                patch.pvWords.push_back(ui32Word);
+            }
+            if(patch.pvWords.empty())
+            {
+                return error(SBL_ARGUMENT_ERROR, "%s:%d: ram32 needs at least one word.", csFile.c_str(), ui32LineNo);
+            }
+            m_ramPatches.push_back(patch);
+        }
+        else if(pvTokens[0] == "patch")
+        {
+            tSblPatch patch;
+            if(pvTokens.size() != 3)
+            {
+                return error(SBL_ARGUMENT_ERROR, "%s:%d: patch takes an address and one data value, quote data "
+                             "with spaces or '#'.", csFile.c_str(), ui32LineNo);
+            }
+            if(!parseNumber(pvTokens[1], patch.ui32Address))
+            {
+                return error(SBL_ARGUMENT_ERROR, "%s:%d: invalid patch address.", csFile.c_str(), ui32LineNo);
+            }
+            patch.csData = pvTokens[2];
+            patch.ui32LineNo = ui32LineNo;
+            m_patches.push_back(patch);
+        }
+        else
+        {
+            return error(SBL_ARGUMENT_ERROR, "%s:%d: unknown entry '%s'.", csFile.c_str(), ui32LineNo, 
+                         pvTokens[0].c_str());
+        }
+    }
+
+    if(m_regions.empty() && m_ramPatches.empty() && m_ccfgFields.empty())
+    {
+        return error(SBL_ARGUMENT_ERROR, "Manifest %s is empty.", csFile.c_str());
+    }
+
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Program the manifest into the connected device \e pDevice. The
+ *      device is not reset.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, or the status of the step that failed with
+ *      getError() set.
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblManifest::run(SblDevice *pDevice)
+{
+    uint32_t retCode;
+    size_t i;
+
+    if(!pDevice->isConnected())
+    {
+        return error(SBL_PORT_ERROR, "Device is not connected.");
+    }
+    if((retCode = planErase(pDevice, flashBase(pDevice))) != SBL_SUCCESS || 
+       (retCode = applyPatches()) != SBL_SUCCESS)
+    {
+        return retCode;
+    }
+
+    //
+    // One erase per run of adjacent pages
+    //
+    for(i = 0; i < m_eraseRanges.size(); i++)
+    {
+        const tRange &range = m_eraseRanges[i];
+        if((retCode = pDevice->eraseFlashRange(range.ui32Start, range.ui32End - range.ui32Start)) != SBL_SUCCESS)
+        {
+            return error(retCode, "Erasing 0x%08X - 0x%08X failed. %s", range.ui32Start, range.ui32End - 1, 
+                         pDevice->getDeviceError().c_str());
+        }
+    }
+
+    for(i = 0; i < m_regions.size(); i++)
+    {
+        tSblRegion &region = m_regions[i];
+        if((retCode = pDevice->writeFlashRange(region.ui32Address, region.pvData.size(), regionData(i))) != SBL_SUCCESS)
+        {
+            return error(retCode, "Writing %s to 0x%08X failed. %s", region.csFile.c_str(), region.ui32Address, 
+                         pDevice->getDeviceError().c_str());
+        }
+    }
+
+    //
+    // Verify the images before the CCFG fields are set. They change the CCFG
+    // page, which an image may cover, so the device would no longer match
+    // the image there.
+    //
+    for(i = 0; i < m_regions.size(); i++)
+    {
+        tSblRegion &region = m_regions[i];
+        if((retCode = verifyRange(pDevice, region.ui32Address, regionData(i), region.pvData.size(), 
+                                  region.verify)) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+    }
+
+    for(i = 0; i < m_ccfgFields.size(); i++)
+    {
+        tSblCcfgField &field = m_ccfgFields[i];
+        if((retCode = pDevice->setCCFG(field.ui32Field, field.ui32Value)) != SBL_SUCCESS)
+        {
+            return error(retCode, "Setting CCFG field 0x%X to 0x%X failed.", field.ui32Field, field.ui32Value);
+        }
+    }
+
+    for(i = 0; i < m_ramPatches.size(); i++)
+    {
+        tSblRamPatch &patch = m_ramPatches[i];
+        if((retCode = pDevice->writeMemory32(patch.ui32Address, patch.pvWords.size(), &patch.pvWords[0])) != SBL_SUCCESS)
+        {
+            return error(retCode, "Writing RAM at 0x%08X failed. %s", patch.ui32Address, 
+                         pDevice->getDeviceError().c_str());
+        }
+    }
+
+    for(i = 0; i < m_ramPatches.size(); i++)
+    {
+        tSblRamPatch &patch = m_ramPatches[i];
+        std::vector<char> pvBytes(patch.pvWords.size() * 4);
+        memcpy(&pvBytes[0], &patch.pvWords[0], pvBytes.size());
+        if((retCode = verifyRange(pDevice, patch.ui32Address, &pvBytes[0], pvBytes.size(), 
+                                  (patch.verify == SBL_VERIFY_NONE) ? SBL_VERIFY_NONE : SBL_VERIFY_READBACK)) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+    }
+
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Resolve the image addresses, check that the images fit in flash
+ *      and do not overlap, and merge the pages under them into as few erase
+ *      ranges as possible.
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblManifest::planErase(SblDevice *pDevice, uint32_t ui32FlashBase)
+{
+    uint32_t ui32PageSize = pDevice->getPageSize();
+    uint32_t ui32FlashEnd = ui32FlashBase + pDevice->getFlashSize();
+    std::vector<tRange> pvPages;
+    size_t i;
+
+    m_eraseRanges.clear();
+    for(i = 0; i < m_regions.size(); i++)
+    {
+        tSblRegion &region = m_regions[i];
+        if(region.bFlashStart) region.ui32Address = ui32FlashBase;
+
+        uint32_t ui32End = region.ui32Address + region.pvData.size();
+        if(region.ui32Address < ui32FlashBase || ui32End > ui32FlashEnd || (region.ui32Address & 3))
+        {
+            return error(SBL_ARGUMENT_ERROR, "%s (0x%08X - 0x%08X) does not fit in flash or is not word aligned.", 
+                         region.csFile.c_str(), region.ui32Address, ui32End - 1);
+        }
+        for(size_t j = 0; j < i; j++)
+        {
+            uint32_t ui32OtherEnd = m_regions[j].ui32Address + m_regions[j].pvData.size();
+            if(region.ui32Address < ui32OtherEnd && m_regions[j].ui32Address < ui32End)
+            {
+                return error(SBL_ARGUMENT_ERROR, "%s overlaps %s.", region.csFile.c_str(), m_regions[j].csFile.c_str());
+            }
+        }
+
+        tRange pages;
+        pages.ui32Start = ui32FlashBase + (region.ui32Address - ui32FlashBase) / ui32PageSize * ui32PageSize;
+        pages.ui32End = ui32FlashBase + ((ui32End - ui32FlashBase) + ui32PageSize - 1) / ui32PageSize * ui32PageSize;
+        pvPages.push_back(pages);
+    }
+
+    //
+    // Sort by start and merge ranges that touch
+    //
+    for(i = 1; i < pvPages.size(); i++)
+    {
+        for(size_t j = i; j > 0 && pvPages[j].ui32Start < pvPages[j - 1].ui32Start; j--)
+        {
+            std::swap(pvPages[j], pvPages[j - 1]);
+        }
+    }
+    for(i = 0; i < pvPages.size(); i++)
+    {
+        if(!m_eraseRanges.empty() && pvPages[i].ui32Start <= m_eraseRanges.back().ui32End)
+        {
+            m_eraseRanges.back().ui32End = GTmax(m_eraseRanges.back().ui32End, pvPages[i].ui32End);
+        }
+        else
+        {
+            m_eraseRanges.push_back(pvPages[i]);
+        }
+    }
+
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Apply the patches to copies of the images they fall in. Images
+ *      without patches are not copied. Called after planErase(), which
+ *      resolves the image addresses.
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblManifest::applyPatches()
+{
+    std::vector<char> pvBytes;
+    uint32_t retCode;
+
+    m_pvPatched.assign(m_regions.size(), std::vector<char>());
+    for(size_t i = 0; i < m_patches.size(); i++)
+    {
+        const tSblPatch &patch = m_patches[i];
+        if((retCode = patchBytes(patch, pvBytes)) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+
+        size_t r = 0;
+        while(r < m_regions.size() && 
+              !(patch.ui32Address >= m_regions[r].ui32Address && 
+                patch.ui32Address + pvBytes.size() <= m_regions[r].ui32Address + m_regions[r].pvData.size()))
+        {
+            r++;
+        }
+        if(r == m_regions.size())
+        {
+            return error(SBL_ARGUMENT_ERROR, "Line %d: patch at 0x%08X (%d bytes) is not inside an image.", 
+                         patch.ui32LineNo, patch.ui32Address, (int)pvBytes.size());
+        }
+
+        if(m_pvPatched[r].empty())
+        {
+            m_pvPatched[r] = m_regions[r].pvData;
+        }
+        std::copy(pvBytes.begin(), pvBytes.end(), m_pvPatched[r].begin() + (patch.ui32Address - m_regions[r].ui32Address));
+    }
+
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Expand the variables in \e patch and convert it to bytes.
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblManifest::patchBytes(const tSblPatch &patch, std::vector<char> &pvBytes)
+{
+    std::string csData = patch.csData;
+    size_t pos;
+    uint32_t ui32Value;
+
+    while((pos = csData.find("${")) != std::string::npos)
+    {
+        size_t end = csData.find('}', pos);
+        if(end == std::string::npos)
+        {
+            return error(SBL_ARGUMENT_ERROR, "Line %d: unterminated ${ in patch.", patch.ui32LineNo);
+        }
+        std::string csName = csData.substr(pos + 2, end - pos - 2);
+        std::map<std::string, std::string>::iterator it = m_variables.find(csName);
+        if(it == m_variables.end())
+        {
+            return error(SBL_ARGUMENT_ERROR, "Line %d: variable %s is not set.", patch.ui32LineNo, csName.c_str());
+        }
+        csData.replace(pos, end - pos + 1, it->second);
+    }
+
+    pvBytes.clear();
+    if(csData.compare(0, 4, "str:") == 0)
+    {
+        pvBytes.assign(csData.begin() + 4, csData.end());
+    }
+    else if(csData.compare(0, 4, "u16:") == 0 && parseNumber(csData.substr(4), ui32Value) && ui32Value <= 0xFFFF)
+    {
+        pvBytes.push_back((char)ui32Value);
+        pvBytes.push_back((char)(ui32Value >> 8));
+    }
+    else if(csData.compare(0, 4, "u32:") == 0 && parseNumber(csData.substr(4), ui32Value))
+    {
+        for(int i = 0; i < 4; i++) pvBytes.push_back((char)(ui32Value >> (8 * i)));
+    }
+    else if(csData.compare(0, 2, "0x") == 0 && csData.size() > 2 && (csData.size() & 1) == 0 && 
+            csData.find_first_not_of("0123456789abcdefABCDEF", 2) == std::string::npos)
+    {
+        for(size_t i = 2; i < csData.size(); i += 2)
+        {
+            pvBytes.push_back((char)strtoul(csData.substr(i, 2).c_str(), NULL, 16));
+        }
+    }
+
+    if(pvBytes.empty())
+    {
+        return error(SBL_ARGUMENT_ERROR, "Line %d: invalid patch data '%s'.", patch.ui32LineNo, csData.c_str());
+    }
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Check \e ui32ByteCount bytes at \e ui32Address against \e pcData.
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblManifest::verifyRange(SblDevice *pDevice, uint32_t ui32Address, const char *pcData, uint32_t ui32ByteCount, 
+                         tSblVerify verify)
+{
+    uint32_t retCode;
+
+    if(verify == SBL_VERIFY_CRC)
+    {
+        uint32_t ui32DevCrc, ui32Crc = SblDevice::calcCrc32(pcData, ui32ByteCount);
+        if((retCode = pDevice->calculateCrc32(ui32Address, ui32ByteCount, &ui32DevCrc)) != SBL_SUCCESS)
+        {
+            return error(retCode, "CRC of 0x%08X - 0x%08X failed.", ui32Address, ui32Address + ui32ByteCount - 1);
+        }
+        if(ui32DevCrc != ui32Crc)
+        {
+            return error(SBL_ERROR, "CRC mismatch at 0x%08X. Device 0x%08X, image 0x%08X.", ui32Address, ui32DevCrc, ui32Crc);
+        }
+    }
+    else if(verify == SBL_VERIFY_READBACK)
+    {
+        std::vector<char> pvRead(ui32ByteCount);
+        if((retCode = pDevice->readMemoryRange(ui32Address, ui32ByteCount, &pvRead[0])) != SBL_SUCCESS)
+        {
+            return error(retCode, "Reading back 0x%08X - 0x%08X failed.", ui32Address, ui32Address + ui32ByteCount - 1);
+        }
+        for(uint32_t i = 0; i < ui32ByteCount; i++)
+        {
+            if(pvRead[i] != pcData[i])
+            {
+                return error(SBL_ERROR, "Read back mismatch at 0x%08X. Device 0x%02X, image 0x%02X.", 
+                             ui32Address + i, (uint8_t)pvRead[i], (uint8_t)pcData[i]);
+            }
+        }
+    }
+
+    return SBL_SUCCESS;
+}
+
+
+/// Set the error message and return \e ui32Status
+uint32_t
+SblManifest::error(uint32_t ui32Status, const char *pcFormat, ...)
+{
+    char pcBuf[512];
+    va_list args;
+
+    va_start(args, pcFormat);
+    vsnprintf(pcBuf, sizeof(pcBuf), pcFormat, args);
+    va_end(args);
+    m_csError = pcBuf;
+
+    return ui32Status;
+}
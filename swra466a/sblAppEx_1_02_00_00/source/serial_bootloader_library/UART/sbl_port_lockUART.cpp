@@ -0,0 +1,246 @@
+/******************************************************************************
+*  Filename:       sbl_port_lock.cpp
+*
+*  Description:    Serial Bootloader port lock file.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+
+#include "sbl_port_lockUART.h"
+#include "sbllibUART.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+//-----------------------------------------------------------------------------
+/** \brief Constructor
+ */
+//-----------------------------------------------------------------------------
+SblPortLock::SblPortLock()
+{
+    m_fd = -1;
+    m_owner = 0;
+    m_error = 0;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Destructor
+ */
+//-----------------------------------------------------------------------------
+SblPortLock::~SblPortLock()
+{
+    unlock();
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Get the device path of a serial port.
+ *
+ * \param[in] csPortNum
+ *      Port name, e.g. "ttyUSB0" or "/dev/serial/by-id/...".
+ *
+ * \return
+ *      Returns the path with symlinks resolved if the device exists.
+ */
+//-----------------------------------------------------------------------------
+/*static*/std::string
+SblPortLock::ttyPath(const std::string &csPortNum)
+{
+    char pcPath[PATH_MAX];
+    std::string csPath = (csPortNum.compare(0, 1, "/") == 0) ? csPortNum : "/dev/" + csPortNum;
+
+    if(realpath(csPath.c_str(), pcPath) != NULL)
+    {
+        csPath = pcPath;
+    }
+    return csPath;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Get the lock name of a serial port. Different names of the same
+ *      tty (e.g. a /dev/serial/by-id link) give the same lock name.
+ *
+ * \return
+ *      Returns the lock name, e.g. "ttyUSB0".
+ */
+//-----------------------------------------------------------------------------
+/*static*/std::string
+SblPortLock::lockName(const std::string &csPortNum)
+{
+    std::string csPath = ttyPath(csPortNum);
+    return csPath.substr(csPath.find_last_of('/') + 1);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Get the lock name of a HID bridge. The enumeration index of a
+ *      bridge changes as bridges come and go, so the bridge is named by its
+ *      serial number, which is also what the bridge is opened by.
+ *
+ * \param[in] csSerial
+ *      Serial number of the bridge, empty if unknown.
+ * \param[in] csIndex
+ *      Enumeration index, used if the serial number is unknown.
+ *
+ * \return
+ *      Returns the lock name, e.g. "hid-0001A2B3", or "hid1".
+ */
+//-----------------------------------------------------------------------------
+/*static*/std::string
+SblPortLock::hidLockName(const std::string &csSerial, const std::string &csIndex)
+{
+    if(csSerial.empty())
+    {
+        return "hid" + csIndex;
+    }
+
+    // Keep the name a plain file name
+    std::string csName = "hid-" + csSerial;
+    for(size_t i = 4; i < csName.size(); i++)
+    {
+        if(!isalnum((unsigned char)csName[i]) && csName[i] != '-' && csName[i] != '_')
+        {
+            csName[i] = '_';
+        }
+    }
+    return csName;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Claim \e csName.
+ *
+ * \param[in] csName
+ *      Lock name, see lockName().
+ *
+ * \return
+ *      Returns SBL_SUCCESS, SBL_PORT_BUSY_ERROR if another process (or
+ *      another SblPortLock in this one) holds the lock, or SBL_PORT_ERROR
+ *      if the lock file cannot be created (see getError()). The port is
+ *      not claimed then, so it must not be used.
+ */
+//-----------------------------------------------------------------------------
+int
+SblPortLock::lock(const std::string &csName)
+{
+    char pcPid[16];
+    struct stat stFd, stPath;
+
+    unlock();
+    m_owner = 0;
+    m_error = 0;
+    m_csPath = std::string(SBL_LOCK_DIR) + "/LCK.." + csName;
+
+    for(;;)
+    {
+        int fd = ::open(m_csPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if(fd < 0)
+        {
+            m_error = errno;
+            return SBL_PORT_ERROR;
+        }
+
+        if(flock(fd, LOCK_EX | LOCK_NB) != 0)
+        {
+            int n = pread(fd, pcPid, sizeof(pcPid) - 1, 0);
+            pcPid[(n > 0) ? n : 0] = '\0';
+            m_owner = atoi(pcPid);
+            if(m_owner <= 0) m_owner = -1;
+            ::close(fd);
+            return SBL_PORT_BUSY_ERROR;
+        }
+
+        //
+        // The previous owner may have unlinked the file between our open()
+        // and flock(). Holding a lock on an unlinked file claims nothing,
+        // so start over.
+        //
+        if(fstat(fd, &stFd) != 0 || stat(m_csPath.c_str(), &stPath) != 0 ||
+           stFd.st_ino != stPath.st_ino || stFd.st_dev != stPath.st_dev)
+        {
+            ::close(fd);
+            continue;
+        }
+
+        //
+        // A lock file of a tool that does not flock(). It is stale once its
+        // owner is gone.
+        //
+        int n = pread(fd, pcPid, sizeof(pcPid) - 1, 0);
+        pcPid[(n > 0) ? n : 0] = '\0';
+        int pid = atoi(pcPid);
+        if(pid > 0 && pid != getpid() && (kill(pid, 0) == 0 || errno == EPERM))
+        {
+            m_owner = pid;
+            ::close(fd);
+            return SBL_PORT_BUSY_ERROR;
+        }
+
+        snprintf(pcPid, sizeof(pcPid), "%10d\n", (int)getpid());
+        if(ftruncate(fd, 0) == 0)
+        {
+            // Without the PID the file is still flock()ed, which is what
+            // other SBL processes check
+            pwrite(fd, pcPid, strlen(pcPid), 0);
+        }
+        m_fd = fd;
+        return SBL_SUCCESS;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Release the lock, if held.
+ */
+//-----------------------------------------------------------------------------
+void
+SblPortLock::unlock()
+{
+    if(m_fd >= 0)
+    {
+        unlink(m_csPath.c_str());
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
@@ -0,0 +1,493 @@
+/******************************************************************************
+*  Filename:       sbl_port_registry.cpp
+*
+*  Description:    Serial Bootloader USB serial port registry file.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+
+#include "sbl_port_registryUART.h"
+#include "sbllibUART.h"
+
+#include <dirent.h>
+#include <limits.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+
+//-----------------------------------------------------------------------------
+/** \brief Read the first line of a sysfs attribute.
+ *
+ * \return
+ *      Returns the value, or an empty string if it cannot be read.
+ */
+//-----------------------------------------------------------------------------
+static std::string
+readSysfsAttr(const std::string &csDir, const char *pcAttr)
+{
+    char pcLine[256];
+    std::string csValue;
+    FILE *pFile = fopen((csDir + "/" + pcAttr).c_str(), "r");
+
+    if(pFile == NULL)
+    {
+        return csValue;
+    }
+    if(fgets(pcLine, sizeof(pcLine), pFile) != NULL)
+    {
+        pcLine[strcspn(pcLine, "\r\n")] = '\0';
+        csValue = pcLine;
+    }
+    fclose(pFile);
+
+    return csValue;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Constructor
+ *
+ * \param[in] csSysfsRoot
+ *      Where sysfs is mounted.
+ */
+//-----------------------------------------------------------------------------
+SblPortRegistry::SblPortRegistry(const std::string &csSysfsRoot)
+{
+    pthread_condattr_t attr;
+
+    m_csSysfsRoot = csSysfsRoot;
+    m_sock = -1;
+    m_bStarted = false;
+    m_bStop = false;
+
+    pthread_mutex_init(&m_mutex, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&m_cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Destructor
+ */
+//-----------------------------------------------------------------------------
+SblPortRegistry::~SblPortRegistry()
+{
+    stop();
+    pthread_cond_destroy(&m_cond);
+    pthread_mutex_destroy(&m_mutex);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Subscribe to kernel uevents, read the current ports from sysfs and
+ *      start the monitor thread.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, or SBL_PORT_ERROR if the netlink socket cannot
+ *      be opened. The port list is filled in either case.
+ */
+//-----------------------------------------------------------------------------
+int
+SblPortRegistry::start()
+{
+    struct sockaddr_nl addr;
+
+    if(m_bStarted)
+    {
+        return SBL_SUCCESS;
+    }
+
+    //
+    // Bind before scanning, so a port added in between is not missed
+    //
+    m_sock = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if(m_sock >= 0)
+    {
+        memset(&addr, 0, sizeof(addr));
+        addr.nl_family = AF_NETLINK;
+        addr.nl_groups = 1; // Kernel events
+        if(bind(m_sock, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+        {
+            close(m_sock);
+            m_sock = -1;
+        }
+    }
+
+    scan();
+
+    if(m_sock < 0)
+    {
+        return SBL_PORT_ERROR;
+    }
+
+    m_bStop = false;
+    if(pthread_create(&m_thread, NULL, &SblPortRegistry::monitorThread, this) != 0)
+    {
+        close(m_sock);
+        m_sock = -1;
+        return SBL_PORT_ERROR;
+    }
+    m_bStarted = true;
+
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Stop the monitor thread.
+ */
+//-----------------------------------------------------------------------------
+void
+SblPortRegistry::stop()
+{
+    if(m_bStarted)
+    {
+        m_bStop = true;
+        pthread_join(m_thread, NULL);
+        m_bStarted = false;
+    }
+    if(m_sock >= 0)
+    {
+        close(m_sock);
+        m_sock = -1;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Get the USB identity of tty \e csTty from sysfs.
+ *
+ * \param[in] csTty
+ *      tty name, e.g. "ttyUSB0".
+ * \param[out] port
+ *      Is populated with the port information.
+ *
+ * \return
+ *      Returns true if \e csTty is a USB serial port.
+ */
+//-----------------------------------------------------------------------------
+bool
+SblPortRegistry::identify(const std::string &csTty, tSblUsbPort &port)
+{
+    char pcPath[PATH_MAX];
+    std::string csDir, csChild;
+    const std::string csDevices = m_csSysfsRoot + "/devices";
+
+    if(realpath((m_csSysfsRoot + "/class/tty/" + csTty + "/device").c_str(), pcPath) == NULL)
+    {
+        return false;
+    }
+
+    //
+    // Walk up to the USB device (the first directory with an idVendor
+    // attribute). The directory below it is the interface, which names
+    // the physical port.
+    //
+    csDir = pcPath;
+    while(csDir.size() > csDevices.size() && 
+          access((csDir + "/idVendor").c_str(), F_OK) != 0)
+    {
+        csChild = csDir;
+        csDir = csDir.substr(0, csDir.rfind('/'));
+    }
+    if(csDir.size() <= csDevices.size() || csChild.empty())
+    {
+        return false;
+    }
+
+    port.csPortNum = csTty;
+    port.csUsbPath = csChild.substr(csChild.rfind('/') + 1);
+    port.csSerial = readSysfsAttr(csDir, "serial");
+    port.csDescription = readSysfsAttr(csDir, "manufacturer");
+    std::string csProduct = readSysfsAttr(csDir, "product");
+    if(!csProduct.empty())
+    {
+        port.csDescription += (port.csDescription.empty() ? "" : " ") + csProduct;
+    }
+    port.ui16Vid = (uint16_t)strtoul(readSysfsAttr(csDir, "idVendor").c_str(), NULL, 16);
+    port.ui16Pid = (uint16_t)strtoul(readSysfsAttr(csDir, "idProduct").c_str(), NULL, 16);
+
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Read all current USB serial ports from sysfs.
+ */
+//-----------------------------------------------------------------------------
+void
+SblPortRegistry::scan()
+{
+    DIR *pDir = opendir((m_csSysfsRoot + "/class/tty").c_str());
+    struct dirent *pEntry;
+    tSblUsbPort port;
+
+    if(pDir == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&m_mutex);
+    while((pEntry = readdir(pDir)) != NULL)
+    {
+        if(pEntry->d_name[0] != '.' && identify(pEntry->d_name, port))
+        {
+            m_ports[port.csPortNum] = port;
+        }
+    }
+    pthread_mutex_unlock(&m_mutex);
+    closedir(pDir);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Get a copy of the current port list, ordered by tty name.
+ *
+ * \param[out] pvPorts
+ *      Is populated with the ports.
+ */
+//-----------------------------------------------------------------------------
+void
+SblPortRegistry::getPorts(std::vector<tSblUsbPort> &pvPorts)
+{
+    pvPorts.clear();
+    pthread_mutex_lock(&m_mutex);
+    for(std::map<std::string, tSblUsbPort>::iterator it = m_ports.begin(); 
+        it != m_ports.end(); ++it)
+    {
+        pvPorts.push_back(it->second);
+    }
+    pthread_mutex_unlock(&m_mutex);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Find a port by stable identity.
+ *
+ * \param[in] csId
+ *      USB serial number or physical USB port (e.g. "1-1.2:1.0", or "1-1.2"
+ *      for interface 0). The SBL_USB_PORT_PREFIX prefix is optional.
+ * \param[out] port
+ *      Is populated with the port found.
+ *
+ * \return
+ *      Returns true if a port was found.
+ */
+//-----------------------------------------------------------------------------
+bool
+SblPortRegistry::find(const std::string &csId, tSblUsbPort &port)
+{
+    std::string csKey = csId;
+    bool bFound = false;
+
+    if(csKey.compare(0, strlen(SBL_USB_PORT_PREFIX), SBL_USB_PORT_PREFIX) == 0)
+    {
+        csKey = csKey.substr(strlen(SBL_USB_PORT_PREFIX));
+    }
+
+    pthread_mutex_lock(&m_mutex);
+    for(std::map<std::string, tSblUsbPort>::iterator it = m_ports.begin(); 
+        it != m_ports.end() && !bFound; ++it)
+    {
+        if((!it->second.csSerial.empty() && it->second.csSerial == csKey) ||
+           it->second.csUsbPath == csKey || it->second.csUsbPath == csKey + ":1.0")
+        {
+            port = it->second;
+            bFound = true;
+        }
+    }
+    pthread_mutex_unlock(&m_mutex);
+
+    return bFound;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Wait for a USB serial port to be plugged in.
+ *
+ * \param[out] port
+ *      Is populated with the next port added since start().
+ * \param[in] timeoutMs
+ *      How long to wait. A negative value waits forever.
+ *
+ * \return
+ *      Returns true if a port was added, false on timeout.
+ */
+//-----------------------------------------------------------------------------
+bool
+SblPortRegistry::waitForPort(tSblUsbPort &port, int timeoutMs)
+{
+    struct timespec ts;
+    bool bFound = false;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    if(timeoutMs >= 0)
+    {
+        ts.tv_sec += timeoutMs / 1000;
+        ts.tv_nsec += (timeoutMs % 1000) * 1000000L;
+        if(ts.tv_nsec >= 1000000000L)
+        {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+    }
+
+    pthread_mutex_lock(&m_mutex);
+    while(m_added.empty() && m_bStarted)
+    {
+        int ret = (timeoutMs < 0) ? pthread_cond_wait(&m_cond, &m_mutex) :
+                                    pthread_cond_timedwait(&m_cond, &m_mutex, &ts);
+        if(ret != 0)
+        {
+            break;
+        }
+    }
+    if(!m_added.empty())
+    {
+        port = m_added.front();
+        m_added.pop_front();
+        bFound = true;
+    }
+    pthread_mutex_unlock(&m_mutex);
+
+    return bFound;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Update the port list from a kernel uevent.
+ *
+ * \param[in] pcMsg
+ *      uevent message: "<action>@<devpath>" followed by NUL separated
+ *      KEY=value strings.
+ * \param[in] length
+ *      Message length.
+ */
+//-----------------------------------------------------------------------------
+void
+SblPortRegistry::handleUevent(const char *pcMsg, int length)
+{
+    std::string csAction, csSubsystem, csDevName;
+    tSblUsbPort port;
+
+    for(int i = 0; i < length; i += strnlen(pcMsg + i, length - i) + 1)
+    {
+        const char *pcKey = pcMsg + i;
+        if(strncmp(pcKey, "ACTION=", 7) == 0)         csAction = pcKey + 7;
+        else if(strncmp(pcKey, "SUBSYSTEM=", 10) == 0) csSubsystem = pcKey + 10;
+        else if(strncmp(pcKey, "DEVNAME=", 8) == 0)   csDevName = pcKey + 8;
+    }
+    if(csSubsystem != "tty" || csDevName.empty())
+    {
+        return;
+    }
+    if(csDevName.compare(0, 5, "/dev/") == 0)
+    {
+        csDevName = csDevName.substr(5);
+    }
+
+    if(csAction == "add" && identify(csDevName, port))
+    {
+        pthread_mutex_lock(&m_mutex);
+        m_ports[csDevName] = port;
+        m_added.push_back(port);
+        pthread_cond_broadcast(&m_cond);
+        pthread_mutex_unlock(&m_mutex);
+    }
+    else if(csAction == "remove")
+    {
+        pthread_mutex_lock(&m_mutex);
+        m_ports.erase(csDevName);
+        for(std::deque<tSblUsbPort>::iterator it = m_added.begin(); it != m_added.end(); )
+        {
+            it = (it->csPortNum == csDevName) ? m_added.erase(it) : it + 1;
+        }
+        pthread_mutex_unlock(&m_mutex);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Monitor thread. Reads kernel uevents until stop() is called.
+ *
+ * \param[in] pArg
+ *      Pointer to the SblPortRegistry.
+ *
+ * \return
+ *      NULL
+ */
+//-----------------------------------------------------------------------------
+/*static*/void *
+SblPortRegistry::monitorThread(void *pArg)
+{
+    SblPortRegistry *pThis = (SblPortRegistry *)pArg;
+    char pcBuf[8192];
+
+    while(!pThis->m_bStop)
+    {
+        struct pollfd pfd = { pThis->m_sock, POLLIN, 0 };
+        struct sockaddr_nl addr;
+        struct iovec iov = { pcBuf, sizeof(pcBuf) - 1 };
+        struct msghdr msg;
+
+        if(poll(&pfd, 1, 200) <= 0)
+        {
+            continue;
+        }
+
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &addr;
+        msg.msg_namelen = sizeof(addr);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        int ret = recvmsg(pThis->m_sock, &msg, 0);
+
+        //
+        // Only messages from the kernel are trusted
+        //
+        if(ret > 0 && addr.nl_pid == 0)
+        {
+            pcBuf[ret] = '\0';
+            pThis->handleUevent(pcBuf, ret);
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,314 @@
+/******************************************************************************
+*  Filename:       sbl_read_cache.cpp
+*
+*  Description:    Serial Bootloader batched memory read file.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+
+
+#include "sbl_read_cacheUART.h"
+#include "sbllibUART.h"
+
+#include <algorithm>
+#include <string.h>
+
+
+/// Order read requests by address
+static bool
+rangeBefore(const tSblReadRequest &a, const tSblReadRequest &b)
+{
+    return a.ui32Address < b.ui32Address;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Constructor
+ *
+ * \param[in] pDevice
+ *      Connected device to read from.
+ */
+//-----------------------------------------------------------------------------
+SblReadCache::SblReadCache(SblDevice *pDevice)
+{
+    m_pDevice = pDevice;
+    m_ui32DeviceReads = 0;
+    m_ui32CacheHits = 0;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Read a batch of memory ranges.
+ *
+ * \param[in|out] pvRequests
+ *      The ranges to read. The data of each is stored at its \e pcData.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, or the status of the read that failed.
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblReadCache::read(std::vector<tSblReadRequest> &pvRequests)
+{
+    uint32_t retCode;
+    uint32_t ui32BlockSize = blockSize();
+    std::vector<uint32_t> pvMissing;
+
+    //
+    // Collect the blocks not cached yet
+    //
+    for(size_t i = 0; i < pvRequests.size(); i++)
+    {
+        const tSblReadRequest &request = pvRequests[i];
+        if(request.ui32ByteCount == 0 || isRegister(request))
+        {
+            continue;
+        }
+
+        bool bHit = true;
+        uint32_t ui32End = request.ui32Address + request.ui32ByteCount;
+        for(uint32_t block = request.ui32Address & ~(ui32BlockSize - 1); block < ui32End; block += ui32BlockSize)
+        {
+            if(m_blocks.find(block) == m_blocks.end())
+            {
+                pvMissing.push_back(block);
+                bHit = false;
+            }
+        }
+        if(bHit)
+        {
+            m_ui32CacheHits++;
+        }
+    }
+    std::sort(pvMissing.begin(), pvMissing.end());
+    pvMissing.erase(std::unique(pvMissing.begin(), pvMissing.end()), pvMissing.end());
+
+    //
+    // Read each run of adjacent missing blocks at once
+    //
+    for(size_t i = 0; i < pvMissing.size(); )
+    {
+        size_t j = i + 1;
+        while(j < pvMissing.size() && pvMissing[j] == pvMissing[j - 1] + ui32BlockSize)
+        {
+            j++;
+        }
+        if((retCode = readBlocks(pvMissing[i], pvMissing[j - 1] + ui32BlockSize)) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+        i = j;
+    }
+
+    if((retCode = readRegisters(pvRequests)) != SBL_SUCCESS)
+    {
+        return retCode;
+    }
+
+    for(size_t i = 0; i < pvRequests.size(); i++)
+    {
+        if(pvRequests[i].ui32ByteCount && !isRegister(pvRequests[i]))
+        {
+            copyFromBlocks(pvRequests[i]);
+        }
+    }
+
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Read one memory range through the cache.
+ *
+ * \param[in] ui32Address
+ *      Start address in device.
+ * \param[in] ui32ByteCount
+ *      Number of bytes to read.
+ * \param[out] pcData
+ *      Pointer to where read data is stored.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, ...
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblReadCache::read(uint32_t ui32Address, uint32_t ui32ByteCount, char *pcData)
+{
+    std::vector<tSblReadRequest> pvRequests(1);
+    pvRequests[0].ui32Address = ui32Address;
+    pvRequests[0].ui32ByteCount = ui32ByteCount;
+    pvRequests[0].pcData = pcData;
+
+    return read(pvRequests);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Does \e request touch a register region (peripherals or the
+ *      private peripheral bus)?
+ */
+//-----------------------------------------------------------------------------
+/*static*/bool
+SblReadCache::isRegister(const tSblReadRequest &request)
+{
+    static const uint32_t pui32Regions[][2] = {
+        { 0x40000000, 0x4FFFFFFF },     // Peripherals
+        { 0xE0000000, 0xE00FFFFF },     // Private peripheral bus
+    };
+    uint32_t ui32Last = request.ui32Address + request.ui32ByteCount - 1;
+
+    for(size_t i = 0; i < sizeof(pui32Regions) / sizeof(pui32Regions[0]); i++)
+    {
+        if(request.ui32Address <= pui32Regions[i][1] && ui32Last >= pui32Regions[i][0])
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Cache block size: the largest power of two one read command can
+ *      return (128 B on CC26xx, a word on CC2538). Memory regions start and
+ *      end on such a boundary, so a block never reaches past one.
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblReadCache::blockSize()
+{
+    uint32_t ui32BlockSize = 4;
+    while(ui32BlockSize * 2 <= m_pDevice->getMaxReadBytes())
+    {
+        ui32BlockSize *= 2;
+    }
+    return ui32BlockSize;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Read the blocks from \e ui32Start to \e ui32End into the cache.
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblReadCache::readBlocks(uint32_t ui32Start, uint32_t ui32End)
+{
+    uint32_t retCode;
+    uint32_t ui32BlockSize = blockSize();
+    std::vector<char> pvData(ui32End - ui32Start);
+
+    m_ui32DeviceReads++;
+    if((retCode = m_pDevice->readMemoryRange(ui32Start, ui32End - ui32Start, &pvData[0])) != SBL_SUCCESS)
+    {
+        return retCode;
+    }
+    for(uint32_t block = ui32Start; block < ui32End; block += ui32BlockSize)
+    {
+        m_blocks[block].assign(pvData.begin() + (block - ui32Start), pvData.begin() + (block - ui32Start + ui32BlockSize));
+    }
+
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Read the register requests of \e pvRequests, merging the ones that
+ *      overlap or touch. Registers are read exactly as asked, and each
+ *      merged range once.
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+SblReadCache::readRegisters(std::vector<tSblReadRequest> &pvRequests)
+{
+    uint32_t retCode;
+    std::vector<tSblReadRequest> pvRegisters;
+
+    for(size_t i = 0; i < pvRequests.size(); i++)
+    {
+        if(pvRequests[i].ui32ByteCount && isRegister(pvRequests[i]))
+        {
+            pvRegisters.push_back(pvRequests[i]);
+        }
+    }
+    std::sort(pvRegisters.begin(), pvRegisters.end(), rangeBefore);
+
+    for(size_t i = 0; i < pvRegisters.size(); )
+    {
+        tRange range;
+        range.ui32Start = pvRegisters[i].ui32Address;
+        range.ui32End = range.ui32Start + pvRegisters[i].ui32ByteCount;
+
+        size_t j = i + 1;
+        while(j < pvRegisters.size() && pvRegisters[j].ui32Address <= range.ui32End)
+        {
+            range.ui32End = GTmax(range.ui32End, pvRegisters[j].ui32Address + pvRegisters[j].ui32ByteCount);
+            j++;
+        }
+
+        std::vector<char> pvData(range.ui32End - range.ui32Start);
+        m_ui32DeviceReads++;
+        if((retCode = m_pDevice->readMemoryRange(range.ui32Start, pvData.size(), &pvData[0])) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+        for(; i < j; i++)
+        {
+            memcpy(pvRegisters[i].pcData, &pvData[pvRegisters[i].ui32Address - range.ui32Start], 
+                   pvRegisters[i].ui32ByteCount);
+        }
+    }
+
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Copy the data of \e request from the cached blocks.
+ */
+//-----------------------------------------------------------------------------
+void
+SblReadCache::copyFromBlocks(const tSblReadRequest &request)
+{
+    uint32_t ui32BlockSize = blockSize();
+    uint32_t ui32Done = 0;
+
+    while(ui32Done < request.ui32ByteCount)
+    {
+        uint32_t ui32Address = request.ui32Address + ui32Done;
+        uint32_t ui32Offset = ui32Address & (ui32BlockSize - 1);
+        uint32_t ui32Bytes = GTmin(ui32BlockSize - ui32Offset, request.ui32ByteCount - ui32Done);
+        const std::vector<char> &block = m_blocks[ui32Address - ui32Offset];
+
+        memcpy(request.pcData + ui32Done, &block[ui32Offset], ui32Bytes);
+        ui32Done += ui32Bytes;
+    }
+}
@@ -0,0 +1,661 @@
+/******************************************************************************
+*  Filename:       sbl_tcp_port.cpp
+*
+*  Description:    Serial Bootloader TCP / RFC 2217 remote serial port file.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+
+#include "sbl_tcp_portUART.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+//
+// Telnet (RFC 854) and COM-PORT-OPTION (RFC 2217) codes
+//
+enum
+{
+    TELNET_SE               = 240,
+    TELNET_SB               = 250,
+    TELNET_WILL             = 251,
+    TELNET_WONT             = 252,
+    TELNET_DO               = 253,
+    TELNET_DONT             = 254,
+    TELNET_IAC              = 255,
+
+    TELOPT_BINARY           = 0,
+    TELOPT_SGA              = 3,
+    TELOPT_COM_PORT         = 44,
+
+    CPO_SET_BAUDRATE        = 1,
+    CPO_SET_DATASIZE        = 2,
+    CPO_SET_PARITY          = 3,
+    CPO_SET_STOPSIZE        = 4,
+    CPO_SET_CONTROL         = 5,
+    CPO_PURGE_DATA          = 12,
+
+    CPO_PARITY_NONE         = 1,
+    CPO_STOPSIZE_1          = 1,
+    CPO_CONTROL_NO_FLOW     = 1,
+    CPO_PURGE_BOTH          = 3,
+};
+
+
+//-----------------------------------------------------------------------------
+/** \brief Constructor
+ */
+//-----------------------------------------------------------------------------
+SblTcpPort::SblTcpPort()
+{
+    m_sock = -1;
+    m_bRfc2217 = false;
+    m_telnetState = TELNET_STATE_DATA;
+    m_ui8TelnetVerb = 0;
+    m_baudRate = 0;
+    m_rdTimeoutMs = 100;
+    m_wrTimeoutMs = 200;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Destructor
+ */
+//-----------------------------------------------------------------------------
+SblTcpPort::~SblTcpPort()
+{
+    close();
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Check if \e csPortNumber names a remote port.
+ *
+ * \param[in] csPortNumber
+ *      Port name.
+ *
+ * \return
+ *      Returns true for "tcp://..." and "rfc2217://..." names.
+ */
+//-----------------------------------------------------------------------------
+/*static*/bool
+SblTcpPort::isTcpPort(const std::string &csPortNumber)
+{
+    return (csPortNumber.compare(0, strlen(SBL_TCP_PORT_PREFIX), SBL_TCP_PORT_PREFIX) == 0 ||
+            csPortNumber.compare(0, strlen(SBL_RFC2217_PORT_PREFIX), SBL_RFC2217_PORT_PREFIX) == 0);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Connect to the server in \e csPortNumber. For RFC 2217 servers the
+ *      line is set to \e baudRate, 8N1, no flow control.
+ *
+ * \param[in] csPortNumber
+ *      "tcp://<host>:<port>" or "rfc2217://<host>:<port>". IPv6 addresses
+ *      are given in brackets.
+ * \param[in] baudRate
+ *      UART baud rate (RFC 2217 only).
+ * \param[in] rdTimeoutMs
+ *      How long readBytes() waits for data.
+ * \param[in] wrTimeoutMs
+ *      How long a write may block.
+ * \param[in] flags
+ *      Not used.
+ *
+ * \return
+ *      Returns ComPort::COMPORT_SUCCESS or ComPort::COMPORT_ERROR.
+ */
+//-----------------------------------------------------------------------------
+int
+SblTcpPort::open(std::string csPortNumber, int baudRate, int rdTimeoutMs, 
+                 int wrTimeoutMs, int /*flags*/)
+{
+    std::string csAddress, csHost, csService;
+    size_t colon;
+
+    close();
+
+    m_bRfc2217 = (csPortNumber.compare(0, strlen(SBL_RFC2217_PORT_PREFIX), SBL_RFC2217_PORT_PREFIX) == 0);
+    csAddress = csPortNumber.substr(csPortNumber.find("://") + 3);
+
+    //
+    // Split "<host>:<port>", the port is required
+    //
+    colon = csAddress.rfind(':');
+    if(colon == std::string::npos || colon + 1 >= csAddress.size())
+    {
+        return ComPort::COMPORT_ERROR;
+    }
+    csHost = csAddress.substr(0, colon);
+    csService = csAddress.substr(colon + 1);
+    if(csHost.size() >= 2 && csHost[0] == '[' && csHost[csHost.size() - 1] == ']')
+    {
+        csHost = csHost.substr(1, csHost.size() - 2);
+    }
+
+    if(connectTo(csHost, csService) != ComPort::COMPORT_SUCCESS)
+    {
+        return ComPort::COMPORT_ERROR;
+    }
+
+    int sock = m_sock;
+    m_sock = -1;
+    return attach(sock, m_bRfc2217, baudRate, rdTimeoutMs, wrTimeoutMs);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Use the connected stream socket \e sock, for example a tunnel
+ *      set up by the caller or one end of a socketpair(). For RFC 2217 the
+ *      line is set to \e baudRate, 8N1, no flow control. The port owns the
+ *      socket from then on, also if this fails.
+ *
+ * \param[in] sock
+ *      Connected socket.
+ * \param[in] bRfc2217
+ *      Whether the peer speaks RFC 2217.
+ * \param[in] baudRate
+ *      UART baud rate (RFC 2217 only).
+ * \param[in] rdTimeoutMs
+ *      How long readBytes() waits for data.
+ * \param[in] wrTimeoutMs
+ *      How long a write may block.
+ *
+ * \return
+ *      Returns ComPort::COMPORT_SUCCESS or ComPort::COMPORT_ERROR.
+ */
+//-----------------------------------------------------------------------------
+int
+SblTcpPort::attach(int sock, bool bRfc2217, int baudRate, int rdTimeoutMs, int wrTimeoutMs)
+{
+    close();
+
+    m_sock = sock;
+    m_bRfc2217 = bRfc2217;
+    fcntl(m_sock, F_SETFL, fcntl(m_sock, F_GETFL) | O_NONBLOCK);
+    m_rdTimeoutMs = rdTimeoutMs;
+    m_wrTimeoutMs = wrTimeoutMs;
+    m_baudRate = baudRate;
+    m_telnetState = TELNET_STATE_DATA;
+    m_pvTx.clear();
+
+    if(m_bRfc2217)
+    {
+        const char pcNegotiate[] = {
+            (char)TELNET_IAC, (char)TELNET_WILL, (char)TELOPT_COM_PORT,
+            (char)TELNET_IAC, (char)TELNET_WILL, (char)TELOPT_BINARY,
+            (char)TELNET_IAC, (char)TELNET_DO,   (char)TELOPT_BINARY,
+            (char)TELNET_IAC, (char)TELNET_WILL, (char)TELOPT_SGA,
+            (char)TELNET_IAC, (char)TELNET_DO,   (char)TELOPT_SGA,
+        };
+        uint8_t pui8Baud[4] = { (uint8_t)(baudRate >> 24), (uint8_t)(baudRate >> 16), 
+                                (uint8_t)(baudRate >> 8), (uint8_t)baudRate };
+        uint8_t ui8DataSize = 8;
+        uint8_t ui8Parity = CPO_PARITY_NONE;
+        uint8_t ui8StopSize = CPO_STOPSIZE_1;
+        uint8_t ui8Control = CPO_CONTROL_NO_FLOW;
+
+        m_pvTx.insert(m_pvTx.end(), pcNegotiate, pcNegotiate + sizeof(pcNegotiate));
+        sendComPortOption(CPO_SET_BAUDRATE, pui8Baud, sizeof(pui8Baud));
+        sendComPortOption(CPO_SET_DATASIZE, &ui8DataSize, 1);
+        sendComPortOption(CPO_SET_PARITY, &ui8Parity, 1);
+        sendComPortOption(CPO_SET_STOPSIZE, &ui8StopSize, 1);
+        sendComPortOption(CPO_SET_CONTROL, &ui8Control, 1);
+        if(flushTx() < 0)
+        {
+            close();
+            return ComPort::COMPORT_ERROR;
+        }
+    }
+
+    return ComPort::COMPORT_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Open a non-blocking TCP connection to \e csHost:\e csService with
+ *      Nagle disabled.
+ *
+ * \return
+ *      Returns ComPort::COMPORT_SUCCESS or ComPort::COMPORT_ERROR.
+ */
+//-----------------------------------------------------------------------------
+int
+SblTcpPort::connectTo(const std::string &csHost, const std::string &csService)
+{
+    struct addrinfo hints, *pResult, *pAddr;
+    int one = 1;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if(getaddrinfo(csHost.c_str(), csService.c_str(), &hints, &pResult) != 0)
+    {
+        return ComPort::COMPORT_ERROR;
+    }
+
+    for(pAddr = pResult; pAddr != NULL && m_sock < 0; pAddr = pAddr->ai_next)
+    {
+        int sock = socket(pAddr->ai_family, pAddr->ai_socktype, pAddr->ai_protocol);
+        if(sock < 0)
+        {
+            continue;
+        }
+        fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        if(connect(sock, pAddr->ai_addr, pAddr->ai_addrlen) != 0)
+        {
+            int err = 0;
+            socklen_t len = sizeof(err);
+            struct pollfd pfd = { sock, POLLOUT, 0 };
+
+            if(errno != EINPROGRESS || poll(&pfd, 1, TCP_CONNECT_TIMEOUT_MS) != 1 ||
+               getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0)
+            {
+                ::close(sock);
+                continue;
+            }
+        }
+        m_sock = sock;
+    }
+    freeaddrinfo(pResult);
+
+    return (m_sock >= 0) ? ComPort::COMPORT_SUCCESS : ComPort::COMPORT_ERROR;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Send queued bytes and close the connection.
+ *
+ * \return
+ *      Returns ComPort::COMPORT_SUCCESS.
+ */
+//-----------------------------------------------------------------------------
+int
+SblTcpPort::close()
+{
+    if(m_sock >= 0)
+    {
+        flushTx();
+        ::close(m_sock);
+        m_sock = -1;
+    }
+    return ComPort::COMPORT_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Wait for \e events on the socket.
+ *
+ * \return
+ *      Returns 1 if ready, 0 on timeout or -1 on error or hang up.
+ */
+//-----------------------------------------------------------------------------
+int
+SblTcpPort::waitSocket(short events, int timeoutMs)
+{
+    struct pollfd pfd = { m_sock, events, 0 };
+    int ret;
+
+    do
+    {
+        ret = poll(&pfd, 1, timeoutMs);
+    }
+    while(ret < 0 && errno == EINTR);
+
+    if(ret > 0 && (pfd.revents & (POLLERR | POLLNVAL)))
+    {
+        return -1;
+    }
+    return ret;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Read up to \e length bytes. Queued writes are sent first, as the
+ *      data waited for is usually the answer to them.
+ *
+ * \param[out] pData
+ *      Pointer to where the data is stored.
+ * \param[in] length
+ *      Max number of bytes to read.
+ *
+ * \return
+ *      Returns the number of bytes read (0 on timeout) or -1 on error.
+ */
+//-----------------------------------------------------------------------------
+int
+SblTcpPort::readBytes(void *pData, int length)
+{
+    struct timespec tsStart, tsNow;
+    int waitMs = m_rdTimeoutMs;
+
+    if(m_sock < 0 || flushTx() < 0)
+    {
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &tsStart);
+    for(;;)
+    {
+        int ret = waitSocket(POLLIN, waitMs);
+        if(ret <= 0)
+        {
+            return ret;
+        }
+
+        ret = recv(m_sock, pData, length, 0);
+        if(ret == 0)
+        {
+            // Server closed the connection
+            return -1;
+        }
+        if(ret < 0)
+        {
+            if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) return -1;
+            ret = 0;
+        }
+
+        if(m_bRfc2217)
+        {
+            ret = parseTelnet((char *)pData, ret);
+        }
+        if(ret > 0)
+        {
+            return ret;
+        }
+
+        //
+        // Only telnet commands were received, keep waiting for data
+        //
+        clock_gettime(CLOCK_MONOTONIC, &tsNow);
+        waitMs = m_rdTimeoutMs - (int)((tsNow.tv_sec - tsStart.tv_sec) * 1000 + 
+                                       (tsNow.tv_nsec - tsStart.tv_nsec) / 1000000);
+        if(waitMs <= 0)
+        {
+            return 0;
+        }
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Queue \e length bytes for sending. The data goes out at the next
+ *      readBytes(), flushBuffers() or flushTx(), or as soon as a full batch
+ *      is queued.
+ *
+ * \param[in] pData
+ *      Pointer to the data.
+ * \param[in] length
+ *      Number of bytes.
+ *
+ * \return
+ *      Returns \e length or -1 on error.
+ */
+//-----------------------------------------------------------------------------
+int
+SblTcpPort::writeBytes(void *pData, int length)
+{
+    const char *pcData = (const char *)pData;
+
+    if(m_sock < 0)
+    {
+        return -1;
+    }
+
+    if(m_bRfc2217)
+    {
+        //
+        // Data bytes equal to IAC are doubled
+        //
+        for(int i = 0; i < length; i++)
+        {
+            m_pvTx.push_back(pcData[i]);
+            if((uint8_t)pcData[i] == TELNET_IAC) m_pvTx.push_back(pcData[i]);
+        }
+    }
+    else
+    {
+        m_pvTx.insert(m_pvTx.end(), pcData, pcData + length);
+    }
+
+    if(m_pvTx.size() >= TCP_TX_BATCH_SIZE && flushTx() < 0)
+    {
+        return -1;
+    }
+
+    return length;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Send all queued bytes.
+ *
+ * \return
+ *      Returns the number of bytes sent or -1 on error.
+ */
+//-----------------------------------------------------------------------------
+int
+SblTcpPort::flushTx()
+{
+    uint32_t ui32Sent = 0;
+
+    while(ui32Sent < m_pvTx.size())
+    {
+        int ret = send(m_sock, &m_pvTx[ui32Sent], m_pvTx.size() - ui32Sent, MSG_NOSIGNAL);
+        if(ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        {
+            if(waitSocket(POLLOUT, m_wrTimeoutMs) > 0) continue;
+        }
+        if(ret <= 0)
+        {
+            m_pvTx.clear();
+            return -1;
+        }
+        ui32Sent += ret;
+    }
+    m_pvTx.clear();
+
+    return ui32Sent;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Send queued bytes, then drop all received data. RFC 2217 servers
+ *      are also told to purge their serial buffers.
+ *
+ * \return
+ *      Returns ComPort::COMPORT_SUCCESS or ComPort::COMPORT_ERROR.
+ */
+//-----------------------------------------------------------------------------
+int
+SblTcpPort::flushBuffers()
+{
+    char pcBuf[512];
+
+    if(m_sock < 0)
+    {
+        return ComPort::COMPORT_ERROR;
+    }
+
+    if(m_bRfc2217)
+    {
+        uint8_t ui8Purge = CPO_PURGE_BOTH;
+        sendComPortOption(CPO_PURGE_DATA, &ui8Purge, 1);
+    }
+    if(flushTx() < 0)
+    {
+        return ComPort::COMPORT_ERROR;
+    }
+
+    //
+    // Drain the socket. Telnet commands still go through the parser so its
+    // state stays in sync with the stream.
+    //
+    for(;;)
+    {
+        int ret = recv(m_sock, pcBuf, sizeof(pcBuf), MSG_DONTWAIT);
+        if(ret <= 0)
+        {
+            break;
+        }
+        if(m_bRfc2217)
+        {
+            parseTelnet(pcBuf, ret);
+        }
+    }
+
+    return ComPort::COMPORT_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Queue an RFC 2217 COM-PORT-OPTION subnegotiation.
+ *
+ * \param[in] ui8Cmd
+ *      Client to server command code.
+ * \param[in] pui8Value
+ *      Command value.
+ * \param[in] ui32Len
+ *      Length of the value.
+ *
+ * \return
+ *      Returns 0.
+ */
+//-----------------------------------------------------------------------------
+int
+SblTcpPort::sendComPortOption(uint8_t ui8Cmd, const uint8_t *pui8Value, uint32_t ui32Len)
+{
+    m_pvTx.push_back((char)TELNET_IAC);
+    m_pvTx.push_back((char)TELNET_SB);
+    m_pvTx.push_back((char)TELOPT_COM_PORT);
+    m_pvTx.push_back((char)ui8Cmd);
+    for(uint32_t i = 0; i < ui32Len; i++)
+    {
+        m_pvTx.push_back((char)pui8Value[i]);
+        if(pui8Value[i] == TELNET_IAC) m_pvTx.push_back((char)TELNET_IAC);
+    }
+    m_pvTx.push_back((char)TELNET_IAC);
+    m_pvTx.push_back((char)TELNET_SE);
+
+    return 0;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Remove telnet commands from received data, in place. Options
+ *      the server offers or asks for, other than the ones requested in
+ *      open(), are refused. Server notifications are ignored.
+ *
+ * \param[in|out] pcData
+ *      Received bytes. Is populated with the UART data.
+ * \param[in] length
+ *      Number of bytes received.
+ *
+ * \return
+ *      Returns the number of UART data bytes left in \e pcData.
+ */
+//-----------------------------------------------------------------------------
+int
+SblTcpPort::parseTelnet(char *pcData, int length)
+{
+    int out = 0;
+
+    for(int i = 0; i < length; i++)
+    {
+        uint8_t c = (uint8_t)pcData[i];
+
+        switch(m_telnetState)
+        {
+        case TELNET_STATE_DATA:
+            if(c == TELNET_IAC) m_telnetState = TELNET_STATE_IAC;
+            else pcData[out++] = (char)c;
+            break;
+
+        case TELNET_STATE_IAC:
+            m_telnetState = TELNET_STATE_DATA;
+            if(c == TELNET_IAC)
+            {
+                pcData[out++] = (char)c;
+            }
+            else if(c >= TELNET_WILL && c <= TELNET_DONT)
+            {
+                m_ui8TelnetVerb = c;
+                m_telnetState = TELNET_STATE_OPTION;
+            }
+            else if(c == TELNET_SB)
+            {
+                m_telnetState = TELNET_STATE_SB;
+            }
+            break;
+
+        case TELNET_STATE_OPTION:
+            m_telnetState = TELNET_STATE_DATA;
+            if(c != TELOPT_BINARY && c != TELOPT_SGA && c != TELOPT_COM_PORT)
+            {
+                if(m_ui8TelnetVerb == TELNET_DO)
+                {
+                    m_pvTx.push_back((char)TELNET_IAC);
+                    m_pvTx.push_back((char)TELNET_WONT);
+                    m_pvTx.push_back((char)c);
+                }
+                else if(m_ui8TelnetVerb == TELNET_WILL)
+                {
+                    m_pvTx.push_back((char)TELNET_IAC);
+                    m_pvTx.push_back((char)TELNET_DONT);
+                    m_pvTx.push_back((char)c);
+                }
+            }
+            break;
+
+        case TELNET_STATE_SB:
+            if(c == TELNET_IAC) m_telnetState = TELNET_STATE_SB_IAC;
+            break;
+
+        case TELNET_STATE_SB_IAC:
+            m_telnetState = (c == TELNET_SE) ? TELNET_STATE_DATA : TELNET_STATE_SB;
+            break;
+        }
+    }
+
+    return out;
+}
@@ -0,0 +1,413 @@
+/******************************************************************************
+*  Filename:       sbl_transport.cpp
+*
+*  Description:    Serial Bootloader transport (UART or USB HID) file.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+
+#include "sbl_transportUART.h"
+#include "sbl_ttyUART.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+
+//-----------------------------------------------------------------------------
+/** \brief Constructor
+ */
+//-----------------------------------------------------------------------------
+SblTransport::SblTransport()
+{
+    m_type = TRANSPORT_UART;
+    m_exclFd = -1;
+    m_busyOwner = 0;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Destructor
+ */
+//-----------------------------------------------------------------------------
+SblTransport::~SblTransport()
+{
+    close();
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Get the transport of a port name.
+ *
+ * \param[in] csPortNumber
+ *      Port name, e.g. "ttyUSB0", "hid:0" or "rfc2217://fixture3:4001".
+ *
+ * \return
+ *      Returns TRANSPORT_HID for names starting with SBL_HID_PORT_PREFIX,
+ *      TRANSPORT_TCP for remote ports, else TRANSPORT_UART.
+ */
+//-----------------------------------------------------------------------------
+/*static*/SblTransport::tType
+SblTransport::portType(const std::string &csPortNumber)
+{
+    if(csPortNumber.compare(0, strlen(SBL_HID_PORT_PREFIX), SBL_HID_PORT_PREFIX) == 0)
+    {
+        return TRANSPORT_HID;
+    }
+    if(SblTcpPort::isTcpPort(csPortNumber))
+    {
+        return TRANSPORT_TCP;
+    }
+    return TRANSPORT_UART;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Enumerate the ports of the transports in \e ui32TransportMask.
+ *      Serial ports are listed first, so their indexes do not depend on
+ *      whether HID bridges are plugged in. HID ports get the
+ *      SBL_HID_PORT_PREFIX prefix. Remote ports cannot be enumerated.
+ *
+ * \param[out] pComPortList
+ *      Set to point to the list of ports. Valid until the next call.
+ * \param[in|out] numElements
+ *      Maximum number of ports to list. Is populated with the number of
+ *      ports found.
+ * \param[in] ui32TransportMask (optional)
+ *      Transports to enumerate.
+ *
+ * \return
+ *      Returns ComPort::COMPORT_SUCCESS if any transport could enumerate.
+ */
+//-----------------------------------------------------------------------------
+int
+SblTransport::enumerate(ComPortElement*& pComPortList, int& numElements, 
+                        uint32_t ui32TransportMask/* = SBL_TRANSPORT_ALL*/)
+{
+    int maxElements = numElements;
+    bool bSuccess = false;
+    m_pvList.clear();
+
+    if(ui32TransportMask & TRANSPORT_UART)
+    {
+        ComPortElement *pList = NULL;
+        int num = maxElements;
+        if(m_uart.enumerate(pList, num) == ComPort::COMPORT_SUCCESS)
+        {
+            m_pvList.insert(m_pvList.end(), pList, pList + num);
+            bSuccess = true;
+        }
+    }
+
+    if((ui32TransportMask & TRANSPORT_HID) && (int)m_pvList.size() < maxElements)
+    {
+        ComPortElement *pList = NULL;
+        int num = maxElements - m_pvList.size();
+        if(m_hid.enumerate(pList, num) == ComPort::COMPORT_SUCCESS)
+        {
+            for(int i = 0; i < num; i++)
+            {
+                ComPortElement element = pList[i];
+                snprintf(element.portNumber, sizeof(element.portNumber), "%s%s", 
+                         SBL_HID_PORT_PREFIX, pList[i].portNumber);
+                m_pvList.push_back(element);
+            }
+            bSuccess = true;
+        }
+    }
+
+    numElements = m_pvList.size();
+    pComPortList = (numElements) ? &m_pvList[0] : NULL;
+    return (bSuccess) ? ComPort::COMPORT_SUCCESS : ComPort::COMPORT_ERROR;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Open \e csPortNumber on the transport its name selects. Any port
+ *      open on another transport is closed first.
+ *
+ * \return
+ *      Returns ComPort::COMPORT_SUCCESS or ComPort::COMPORT_ERROR.
+ */
+//-----------------------------------------------------------------------------
+int
+SblTransport::open(std::string csPortNumber, int baudRate, int rdTimeoutMs, 
+                   int wrTimeoutMs, int flags)
+{
+    tType type = portType(csPortNumber);
+    if(type != m_type)
+    {
+        close();
+        m_type = type;
+    }
+
+    m_busyOwner = 0;
+    m_csLockError.clear();
+
+    switch(m_type)
+    {
+    case TRANSPORT_HID:
+    {
+        std::string csIndex = csPortNumber.substr(strlen(SBL_HID_PORT_PREFIX));
+        if(takeLock(m_portLock, SblPortLock::hidLockName(hidSerial(csIndex), csIndex)) != SBL_SUCCESS)
+        {
+            return ComPort::COMPORT_ERROR;
+        }
+        int result = SblHidTransport::open(&m_hid, csIndex, baudRate, rdTimeoutMs, wrTimeoutMs, flags);
+        if(result != ComPort::COMPORT_SUCCESS)
+        {
+            m_portLock.unlock();
+        }
+        return result;
+    }
+    case TRANSPORT_TCP:
+        // The remote end serializes its clients
+        return SblTcpTransport::open(&m_tcp, csPortNumber, baudRate, rdTimeoutMs, wrTimeoutMs, flags);
+    default:
+    {
+        if(claimTty(csPortNumber) != SBL_SUCCESS)
+        {
+            return ComPort::COMPORT_ERROR;
+        }
+        int result = SblUartTransport::open(&m_uart, csPortNumber, baudRate, rdTimeoutMs, wrTimeoutMs, flags);
+        if(result != ComPort::COMPORT_SUCCESS)
+        {
+            close();
+            return result;
+        }
+
+        //
+        // Keep other processes from opening the tty while we use it. Root
+        // may still open it, hence the lock file.
+        //
+        if(m_exclFd >= 0)
+        {
+            ioctl(m_exclFd, TIOCEXCL);
+        }
+        return result;
+    }
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Is \e csTty one of the Pi's own UARTs, the ones wired to the Pi
+ *      HAT (ttyAMA<n>, or ttyS<n> for the mini UART)?
+ */
+//-----------------------------------------------------------------------------
+/*static*/bool
+SblTransport::isPiUart(const std::string &csTty)
+{
+    return (csTty.compare(0, 6, "ttyAMA") == 0 || csTty.compare(0, 4, "ttyS") == 0);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Claim a tty before opening it: take its lock file, then open it
+ *      to check that no other process holds it exclusively (TIOCEXCL).
+ *
+ * \return
+ *      Returns SBL_SUCCESS, SBL_PORT_BUSY_ERROR with m_busyOwner set, or
+ *      SBL_PORT_ERROR with m_csLockError set.
+ */
+//-----------------------------------------------------------------------------
+int
+SblTransport::claimTty(const std::string &csPortNumber)
+{
+    int retCode;
+
+    m_csTty = SblPortLock::lockName(csPortNumber);
+    if((retCode = takeLock(m_portLock, m_csTty)) != SBL_SUCCESS)
+    {
+        return retCode;
+    }
+
+    m_exclFd = ::open(SblPortLock::ttyPath(csPortNumber).c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if(m_exclFd < 0 && errno == EBUSY)
+    {
+        m_portLock.unlock();
+        m_busyOwner = -1;
+        return SBL_PORT_BUSY_ERROR;
+    }
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Serial number of the HID bridge at enumeration index \e csIndex,
+ *      as listed by the bridge's enumerate(). Empty if not found.
+ */
+//-----------------------------------------------------------------------------
+std::string
+SblTransport::hidSerial(const std::string &csIndex)
+{
+    ComPortElement *pList = NULL;
+    int num = SBL_MAX_HID_PORTS;
+
+    if(m_hid.enumerate(pList, num) == ComPort::COMPORT_SUCCESS)
+    {
+        for(int i = 0; i < num; i++)
+        {
+            if(csIndex.compare(pList[i].portNumber) == 0)
+            {
+                return pList[i].description;
+            }
+        }
+    }
+    return "";
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Take \e lock on \e csName, and note who holds it or what went
+ *      wrong if that fails.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, SBL_PORT_BUSY_ERROR with m_busyOwner set, or
+ *      SBL_PORT_ERROR with m_csLockError set.
+ */
+//-----------------------------------------------------------------------------
+int
+SblTransport::takeLock(SblPortLock &lock, const std::string &csName)
+{
+    int retCode = lock.lock(csName);
+
+    if(retCode == SBL_PORT_BUSY_ERROR)
+    {
+        m_busyOwner = lock.getOwner();
+    }
+    else if(retCode != SBL_SUCCESS)
+    {
+        m_csLockError = "Unable to create lock file " + lock.getPath() + " (" + strerror(lock.getError()) + ")";
+    }
+    return retCode;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Close the port.
+ */
+//-----------------------------------------------------------------------------
+int
+SblTransport::close()
+{
+    if(m_hid.isInitiated())
+    {
+        m_hid.close();
+    }
+    if(m_uart.isInitiated())
+    {
+        m_uart.close();
+    }
+    if(m_tcp.isInitiated())
+    {
+        m_tcp.close();
+    }
+    if(m_exclFd >= 0)
+    {
+        ioctl(m_exclFd, TIOCNXCL);
+        ::close(m_exclFd);
+        m_exclFd = -1;
+    }
+    m_portLock.unlock();
+    m_gpioLock.unlock();
+    return ComPort::COMPORT_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Put the device into bootloader mode, as far as the transport
+ *      can do that.
+ *
+ * \param[in] pigpiodID
+ *      pigpio daemon handle (serial ports on the Pi HAT only), or -1.
+ *
+ * \return
+ *      Returns SBL_SUCCESS, SBL_PORT_BUSY_ERROR if another port drives
+ *      the bootloader GPIOs, or SBL_PORT_ERROR if their lock file cannot
+ *      be created.
+ */
+//-----------------------------------------------------------------------------
+int
+SblTransport::setBootloaderMode(int pigpiodID)
+{
+    //
+    // The Pi HAT GPIOs are shared by the Pi's own UARTs. Toggling them
+    // while another session uses them would reset that device mid-flash.
+    // USB serial ports do not use them and are not serialized on them.
+    //
+    int retCode;
+    if(m_type == TRANSPORT_UART && pigpiodID >= 0 && !m_gpioLock.isLocked() &&
+       isPiUart(m_csTty) &&
+       (retCode = takeLock(m_gpioLock, SBL_GPIO_LOCK_NAME)) != SBL_SUCCESS)
+    {
+        return retCode;
+    }
+
+    switch(m_type)
+    {
+    case TRANSPORT_HID:
+        return SblHidTransport::setBootloaderMode(&m_hid, pigpiodID);
+    case TRANSPORT_TCP:
+        return SblTcpTransport::setBootloaderMode(&m_tcp, pigpiodID);
+    default:
+        return SblUartTransport::setBootloaderMode(&m_uart, pigpiodID);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Enable or disable RTS/CTS flow control. This is done on the
+ *      descriptor claimTty() opened; a second open() of the tty would fail
+ *      with EBUSY while it holds TIOCEXCL.
+ *
+ * \param[in] bEnable
+ *      True to enable RTS/CTS, false to disable.
+ *
+ * \return
+ *      Returns 0 on success, -1 if the port is not a local tty or the
+ *      setting could not be changed (see SblTty::setFlowControl()).
+ */
+//-----------------------------------------------------------------------------
+int
+SblTransport::setFlowControl(bool bEnable)
+{
+    if(m_type != TRANSPORT_UART)
+    {
+        return -1;
+    }
+    return SblTty::setFlowControl(m_exclFd, bEnable);
+}
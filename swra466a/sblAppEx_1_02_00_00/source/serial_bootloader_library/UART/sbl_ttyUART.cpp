@@ -0,0 +1,87 @@
+/******************************************************************************
+*  Filename:       sbl_tty.cpp
+*
+*  Description:    Serial Bootloader tty line control file.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+
+#include "sbl_ttyUART.h"
+
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+
+//-----------------------------------------------------------------------------
+/** \brief Enable or disable RTS/CTS hardware flow control on the tty open as
+ *      \e fd. The
+ *      change takes effect immediately (TCSANOW). Data already queued in the
+ *      driver is not affected. Flow control is not enabled unless the device
+ *      asserts CTS, since every write would otherwise stall.
+ *
+ * \param[in] fd
+ *      Open descriptor of the tty.
+ * \param[in] bEnable
+ *      True to enable RTS/CTS, false to disable.
+ *
+ * \return
+ *      Returns 0 on success, -1 if the port is not a tty, CTS is not asserted
+ *      or the line settings could not be changed.
+ */
+//-----------------------------------------------------------------------------
+/*static*/int
+SblTty::setFlowControl(int fd, bool bEnable)
+{
+    struct termios tio;
+    int ret = -1;
+
+    if(fd >= 0 && isatty(fd) && tcgetattr(fd, &tio) == 0)
+    {
+        if(bEnable)
+        {
+            int modemBits = 0;
+            if(ioctl(fd, TIOCMGET, &modemBits) != 0 || !(modemBits & TIOCM_CTS))
+            {
+                return -1;
+            }
+            tio.c_cflag |= CRTSCTS;
+        }
+        else
+        {
+            tio.c_cflag &= ~CRTSCTS;
+        }
+        ret = tcsetattr(fd, TCSANOW, &tio);
+    }
+
+    return (ret == 0) ? 0 : -1;
+}
@@ -0,0 +1,151 @@
+/******************************************************************************
+*  Filename:       sbl_blank_check_test.cpp
+*
+*  Description:    Unit test of the blank page check of eraseFlashRange()
+*                  (SblDevice::setBlankCheck()).
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+
+
+#include "sbl_testUART.h"
+#include "sbl_fake_deviceUART.h"
+
+#define PAGE_SIZE       4096
+#define PAGE_COUNT      12
+
+
+//-----------------------------------------------------------------------------
+/** \brief The runs nextDirtyRun() finds in \e pcDirty ('x' for a page to
+ *      erase), as "<first page>+<count>" separated by spaces.
+ */
+//-----------------------------------------------------------------------------
+static std::string
+dirtyRuns(const char *pcDirty, uint32_t ui32MaxCount)
+{
+    std::vector<bool> pvDirty;
+    std::string csRuns;
+    char pcRun[32];
+    uint32_t runCount;
+
+    for(const char *pc = pcDirty; *pc; pc++)
+    {
+        pvDirty.push_back(*pc == 'x');
+    }
+    for(uint32_t i = 0; (runCount = SblFakeDevice::nextDirtyRun(pvDirty, i, ui32MaxCount)) != 0; i += runCount)
+    {
+        snprintf(pcRun, sizeof(pcRun), "%s%u+%u", (csRuns.empty()) ? "" : " ", i, runCount);
+        csRuns += pcRun;
+    }
+    return csRuns;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    //
+    // CRC of blank flash, also for sizes that are not a multiple of the
+    // buffer calcBlankCrc32() works with
+    //
+    uint32_t pui32Sizes[] = { 0, 1, 255, 256, 257, 1000, PAGE_SIZE, 3 * PAGE_SIZE + 100, 0x20000 };
+    for(uint32_t i = 0; i < sizeof(pui32Sizes) / sizeof(pui32Sizes[0]); i++)
+    {
+        std::vector<char> pvBlank(pui32Sizes[i] + 1, (char)0xFF);
+        TEST_CHECK_EQUAL(SblDevice::calcBlankCrc32(pui32Sizes[i]), SblDevice::calcCrc32(&pvBlank[0], pui32Sizes[i]));
+    }
+
+    //
+    // A blank range takes one CRC over all of it
+    //
+    {
+        SblFakeDevice device;
+        std::vector<bool> pvDirty;
+        TEST_CHECK_EQUAL(device.findDirtyPages(2 * PAGE_SIZE, PAGE_COUNT, pvDirty), SBL_SUCCESS);
+        TEST_CHECK_EQUAL(device.m_pvLog.size(), 1);
+        TEST_CHECK(device.m_pvLog[0].cType == 'c');
+        TEST_CHECK_EQUAL(device.m_pvLog[0].ui32Address, 2 * PAGE_SIZE);
+        TEST_CHECK_EQUAL(device.m_pvLog[0].ui32ByteCount, PAGE_COUNT * PAGE_SIZE);
+        TEST_CHECK(pvDirty == std::vector<bool>(PAGE_COUNT, false));
+        TEST_CHECK_EQUAL(device.getBlankPageCount(), PAGE_COUNT);
+    }
+
+    //
+    // Otherwise each page is checked on its own. A single cleared bit makes
+    // a page dirty.
+    //
+    {
+        SblFakeDevice device;
+        std::vector<bool> pvDirty;
+        uint32_t pui32DirtyPages[] = { 0, 3, 4, 5, 11 };
+        std::vector<bool> pvExpected(PAGE_COUNT, false);
+        for(uint32_t i = 0; i < sizeof(pui32DirtyPages) / sizeof(pui32DirtyPages[0]); i++)
+        {
+            device.m_pvFlash[pui32DirtyPages[i] * PAGE_SIZE + (i * 509) % PAGE_SIZE] = (char)0xEF;
+            pvExpected[pui32DirtyPages[i]] = true;
+        }
+        TEST_CHECK_EQUAL(device.findDirtyPages(0, PAGE_COUNT, pvDirty), SBL_SUCCESS);
+        TEST_CHECK_EQUAL(device.count('c'), 1 + PAGE_COUNT);
+        for(uint32_t i = 1; i < device.m_pvLog.size(); i++)
+        {
+            TEST_CHECK_EQUAL(device.m_pvLog[i].ui32Address, (i - 1) * PAGE_SIZE);
+            TEST_CHECK_EQUAL(device.m_pvLog[i].ui32ByteCount, PAGE_SIZE);
+        }
+        TEST_CHECK(pvDirty == pvExpected);
+        TEST_CHECK_EQUAL(device.getBlankPageCount(), PAGE_COUNT - 5);
+    }
+
+    //
+    // A dirty single page range takes one CRC
+    //
+    {
+        SblFakeDevice device;
+        std::vector<bool> pvDirty;
+        device.m_pvFlash[PAGE_SIZE - 1] = 0;
+        TEST_CHECK_EQUAL(device.findDirtyPages(0, 1, pvDirty), SBL_SUCCESS);
+        TEST_CHECK_EQUAL(device.count('c'), 1);
+        TEST_CHECK(pvDirty == std::vector<bool>(1, true));
+        TEST_CHECK_EQUAL(device.getBlankPageCount(), 0);
+    }
+
+    //
+    // Pages to erase are grouped in runs, split at the batch limit
+    //
+    TEST_CHECK(dirtyRuns("", 4) == "");
+    TEST_CHECK(dirtyRuns("....", 4) == "");
+    TEST_CHECK(dirtyRuns("x..xxx.x...x", 12) == "0+1 3+3 7+1 11+1");
+    TEST_CHECK(dirtyRuns("..xxxxxxx...", 3) == "2+3 5+3 8+1");
+    TEST_CHECK(dirtyRuns("xxxxxxxxxxxx", 12) == "0+12");
+    TEST_CHECK(dirtyRuns("xxxx", 1) == "0+1 1+1 2+1 3+1");
+
+    return TEST_RESULT("sbl_blank_check_test");
+}
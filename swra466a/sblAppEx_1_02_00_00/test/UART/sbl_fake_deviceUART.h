@@ -0,0 +1,246 @@
+#ifndef __SBL_FAKE_DEVICE_H__
+#define __SBL_FAKE_DEVICE_H__
+/******************************************************************************
+*  Filename:       sbl_fake_device.h
+*
+*  Description:    Serial Bootloader Library device stand-in for unit tests.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+#include "sbllibUART.h"
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+//
+// One device access made through SblFakeDevice
+//
+typedef struct
+{
+    char        cType;          // 'r' readMemory8, 'R' readMemory32, 'c' CRC32,
+                                // 'e' eraseFlashRange, 'w' writeFlashRange
+    uint32_t    ui32Address;
+    uint32_t    ui32ByteCount;
+} tFakeAccess;
+
+//
+// SblDevice without a device behind it. Flash, RAM and peripheral registers
+// are host memory, and every access is logged in m_pvLog, so the host side
+// logic of SblDevice, and of the classes using it, can be tested without a
+// board.
+//
+// Flash starts at 0, RAM at 0x20000000. A register (peripheral or private
+// peripheral bus) reads as the low byte of
+// its address XOR 0x5A. Flash is written like the real thing (bits can only
+// be cleared), and the first byte of the next m_ui32CorruptWrites writes to
+// page m_ui32CorruptPage is flipped.
+//
+class SblFakeDevice : public SblDevice
+{
+public:
+    enum {
+        RAM_START           = 0x20000000,
+        RAM_SIZE            = 0x5000,
+        REG_START           = 0x40000000,
+        REG_END             = 0x50000000,
+        PPB_START           = 0xE0000000,
+        PPB_END             = 0xE0100000,
+    };
+
+    SblFakeDevice(uint32_t ui32FlashSize = 0x20000, uint32_t ui32PageSize = 4096, uint32_t ui32MaxReadBytes = 252)
+    {
+        m_pvFlash.assign(ui32FlashSize, (char)0xFF);
+        m_pvRam.assign(RAM_SIZE, 0);
+        m_ui32PageSize = ui32PageSize;
+        m_ui32MaxReadBytes = ui32MaxReadBytes;
+        m_ui32CorruptPage = 0;
+        m_ui32CorruptWrites = 0;
+        m_flashSize = ui32FlashSize;
+        m_ramSize = RAM_SIZE;
+    }
+
+    static char regByte(uint32_t ui32Address) { return (char)((ui32Address & 0xFF) ^ 0x5A); }
+
+    uint32_t count(char cType)
+    {
+        uint32_t n = 0;
+        for(size_t i = 0; i < m_pvLog.size(); i++)
+        {
+            n += (m_pvLog[i].cType == cType) ? 1 : 0;
+        }
+        return n;
+    }
+
+    // SblDevice
+    uint32_t ping() { return SBL_SUCCESS; }
+    uint32_t readStatus(uint32_t *pui32Status) { *pui32Status = CMD_RET_SUCCESS; return SBL_SUCCESS; }
+    uint32_t readDeviceId(uint32_t *pui32DeviceId) { *pui32DeviceId = 0; return SBL_SUCCESS; }
+    uint32_t readFlashSize(uint32_t *pui32FlashSize) { *pui32FlashSize = m_flashSize; return SBL_SUCCESS; }
+    uint32_t readRamSize(uint32_t *pui32RamSize) { *pui32RamSize = m_ramSize; return SBL_SUCCESS; }
+    uint32_t reset() { return SBL_SUCCESS; }
+    uint32_t setBootloaderMode(int pigpiodID) { return SBL_SUCCESS; }
+    uint32_t getPageSize() { return m_ui32PageSize; }
+    uint32_t getMaxReadBytes() { return m_ui32MaxReadBytes; }
+
+    uint32_t readMemory8(uint32_t ui32StartAddress, uint32_t ui32UnitCount, char *pcData)
+    {
+        log('r', ui32StartAddress, ui32UnitCount);
+        return read(ui32StartAddress, ui32UnitCount, pcData);
+    }
+
+    uint32_t readMemory32(uint32_t ui32StartAddress, uint32_t ui32UnitCount, uint32_t *pui32Data)
+    {
+        log('R', ui32StartAddress, ui32UnitCount * 4);
+        return read(ui32StartAddress, ui32UnitCount * 4, (char *)pui32Data);
+    }
+
+    uint32_t writeMemory8(uint32_t ui32StartAddress, uint32_t ui32UnitCount, const char *pcData)
+    {
+        return SBL_UNSUPPORTED_FUNCTION;
+    }
+
+    uint32_t writeMemory32(uint32_t ui32StartAddress, uint32_t ui32UnitCount, const uint32_t *pui32Data)
+    {
+        return SBL_UNSUPPORTED_FUNCTION;
+    }
+
+    uint32_t calculateCrc32(uint32_t ui32StartAddress, uint32_t ui32ByteCount, uint32_t *pui32Crc)
+    {
+        std::vector<char> pvData(ui32ByteCount + 1);
+        log('c', ui32StartAddress, ui32ByteCount);
+        read(ui32StartAddress, ui32ByteCount, &pvData[0]);
+        *pui32Crc = calcCrc32(&pvData[0], ui32ByteCount);
+        return SBL_SUCCESS;
+    }
+
+    uint32_t eraseFlashRange(uint32_t ui32StartAddress, uint32_t ui32ByteCount)
+    {
+        log('e', ui32StartAddress, ui32ByteCount);
+        if(!addressInFlash(ui32StartAddress, ui32ByteCount))
+        {
+            return SBL_ARGUMENT_ERROR;
+        }
+        uint32_t ui32Start = ui32StartAddress - (ui32StartAddress % m_ui32PageSize);
+        uint32_t ui32End = ui32StartAddress + ui32ByteCount;
+        for(uint32_t i = ui32Start; i < ui32End || (i - ui32Start) % m_ui32PageSize; i++)
+        {
+            m_pvFlash[i] = (char)0xFF;
+        }
+        return SBL_SUCCESS;
+    }
+
+    uint32_t writeFlashRange(uint32_t ui32StartAddress, uint32_t ui32ByteCount, const char *pcData)
+    {
+        log('w', ui32StartAddress, ui32ByteCount);
+        if(!addressInFlash(ui32StartAddress, ui32ByteCount))
+        {
+            return SBL_ARGUMENT_ERROR;
+        }
+        for(uint32_t i = 0; i < ui32ByteCount; i++)
+        {
+            m_pvFlash[ui32StartAddress + i] &= pcData[i];
+        }
+        if(m_ui32CorruptWrites && addressToPage(ui32StartAddress) == m_ui32CorruptPage)
+        {
+            m_pvFlash[ui32StartAddress] = ~pcData[0];
+            m_ui32CorruptWrites--;
+        }
+        return SBL_SUCCESS;
+    }
+
+    // Protected SblDevice functions under test
+    using SblDevice::findDirtyPages;
+    using SblDevice::nextDirtyRun;
+    using SblDevice::verifyPages;
+    using SblDevice::releasePageCrcs;
+    using SblDevice::verifyChunk;
+
+    std::vector<char>   m_pvFlash;
+    std::vector<char>   m_pvRam;
+    std::vector<tFakeAccess> m_pvLog;
+    uint32_t            m_ui32CorruptPage;
+    uint32_t            m_ui32CorruptWrites;
+
+protected:
+    uint32_t initCommunication(bool bSetXosc) { return SBL_SUCCESS; }
+    uint32_t sendCmd(uint32_t ui32Cmd, const char *pcSendData = NULL, uint32_t ui32SendLen = 0) { return SBL_UNSUPPORTED_FUNCTION; }
+    uint32_t cmdDownload(uint32_t ui32Address, uint32_t ui32Size) { return SBL_UNSUPPORTED_FUNCTION; }
+    std::string getCmdStatusString(uint32_t ui32Status) { return "Unknown"; }
+    uint32_t addressToPage(uint32_t ui32Address) { return ui32Address / m_ui32PageSize; }
+    bool addressInRam(uint32_t ui32StartAddress, uint32_t ui32ByteCount = 1)
+    {
+        return ui32StartAddress >= RAM_START && ui32StartAddress - RAM_START + ui32ByteCount <= m_pvRam.size();
+    }
+    bool addressInFlash(uint32_t ui32StartAddress, uint32_t ui32ByteCount = 1)
+    {
+        return ui32StartAddress + ui32ByteCount <= m_pvFlash.size();
+    }
+
+private:
+    void log(char cType, uint32_t ui32Address, uint32_t ui32ByteCount)
+    {
+        tFakeAccess access = { cType, ui32Address, ui32ByteCount };
+        m_pvLog.push_back(access);
+    }
+
+    uint32_t read(uint32_t ui32Address, uint32_t ui32ByteCount, char *pcData)
+    {
+        for(uint32_t i = 0; i < ui32ByteCount; i++)
+        {
+            uint32_t ui32Byte = ui32Address + i;
+            if(addressInFlash(ui32Byte))
+            {
+                pcData[i] = m_pvFlash[ui32Byte];
+            }
+            else if(addressInRam(ui32Byte))
+            {
+                pcData[i] = m_pvRam[ui32Byte - RAM_START];
+            }
+            else if((ui32Byte >= REG_START && ui32Byte < REG_END) || 
+                    (ui32Byte >= PPB_START && ui32Byte < PPB_END))
+            {
+                pcData[i] = regByte(ui32Byte);
+            }
+            else
+            {
+                return SBL_ARGUMENT_ERROR;
+            }
+        }
+        return SBL_SUCCESS;
+    }
+
+    uint32_t    m_ui32PageSize;
+    uint32_t    m_ui32MaxReadBytes;
+};
+
+#endif // __SBL_FAKE_DEVICE_H__
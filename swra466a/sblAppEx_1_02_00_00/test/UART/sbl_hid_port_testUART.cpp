@@ -0,0 +1,384 @@
+/******************************************************************************
+*  Filename:       sbl_hid_port_test.cpp
+*
+*  Description:    Test of the CP2110 report batching and RX ring (SblHidPort) against a fake port.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+
+#include "sbl_testUART.h"
+#include "sbl_hid_portUART.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+
+#define REPORT      SblHidPort::HID_REPORT_DATA_SIZE
+
+
+//
+// SblHidPort with a fake CP2110 behind it. Every port write is logged in
+// m_pvWrites. Bytes passed to deliver(), and m_pvResponse after each port
+// write, are returned to the reader thread one report at a time.
+//
+class SblFakeHidPort : public SblHidPort
+{
+public:
+    SblFakeHidPort()
+    {
+        m_bOpen = false;
+        m_bReadError = false;
+        m_rdTimeoutMs = 0;
+        m_ui32MaxWrite = 0;
+        m_ui32Flushes = 0;
+        pthread_mutex_init(&m_mutex, NULL);
+    }
+
+    ~SblFakeHidPort()
+    {
+        close();
+        pthread_mutex_destroy(&m_mutex);
+    }
+
+    void deliver(const char *pcData, uint32_t ui32Bytes)
+    {
+        pthread_mutex_lock(&m_mutex);
+        m_pvRx.insert(m_pvRx.end(), pcData, pcData + ui32Bytes);
+        pthread_mutex_unlock(&m_mutex);
+    }
+
+    void setReadError()
+    {
+        pthread_mutex_lock(&m_mutex);
+        m_bReadError = true;
+        pthread_mutex_unlock(&m_mutex);
+    }
+
+    /// Wait until the reader thread has taken all delivered bytes
+    void waitDelivered()
+    {
+        for(int i = 0; i < 1000; i++)
+        {
+            pthread_mutex_lock(&m_mutex);
+            bool bEmpty = m_pvRx.empty();
+            pthread_mutex_unlock(&m_mutex);
+            if(bEmpty) break;
+            usleep(1000);
+        }
+        usleep(20000);
+    }
+
+    bool m_bOpen;
+    int m_rdTimeoutMs;
+    uint32_t m_ui32MaxWrite;            // Max bytes per port write, 0: all
+    uint32_t m_ui32Flushes;
+    std::vector<std::vector<char> > m_pvWrites;
+    std::vector<char> m_pvResponse;
+
+protected:
+    int portOpen(const std::string &csPortNumber, int baudRate, int rdTimeoutMs, 
+                 int wrTimeoutMs, int flags)
+    {
+        m_bOpen = true;
+        m_rdTimeoutMs = rdTimeoutMs;
+        return ComPort::COMPORT_SUCCESS;
+    }
+
+    int portClose()
+    {
+        m_bOpen = false;
+        return ComPort::COMPORT_SUCCESS;
+    }
+
+    int portRead(void *pData, int length)
+    {
+        int ret = 0;
+
+        pthread_mutex_lock(&m_mutex);
+        if(!m_pvRx.empty())
+        {
+            ret = (int)m_pvRx.size();
+            if(ret > REPORT) ret = REPORT;
+            if(ret > length) ret = length;
+            std::copy(m_pvRx.begin(), m_pvRx.begin() + ret, (char *)pData);
+            m_pvRx.erase(m_pvRx.begin(), m_pvRx.begin() + ret);
+        }
+        else if(m_bReadError)
+        {
+            ret = -1;
+        }
+        pthread_mutex_unlock(&m_mutex);
+
+        if(ret == 0)
+        {
+            usleep(1000);
+        }
+        return ret;
+    }
+
+    int portWrite(void *pData, int length)
+    {
+        if(m_ui32MaxWrite != 0 && (uint32_t)length > m_ui32MaxWrite)
+        {
+            length = m_ui32MaxWrite;
+        }
+        m_pvWrites.push_back(std::vector<char>((char *)pData, (char *)pData + length));
+        if(!m_pvResponse.empty())
+        {
+            deliver(&m_pvResponse[0], m_pvResponse.size());
+        }
+        return length;
+    }
+
+    int portFlush()
+    {
+        m_ui32Flushes++;
+        return ComPort::COMPORT_SUCCESS;
+    }
+
+    bool portIsOpen() { return m_bOpen; }
+
+private:
+    pthread_mutex_t m_mutex;
+    std::deque<char> m_pvRx;
+    bool m_bReadError;
+};
+
+
+//-----------------------------------------------------------------------------
+/** \brief Number of HID reports needed to send \e pvData.
+ */
+//-----------------------------------------------------------------------------
+static uint32_t
+reports(const std::vector<char> &pvData)
+{
+    return (pvData.size() + REPORT - 1) / REPORT;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Command/response exchange as the bootloader protocol does it: each
+ *      command is answered with an ACK and a response, which the host
+ *      ACKs. The host ACK goes out with the next command.
+ */
+//-----------------------------------------------------------------------------
+static void
+testBatching(void)
+{
+    char pcCmd[11] = { 11, 0x2B, 0x21 };
+    char pcAck[2] = { 0x00, (char)0xCC };
+    const char pcResponse[] = { 0x00, (char)0xCC, 3, 0x40, 0x40 };
+    char pcBuf[16];
+    std::vector<char> pvCmdAck(pcAck, pcAck + 2);
+    SblFakeHidPort port;
+
+    pvCmdAck.insert(pvCmdAck.begin(), pcCmd, pcCmd + sizeof(pcCmd));
+    port.m_pvResponse.assign(pcResponse, pcResponse + sizeof(pcResponse));
+    TEST_CHECK_EQUAL(port.open("0", 115200, 100, 200, 0), ComPort::COMPORT_SUCCESS);
+    TEST_CHECK(port.isInitiated());
+    TEST_CHECK_EQUAL(port.m_rdTimeoutMs, SblHidPort::HID_RX_POLL_MS);
+
+    for(int i = 0; i < 10; i++)
+    {
+        int ret, bytes = 0;
+
+        TEST_CHECK_EQUAL(port.writeBytes(pcCmd, sizeof(pcCmd)), sizeof(pcCmd));
+        while(bytes < (int)sizeof(pcResponse) && 
+              (ret = port.readBytes(pcBuf + bytes, sizeof(pcResponse) - bytes)) > 0)
+        {
+            bytes += ret;
+        }
+        TEST_CHECK_EQUAL(bytes, sizeof(pcResponse));
+        TEST_CHECK(memcmp(pcBuf, pcResponse, sizeof(pcResponse)) == 0);
+        TEST_CHECK_EQUAL(port.writeBytes(pcAck, sizeof(pcAck)), sizeof(pcAck));
+    }
+    port.flushTx();
+
+    //
+    // One port write, and one report, per command. The first write has no
+    // ACK in front, the last is the final ACK.
+    //
+    TEST_CHECK_EQUAL(port.m_pvWrites.size(), 11);
+    if(port.m_pvWrites.size() == 11)
+    {
+        TEST_CHECK(port.m_pvWrites[0] == std::vector<char>(pcCmd, pcCmd + sizeof(pcCmd)));
+        for(int i = 1; i < 10; i++)
+        {
+            std::vector<char> pvExpected(pcAck, pcAck + 2);
+            pvExpected.insert(pvExpected.end(), pcCmd, pcCmd + sizeof(pcCmd));
+            TEST_CHECK(port.m_pvWrites[i] == pvExpected);
+            TEST_CHECK_EQUAL(reports(port.m_pvWrites[i]), 1);
+        }
+        TEST_CHECK(port.m_pvWrites[10] == std::vector<char>(pcAck, pcAck + 2));
+    }
+
+    //
+    // Writes are held back until a full batch is queued, then sent as one
+    // transfer of full reports
+    //
+    char pcData[100];
+    std::vector<char> pvSent;
+    port.m_pvWrites.clear();
+    port.m_pvResponse.clear();
+    for(int i = 0; i < 10; i++)
+    {
+        memset(pcData, i, sizeof(pcData));
+        TEST_CHECK_EQUAL(port.writeBytes(pcData, sizeof(pcData)), sizeof(pcData));
+        pvSent.insert(pvSent.end(), pcData, pcData + sizeof(pcData));
+    }
+    TEST_CHECK_EQUAL(port.m_pvWrites.size(), 0);
+    memset(pcData, 10, sizeof(pcData));
+    TEST_CHECK_EQUAL(port.writeBytes(pcData, sizeof(pcData)), sizeof(pcData));
+    pvSent.insert(pvSent.end(), pcData, pcData + sizeof(pcData));
+    TEST_CHECK_EQUAL(port.m_pvWrites.size(), 1);
+    if(port.m_pvWrites.size() == 1)
+    {
+        TEST_CHECK(port.m_pvWrites[0] == pvSent);
+        TEST_CHECK_EQUAL(reports(port.m_pvWrites[0]), 18);
+    }
+
+    //
+    // Partial port writes are continued
+    //
+    port.m_pvWrites.clear();
+    port.m_ui32MaxWrite = 120;
+    TEST_CHECK_EQUAL(port.writeBytes(pcData, sizeof(pcData)), sizeof(pcData));
+    TEST_CHECK_EQUAL(port.writeBytes(pcData, sizeof(pcData)), sizeof(pcData));
+    TEST_CHECK_EQUAL(port.writeBytes(pcData, sizeof(pcData)), sizeof(pcData));
+    TEST_CHECK_EQUAL(port.flushTx(), 300);
+    TEST_CHECK_EQUAL(port.m_pvWrites.size(), 3);
+    if(port.m_pvWrites.size() == 3)
+    {
+        TEST_CHECK_EQUAL(port.m_pvWrites[0].size(), 120);
+        TEST_CHECK_EQUAL(port.m_pvWrites[1].size(), 120);
+        TEST_CHECK_EQUAL(port.m_pvWrites[2].size(), 60);
+    }
+
+    //
+    // close() sends what is queued
+    //
+    port.m_pvWrites.clear();
+    TEST_CHECK_EQUAL(port.writeBytes(pcCmd, sizeof(pcCmd)), sizeof(pcCmd));
+    TEST_CHECK_EQUAL(port.close(), ComPort::COMPORT_SUCCESS);
+    TEST_CHECK(!port.isInitiated());
+    TEST_CHECK_EQUAL(port.m_pvWrites.size(), 1);
+    TEST_CHECK_EQUAL(port.writeBytes(pcCmd, sizeof(pcCmd)), -1);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief RX ring: data comes out in order across wrap-arounds, the oldest
+ *      data is dropped on overflow, flushBuffers() empties it, and a port
+ *      error is reported after the data read before it.
+ */
+//-----------------------------------------------------------------------------
+static void
+testRxRing(void)
+{
+    std::vector<char> pvData(SblHidPort::HID_RX_RING_SIZE + 100);
+    std::vector<char> pvRead;
+    char pcBuf[500];
+    SblFakeHidPort port;
+    int ret;
+
+    for(uint32_t i = 0; i < pvData.size(); i++)
+    {
+        pvData[i] = (char)(i * 7 + i / 251);
+    }
+    TEST_CHECK_EQUAL(port.open("0", 115200, 50, 200, 0), ComPort::COMPORT_SUCCESS);
+
+    //
+    // 3 x 7000 bytes wrap around the 16 KB ring
+    //
+    for(int i = 0; i < 3; i++)
+    {
+        pvRead.clear();
+        port.deliver(&pvData[i * 100], 7000);
+        while(pvRead.size() < 7000 && (ret = port.readBytes(pcBuf, sizeof(pcBuf))) > 0)
+        {
+            pvRead.insert(pvRead.end(), pcBuf, pcBuf + ret);
+        }
+        TEST_CHECK_EQUAL(pvRead.size(), 7000);
+        TEST_CHECK(pvRead.size() == 7000 && memcmp(&pvRead[0], &pvData[i * 100], 7000) == 0);
+    }
+
+    //
+    // Overflow: the oldest 100 bytes are lost
+    //
+    pvRead.clear();
+    port.deliver(&pvData[0], pvData.size());
+    port.waitDelivered();
+    while((ret = port.readBytes(pcBuf, sizeof(pcBuf))) > 0)
+    {
+        pvRead.insert(pvRead.end(), pcBuf, pcBuf + ret);
+    }
+    TEST_CHECK_EQUAL(ret, 0);
+    TEST_CHECK_EQUAL(pvRead.size(), SblHidPort::HID_RX_RING_SIZE);
+    TEST_CHECK(pvRead.size() == SblHidPort::HID_RX_RING_SIZE && 
+               memcmp(&pvRead[0], &pvData[100], pvRead.size()) == 0);
+
+    //
+    // flushBuffers() sends queued writes and drops received data
+    //
+    port.deliver(&pvData[0], 10);
+    port.waitDelivered();
+    TEST_CHECK_EQUAL(port.writeBytes(pcBuf, 4), 4);
+    TEST_CHECK_EQUAL(port.flushBuffers(), ComPort::COMPORT_SUCCESS);
+    TEST_CHECK_EQUAL(port.m_ui32Flushes, 1);
+    TEST_CHECK_EQUAL(port.m_pvWrites.size(), 1);
+    TEST_CHECK_EQUAL(port.readBytes(pcBuf, sizeof(pcBuf)), 0);
+
+    //
+    // Port error
+    //
+    port.deliver(&pvData[0], 5);
+    port.setReadError();
+    TEST_CHECK_EQUAL(port.readBytes(pcBuf, sizeof(pcBuf)), 5);
+    TEST_CHECK(memcmp(pcBuf, &pvData[0], 5) == 0);
+    TEST_CHECK_EQUAL(port.readBytes(pcBuf, sizeof(pcBuf)), -1);
+
+    TEST_CHECK_EQUAL(port.close(), ComPort::COMPORT_SUCCESS);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    testBatching();
+    testRxRing();
+
+    return TEST_RESULT("sbl_hid_port_test");
+}
@@ -0,0 +1,170 @@
+/******************************************************************************
+*  Filename:       sbl_manifest_test.cpp
+*
+*  Description:    Unit test of the manifest parser (SblManifest::load()).
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+
+
+#include "sbl_testUART.h"
+#include "sbl_manifestUART.h"
+#include "sbllibUART.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#define MANIFEST        "manifest.txt"
+#define IMAGE           "app.bin"
+#define SPACED_IMAGE    "my app.bin"
+
+
+//-----------------------------------------------------------------------------
+/** \brief Write \e csText to file \e csPath.
+ */
+//-----------------------------------------------------------------------------
+static void
+writeFile(const std::string &csPath, const std::string &csText)
+{
+    FILE *pFile = fopen(csPath.c_str(), "wb");
+    TEST_CHECK(pFile != NULL);
+    if(pFile != NULL)
+    {
+        fwrite(csText.data(), 1, csText.size(), pFile);
+        fclose(pFile);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Load a manifest holding \e csText from \e csDir. The error is
+ *      returned in \e csError.
+ */
+//-----------------------------------------------------------------------------
+static uint32_t
+loadText(SblManifest &manifest, const std::string &csDir, const std::string &csText, std::string &csError)
+{
+    writeFile(csDir + "/" MANIFEST, csText);
+    uint32_t retCode = manifest.load(csDir + "/" MANIFEST);
+    csError = manifest.getError();
+    return retCode;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    char pcTemplate[] = "/tmp/sbl_manifest_XXXXXX";
+    std::string csError;
+
+    TEST_CHECK(mkdtemp(pcTemplate) != NULL);
+    const std::string csDir = pcTemplate;
+    writeFile(csDir + "/" IMAGE, std::string(256, 'a'));
+    writeFile(csDir + "/" SPACED_IMAGE, std::string(16, 'b'));
+
+    //
+    // Plain arguments, comments and CRLF line ends
+    //
+    {
+        SblManifest manifest;
+        TEST_CHECK_EQUAL(loadText(manifest, csDir, 
+                                  "# serial number\r\n"
+                                  "image " IMAGE " 0x1000 verify=readback   # main image\r\n"
+                                  "patch 0x1010 str:L1000123\r\n"
+                                  "patch 0x1020 u32:0x12345678#\r\n", csError), SBL_ARGUMENT_ERROR);
+        TEST_CHECK(csError.find(MANIFEST ":4: '#' inside an argument") != std::string::npos);
+
+        TEST_CHECK_EQUAL(loadText(manifest, csDir, 
+                                  "# serial number\r\n"
+                                  "image " IMAGE " 0x1000 verify=readback   # main image\r\n"
+                                  "patch 0x1010 str:L1000123\r\n"
+                                  "patch 0x1020 u32:0x12345678 #\r\n", csError), SBL_SUCCESS);
+        TEST_CHECK_EQUAL(manifest.getRegions().size(), 1);
+        TEST_CHECK_EQUAL(manifest.getRegions()[0].ui32Address, 0x1000);
+        TEST_CHECK(manifest.getRegions()[0].verify == SBL_VERIFY_READBACK);
+        TEST_CHECK_EQUAL(manifest.getPatches().size(), 2);
+        TEST_CHECK(manifest.getPatches()[0].csData == "str:L1000123");
+        TEST_CHECK(manifest.getPatches()[1].csData == "u32:0x12345678");
+        TEST_CHECK_EQUAL(manifest.getPatches()[1].ui32LineNo, 4);
+    }
+
+    //
+    // Quoted text keeps spaces and '#', with \" and \\ escapes
+    //
+    {
+        SblManifest manifest;
+        TEST_CHECK_EQUAL(loadText(manifest, csDir, 
+                                  "image \"" SPACED_IMAGE "\" 0x2000\n"
+                                  "patch 0x2000 str:\"Unit #1  of 2\"   # label\n"
+                                  "patch 0x2004 \"str:say \\\"hi\\\" c:\\\\\"\n"
+                                  "patch 0x2008 str:\"\"\n", csError), SBL_SUCCESS);
+        TEST_CHECK_EQUAL(manifest.getRegions().size(), 1);
+        TEST_CHECK(manifest.getRegions()[0].csFile == csDir + "/" SPACED_IMAGE);
+        TEST_CHECK_EQUAL(manifest.getRegions()[0].pvData.size(), 16);
+        TEST_CHECK_EQUAL(manifest.getPatches().size(), 3);
+        TEST_CHECK(manifest.getPatches()[0].csData == "str:Unit #1  of 2");
+        TEST_CHECK(manifest.getPatches()[1].csData == "str:say \"hi\" c:\\");
+        TEST_CHECK(manifest.getPatches()[2].csData == "str:");
+    }
+
+    //
+    // Text that would be cut short fails with the line number
+    //
+    {
+        SblManifest manifest;
+        TEST_CHECK_EQUAL(loadText(manifest, csDir, 
+                                  "image " IMAGE "\n"
+                                  "patch 0x10 str:Unit 1\n", csError), SBL_ARGUMENT_ERROR);
+        TEST_CHECK(csError.find(MANIFEST ":2: patch takes") != std::string::npos);
+        TEST_CHECK(manifest.getPatches().empty());
+
+        TEST_CHECK_EQUAL(loadText(manifest, csDir, 
+                                  "image " IMAGE "\n"
+                                  "\n"
+                                  "patch 0x10 str:\"Unit 1\n", csError), SBL_ARGUMENT_ERROR);
+        TEST_CHECK(csError.find(MANIFEST ":3: missing closing quote") != std::string::npos);
+
+        TEST_CHECK_EQUAL(loadText(manifest, csDir, 
+                                  "image " SPACED_IMAGE "\n", csError), SBL_ARGUMENT_ERROR);
+        TEST_CHECK(csError.find(MANIFEST ":1: invalid argument 'app.bin'") != std::string::npos);
+    }
+
+    unlink((csDir + "/" MANIFEST).c_str());
+    unlink((csDir + "/" IMAGE).c_str());
+    unlink((csDir + "/" SPACED_IMAGE).c_str());
+    rmdir(csDir.c_str());
+
+    return TEST_RESULT("sbl_manifest_test");
+}
@@ -0,0 +1,271 @@
+/******************************************************************************
+*  Filename:       sbl_page_verify_test.cpp
+*
+*  Description:    Unit test of verify-as-you-go (SblDevice::setPageVerify()) and
+*                  of the page CRC map of SblImagePrep.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+
+
+#include "sbl_testUART.h"
+#include "sbl_fake_deviceUART.h"
+#include "sbl_image_prepUART.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#define PAGE_SIZE       4096
+#define IMAGE_SIZE      (3 * PAGE_SIZE + 100)   // Last page written in part
+#define CHUNK_SIZE      252                     // As sent by writeFlashRange()
+
+
+//-----------------------------------------------------------------------------
+/** \brief Write \e pvImage to \e device at 0 the way writeFlashRange() does
+ *      with setPageVerify() on: in chunks, with verifyPages() after each.
+ *
+ * \param[out] pvCrcAfterChunk
+ *      Number of CRC commands after each chunk.
+ */
+//-----------------------------------------------------------------------------
+static uint32_t
+writeAndVerify(SblFakeDevice &device, const std::vector<char> &pvImage, std::vector<uint32_t> &pvCrcAfterChunk)
+{
+    uint32_t retCode;
+    uint32_t ui32VerifyAddress = 0;
+    bool bVerified;
+
+    pvCrcAfterChunk.clear();
+    for(uint32_t ui32Done = 0; ui32Done < pvImage.size(); )
+    {
+        uint32_t ui32Bytes = GTmin(CHUNK_SIZE, pvImage.size() - ui32Done);
+        if((retCode = device.writeFlashRange(ui32Done, ui32Bytes, &pvImage[ui32Done])) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+        ui32Done += ui32Bytes;
+        if((retCode = device.verifyPages(ui32VerifyAddress, ui32Done, pvImage.size(), 0, &pvImage[0], bVerified)) != SBL_SUCCESS)
+        {
+            return retCode;
+        }
+        pvCrcAfterChunk.push_back(device.count('c'));
+    }
+    return SBL_SUCCESS;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Page CRCs of \e pvImage as SblImagePrep makes them, from a
+ *      temporary file.
+ */
+//-----------------------------------------------------------------------------
+static std::vector<uint32_t>
+preparePageCrcs(const std::vector<char> &pvImage)
+{
+    std::vector<uint32_t> pvCrcs;
+    char pcFile[] = "/tmp/sbl_page_verify_testXXXXXX";
+    int fd = mkstemp(pcFile);
+    if(fd < 0 || write(fd, &pvImage[0], pvImage.size()) != (ssize_t)pvImage.size())
+    {
+        printf("Cannot write %s\n", pcFile);
+        return pvCrcs;
+    }
+    close(fd);
+
+    SblImagePrep imagePrep;
+    if(imagePrep.start(pcFile, PAGE_SIZE) == SBL_SUCCESS && imagePrep.wait() == SBL_SUCCESS)
+    {
+        pvCrcs = imagePrep.getPageCrcs();
+    }
+    unlink(pcFile);
+    return pvCrcs;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    std::vector<char> pvImage(IMAGE_SIZE);
+    std::vector<uint32_t> pvCrcAfterChunk;
+    for(uint32_t i = 0; i < pvImage.size(); i++)
+    {
+        pvImage[i] = (char)(i * 7 + (i >> 8));
+    }
+
+    //
+    // The map has one CRC per page, the last one of the bytes in it
+    //
+    std::vector<uint32_t> pvCrcs = preparePageCrcs(pvImage);
+    TEST_CHECK_EQUAL(pvCrcs.size(), 4);
+    if(pvCrcs.size() != 4)
+    {
+        return TEST_RESULT("sbl_page_verify_test");
+    }
+    for(uint32_t page = 0; page < 4; page++)
+    {
+        uint32_t ui32Bytes = GTmin(PAGE_SIZE, IMAGE_SIZE - page * PAGE_SIZE);
+        TEST_CHECK_EQUAL(pvCrcs[page], SblDevice::calcCrc32(&pvImage[page * PAGE_SIZE], ui32Bytes));
+    }
+
+    //
+    // Clean write: each page is checked once, as soon as its last chunk is
+    // written, and the partly written last page at the end
+    //
+    {
+        SblFakeDevice device;
+        device.setPageCrcs(0, IMAGE_SIZE, &pvImage[0], pvCrcs);
+        TEST_CHECK_EQUAL(writeAndVerify(device, pvImage, pvCrcAfterChunk), SBL_SUCCESS);
+        TEST_CHECK_EQUAL(device.count('c'), 4);
+        TEST_CHECK_EQUAL(device.count('e'), 0);
+        TEST_CHECK_EQUAL(pvCrcAfterChunk[PAGE_SIZE / CHUNK_SIZE - 1], 0);  // Chunk 16 ends at 4032
+        TEST_CHECK_EQUAL(pvCrcAfterChunk[PAGE_SIZE / CHUNK_SIZE], 1);      // Chunk 17 crosses 4096
+        TEST_CHECK_EQUAL(pvCrcAfterChunk[pvCrcAfterChunk.size() - 1], 4);
+        TEST_CHECK(memcmp(&device.m_pvFlash[0], &pvImage[0], IMAGE_SIZE) == 0);
+    }
+
+    //
+    // A bad write to page 1 is found right after page 1 is written, and only
+    // page 1 is erased and written again
+    //
+    {
+        SblFakeDevice device;
+        device.setPageCrcs(0, IMAGE_SIZE, &pvImage[0], pvCrcs);
+        device.m_ui32CorruptPage = 1;
+        device.m_ui32CorruptWrites = 1;
+        TEST_CHECK_EQUAL(writeAndVerify(device, pvImage, pvCrcAfterChunk), SBL_SUCCESS);
+        TEST_CHECK_EQUAL(device.count('e'), 1);
+        TEST_CHECK_EQUAL(device.count('c'), 5);
+        TEST_CHECK_EQUAL(pvCrcAfterChunk[2 * PAGE_SIZE / CHUNK_SIZE], 3);  // Crosses 8192: page 1 twice
+        for(size_t i = 0; i < device.m_pvLog.size(); i++)
+        {
+            if(device.m_pvLog[i].cType == 'e')
+            {
+                TEST_CHECK_EQUAL(device.m_pvLog[i].ui32Address, PAGE_SIZE);
+                TEST_CHECK_EQUAL(device.m_pvLog[i].ui32ByteCount, PAGE_SIZE);
+                TEST_CHECK(device.m_pvLog[i + 1].cType == 'w');
+                TEST_CHECK_EQUAL(device.m_pvLog[i + 1].ui32ByteCount, PAGE_SIZE);
+            }
+        }
+        TEST_CHECK(memcmp(&device.m_pvFlash[0], &pvImage[0], IMAGE_SIZE) == 0);
+    }
+
+    //
+    // The expected CRCs come from the map: a wrong entry for page 2 fails
+    // page 2 although the flash holds the image, after the retries
+    //
+    {
+        SblFakeDevice device;
+        std::vector<uint32_t> pvBadCrcs = pvCrcs;
+        pvBadCrcs[2] ^= 1;
+        device.setRetryPolicy(2, SBL_DEFAULT_TOTAL_RETRIES, 0);
+        device.setPageCrcs(0, IMAGE_SIZE, &pvImage[0], pvBadCrcs);
+        TEST_CHECK_EQUAL(writeAndVerify(device, pvImage, pvCrcAfterChunk), SBL_ERROR);
+        TEST_CHECK_EQUAL(device.count('e'), 2);
+        TEST_CHECK_EQUAL(device.count('c'), 2 + 3);
+    }
+
+    //
+    // A map made for another page size is not used
+    //
+    {
+        SblFakeDevice device;
+        std::vector<uint32_t> pvBadCrcs = pvCrcs;
+        pvBadCrcs[2] ^= 1;
+        pvBadCrcs.push_back(0);
+        device.setPageCrcs(0, IMAGE_SIZE, &pvImage[0], pvBadCrcs);
+        TEST_CHECK_EQUAL(writeAndVerify(device, pvImage, pvCrcAfterChunk), SBL_SUCCESS);
+        TEST_CHECK_EQUAL(device.count('e'), 0);
+    }
+
+    //
+    // A map given for another buffer is not used, even with the same address
+    // and size
+    //
+    {
+        SblFakeDevice device;
+        std::vector<char> pvOther(pvImage);
+        std::vector<uint32_t> pvBadCrcs = pvCrcs;
+        pvBadCrcs[2] ^= 1;
+        device.setPageCrcs(0, IMAGE_SIZE, &pvOther[0], pvBadCrcs);
+        TEST_CHECK_EQUAL(writeAndVerify(device, pvImage, pvCrcAfterChunk), SBL_SUCCESS);
+        TEST_CHECK_EQUAL(device.count('e'), 0);
+    }
+
+    //
+    // The map is dropped when the write of the whole image ends, not when
+    // a write of part of it or of another buffer does
+    //
+    {
+        std::vector<char> pvOther(pvImage);
+        std::vector<uint32_t> pvBadCrcs = pvCrcs;
+        pvBadCrcs[2] ^= 1;
+
+        SblFakeDevice device;
+        device.setRetryPolicy(0, SBL_DEFAULT_TOTAL_RETRIES, 0);
+        device.setPageCrcs(0, IMAGE_SIZE, &pvImage[0], pvBadCrcs);
+        device.releasePageCrcs(0, PAGE_SIZE, &pvImage[0]);
+        device.releasePageCrcs(0, IMAGE_SIZE, &pvOther[0]);
+        TEST_CHECK_EQUAL(writeAndVerify(device, pvImage, pvCrcAfterChunk), SBL_ERROR);
+
+        SblFakeDevice device2;
+        device2.setPageCrcs(0, IMAGE_SIZE, &pvImage[0], pvBadCrcs);
+        device2.releasePageCrcs(0, IMAGE_SIZE, &pvImage[0]);
+        TEST_CHECK_EQUAL(writeAndVerify(device2, pvImage, pvCrcAfterChunk), SBL_SUCCESS);
+        TEST_CHECK_EQUAL(device2.count('e'), 0);
+    }
+
+    //
+    // Zeros programmed over a chunk that crosses into page 1, as when the
+    // device takes the resync padding as data, are found by verifyChunk().
+    // Only page 1 is erased and written again.
+    //
+    {
+        SblFakeDevice device;
+        uint32_t ui32Chunk = PAGE_SIZE - 100;
+        TEST_CHECK_EQUAL(writeAndVerify(device, pvImage, pvCrcAfterChunk), SBL_SUCCESS);
+        memset(&device.m_pvFlash[PAGE_SIZE], 0, 100);
+        device.m_pvLog.clear();
+        TEST_CHECK_EQUAL(device.verifyChunk(ui32Chunk, CHUNK_SIZE, &pvImage[ui32Chunk]), SBL_SUCCESS);
+        TEST_CHECK_EQUAL(device.count('c'), 3);
+        TEST_CHECK_EQUAL(device.count('e'), 1);
+        for(size_t i = 0; i < device.m_pvLog.size(); i++)
+        {
+            if(device.m_pvLog[i].cType == 'e')
+            {
+                TEST_CHECK_EQUAL(device.m_pvLog[i].ui32Address, PAGE_SIZE);
+            }
+        }
+        TEST_CHECK(memcmp(&device.m_pvFlash[0], &pvImage[0], IMAGE_SIZE) == 0);
+    }
+
+    return TEST_RESULT("sbl_page_verify_test");
+}
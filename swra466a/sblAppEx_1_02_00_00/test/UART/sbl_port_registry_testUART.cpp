@@ -0,0 +1,275 @@
+/******************************************************************************
+*  Filename:       sbl_port_registry_test.cpp
+*
+*  Description:    Test of the USB serial port registry (SblPortRegistry) against a fake sysfs tree.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+
+#include "sbl_testUART.h"
+#include "sbl_port_registryUART.h"
+
+#include <ftw.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#define USB_HUB     "/devices/pci0000:00/0000:00:14.0/usb1/1-1"
+
+//
+// SblPortRegistry with the sysfs scan and the uevent handler reachable, so
+// hotplug can be tested without kernel events
+//
+class SblTestRegistry : public SblPortRegistry
+{
+public:
+    SblTestRegistry(const std::string &csSysfsRoot) : SblPortRegistry(csSysfsRoot) {}
+
+    using SblPortRegistry::scan;
+    using SblPortRegistry::handleUevent;
+};
+
+
+//-----------------------------------------------------------------------------
+/** \brief Create directory \e csPath and its parents.
+ */
+//-----------------------------------------------------------------------------
+static void
+makeDirs(const std::string &csPath)
+{
+    for(size_t slash = csPath.find('/', 1); slash != std::string::npos; 
+        slash = csPath.find('/', slash + 1))
+    {
+        mkdir(csPath.substr(0, slash).c_str(), 0755);
+    }
+    mkdir(csPath.c_str(), 0755);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Write the sysfs attribute \e pcAttr of \e csDir.
+ */
+//-----------------------------------------------------------------------------
+static void
+writeAttr(const std::string &csDir, const char *pcAttr, const char *pcValue)
+{
+    FILE *pFile = fopen((csDir + "/" + pcAttr).c_str(), "w");
+
+    TEST_CHECK(pFile != NULL);
+    if(pFile != NULL)
+    {
+        fprintf(pFile, "%s\n", pcValue);
+        fclose(pFile);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Add USB device \e pcUsbDev (e.g. "1-1.2") with tty \e pcTty on
+ *      interface \e pcIntf to the sysfs tree at \e csRoot. \e pcSerial may be
+ *      NULL. ttyUSB ports have the usb-serial port directory between the
+ *      interface and the tty, like the kernel does.
+ */
+//-----------------------------------------------------------------------------
+static void
+addUsbTty(const std::string &csRoot, const char *pcUsbDev, const char *pcIntf, 
+          const char *pcTty, const char *pcVid, const char *pcPid, const char *pcSerial)
+{
+    std::string csUsb = csRoot + USB_HUB + "/" + pcUsbDev;
+    std::string csIntf = csUsb + "/" + pcUsbDev + pcIntf;
+    std::string csDevice = csIntf;
+
+    makeDirs(csIntf);
+    writeAttr(csUsb, "idVendor", pcVid);
+    writeAttr(csUsb, "idProduct", pcPid);
+    writeAttr(csUsb, "manufacturer", "Texas Instruments");
+    writeAttr(csUsb, "product", "XDS110");
+    if(pcSerial != NULL)
+    {
+        writeAttr(csUsb, "serial", pcSerial);
+    }
+
+    if(strncmp(pcTty, "ttyUSB", 6) == 0)
+    {
+        csDevice = csIntf + "/" + pcTty;
+    }
+    makeDirs(csDevice + "/tty/" + pcTty);
+    makeDirs(csRoot + "/class/tty");
+    TEST_CHECK_EQUAL(symlink((csDevice + "/tty/" + pcTty).c_str(), 
+                             (csRoot + "/class/tty/" + pcTty).c_str()), 0);
+    TEST_CHECK_EQUAL(symlink(csDevice.c_str(), (csDevice + "/tty/" + pcTty + "/device").c_str()), 0);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Build a uevent message for \e pcAction of \e pcTty in
+ *      \e pcSubsystem.
+ */
+//-----------------------------------------------------------------------------
+static std::string
+uevent(const char *pcAction, const char *pcSubsystem, const char *pcTty)
+{
+    std::string csMsg;
+
+    csMsg += std::string(pcAction) + "@/devices/virtual/tty/" + pcTty + '\0';
+    csMsg += std::string("ACTION=") + pcAction + '\0';
+    csMsg += std::string("DEVPATH=/devices/virtual/tty/") + pcTty + '\0';
+    csMsg += std::string("SUBSYSTEM=") + pcSubsystem + '\0';
+    csMsg += std::string("DEVNAME=/dev/") + pcTty + '\0';
+    return csMsg;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief nftw() callback removing the fixture.
+ */
+//-----------------------------------------------------------------------------
+static int
+removeEntry(const char *pcPath, const struct stat *pStat, int flag, struct FTW *pFtw)
+{
+    return remove(pcPath);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    char pcTemplate[] = "/tmp/sbl_sysfs_XXXXXX";
+    char pcRoot[PATH_MAX];
+    std::vector<tSblUsbPort> pvPorts;
+    tSblUsbPort port;
+    std::string csMsg;
+
+    TEST_CHECK(mkdtemp(pcTemplate) != NULL);
+    TEST_CHECK(realpath(pcTemplate, pcRoot) != NULL);
+    const std::string csRoot = pcRoot;
+
+    //
+    // Fake sysfs: a CDC ACM board with a serial number, an FTDI style
+    // usb-serial board without one, a built in UART and a virtual console
+    //
+    addUsbTty(csRoot, "1-1.2", ":1.0", "ttyACM0", "0451", "bef3", "L1000123");
+    addUsbTty(csRoot, "1-1.3", ":1.0", "ttyUSB0", "0403", "6001", NULL);
+    makeDirs(csRoot + "/devices/platform/serial8250/tty/ttyS0");
+    TEST_CHECK_EQUAL(symlink((csRoot + "/devices/platform/serial8250/tty/ttyS0").c_str(), 
+                             (csRoot + "/class/tty/ttyS0").c_str()), 0);
+    TEST_CHECK_EQUAL(symlink((csRoot + "/devices/platform/serial8250").c_str(), 
+                             (csRoot + "/devices/platform/serial8250/tty/ttyS0/device").c_str()), 0);
+    makeDirs(csRoot + "/devices/virtual/tty/tty0");
+    TEST_CHECK_EQUAL(symlink((csRoot + "/devices/virtual/tty/tty0").c_str(), 
+                             (csRoot + "/class/tty/tty0").c_str()), 0);
+
+    SblTestRegistry registry(csRoot);
+
+    //
+    // Parse: only the USB ports are listed, ordered by tty name
+    //
+    registry.scan();
+    registry.getPorts(pvPorts);
+    TEST_CHECK_EQUAL(pvPorts.size(), 2);
+    if(pvPorts.size() == 2)
+    {
+        TEST_CHECK(pvPorts[0].csPortNum == "ttyACM0");
+        TEST_CHECK(pvPorts[0].csUsbPath == "1-1.2:1.0");
+        TEST_CHECK(pvPorts[0].csSerial == "L1000123");
+        TEST_CHECK(pvPorts[0].csDescription == "Texas Instruments XDS110");
+        TEST_CHECK_EQUAL(pvPorts[0].ui16Vid, 0x0451);
+        TEST_CHECK_EQUAL(pvPorts[0].ui16Pid, 0xBEF3);
+        TEST_CHECK(pvPorts[1].csPortNum == "ttyUSB0");
+        TEST_CHECK(pvPorts[1].csUsbPath == "1-1.3:1.0");
+        TEST_CHECK(pvPorts[1].csSerial.empty());
+        TEST_CHECK_EQUAL(pvPorts[1].ui16Vid, 0x0403);
+        TEST_CHECK_EQUAL(pvPorts[1].ui16Pid, 0x6001);
+    }
+    TEST_CHECK(!registry.identify("ttyS0", port));
+    TEST_CHECK(!registry.identify("tty0", port));
+    TEST_CHECK(!registry.identify("ttyUSB9", port));
+
+    //
+    // find() by serial number or physical port, with or without the
+    // interface and the "usb:" prefix
+    //
+    TEST_CHECK(registry.find("L1000123", port) && port.csPortNum == "ttyACM0");
+    TEST_CHECK(registry.find("usb:L1000123", port) && port.csPortNum == "ttyACM0");
+    TEST_CHECK(registry.find("1-1.3", port) && port.csPortNum == "ttyUSB0");
+    TEST_CHECK(registry.find("usb:1-1.3:1.0", port) && port.csPortNum == "ttyUSB0");
+    TEST_CHECK(!registry.find("1-1", port));
+    TEST_CHECK(!registry.find("", port));
+    TEST_CHECK(!registry.find("ttyS0", port));
+
+    //
+    // Hotplug: a board added after the scan is reported by waitForPort()
+    // and can be found. Events of other subsystems and of non-USB ttys are
+    // ignored.
+    //
+    TEST_CHECK(!registry.waitForPort(port, 0));
+    addUsbTty(csRoot, "1-1.4", ":1.0", "ttyUSB1", "0403", "6015", "FT12AB");
+    csMsg = uevent("add", "usb", "ttyUSB1");
+    registry.handleUevent(csMsg.data(), csMsg.size());
+    csMsg = uevent("add", "tty", "ttyS0");
+    registry.handleUevent(csMsg.data(), csMsg.size());
+    TEST_CHECK(!registry.waitForPort(port, 0));
+    csMsg = uevent("add", "tty", "ttyUSB1");
+    registry.handleUevent(csMsg.data(), csMsg.size());
+    TEST_CHECK(registry.waitForPort(port, 0));
+    TEST_CHECK(port.csPortNum == "ttyUSB1");
+    TEST_CHECK(port.csUsbPath == "1-1.4:1.0");
+    TEST_CHECK(!registry.waitForPort(port, 0));
+    TEST_CHECK(registry.find("FT12AB", port) && port.csPortNum == "ttyUSB1");
+    registry.getPorts(pvPorts);
+    TEST_CHECK_EQUAL(pvPorts.size(), 3);
+
+    //
+    // Removal drops the port, also one added but not yet waited for. The
+    // tty name may come back on another board.
+    //
+    csMsg = uevent("remove", "tty", "ttyUSB0");
+    registry.handleUevent(csMsg.data(), csMsg.size());
+    TEST_CHECK(!registry.find("1-1.3", port));
+    csMsg = uevent("add", "tty", "ttyACM0");
+    registry.handleUevent(csMsg.data(), csMsg.size());
+    csMsg = uevent("remove", "tty", "ttyACM0");
+    registry.handleUevent(csMsg.data(), csMsg.size());
+    TEST_CHECK(!registry.waitForPort(port, 0));
+    TEST_CHECK(!registry.find("L1000123", port));
+    registry.getPorts(pvPorts);
+    TEST_CHECK_EQUAL(pvPorts.size(), 1);
+
+    nftw(csRoot.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+
+    return TEST_RESULT("sbl_port_registry_test");
+}
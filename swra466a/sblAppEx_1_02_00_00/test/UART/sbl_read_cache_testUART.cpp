@@ -0,0 +1,208 @@
+/******************************************************************************
+*  Filename:       sbl_read_cache_test.cpp
+*
+*  Description:    Unit test of the batched memory read (SblReadCache).
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+
+
+#include "sbl_testUART.h"
+#include "sbl_fake_deviceUART.h"
+#include "sbl_read_cacheUART.h"
+
+#define RAM     SblFakeDevice::RAM_START
+#define REG     SblFakeDevice::REG_START
+#define PPB     SblFakeDevice::PPB_START
+
+
+//-----------------------------------------------------------------------------
+/** \brief Check that access \e ui32Index of \e device is \e cType of
+ *      \e ui32ByteCount bytes at \e ui32Address.
+ */
+//-----------------------------------------------------------------------------
+#define CHECK_ACCESS(device, ui32Index, type, address, bytes)                \
+    do {                                                                    \
+        TEST_CHECK((ui32Index) < (device).m_pvLog.size());                  \
+        if((ui32Index) < (device).m_pvLog.size())                           \
+        {                                                                   \
+            TEST_CHECK((device).m_pvLog[ui32Index].cType == (type));        \
+            TEST_CHECK_EQUAL((device).m_pvLog[ui32Index].ui32Address, address); \
+            TEST_CHECK_EQUAL((device).m_pvLog[ui32Index].ui32ByteCount, bytes); \
+        }                                                                   \
+    } while(0)
+
+
+//-----------------------------------------------------------------------------
+/** \brief Add a request for \e ui32ByteCount bytes at \e ui32Address to
+ *      \e pvRequests, read into \e pcData.
+ */
+//-----------------------------------------------------------------------------
+static void
+addRequest(std::vector<tSblReadRequest> &pvRequests, uint32_t ui32Address, uint32_t ui32ByteCount, char *pcData)
+{
+    tSblReadRequest request = { ui32Address, ui32ByteCount, pcData };
+    memset(pcData, 0, ui32ByteCount);
+    pvRequests.push_back(request);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Did \e request get the bytes of \e device?
+ */
+//-----------------------------------------------------------------------------
+static bool
+requestHasData(SblFakeDevice &device, const tSblReadRequest &request)
+{
+    for(uint32_t i = 0; i < request.ui32ByteCount; i++)
+    {
+        uint32_t ui32Address = request.ui32Address + i;
+        char expected = (ui32Address >= REG) ? SblFakeDevice::regByte(ui32Address) :
+                        (ui32Address >= RAM) ? device.m_pvRam[ui32Address - RAM] : device.m_pvFlash[ui32Address];
+        if(request.pcData[i] != expected)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    SblFakeDevice device;               // 252 bytes per read: 128 byte blocks
+    SblReadCache cache(&device);
+    std::vector<tSblReadRequest> pvRequests;
+    char pcData[8][64];
+
+    for(uint32_t i = 0; i < device.m_pvRam.size(); i++)
+    {
+        device.m_pvRam[i] = (char)(i * 13 + 1);
+    }
+
+    //
+    // Registers: overlapping and touching requests are read as one range,
+    // exactly as asked and in 32 bit accesses where aligned. Registers that
+    // are apart are read on their own, an unaligned one with 8 bit access.
+    //
+    addRequest(pvRequests, REG + 0x1004, 8, pcData[0]);
+    addRequest(pvRequests, REG + 0x1000, 8, pcData[1]);     // Overlaps the first
+    addRequest(pvRequests, REG + 0x100C, 8, pcData[2]);     // Touches the first
+    addRequest(pvRequests, REG + 0x2001, 3, pcData[3]);
+    TEST_CHECK_EQUAL(cache.read(pvRequests), SBL_SUCCESS);
+    TEST_CHECK_EQUAL(cache.getDeviceReads(), 2);
+    TEST_CHECK_EQUAL(device.m_pvLog.size(), 2);
+    CHECK_ACCESS(device, 0, 'R', REG + 0x1000, 20);
+    CHECK_ACCESS(device, 1, 'r', REG + 0x2001, 3);
+    for(uint32_t i = 0; i < pvRequests.size(); i++)
+    {
+        TEST_CHECK(requestHasData(device, pvRequests[i]));
+    }
+
+    //
+    // Registers are never cached
+    //
+    device.m_pvLog.clear();
+    TEST_CHECK_EQUAL(cache.read(pvRequests), SBL_SUCCESS);
+    TEST_CHECK_EQUAL(cache.getDeviceReads(), 4);
+    TEST_CHECK_EQUAL(device.m_pvLog.size(), 2);
+    TEST_CHECK_EQUAL(cache.getCacheHits(), 0);
+
+    //
+    // Nor are the private peripheral bus registers (here CPUID and ICSR),
+    // which are read exactly as asked each time
+    //
+    pvRequests.clear();
+    addRequest(pvRequests, PPB + 0xED00, 4, pcData[0]);
+    addRequest(pvRequests, PPB + 0xED04, 4, pcData[1]);
+    for(uint32_t pass = 0; pass < 2; pass++)
+    {
+        device.m_pvLog.clear();
+        TEST_CHECK_EQUAL(cache.read(pvRequests), SBL_SUCCESS);
+        TEST_CHECK_EQUAL(device.m_pvLog.size(), 1);
+        CHECK_ACCESS(device, 0, 'R', PPB + 0xED00, 8);
+        TEST_CHECK(requestHasData(device, pvRequests[0]) && requestHasData(device, pvRequests[1]));
+    }
+    TEST_CHECK_EQUAL(cache.getDeviceReads(), 6);
+    TEST_CHECK_EQUAL(cache.getCacheHits(), 0);
+
+    //
+    // Memory: a request straddling a block boundary reads both blocks, in
+    // one read together with the adjacent block of another request. A block
+    // further away takes a read of its own.
+    //
+    pvRequests.clear();
+    device.m_pvLog.clear();
+    addRequest(pvRequests, RAM + 0x7C, 8, pcData[0]);       // Blocks 0x00 and 0x80
+    addRequest(pvRequests, RAM + 0x104, 4, pcData[1]);      // Block 0x100
+    addRequest(pvRequests, RAM + 0x403, 5, pcData[2]);      // Block 0x400
+    TEST_CHECK_EQUAL(cache.read(pvRequests), SBL_SUCCESS);
+    TEST_CHECK_EQUAL(cache.getDeviceReads(), 8);
+    TEST_CHECK_EQUAL(device.m_pvLog.size(), 2);
+    CHECK_ACCESS(device, 0, 'R', RAM, 3 * 128);
+    CHECK_ACCESS(device, 1, 'R', RAM + 0x400, 128);
+    for(uint32_t i = 0; i < pvRequests.size(); i++)
+    {
+        TEST_CHECK(requestHasData(device, pvRequests[i]));
+    }
+    TEST_CHECK_EQUAL(cache.getCacheHits(), 0);
+
+    //
+    // A second read of cached blocks is served from the cache
+    //
+    pvRequests.clear();
+    device.m_pvLog.clear();
+    addRequest(pvRequests, RAM + 0x10, 16, pcData[0]);
+    addRequest(pvRequests, RAM + 0x7E, 40, pcData[1]);      // Straddles 0x80
+    addRequest(pvRequests, RAM + 0x47F, 1, pcData[2]);
+    TEST_CHECK_EQUAL(cache.read(pvRequests), SBL_SUCCESS);
+    TEST_CHECK_EQUAL(cache.getDeviceReads(), 8);
+    TEST_CHECK_EQUAL(device.m_pvLog.size(), 0);
+    TEST_CHECK_EQUAL(cache.getCacheHits(), 3);
+    for(uint32_t i = 0; i < pvRequests.size(); i++)
+    {
+        TEST_CHECK(requestHasData(device, pvRequests[i]));
+    }
+
+    //
+    // Until the cache is invalidated
+    //
+    device.m_pvRam[0x10] ^= 0x55;
+    cache.invalidate();
+    TEST_CHECK_EQUAL(cache.read(RAM + 0x10, 4, pcData[3]), SBL_SUCCESS);
+    TEST_CHECK_EQUAL(device.m_pvLog.size(), 1);
+    CHECK_ACCESS(device, 0, 'R', RAM, 128);
+    TEST_CHECK(pcData[3][0] == device.m_pvRam[0x10]);
+
+    return TEST_RESULT("sbl_read_cache_test");
+}
@@ -0,0 +1,280 @@
+/******************************************************************************
+*  Filename:       sbl_tcp_port_test.cpp
+*
+*  Description:    Loopback test of the TCP and RFC 2217 port (SblTcpPort).
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+
+#include "sbl_testUART.h"
+#include "sbl_tcp_portUART.h"
+
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#define IAC     0xFF
+#define SB      0xFA
+#define SE      0xF0
+#define WILL    0xFB
+#define WONT    0xFC
+#define DO      0xFD
+#define DONT    0xFE
+
+
+//-----------------------------------------------------------------------------
+/** \brief Receive what the port sent to the peer end \e sock, until nothing
+ *      more arrives within \e timeoutMs.
+ */
+//-----------------------------------------------------------------------------
+static std::vector<uint8_t>
+peerRecv(int sock, int timeoutMs)
+{
+    std::vector<uint8_t> pvData;
+    struct pollfd pfd = { sock, POLLIN, 0 };
+    uint8_t pui8Buf[256];
+
+    while(poll(&pfd, 1, timeoutMs) > 0)
+    {
+        int ret = recv(sock, pui8Buf, sizeof(pui8Buf), 0);
+        if(ret <= 0)
+        {
+            break;
+        }
+        pvData.insert(pvData.end(), pui8Buf, pui8Buf + ret);
+    }
+    return pvData;
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Send \e ui32Bytes bytes of \e pui8Data from the peer end \e sock.
+ */
+//-----------------------------------------------------------------------------
+static void
+peerSend(int sock, const uint8_t *pui8Data, uint32_t ui32Bytes)
+{
+    TEST_CHECK_EQUAL(send(sock, pui8Data, ui32Bytes, 0), ui32Bytes);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Are \e pvData exactly the \e ui32Bytes bytes of \e pui8Expected?
+ */
+//-----------------------------------------------------------------------------
+static bool
+bytesEqual(const std::vector<uint8_t> &pvData, const uint8_t *pui8Expected, uint32_t ui32Bytes)
+{
+    return (pvData.size() == ui32Bytes && 
+            (ui32Bytes == 0 || memcmp(&pvData[0], pui8Expected, ui32Bytes) == 0));
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief Raw TCP: bytes pass unchanged both ways, 0xFF included, and writes
+ *      are held back until the next read or flush.
+ */
+//-----------------------------------------------------------------------------
+static void
+testRaw(void)
+{
+    uint8_t pui8Tx[] = { 0x55, IAC, 0x00, IAC, IAC, 0xAA };
+    const uint8_t pui8Rx[] = { IAC, WILL, 44, 0x10, IAC };
+    uint8_t pui8Buf[16];
+    SblTcpPort port;
+    int sv[2];
+
+    TEST_CHECK_EQUAL(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    TEST_CHECK_EQUAL(port.attach(sv[0], false, 115200, 100, 100), ComPort::COMPORT_SUCCESS);
+    TEST_CHECK(port.isInitiated());
+
+    // Nothing is sent when the port is set up
+    TEST_CHECK(peerRecv(sv[1], 20).empty());
+
+    // Writes are batched ...
+    TEST_CHECK_EQUAL(port.writeBytes(pui8Tx, 3), 3);
+    TEST_CHECK_EQUAL(port.writeBytes(pui8Tx + 3, 3), 3);
+    TEST_CHECK(peerRecv(sv[1], 20).empty());
+
+    // ... and go out unchanged when the port reads
+    peerSend(sv[1], pui8Rx, sizeof(pui8Rx));
+    TEST_CHECK_EQUAL(port.readBytes(pui8Buf, sizeof(pui8Buf)), sizeof(pui8Rx));
+    TEST_CHECK(memcmp(pui8Buf, pui8Rx, sizeof(pui8Rx)) == 0);
+    TEST_CHECK(bytesEqual(peerRecv(sv[1], 20), pui8Tx, sizeof(pui8Tx)));
+
+    // Read timeout
+    TEST_CHECK_EQUAL(port.readBytes(pui8Buf, sizeof(pui8Buf)), 0);
+
+    // No PURGE is sent in raw mode, flushBuffers() drops received data
+    peerSend(sv[1], pui8Rx, sizeof(pui8Rx));
+    usleep(10000);
+    TEST_CHECK_EQUAL(port.flushBuffers(), ComPort::COMPORT_SUCCESS);
+    TEST_CHECK(peerRecv(sv[1], 20).empty());
+    TEST_CHECK_EQUAL(port.readBytes(pui8Buf, sizeof(pui8Buf)), 0);
+
+    port.close();
+    TEST_CHECK(!port.isInitiated());
+    close(sv[1]);
+}
+
+
+//-----------------------------------------------------------------------------
+/** \brief RFC 2217: option negotiation and line settings, IAC doubling in
+ *      both directions, refused options, notifications and purge.
+ */
+//-----------------------------------------------------------------------------
+static void
+testRfc2217(void)
+{
+    const uint8_t pui8Negotiate[] = {
+        IAC, WILL, 44, IAC, WILL, 0, IAC, DO, 0, IAC, WILL, 3, IAC, DO, 3,
+        IAC, SB, 44, 1, 0x00, 0x01, 0xC2, 0x00, IAC, SE,    // 115200 baud
+        IAC, SB, 44, 2, 8, IAC, SE,                         // 8 data bits
+        IAC, SB, 44, 3, 1, IAC, SE,                         // No parity
+        IAC, SB, 44, 4, 1, IAC, SE,                         // 1 stop bit
+        IAC, SB, 44, 5, 1, IAC, SE,                         // No flow control
+    };
+    const uint8_t pui8BaudFF[] = {
+        IAC, SB, 44, 1, 0x00, 0x00, IAC, IAC, IAC, IAC, IAC, SE,
+    };
+    uint8_t pui8Tx[] = { 0x01, IAC, 0x02, IAC, IAC };
+    const uint8_t pui8TxWire[] = { 0x01, IAC, IAC, 0x02, IAC, IAC, IAC, IAC };
+    const uint8_t pui8RxWire[] = {
+        IAC, DO, 44, IAC, WILL, 44,                         // Accepted
+        IAC, DO, 24, IAC, WILL, 31,                         // Refused
+        0x10, IAC, IAC, 0x20,
+        IAC, SB, 44, 106, IAC, IAC, IAC, SE,                // Line state
+        0x30, IAC, 0xF1, 0x40,                              // NOP
+    };
+    const uint8_t pui8Rx[] = { 0x10, IAC, 0x20, 0x30, 0x40 };
+    const uint8_t pui8Refuse[] = { IAC, WONT, 24, IAC, DONT, 31 };
+    const uint8_t pui8Purge[] = { IAC, SB, 44, 12, 3, IAC, SE };
+    const uint8_t pui8Split1[] = { 0x50, IAC };
+    const uint8_t pui8Split2[] = { IAC, 0x60, IAC, SB, 44 };
+    const uint8_t pui8Split3[] = { 107, 0x00, IAC, SE, 0x70 };
+    uint8_t pui8Buf[16];
+    std::vector<uint8_t> pvRx;
+    SblTcpPort port;
+    int sv[2];
+    int ret;
+
+    //
+    // Negotiation, sent as part of opening the port
+    //
+    TEST_CHECK_EQUAL(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    TEST_CHECK_EQUAL(port.attach(sv[0], true, 115200, 100, 100), ComPort::COMPORT_SUCCESS);
+    TEST_CHECK_EQUAL(port.getBaudRate(), 115200);
+    TEST_CHECK(bytesEqual(peerRecv(sv[1], 20), pui8Negotiate, sizeof(pui8Negotiate)));
+
+    //
+    // Data to the server has IAC doubled
+    //
+    TEST_CHECK_EQUAL(port.writeBytes(pui8Tx, sizeof(pui8Tx)), sizeof(pui8Tx));
+    TEST_CHECK(peerRecv(sv[1], 20).empty());
+    TEST_CHECK(port.flushTx() >= 0);
+    TEST_CHECK(bytesEqual(peerRecv(sv[1], 20), pui8TxWire, sizeof(pui8TxWire)));
+
+    //
+    // Data from the server: commands and notifications are stripped, IAC IAC
+    // is one data byte. Unknown options are refused with the next send.
+    //
+    peerSend(sv[1], pui8RxWire, sizeof(pui8RxWire));
+    usleep(10000);
+    while((ret = port.readBytes(pui8Buf, sizeof(pui8Buf))) > 0)
+    {
+        pvRx.insert(pvRx.end(), pui8Buf, pui8Buf + ret);
+    }
+    TEST_CHECK_EQUAL(ret, 0);
+    TEST_CHECK(bytesEqual(pvRx, pui8Rx, sizeof(pui8Rx)));
+    TEST_CHECK(port.flushTx() >= 0);
+    TEST_CHECK(bytesEqual(peerRecv(sv[1], 20), pui8Refuse, sizeof(pui8Refuse)));
+
+    //
+    // Commands and doubled IAC split over several reads
+    //
+    pvRx.clear();
+    peerSend(sv[1], pui8Split1, sizeof(pui8Split1));
+    ret = port.readBytes(pui8Buf, sizeof(pui8Buf));
+    TEST_CHECK_EQUAL(ret, 1);
+    pvRx.insert(pvRx.end(), pui8Buf, pui8Buf + ret);
+    peerSend(sv[1], pui8Split2, sizeof(pui8Split2));
+    ret = port.readBytes(pui8Buf, sizeof(pui8Buf));
+    TEST_CHECK_EQUAL(ret, 2);
+    pvRx.insert(pvRx.end(), pui8Buf, pui8Buf + ret);
+    peerSend(sv[1], pui8Split3, sizeof(pui8Split3));
+    ret = port.readBytes(pui8Buf, sizeof(pui8Buf));
+    TEST_CHECK_EQUAL(ret, 1);
+    pvRx.insert(pvRx.end(), pui8Buf, pui8Buf + ret);
+    const uint8_t pui8Split[] = { 0x50, IAC, 0x60, 0x70 };
+    TEST_CHECK(bytesEqual(pvRx, pui8Split, sizeof(pui8Split)));
+    TEST_CHECK(peerRecv(sv[1], 20).empty());
+
+    //
+    // flushBuffers() asks the server to purge both directions and drops
+    // what was received
+    //
+    peerSend(sv[1], pui8Rx, 3);
+    usleep(10000);
+    TEST_CHECK_EQUAL(port.flushBuffers(), ComPort::COMPORT_SUCCESS);
+    TEST_CHECK(bytesEqual(peerRecv(sv[1], 20), pui8Purge, sizeof(pui8Purge)));
+    TEST_CHECK_EQUAL(port.readBytes(pui8Buf, sizeof(pui8Buf)), 0);
+
+    port.close();
+    close(sv[1]);
+
+    //
+    // IAC is doubled in option values too
+    //
+    TEST_CHECK_EQUAL(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    TEST_CHECK_EQUAL(port.attach(sv[0], true, 0xFFFF, 100, 100), ComPort::COMPORT_SUCCESS);
+    pvRx = peerRecv(sv[1], 20);
+    TEST_CHECK(pvRx.size() > 15 + sizeof(pui8BaudFF));
+    if(pvRx.size() > 15 + sizeof(pui8BaudFF))
+    {
+        TEST_CHECK(memcmp(&pvRx[15], pui8BaudFF, sizeof(pui8BaudFF)) == 0);
+    }
+
+    port.close();
+    close(sv[1]);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    testRaw();
+    testRfc2217();
+
+    return TEST_RESULT("sbl_tcp_port_test");
+}
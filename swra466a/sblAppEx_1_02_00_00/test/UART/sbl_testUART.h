@@ -0,0 +1,77 @@
+#ifndef __SBL_TEST_H__
+#define __SBL_TEST_H__
+/******************************************************************************
+*  Filename:       sbl_test.h
+*
+*  Description:    Serial Bootloader Library unit test helpers.
+*
+*  Copyright (C) 2014 Texas Instruments Incorporated - http://www.ti.com/
+*
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*    Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+*
+*    Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+*    Neither the name of Texas Instruments Incorporated nor the names of
+*    its contributors may be used to endorse or promote products derived
+*    from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+*  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+*  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+*  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+*  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+*  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+*  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************/
+#include <stdint.h>
+#include <stdio.h>
+
+//
+// Minimal checks for the unit tests in this directory. Each test is a
+// program of its own; it prints the checks that fail and returns non-zero
+// from main() through TEST_RESULT().
+//
+static int g_testChecks = 0;
+static int g_testFailures = 0;
+
+#define TEST_CHECK(cond)                                                    \
+    do {                                                                    \
+        g_testChecks++;                                                     \
+        if(!(cond))                                                         \
+        {                                                                   \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            g_testFailures++;                                               \
+        }                                                                   \
+    } while(0)
+
+#define TEST_CHECK_EQUAL(actual, expected)                                  \
+    do {                                                                    \
+        g_testChecks++;                                                     \
+        uint32_t _a = (uint32_t)(actual);                                   \
+        uint32_t _e = (uint32_t)(expected);                                 \
+        if(_a != _e)                                                        \
+        {                                                                   \
+            printf("%s:%d: %s is 0x%X, expected 0x%X\n", __FILE__, __LINE__, \
+                   #actual, _a, _e);                                        \
+            g_testFailures++;                                               \
+        }                                                                   \
+    } while(0)
+
+#define TEST_RESULT(name)                                                   \
+    (printf("%s: %d checks, %d failed\n", name, g_testChecks, g_testFailures), \
+     (g_testFailures) ? 1 : 0)
+
+#endif // __SBL_TEST_H__